@@ -267,6 +267,8 @@ def main(args):
         cmake_options.append("-DCMAKE_BUILD_TYPE=Release")
     if args["static"]:
         cmake_options.append("-DBUILD_SHARED_LIBS=OFF")
+    if args["portable"]:
+        cmake_options.append("-DBUILD_PORTABLE=ON")
     if args["verbose"]:
         cmake_options.append("-DCMAKE_VERBOSE_MAKEFILE:BOOL=ON")
     if dependencies_dir is not None:
@@ -380,6 +382,10 @@ if __name__ == '__main__':
                         default=False,
                         help='Builds using static libraries',
                         action='store_true')
+    parser.add_argument('--portable',
+                        default=False,
+                        help='Builds a binary that can run on any x86-64 host (SIMD kernels are selected at runtime)',
+                        action='store_true')
     parser.add_argument('--threads',
                         help='The number of threads to use for building',
                         type=int)
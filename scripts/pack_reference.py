@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+
+# Converts an indexed FASTA file into the packed reference format read by octopus (io/reference/packed_reference.hpp).
+# Bases are stored in 2 bits, with separate lists of non-ACGT runs and lowercase runs.
+# The packed file can be given to octopus with --reference in place of the FASTA.
+
+import argparse
+import re
+import struct
+from pathlib import Path
+from os.path import isfile
+
+MAGIC = b'OCTOPFA\0'
+VERSION = 1
+HEADER_SIZE = 32
+CONTIG_RECORD_SIZE = 64
+BASE_CODES = bytes(b'ACGT'.find(bytes([c])) if c in b'ACGT' else 0 for c in range(256))
+
+def read_fai(fai_fname):
+    contigs = []
+    with open(fai_fname) as fai:
+        for line in fai:
+            name, length, offset, line_bases, line_width = line.rstrip('\n').split('\t')[:5]
+            contigs.append((name, int(length), int(offset), int(line_bases), int(line_width)))
+    return contigs
+
+def read_contig_sequence(fasta, length, offset, line_bases, line_width):
+    num_lines = (length + line_bases - 1) // line_bases
+    fasta.seek(offset)
+    result = fasta.read(num_lines * line_width).replace(b'\n', b'').replace(b'\r', b'')[:length]
+    if len(result) != length:
+        raise ValueError('FASTA sequence is shorter than its index entry')
+    return result
+
+def pack_bases(sequence):
+    # non-ACGT bases are packed as A and recorded as exceptions
+    codes = sequence.translate(BASE_CODES)
+    codes += bytes(-len(codes) % 4)
+    # each code is < 4, so shifted codes never carry into the next byte
+    packed = 0
+    for i in range(4):
+        packed |= int.from_bytes(codes[i::4], 'little') << (2 * i)
+    return packed.to_bytes(len(codes) // 4, 'little')
+
+def pack_exceptions(sequence):
+    runs = [struct.pack('<QII', m.start(), m.end() - m.start(), sequence[m.start()])
+            for m in re.finditer(rb'([^ACGT])\1*', sequence)]
+    return b''.join(runs), len(runs)
+
+def pack_lowercase(raw):
+    runs = [struct.pack('<QQ', m.start(), m.end()) for m in re.finditer(rb'[a-z]+', raw)]
+    return b''.join(runs), len(runs)
+
+def align(offset):
+    return (offset + 7) // 8 * 8
+
+def main(options):
+    fasta_fname = Path(options.fasta)
+    fai_fname = Path(options.index) if options.index else Path(str(fasta_fname) + '.fai')
+    if not isfile(fasta_fname):
+        print('Input FASTA ' + str(fasta_fname) + ' does not exist')
+        exit(1)
+    if not isfile(fai_fname):
+        print('FASTA index ' + str(fai_fname) + ' does not exist. Make one with samtools faidx')
+        exit(1)
+    out_fname = Path(options.output) if options.output else fasta_fname.with_suffix('.pfa')
+    contigs = read_fai(fai_fname)
+    names = b''.join(name.encode() for name, *_ in contigs)
+    contig_table_offset = HEADER_SIZE
+    names_offset = contig_table_offset + CONTIG_RECORD_SIZE * len(contigs)
+    with open(fasta_fname, 'rb') as fasta, open(out_fname, 'wb') as out:
+        out.write(MAGIC + struct.pack('<IIQQ', VERSION, len(contigs), contig_table_offset, 0))
+        out.write(b'\0' * CONTIG_RECORD_SIZE * len(contigs))
+        out.write(names)
+        records = []
+        name_offset = names_offset
+        for name, length, offset, line_bases, line_width in contigs:
+            raw = read_contig_sequence(fasta, length, offset, line_bases, line_width)
+            sequence = raw.upper()
+            sections = [pack_bases(sequence), *pack_exceptions(sequence), *pack_lowercase(raw)]
+            bases, exceptions, num_exceptions, lowercase, num_lowercase = sections
+            section_offsets = []
+            for section in (bases, exceptions, lowercase):
+                out.write(b'\0' * (align(out.tell()) - out.tell()))
+                section_offsets.append(out.tell())
+                out.write(section)
+            records.append(struct.pack('<8Q', name_offset, len(name.encode()), length, section_offsets[0],
+                                       section_offsets[1], num_exceptions, section_offsets[2], num_lowercase))
+            name_offset += len(name.encode())
+            if options.verbose:
+                print('Packed ' + name + ' (' + str(length) + ' bp, ' + str(num_exceptions) + ' non-ACGT runs, '
+                      + str(num_lowercase) + ' lowercase runs)')
+        out.seek(contig_table_offset)
+        out.write(b''.join(records))
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser()
+    parser.add_argument('fasta', metavar='FASTA', help='Indexed FASTA file to pack')
+    parser.add_argument('--index', type=str, help='FASTA index (default FASTA.fai)')
+    parser.add_argument('-o', '--output', type=str, help='Output packed reference (default FASTA with .pfa extension)')
+    parser.add_argument('--verbose', default=False, action='store_true', help='Report each packed contig')
+    parsed, unparsed = parser.parse_known_args()
+    main(parsed)
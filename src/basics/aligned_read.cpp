@@ -17,7 +17,7 @@ namespace octopus {
 
 const GenomicRegion::ContigName& AlignedRead::Segment::contig_name() const
 {
-    return contig_name_;
+    return *contig_name_;
 }
 
 GenomicRegion::Position AlignedRead::Segment::begin() const noexcept
@@ -54,7 +54,7 @@ const std::string& AlignedRead::name() const noexcept
 
 const std::string& AlignedRead::read_group() const noexcept
 {
-    return read_group_;
+    return *read_group_;
 }
 
 const GenomicRegion& AlignedRead::mapped_region() const noexcept
@@ -546,11 +546,6 @@ std::vector<AlignedRead> split(const AlignedRead& read, const GenomicRegion::Siz
 
 namespace {
 
-auto calculate_dynamic_bytes(const AlignedRead::Segment& segment)
-{
-    return segment.contig_name().size() * sizeof(char);
-}
-
 auto calculate_dynamic_bytes(const AlignedRead::SupplementaryAlignment& alignment)
 {
     return contig_name(alignment).size() * sizeof(char) + alignment.cigar().size() * sizeof(CigarOperation);
@@ -564,14 +559,13 @@ auto calculate_dynamic_bytes(const std::vector<AlignedRead::SupplementaryAlignme
 
 auto calculate_dynamic_bytes(const AlignedRead& read) noexcept
 {
+    // The read group and next segment contig name are interned so are not counted
     return read.name().size() * sizeof(char)
-           + read.read_group().size() * sizeof(char)
            + sequence_size(read) * sizeof(char)
            + sequence_size(read) * sizeof(AlignedRead::BaseQuality)
            + read.cigar().size() * sizeof(CigarOperation)
            + contig_name(read).size() * sizeof(char)
            + read.barcode().size() * sizeof(char)
-           + (read.has_other_segment() ? sizeof(AlignedRead::Segment) + calculate_dynamic_bytes(read.next_segment()) : 0)
            + calculate_dynamic_bytes(read.supplementary_alignments());
 }
 
@@ -584,7 +578,7 @@ MemoryFootprint footprint(const AlignedRead& read) noexcept
 
 bool operator==(const AlignedRead::Segment& lhs, const AlignedRead::Segment& rhs) noexcept
 {
-    return lhs.contig_name() == rhs.contig_name()
+    return lhs.contig_name_ == rhs.contig_name_ // interned
            && lhs.begin() == rhs.begin()
            && lhs.flags_ == rhs.flags_
            && lhs.inferred_template_length() == rhs.inferred_template_length();
@@ -607,7 +601,7 @@ bool operator==(const AlignedRead& lhs, const AlignedRead& rhs) noexcept
         && lhs.cigar()           == rhs.cigar()
         && lhs.sequence()        == rhs.sequence()
         && lhs.base_qualities()  == rhs.base_qualities()
-        && lhs.read_group()      == rhs.read_group()
+        && lhs.read_group_       == rhs.read_group_ // interned
         && lhs.name()            == rhs.name()
         && other_segments_equal(lhs, rhs);
 }
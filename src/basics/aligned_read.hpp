@@ -23,6 +23,7 @@
 #include "basics/genomic_region.hpp"
 #include "concepts/mappable.hpp"
 #include "utils/memory_footprint.hpp"
+#include "utils/string_interner.hpp"
 #include "cigar_string.hpp"
 
 namespace octopus {
@@ -73,7 +74,7 @@ public:
     private:
         using FlagBits = std::bitset<2>;
         
-        GenomicRegion::ContigName contig_name_;
+        const GenomicRegion::ContigName* contig_name_ = &intern(GenomicRegion::ContigName {}); // interned
         GenomicRegion::Position begin_;
         GenomicRegion::Size inferred_template_length_;
         FlagBits flags_;
@@ -152,9 +153,9 @@ private:
     NucleotideSequence sequence_, barcode_sequence_;
     BaseQualityVector base_qualities_;
     CigarString cigar_;
-    std::string read_group_;
-    boost::optional<Segment> next_segment_;
     std::vector<SupplementaryAlignment> supplementary_alignments_;
+    boost::optional<Segment> next_segment_;
+    const std::string* read_group_ = &intern(std::string {}); // interned
     FlagBits flags_;
     MappingQuality mapping_quality_;
     
@@ -219,9 +220,9 @@ AlignedRead::AlignedRead(String_&& name, GenomicRegion_&& reference_region, Seq1
 , barcode_sequence_ {std::forward<Seq2>(barcode)}
 , base_qualities_ {std::forward<Qualities_>(qualities)}
 , cigar_ {std::forward<CigarString_>(cigar)}
-, read_group_ {std::forward<String2_>(read_group)}
-, next_segment_ {}
 , supplementary_alignments_ {}
+, next_segment_ {}
+, read_group_ {&intern(std::forward<String2_>(read_group))}
 , flags_ {compress(flags)}
 , mapping_quality_ {mapping_quality}
 {}
@@ -239,12 +240,12 @@ AlignedRead::AlignedRead(String1_&& name, GenomicRegion_&& reference_region, Seq
 , barcode_sequence_ {std::forward<Seq2>(barcode)}
 , base_qualities_ {std::forward<Qualities_>(qualities)}
 , cigar_ {std::forward<CigarString_>(cigar)}
-, read_group_ {std::forward<String2_>(read_group)}
+, supplementary_alignments_ {}
 , next_segment_ {
     Segment {std::forward<String3_>(next_segment_contig_name), next_segment_begin,
     inferred_template_length, next_segment_flags}
   }
-, supplementary_alignments_ {}
+, read_group_ {&intern(std::forward<String2_>(read_group))}
 , flags_ {compress(flags)}
 , mapping_quality_ {mapping_quality}
 {}
@@ -252,7 +253,7 @@ AlignedRead::AlignedRead(String1_&& name, GenomicRegion_&& reference_region, Seq
 template <typename String_>
 AlignedRead::Segment::Segment(String_&& contig_name, GenomicRegion::Position begin,
                               GenomicRegion::Size inferred_template_length, Flags data)
-: contig_name_ {std::forward<String_>(contig_name)}
+: contig_name_ {&intern(std::forward<String_>(contig_name))}
 , begin_ {begin}
 , inferred_template_length_ {inferred_template_length}
 , flags_ {compress(data)}
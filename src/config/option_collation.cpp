@@ -245,6 +245,14 @@ boost::optional<unsigned> get_num_threads(const OptionMap& options)
     return boost::none;
 }
 
+boost::optional<unsigned> get_num_io_threads(const OptionMap& options)
+{
+    if (is_set("io-threads", options)) {
+        return as_unsigned("io-threads", options);
+    }
+    return boost::none;
+}
+
 ExecutionPolicy get_thread_execution_policy(const OptionMap& options)
 {
     if (is_set("threads", options)) {
@@ -722,11 +730,11 @@ unsigned count_read_paths(const OptionMap& options)
     return get_read_paths(options, false).size();
 }
 
-ReadManager make_read_manager(const OptionMap& options)
+ReadManager make_read_manager(const OptionMap& options, HtslibThreadPool* thread_pool)
 {
     auto read_paths = get_read_paths(options);
     const auto max_open_files = as_unsigned("max-open-read-files", options);
-    return ReadManager {std::move(read_paths), max_open_files};
+    return ReadManager {std::move(read_paths), max_open_files, thread_pool};
 }
 
 bool denovo_candidate_variant_discovery_enabled(const OptionMap& options)
@@ -1588,6 +1596,7 @@ HaplotypeLikelihoodModel make_haplotype_likelihood_model(const OptionMap& option
         config.mapping_quality_cap_trigger = calculate_mapping_quality_cap_trigger(options, read_profile);
     }
     config.max_indel_error = as_unsigned("max-indel-errors", options);
+    config.share_haplotype_prefixes = options.at("share-haplotype-prefixes").as<bool>();
     return HaplotypeLikelihoodModel {std::move(error_model.snv), std::move(error_model.indel), config};
 }
 
@@ -1997,6 +2006,15 @@ boost::optional<std::size_t> get_max_genotype_combinations(const OptionMap& opti
     }
 }
 
+boost::optional<std::size_t> get_sample_block_size(const OptionMap& options)
+{
+    if (options.count("sample-block-size") == 1) {
+        return as_unsigned("sample-block-size", options);
+    } else {
+        return boost::none;
+    }
+}
+
 class TooManyNormalsError : public UserError
 {
     std::string do_where() const override
@@ -2075,6 +2093,7 @@ CallerFactory make_caller_factory(const ReferenceGenome& reference, ReadPipe& re
     vc_builder.set_max_haplotypes(get_max_haplotypes(options));
     vc_builder.set_max_genotypes(get_max_genotypes(options, caller));
     vc_builder.set_max_genotype_combinations(get_max_genotype_combinations(options, caller));
+    vc_builder.set_sample_block_size(get_sample_block_size(options));
     vc_builder.set_haplotype_extension_threshold(options.at("min-protected-haplotype-posterior").as<double>());
     vc_builder.set_reference_haplotype_protection(protect_reference_haplotype(options));
     vc_builder.set_likelihood_model(make_haplotype_likelihood_model(options, read_profile));
@@ -2104,6 +2123,9 @@ CallerFactory make_caller_factory(const ReferenceGenome& reference, ReadPipe& re
         vc_builder.set_min_somatic_posterior(min_somatic_posterior);
         vc_builder.set_normal_contamination_risk(get_normal_contamination_risk(options));
         vc_builder.set_tumour_germline_concentration(options.at("tumour-germline-concentration").as<float>());
+        if (is_set("germline-dominance-margin", options)) {
+            vc_builder.set_germline_dominance_margin(options.at("germline-dominance-margin").as<float>());
+        }
     } else if (caller == "trio") {
         vc_builder.set_trio(make_trio(read_pipe.samples(), options, pedigree));
         vc_builder.set_snv_denovo_prior(options.at("denovo-snv-prior").as<float>());
@@ -2286,7 +2308,7 @@ make_call_filter_factory(const ReferenceGenome& reference, ReadPipe& read_pipe,
 
 bool use_calling_read_pipe_for_call_filtering(const OptionMap& options) noexcept
 {
-    return options.at("use-preprocessed-reads-for-filtering").as<bool>();
+    return options.at("use-preprocessed-reads-for-filtering").as<bool>() || use_fused_call_filtering(options);
 }
 
 bool keep_unfiltered_calls(const OptionMap& options) noexcept
@@ -2294,6 +2316,11 @@ bool keep_unfiltered_calls(const OptionMap& options) noexcept
     return options.at("keep-unfiltered-calls").as<bool>();
 }
 
+bool use_fused_call_filtering(const OptionMap& options) noexcept
+{
+    return is_call_filtering_requested(options) && options.at("fused-call-filtering").as<bool>();
+}
+
 ReadPipe make_default_filter_read_pipe(ReadManager& read_manager, std::vector<SampleName> samples)
 {
     using std::make_unique;
@@ -2492,5 +2519,13 @@ boost::optional<fs::path> data_profile_request(const OptionMap& options)
     return boost::none;
 }
 
+boost::optional<fs::path> read_coverage_index_request(const OptionMap& options)
+{
+    if (is_set("read-coverage-index", options)) {
+        return resolve_path(options.at("read-coverage-index").as<fs::path>(), options);
+    }
+    return boost::none;
+}
+
 } // namespace options
 } // namespace octopus
@@ -37,6 +37,8 @@ boost::optional<fs::path> get_trace_log_file_name(const OptionMap& options);
 
 boost::optional<unsigned> get_num_threads(const OptionMap& options);
 
+boost::optional<unsigned> get_num_io_threads(const OptionMap& options);
+
 MemoryFootprint get_target_read_buffer_size(const OptionMap& options);
 
 ReferenceGenome make_reference(const OptionMap& options);
@@ -49,7 +51,7 @@ bool ignore_unmapped_contigs(const OptionMap& options);
 
 boost::optional<std::vector<SampleName>> get_user_samples(const OptionMap& options);
 
-ReadManager make_read_manager(const OptionMap& options);
+ReadManager make_read_manager(const OptionMap& options, HtslibThreadPool* thread_pool = nullptr);
 
 boost::optional<AlignedRead::NucleotideSequence::size_type> max_read_length(const OptionMap& options);
 
@@ -79,6 +81,8 @@ bool use_calling_read_pipe_for_call_filtering(const OptionMap& options) noexcept
 
 bool keep_unfiltered_calls(const OptionMap& options) noexcept;
 
+bool use_fused_call_filtering(const OptionMap& options) noexcept;
+
 ReadPipe make_call_filter_read_pipe(ReadManager& read_manager, const ReferenceGenome& reference, std::vector<SampleName> samples, const OptionMap& options);
 
 boost::optional<fs::path> get_output_path(const OptionMap& options);
@@ -97,6 +101,8 @@ unsigned estimate_max_open_files(const OptionMap& options);
 
 boost::optional<fs::path> data_profile_request(const OptionMap& options);
 
+boost::optional<fs::path> read_coverage_index_request(const OptionMap& options);
+
 ReadLinkageType get_read_linkage_type(const OptionMap& options);
 
 } // namespace options
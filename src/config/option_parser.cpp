@@ -76,6 +76,11 @@ OptionMap parse_options(const int argc, const char** argv)
      po::value<int>()->implicit_value(0),
      "Maximum number of threads to be used. If no argument is provided unlimited threads are assumed")
     
+    ("io-threads",
+     po::value<int>(),
+     "Number of threads, out of the --threads budget, used for BGZF and CRAM compression and decompression."
+     " Defaults to a quarter of the threads")
+    
     ("max-reference-cache-footprint,X",
      po::value<MemoryFootprint>()->default_value(*parse_footprint("500MB"), "500MB"),
      "Maximum memory footprint for cached reference sequence")
@@ -88,6 +93,10 @@ OptionMap parse_options(const int argc, const char** argv)
      po::value<int>()->default_value(250),
      "Limits the number of read files that are open simultaneously")
     
+    ("read-coverage-index",
+     po::value<fs::path>(),
+     "Binned read coverage index used to partition the calling regions. The index is built with one pass over the reads if the file does not exist")
+    
      ("target-working-memory",
      po::value<MemoryFootprint>(),
      "Target working memory footprint for analysis, not including read or reference buffers")
@@ -548,6 +557,12 @@ OptionMap parse_options(const int argc, const char** argv)
      "Maximum number of genotype combinations that can be considered when computing joint"
      " genotype posterior probabilities")
     
+    ("sample-block-size",
+     po::value<int>(),
+     "Population calling cohorts with more samples than this are evaluated in blocks of this many samples,"
+     " without enumerating joint genotype combinations. Blocked evaluation assumes Hardy-Weinberg"
+     " equilibrium and does not use the population prior model")
+    
     ("use-independent-genotype-priors",
      po::bool_switch()->default_value(false),
      "Use independent genotype priors for joint calling")
@@ -576,6 +591,10 @@ OptionMap parse_options(const int argc, const char** argv)
      po::value<int>()->default_value(16),
      "Maximum number of indel errors that must be tolerated for haplotype likelihood calculation")
     
+    ("share-haplotype-prefixes",
+     po::bool_switch()->default_value(false),
+     "Reuse read alignments to the common prefix of similar haplotypes in the haplotype likelihood calculation")
+    
     ("read-linkage",
      po::value<ReadLinkage>()->default_value(ReadLinkage::paired),
      "Read linkage information to use for calling [NONE, PAIRED, LINKED]")
@@ -627,6 +646,11 @@ OptionMap parse_options(const int argc, const char** argv)
      po::value<NormalContaminationRisk>()->default_value(NormalContaminationRisk::low),
      "Risk that the normal sample is contaminated by the tumour [LOW, HIGH]")
     
+    ("germline-dominance-margin",
+     po::value<float>(),
+     "Skip the somatic and noise models when the germline model log posterior exceeds the CNV model's by at least"
+     " this margin")
+    
     ("somatics-only",
      po::bool_switch()->default_value(false),
      "Only emit SOMATIC mutations")
@@ -734,6 +758,10 @@ OptionMap parse_options(const int argc, const char** argv)
     ("keep-unfiltered-calls",
      po::bool_switch()->default_value(false),
      "Keep a copy of unfiltered calls")
+    
+    ("fused-call-filtering",
+     po::bool_switch()->default_value(false),
+     "Filter calls as each calling task finishes, using the reads fetched for calling, rather than in a separate pass")
      
     ("annotations",
      po::value<std::vector<std::string>>()->multitoken()->implicit_value(std::vector<std::string> {"active"}, "active")->composing(),
@@ -1137,7 +1165,7 @@ po::parsed_options run(po::command_line_parser& parser)
 void validate(const OptionMap& vm)
 {
     const std::vector<std::string> positive_int_options {
-        "threads", "mask-low-quality-tails", "mask-tails", "soft-clip-mask-threshold", "mask-soft-clipped-boundary-bases",
+        "threads", "io-threads", "mask-low-quality-tails", "mask-tails", "soft-clip-mask-threshold", "mask-soft-clipped-boundary-bases",
         "min-mapping-quality", "good-base-quality", "min-good-bases", "min-read-length",
         "max-read-length", "min-base-quality", "max-variant-size",
         "num-fallback-kmers", "max-assemble-region-overlap", "assembler-mask-base-quality",
@@ -1147,7 +1175,7 @@ void validate(const OptionMap& vm)
         "max-open-read-files", "downsample-above", "downsample-target", "min-supporting-reads",
         "max-region-to-assemble", "fallback-kmer-gap", "organism-ploidy",
         "max-haplotypes", "haplotype-holdout-threshold", "haplotype-overflow",
-        "max-genotypes", "max-genotype-combinations", "max-somatic-haplotypes", "max-clones",
+        "max-genotypes", "max-genotype-combinations", "sample-block-size", "max-somatic-haplotypes", "max-clones",
         "max-vb-seeds", "max-indel-errors", "max-base-quality", "max-phylogeny-size"
     };
     const std::vector<std::string> probability_options {
@@ -1158,6 +1186,8 @@ void validate(const OptionMap& vm)
     };
     conflicting_options(vm, "maternal-sample", "normal-sample");
     conflicting_options(vm, "paternal-sample", "normal-sample");
+    conflicting_options(vm, "fused-call-filtering", "keep-unfiltered-calls");
+    conflicting_options(vm, "fused-call-filtering", "filter-vcf");
     for (const auto& option : positive_int_options) {
         check_positive(option, vm);
     }
@@ -93,6 +93,8 @@ public:
     iterator insert(const_iterator, MappableType&& mappable);
     template <typename InputIterator>
     void insert(InputIterator, InputIterator);
+    template <typename InputIterator>
+    void insert(ForwardSortedTag, InputIterator, InputIterator); // merges rather than sorts
     iterator insert(std::initializer_list<MappableType>);
     iterator erase(const_iterator);
     size_type erase(const MappableType&);
@@ -453,6 +455,20 @@ MappableFlatMultiSet<MappableType, Allocator>::insert(InputIterator first, Input
     }
 }
 
+template <typename MappableType, typename Allocator>
+template <typename InputIterator>
+void
+MappableFlatMultiSet<MappableType, Allocator>::insert(ForwardSortedTag, InputIterator first, InputIterator last)
+{
+    if (first != last) {
+        max_element_size_ = std::max(max_element_size_, region_size(*largest_mappable(first, last)));
+        elements_.insert(boost::container::ordered_range_t {}, first, last);
+        if (is_bidirectionally_sorted_) {
+            is_bidirectionally_sorted_ = is_bidirectionally_sorted(elements_);
+        }
+    }
+}
+
 template <typename MappableType, typename Allocator>
 typename MappableFlatMultiSet<MappableType, Allocator>::iterator
 MappableFlatMultiSet<MappableType, Allocator>::insert(std::initializer_list<MappableType> il)
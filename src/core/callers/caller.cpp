@@ -25,6 +25,7 @@
 #include "utils/read_stats.hpp"
 #include "utils/maths.hpp"
 #include "utils/append.hpp"
+#include "utils/memory_arena.hpp"
 
 #include "basics/aligned_template.hpp"
 
@@ -43,6 +44,7 @@ Caller::Caller(Components&& components, Parameters parameters)
 , likelihood_model_ {std::move(components.likelihood_model)}
 , phaser_ {std::move(components.phaser)}
 , bad_region_detector_ {std::move(components.bad_region_detector)}
+, likelihood_workers_ {components.likelihood_workers}
 , parameters_ {std::move(parameters)}
 {
     if (parameters_.max_haplotypes == 0) {
@@ -146,10 +148,50 @@ auto convert_to_vcf(std::deque<CallWrapper>&& calls, const VcfRecordFactory& fac
 
 std::deque<VcfRecord> Caller::call(const GenomicRegion& call_region, ProgressMeter& progress_meter) const
 {
-    ReadPipe::Report reads_report {};
     ReadMap reads;
+    return call(call_region, progress_meter, reads);
+}
+
+std::deque<VcfRecord> Caller::call(const GenomicRegion& call_region, ProgressMeter& progress_meter, ReadMap& reads) const
+{
+    return call(call_region, progress_meter, reads, boost::none);
+}
+
+Caller::PrefetchedReads Caller::prefetch_reads(const GenomicRegion& call_region) const
+{
+    PrefetchedReads result {call_region, {}, {}};
+    const auto read_region = candidate_generator_.requires_reads() ? expand(call_region, 100) : call_region;
+    result.reads = read_pipe_.get().fetch_reads(read_region, result.report);
+    return result;
+}
+
+std::deque<VcfRecord> Caller::call(const GenomicRegion& call_region, ProgressMeter& progress_meter,
+                                   PrefetchedReads prefetched) const
+{
+    ReadMap reads;
+    return call(call_region, progress_meter, std::move(prefetched), reads);
+}
+
+std::deque<VcfRecord> Caller::call(const GenomicRegion& call_region, ProgressMeter& progress_meter,
+                                   PrefetchedReads prefetched, ReadMap& reads) const
+{
+    if (prefetched.call_region != call_region) {
+        throw std::invalid_argument {"Caller: prefetched reads are for a different call region"};
+    }
+    return call(call_region, progress_meter, reads, prefetched);
+}
+
+std::deque<VcfRecord> Caller::call(const GenomicRegion& call_region, ProgressMeter& progress_meter, ReadMap& reads,
+                                   boost::optional<PrefetchedReads&> prefetched) const
+{
+    ReadPipe::Report reads_report {};
+    reads.clear();
+    if (prefetched) {
+        reads = std::move(prefetched->reads);
+        reads_report = std::move(prefetched->report);
+    }
     if (candidate_generator_.requires_reads()) {
-        reads = read_pipe_.get().fetch_reads(expand(call_region, 100), reads_report);
+        if (!prefetched) reads = read_pipe_.get().fetch_reads(expand(call_region, 100), reads_report);
         add_reads(reads, candidate_generator_);
         if (!refcalls_requested() && all_empty(reads)) {
             if (debug_log_) stream(*debug_log_) << "Stopping early as no reads found in call region " << call_region;
@@ -164,7 +206,7 @@ std::deque<VcfRecord> Caller::call(const GenomicRegion& call_region, ProgressMet
         progress_meter.log_completed(call_region);
         return {};
     }
-    if (!candidate_generator_.requires_reads()) {
+    if (!candidate_generator_.requires_reads() && !prefetched) {
         // as we didn't fetch them earlier
         reads = read_pipe_.get().fetch_reads(call_region, reads_report);
     }
@@ -402,6 +444,16 @@ Caller::call_variants(const GenomicRegion& call_region,
                       ProgressMeter& progress_meter) const
 {
     auto haplotype_likelihoods = make_haplotype_likelihood_cache();
+    // Lagging and backtracking mean many reads are re-evaluated against the same haplotypes in
+    // consecutive active regions, so keep PairHMM results for the whole call region.
+    ReadLikelihoodCache read_likelihood_cache {parameters_.max_likelihood_cache_size};
+    if (read_likelihood_cache.capacity() > 0) {
+        haplotype_likelihoods.set_cache(std::addressof(read_likelihood_cache));
+    }
+    // Working memory that only lives for one active region comes from here rather than the heap,
+    // which avoids contention in malloc between calling threads.
+    MemoryArena arena {};
+    haplotype_likelihoods.set_arena(std::addressof(arena));
     std::deque<CallWrapper> result {};
     if (candidates.empty()) {
         if (refcalls_requested()) {
@@ -427,6 +479,7 @@ Caller::call_variants(const GenomicRegion& call_region,
     std::deque<Haplotype> protected_haplotypes {};
     boost::variant<ReadMap, TemplateMap> active_reads;
     while (true) {
+        arena.reset();
         status = generate_active_haplotypes(call_region, haplotype_generator, active_region, next_active_region,
                                             haplotypes, next_haplotypes, backtrack_region);
         if (status == GeneratorStatus::done) {
@@ -513,6 +566,18 @@ Caller::call_variants(const GenomicRegion& call_region,
         haplotype_likelihoods.clear();
         progress_meter.log_completed(completed_region);
     }
+    if (debug_log_ && read_likelihood_cache.capacity() > 0) {
+        const auto cache_stats = read_likelihood_cache.stats();
+        stream(*debug_log_) << "Read likelihood cache hit rate in " << call_region << " was "
+                            << 100 * read_likelihood_cache.hit_rate() << "% ("
+                            << cache_stats.hits << " hits, " << cache_stats.misses << " misses)";
+    }
+    if (debug_log_) {
+        const auto arena_stats = arena.stats();
+        stream(*debug_log_) << "Memory arena served " << arena_stats.num_allocations << " allocations in " << call_region
+                            << " from " << arena_stats.num_blocks << " blocks (" << arena_stats.capacity << " bytes, peak usage "
+                            << arena_stats.peak_usage << " bytes)";
+    }
     return result;
 }
 
@@ -531,6 +596,11 @@ ExecutionPolicy Caller::exucution_policy() const noexcept
     return parameters_.execution_policy;
 }
 
+ThreadPool* Caller::likelihood_workers() const noexcept
+{
+    return likelihood_workers_;
+}
+
 Caller::GeneratorStatus
 Caller::generate_active_haplotypes(const GenomicRegion& call_region,
                                    HaplotypeGenerator& haplotype_generator,
@@ -1065,7 +1135,9 @@ Caller::make_haplotype_generator(const MappableFlatSet<Variant>& candidates,
 
 HaplotypeLikelihoodArray Caller::make_haplotype_likelihood_cache() const
 {
-    return HaplotypeLikelihoodArray {likelihood_model_, parameters_.max_haplotypes, samples_};
+    HaplotypeLikelihoodArray result {likelihood_model_, parameters_.max_haplotypes, samples_};
+    result.set_workers(likelihood_workers_);
+    return result;
 }
 
 VcfRecordFactory Caller::make_record_factory(const ReadMap& reads) const
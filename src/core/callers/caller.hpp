@@ -39,6 +39,7 @@ class Call;
 struct CallWrapper;
 class VariantCall;
 class ReferenceCall;
+class ThreadPool;
 
 class Caller
 {
@@ -57,6 +58,7 @@ public:
         HaplotypeLikelihoodModel likelihood_model;
         Phaser phaser;
         boost::optional<BadRegionDetector> bad_region_detector = boost::none;
+        ThreadPool* likelihood_workers = nullptr;
     };
     
     struct Parameters
@@ -71,10 +73,19 @@ public:
         boost::optional<MemoryFootprint> target_max_memory;
         ExecutionPolicy execution_policy;
         ReadLinkageType read_linkage;
+        std::size_t max_likelihood_cache_size; // read likelihoods reused across active regions, 0 disables
     };
     
     using ReadMap = octopus::ReadMap;
     
+    // Reads fetched ahead of calling, e.g. while another region is being called
+    struct PrefetchedReads
+    {
+        GenomicRegion call_region;
+        ReadMap reads;
+        ReadPipe::Report report;
+    };
+    
     Caller() = delete;
     
     Caller(Components&& components, Parameters parameters);
@@ -94,6 +105,15 @@ public:
     unsigned max_callable_ploidy() const;
     
     std::deque<VcfRecord> call(const GenomicRegion& call_region, ProgressMeter& progress_meter) const;
+    // As above, but the reads used for calling, which overlap call_region, are returned in reads
+    std::deque<VcfRecord> call(const GenomicRegion& call_region, ProgressMeter& progress_meter, ReadMap& reads) const;
+    
+    // Fetches the reads that call needs for call_region. Safe to use concurrently with call.
+    PrefetchedReads prefetch_reads(const GenomicRegion& call_region) const;
+    // As above, but using reads returned by prefetch_reads for the same call_region
+    std::deque<VcfRecord> call(const GenomicRegion& call_region, ProgressMeter& progress_meter, PrefetchedReads prefetched) const;
+    std::deque<VcfRecord> call(const GenomicRegion& call_region, ProgressMeter& progress_meter, PrefetchedReads prefetched,
+                               ReadMap& reads) const;
     
     std::vector<VcfRecord> regenotype(const std::vector<Variant>& variants, ProgressMeter& progress_meter) const;
     
@@ -133,6 +153,7 @@ private:
     HaplotypeLikelihoodModel likelihood_model_;
     Phaser phaser_;
     boost::optional<BadRegionDetector> bad_region_detector_;
+    ThreadPool* likelihood_workers_;
     Parameters parameters_;
     
     // virtual methods
@@ -149,6 +170,7 @@ protected:
     
     boost::optional<MemoryFootprint> target_max_memory() const noexcept;
     ExecutionPolicy exucution_policy() const noexcept;
+    ThreadPool* likelihood_workers() const noexcept;
 
 private:
     virtual std::unique_ptr<Latents>
@@ -171,6 +193,8 @@ private:
     
     // helper methods
     
+    std::deque<VcfRecord> call(const GenomicRegion& call_region, ProgressMeter& progress_meter, ReadMap& reads,
+                               boost::optional<PrefetchedReads&> prefetched) const;
     boost::optional<TemplateMap> make_read_templates(const ReadMap& reads) const;
     std::deque<CallWrapper>
     call_variants(const GenomicRegion& call_region,
@@ -27,6 +27,7 @@ CallerBuilder::CallerBuilder(const ReferenceGenome& reference, const ReadPipe& r
     params_.general.haplotype_extension_threshold = 1e-10;
     params_.general.saturation_limit = 0.9;
     params_.general.max_haplotypes = 200;
+    params_.general.max_likelihood_cache_size = 100'000;
     factory_ = generate_factory();
 }
 
@@ -141,6 +142,12 @@ CallerBuilder& CallerBuilder::set_read_linkage(ReadLinkageType linkage) noexcept
     return *this;
 }
 
+CallerBuilder& CallerBuilder::set_max_likelihood_cache_size(std::size_t n) noexcept
+{
+    params_.general.max_likelihood_cache_size = n;
+    return *this;
+}
+
 CallerBuilder& CallerBuilder::set_bad_region_detector(BadRegionDetector detector) noexcept
 {
     components_.bad_region_detector = std::move(detector);
@@ -207,6 +214,18 @@ CallerBuilder& CallerBuilder::set_max_genotype_combinations(boost::optional<std:
     return *this;
 }
 
+CallerBuilder& CallerBuilder::set_sample_block_size(boost::optional<std::size_t> size) noexcept
+{
+    params_.sample_block_size = size;
+    return *this;
+}
+
+CallerBuilder& CallerBuilder::set_likelihood_workers(ThreadPool* workers) noexcept
+{
+    components_.likelihood_workers = workers;
+    return *this;
+}
+
 CallerBuilder& CallerBuilder::set_likelihood_model(HaplotypeLikelihoodModel model) noexcept
 {
     components_.likelihood_model = std::move(model);
@@ -299,6 +318,12 @@ CallerBuilder& CallerBuilder::set_normal_contamination_risk(NormalContaminationR
     return *this;
 }
 
+CallerBuilder& CallerBuilder::set_germline_dominance_margin(boost::optional<double> margin) noexcept
+{
+    params_.germline_dominance_margin = margin;
+    return *this;
+}
+
 CallerBuilder& CallerBuilder::set_trio(Trio trio)
 {
     params_.trio = std::move(trio);
@@ -397,7 +422,8 @@ Caller::Components CallerBuilder::make_components() const
         components_.haplotype_generator_builder,
         components_.likelihood_model,
         Phaser {Phaser::Config {Phaser::GenotypeMatchType::exact, params_.min_phase_score}},
-        components_.bad_region_detector
+        components_.bad_region_detector,
+        components_.likelihood_workers
     };
 }
 
@@ -470,6 +496,7 @@ CallerBuilder::CallerFactoryMap CallerBuilder::generate_factory() const
                                                           get_ploidies(samples, *requested_contig_, params_.ploidies),
                                                           make_population_prior_model(params_.snp_heterozygosity, params_.indel_heterozygosity),
                                                           params_.max_genotype_combinations,
+                                                          params_.sample_block_size,
                                                           params_.use_independent_genotype_priors,
                                                           params_.deduplicate_haplotypes_with_caller_model
                                                       });
@@ -497,6 +524,7 @@ CallerBuilder::CallerFactoryMap CallerBuilder::generate_factory() const
                 params_.max_vb_seeds
             };
             cancer_params.concentrations.somatic.tumour_germline = params_.tumour_germline_concentration;
+            cancer_params.germline_dominance_margin = params_.germline_dominance_margin;
             return std::make_unique<CancerCaller>(make_components(), params_.general, std::move(cancer_params));
         }},
         {"trio", [this] () {
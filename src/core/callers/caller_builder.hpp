@@ -56,7 +56,9 @@ public:
     CallerBuilder& set_target_memory_footprint(MemoryFootprint memory) noexcept;
     CallerBuilder& set_execution_policy(ExecutionPolicy policy) noexcept;
     CallerBuilder& set_read_linkage(ReadLinkageType linkage) noexcept;
+    CallerBuilder& set_max_likelihood_cache_size(std::size_t n) noexcept;
     CallerBuilder& set_bad_region_detector(BadRegionDetector detector) noexcept;
+    CallerBuilder& set_likelihood_workers(ThreadPool* workers) noexcept;
     
     CallerBuilder& set_min_variant_posterior(Phred<double> posterior) noexcept;
     CallerBuilder& set_min_refcall_posterior(Phred<double> posterior) noexcept;
@@ -68,6 +70,7 @@ public:
     CallerBuilder& set_indel_heterozygosity(double heterozygosity) noexcept;
     CallerBuilder& set_max_genotypes(boost::optional<std::size_t> max) noexcept;
     CallerBuilder& set_max_genotype_combinations(boost::optional<std::size_t> max) noexcept;
+    CallerBuilder& set_sample_block_size(boost::optional<std::size_t> size) noexcept;
     CallerBuilder& set_likelihood_model(HaplotypeLikelihoodModel model) noexcept;
     CallerBuilder& set_model_based_haplotype_dedup(bool use) noexcept;
     CallerBuilder& set_independent_genotype_prior_flag(bool use_independent) noexcept;
@@ -85,6 +88,7 @@ public:
     CallerBuilder& set_tumour_germline_concentration(double concentration) noexcept;
     CallerBuilder& set_min_somatic_posterior(Phred<double> posterior) noexcept;
     CallerBuilder& set_normal_contamination_risk(NormalContaminationRisk risk) noexcept;
+    CallerBuilder& set_germline_dominance_margin(boost::optional<double> margin) noexcept;
     
     // trio
     CallerBuilder& set_trio(Trio trio);
@@ -120,6 +124,7 @@ private:
         HaplotypeLikelihoodModel likelihood_model;
         Phaser phaser;
         boost::optional<BadRegionDetector> bad_region_detector = boost::none;
+        ThreadPool* likelihood_workers = nullptr;
     };
     
     struct Parameters
@@ -131,6 +136,7 @@ private:
         boost::optional<double> snp_heterozygosity, indel_heterozygosity;
         Phred<double> min_phase_score;
         boost::optional<std::size_t> max_genotypes, max_genotype_combinations;
+        boost::optional<std::size_t> sample_block_size;
         bool deduplicate_haplotypes_with_caller_model;
         bool use_independent_genotype_priors;
         boost::optional<unsigned> max_vb_seeds;
@@ -145,6 +151,7 @@ private:
         double tumour_germline_concentration;
         Phred<double> min_somatic_posterior;
         NormalContaminationRisk normal_contamination_risk;
+        boost::optional<double> germline_dominance_margin;
         bool call_somatics_only;
         
         // trio
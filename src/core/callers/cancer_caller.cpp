@@ -11,6 +11,7 @@
 #include <deque>
 #include <unordered_set>
 #include <stdexcept>
+#include <exception>
 #include <iostream>
 #include <limits>
 
@@ -33,6 +34,7 @@
 #include "utils/mappable_algorithms.hpp"
 #include "utils/maths.hpp"
 #include "utils/map_utils.hpp"
+#include "utils/thread_pool.hpp"
 #include "logging/logging.hpp"
 #include "core/types/calls/germline_variant_call.hpp"
 #include "core/types/calls/reference_call.hpp"
@@ -142,11 +144,15 @@ CancerCaller::infer_latents(const HaplotypeBlock& haplotypes,
     set_model_priors(*result);
     generate_germline_genotypes(*result, haplotypes);
     if (debug_log_) stream(*debug_log_) << "There are " << result->germline_genotypes_.size() << " candidate germline genotypes";
-    evaluate_germline_model(*result, haplotype_likelihoods);
-    evaluate_cnv_model(*result, haplotype_likelihoods);
+    evaluate_germline_and_cnv_models(*result, haplotype_likelihoods);
     if (haplotypes.size() > 1) {
-        fit_somatic_model(*result, haplotype_likelihoods);
-        evaluate_noise_model(*result, haplotype_likelihoods);
+        if (is_germline_model_dominant(*result)) {
+            if (debug_log_) stream(*debug_log_) << "Skipping somatic model as germline model is dominant";
+            result->somatic_model_inferences_.approx_log_evidence = -std::numeric_limits<double>::infinity();
+        } else {
+            fit_somatic_model(*result, haplotype_likelihoods);
+            evaluate_noise_model(*result, haplotype_likelihoods);
+        }
         set_model_posteriors(*result);
     }
     return result;
@@ -645,7 +651,7 @@ bool CancerCaller::has_high_normal_contamination_risk(const Latents& latents) co
 void CancerCaller::evaluate_germline_model(Latents& latents, const HaplotypeLikelihoodArray& haplotype_likelihoods) const
 {
     assert(!(latents.haplotypes_.get().empty() || latents.germline_genotypes_.empty()));
-    latents.germline_prior_model_ = make_germline_prior_model(latents.haplotypes_);
+    assert(latents.germline_prior_model_);
     latents.germline_model_ = std::make_unique<GermlineModel>(*latents.germline_prior_model_);
     const auto pooled_likelihoods = pool_likelihood(samples_,  latents.haplotypes_, haplotype_likelihoods);
     if (latents.germline_genotype_indices_) {
@@ -659,10 +665,11 @@ void CancerCaller::evaluate_germline_model(Latents& latents, const HaplotypeLike
     }
 }
 
-void CancerCaller::evaluate_cnv_model(Latents& latents, const HaplotypeLikelihoodArray& haplotype_likelihoods) const
+void CancerCaller::evaluate_cnv_model(Latents& latents, const GenotypePriorModel& germline_prior_model,
+                                      const HaplotypeLikelihoodArray& haplotype_likelihoods) const
 {
-    assert(!latents.germline_genotypes_.empty() && latents.germline_prior_model_);
-    auto cnv_model_priors = get_cnv_model_priors(*latents.germline_prior_model_);
+    assert(!latents.germline_genotypes_.empty());
+    auto cnv_model_priors = get_cnv_model_priors(germline_prior_model);
     CNVModel::AlgorithmParameters params {};
     if (parameters_.max_vb_seeds) params.max_seeds = *parameters_.max_vb_seeds;
     params.target_max_memory = this->target_max_memory();
@@ -677,6 +684,36 @@ void CancerCaller::evaluate_cnv_model(Latents& latents, const HaplotypeLikelihoo
     }
 }
 
+void CancerCaller::evaluate_germline_and_cnv_models(Latents& latents, const HaplotypeLikelihoodArray& haplotype_likelihoods) const
+{
+    latents.germline_prior_model_ = make_germline_prior_model(latents.haplotypes_);
+    auto workers = this->likelihood_workers();
+    if (!workers || workers->empty()) {
+        evaluate_germline_model(latents, haplotype_likelihoods);
+        evaluate_cnv_model(latents, *latents.germline_prior_model_, haplotype_likelihoods);
+        return;
+    }
+    // The CNV model only needs the germline prior model, not the germline inferences, so it can be evaluated
+    // while the germline model is. The prior model caches are not thread safe so the CNV model gets its own.
+    // Only the CNV model primes haplotype_likelihoods; the germline model reads it by index when pooling samples.
+    auto cnv_prior_model = make_germline_prior_model(latents.haplotypes_);
+    if (latents.germline_genotype_indices_) cnv_prior_model->prime(latents.haplotypes_);
+    auto cnv_evaluation = workers->push([&] () { evaluate_cnv_model(latents, *cnv_prior_model, haplotype_likelihoods); });
+    std::exception_ptr error {};
+    try {
+        evaluate_germline_model(latents, haplotype_likelihoods);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    // The CNV evaluation references latents, so must finish before returning, even on error
+    try {
+        workers->wait(cnv_evaluation);
+    } catch (...) {
+        if (!error) error = std::current_exception();
+    }
+    if (error) std::rethrow_exception(error);
+}
+
 void CancerCaller::evaluate_somatic_model(Latents& latents, const HaplotypeLikelihoodArray& haplotype_likelihoods) const
 {
     assert(latents.germline_prior_model_ && !latents.cancer_genotypes_.empty());
@@ -737,6 +774,14 @@ void CancerCaller::set_model_priors(Latents& latents) const
     }
 }
 
+bool CancerCaller::is_germline_model_dominant(const Latents& latents) const
+{
+    if (!parameters_.germline_dominance_margin) return false;
+    const auto germline_model_jlp = std::log(latents.model_priors_.germline) + latents.germline_model_inferences_.log_evidence;
+    const auto cnv_model_jlp = std::log(latents.model_priors_.cnv) + latents.cnv_model_inferences_.approx_log_evidence;
+    return germline_model_jlp - cnv_model_jlp >= *parameters_.germline_dominance_margin;
+}
+
 void CancerCaller::set_model_posteriors(Latents& latents) const
 {
     const auto& germline_inferences = latents.germline_model_inferences_;
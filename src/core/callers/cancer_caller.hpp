@@ -67,6 +67,8 @@ public:
         bool deduplicate_haplotypes_with_germline_model = true;
         boost::optional<unsigned> max_vb_seeds = boost::none; // Use default if none
         Concentrations concentrations = Concentrations {};
+        // Skip the somatic and noise models if the germline model log joint probability exceeds the CNV model's by this
+        boost::optional<double> germline_dominance_margin = boost::none;
     };
     
     CancerCaller() = delete;
@@ -151,12 +153,15 @@ private:
     bool has_high_normal_contamination_risk(const Latents& latents) const;
     
     void evaluate_germline_model(Latents& latents, const HaplotypeLikelihoodArray& haplotype_likelihoods) const;
-    void evaluate_cnv_model(Latents& latents, const HaplotypeLikelihoodArray& haplotype_likelihoods) const;
+    void evaluate_cnv_model(Latents& latents, const GenotypePriorModel& germline_prior_model,
+                            const HaplotypeLikelihoodArray& haplotype_likelihoods) const;
+    void evaluate_germline_and_cnv_models(Latents& latents, const HaplotypeLikelihoodArray& haplotype_likelihoods) const;
     void evaluate_somatic_model(Latents& latents, const HaplotypeLikelihoodArray& haplotype_likelihoods) const;
     void evaluate_noise_model(Latents& latents, const HaplotypeLikelihoodArray& haplotype_likelihoods) const;
     
     void set_model_priors(Latents& latents) const;
     void set_model_posteriors(Latents& latents) const;
+    bool is_germline_model_dominant(const Latents& latents) const;
 
     void set_cancer_genotype_prior_model(Latents& latents) const;
     void fit_somatic_model(Latents& latents, const HaplotypeLikelihoodArray& haplotype_likelihoods) const;
@@ -754,7 +754,10 @@ PopulationCaller::infer_latents_with_joint_model(const HaplotypeBlock& haplotype
                                                  const HaplotypeLikelihoodArray& haplotype_likelihoods) const
 {
     const auto prior_model = make_joint_prior_model(haplotypes);
-    const model::PopulationModel model {*prior_model, {parameters_.max_genotype_combinations}, debug_log_};
+    model::PopulationModel::Options model_options {};
+    model_options.max_genotype_combinations = parameters_.max_genotype_combinations;
+    model_options.sample_block_size = parameters_.sample_block_size;
+    const model::PopulationModel model {*prior_model, model_options, debug_log_};
     if (unique_ploidies_.size() == 1) {
         prior_model->prime(haplotypes);
         std::vector<GenotypeIndex> genotype_indices;
@@ -39,6 +39,7 @@ public:
         std::vector<unsigned> ploidies;
         boost::optional<CoalescentModel::Parameters> prior_model_params;
         boost::optional<std::size_t> max_genotype_combinations;
+        boost::optional<std::size_t> sample_block_size;
         bool use_independent_genotype_priors = false;
         bool deduplicate_haplotypes_with_germline_model = true;
     };
@@ -9,12 +9,14 @@
 #include <algorithm>
 #include <functional>
 #include <exception>
+#include <thread>
 
 #include "config/config.hpp"
 #include "config/option_collation.hpp"
 #include "utils/map_utils.hpp"
 #include "logging/logging.hpp"
 #include "exceptions/user_error.hpp"
+#include "exceptions/malformed_file_error.hpp"
 
 namespace octopus {
 
@@ -22,16 +24,17 @@ namespace {
 
 namespace fs = boost::filesystem;
 
-VcfWriter make_vcf_writer(boost::optional<fs::path> dst)
+VcfWriter make_vcf_writer(boost::optional<fs::path> dst, HtslibThreadPool* thread_pool)
 {
-    return dst ? VcfWriter {std::move(*dst)} : VcfWriter {};
+    return dst ? VcfWriter {std::move(*dst), thread_pool} : VcfWriter {};
 }
 
 } // namespace
 
-GenomeCallingComponents::GenomeCallingComponents(ReferenceGenome&& reference, ReadManager&& read_manager,
+GenomeCallingComponents::GenomeCallingComponents(std::unique_ptr<HtslibThreadPool> htslib_thread_pool,
+                                                 ReferenceGenome&& reference, ReadManager&& read_manager,
                                                  VcfWriter&& output, const options::OptionMap& options)
-: components_ {std::move(reference), std::move(read_manager), std::move(output), options}
+: components_ {std::move(htslib_thread_pool), std::move(reference), std::move(read_manager), std::move(output), options}
 {}
 
 GenomeCallingComponents::GenomeCallingComponents(GenomeCallingComponents&& other) noexcept
@@ -110,6 +113,21 @@ boost::optional<unsigned> GenomeCallingComponents::num_threads() const noexcept
     return components_.num_threads;
 }
 
+ThreadPool* GenomeCallingComponents::thread_pool() noexcept
+{
+    return components_.thread_pool.get();
+}
+
+const ThreadPool* GenomeCallingComponents::thread_pool() const noexcept
+{
+    return components_.thread_pool.get();
+}
+
+HtslibThreadPool* GenomeCallingComponents::htslib_thread_pool() const noexcept
+{
+    return components_.htslib_thread_pool.get();
+}
+
 const HaplotypeLikelihoodModel& GenomeCallingComponents::haplotype_likelihood_model() const noexcept
 {
     return components_.haplotype_likelihood_model;
@@ -153,6 +171,25 @@ const ReadPipe& GenomeCallingComponents::filter_read_pipe() const noexcept
     return components_.filter_read_pipe ? *components_.filter_read_pipe : read_pipe();
 }
 
+bool GenomeCallingComponents::fused_call_filtering_requested() const noexcept
+{
+    return components_.fused_call_filtering;
+}
+
+void GenomeCallingComponents::set_fused_call_filter(FusedCallFilter filter)
+{
+    components_.fused_call_filter = std::move(filter);
+}
+
+boost::optional<const FusedCallFilter&> GenomeCallingComponents::fused_call_filter() const noexcept
+{
+    if (components_.fused_call_filter) {
+        return *components_.fused_call_filter; // convert to reference
+    } else {
+        return boost::none;
+    }
+}
+
 ProgressMeter& GenomeCallingComponents::progress_meter() noexcept
 {
     return components_.progress_meter;
@@ -368,10 +405,15 @@ void drop_unused_samples(std::vector<SampleName>& calling_samples, ReadManager&
     rm.drop_samples(unused_samples);
 }
 
+unsigned get_max_threads(const boost::optional<unsigned> num_threads)
+{
+    const auto num_cores = std::thread::hardware_concurrency();
+    return num_threads ? *num_threads : (num_cores > 0 ? num_cores : 8);
+}
+
 bool is_multithreaded_run(const options::OptionMap& options) noexcept
 {
-    const auto num_threads = options::get_num_threads(options);
-    return !num_threads || *num_threads > 1;
+    return get_max_threads(options::get_num_threads(options)) > 1;
 }
 
 bool is_stdout_output(const options::OptionMap& options)
@@ -562,11 +604,35 @@ boost::optional<const T&> optional_cref(const boost::optional<T>& v)
     }
 }
 
+// BGZF (de)compression and CRAM (de)coding are CPU bound, so htslib threads are taken out of the
+// thread budget rather than added to it. At least one thread is always left for calling.
+unsigned get_num_io_threads(const options::OptionMap& options)
+{
+    const auto max_threads = get_max_threads(options::get_num_threads(options));
+    if (max_threads < 2) return 0;
+    const auto num_io_threads = options::get_num_io_threads(options);
+    return std::min(num_io_threads ? *num_io_threads : max_threads / 4, max_threads - 1);
+}
+
+// All calling work, including nested work within calling tasks, runs on this pool, so its size is
+// the thread budget for the whole run less the htslib threads.
+std::unique_ptr<ThreadPool> make_thread_pool(const options::OptionMap& options)
+{
+    const auto max_threads = get_max_threads(options::get_num_threads(options));
+    if (max_threads > 1) {
+        return std::make_unique<ThreadPool>(max_threads - get_num_io_threads(options));
+    } else {
+        return nullptr;
+    }
+}
+
 } // namespace
 
-GenomeCallingComponents::Components::Components(ReferenceGenome&& reference, ReadManager&& read_manager,
+GenomeCallingComponents::Components::Components(std::unique_ptr<HtslibThreadPool> htslib_thread_pool,
+                                                ReferenceGenome&& reference, ReadManager&& read_manager,
                                                 VcfWriter&& output, const options::OptionMap& options)
-: reference {std::move(reference)}
+: htslib_thread_pool {std::move(htslib_thread_pool)}
+, reference {std::move(reference)}
 , read_manager {std::move(read_manager)}
 , samples {extract_samples(options, this->read_manager)}
 , regions {get_search_regions(options, this->reference, this->read_manager)}
@@ -580,17 +646,20 @@ GenomeCallingComponents::Components::Components(ReferenceGenome&& reference, Rea
 , output {std::move(output)}
 , filtered_output {}
 , num_threads {options::get_num_threads(options)}
+, thread_pool {make_thread_pool(options)}
 , read_buffer_footprint {options::get_target_read_buffer_size(options)}
 , read_buffer_size {}
 , progress_meter {regions}
 , pedigree {options::get_pedigree(options, samples)}
 , sites_only {options::call_sites_only(options)}
+, fused_call_filtering {options::use_fused_call_filtering(options)}
 , filter_request {}
 , bamout {options::bamout_request(options)}
 , bamout_config {}
 , data_profile {options::data_profile_request(options)}
 , profiler_config {}
 {
+    setup_read_coverage_index(options);
     drop_unused_samples(this->samples, this->read_manager);
     setup_progress_meter(options);
     set_read_buffer_size(options);
@@ -616,6 +685,7 @@ GenomeCallingComponents::Components::Components(ReferenceGenome&& reference, Rea
     bamout_config.max_buffer = read_buffer_footprint;
     bamout_config.max_threads = num_threads;
     bamout_config.read_linkage = options::get_read_linkage_type(options);
+    bamout_config.htslib_thread_pool = this->htslib_thread_pool.get();
     profiler_config.alignment_model = bamout_config.alignment_model;
     if (reads_profile && reads_profile->length_stats.median > 1'000) {
         profiler_config.ignore_likely_misaligned_reads = false;
@@ -634,6 +704,42 @@ void GenomeCallingComponents::Components::setup_progress_meter(const options::Op
     }
 }
 
+void GenomeCallingComponents::Components::setup_read_coverage_index(const options::OptionMap& options)
+{
+    const auto index_path = options::read_coverage_index_request(options);
+    if (!index_path || regions.empty()) return;
+    std::vector<GenomicRegion> contigs {};
+    contigs.reserve(regions.size());
+    for (const auto& p : regions) {
+        contigs.push_back(reference.contig_region(p.first));
+    }
+    const auto covers_inputs = [&] (const io::ReadCoverageIndex& index) {
+        return std::all_of(std::cbegin(contigs), std::cend(contigs),
+                           [&] (const auto& contig) { return index.is_indexed(read_manager.samples(), contig); });
+    };
+    io::ReadCoverageIndex index {};
+    if (fs::exists(*index_path)) {
+        try {
+            index = io::read_coverage_index(*index_path);
+        } catch (const MalformedFileError&) {
+            index = {}; // e.g. written by an older version, so is rebuilt below
+        }
+        if (!index.is_current(read_manager.paths()) || !covers_inputs(index)) {
+            logging::WarningLogger warn_log {};
+            stream(warn_log) << "Read coverage index " << *index_path
+                             << " is out of date with the input read files or does not cover all input samples and contigs so will be rebuilt";
+            index = {};
+        }
+    }
+    if (!covers_inputs(index)) {
+        logging::InfoLogger info_log {};
+        stream(info_log) << "Building read coverage index " << *index_path;
+        index = io::make_read_coverage_index(read_manager, contigs);
+        index.write(*index_path);
+    }
+    read_manager.set_coverage_index(std::make_shared<const io::ReadCoverageIndex>(std::move(index)));
+}
+
 void GenomeCallingComponents::Components::set_read_buffer_size(const options::OptionMap& options)
 {
     if (!samples.empty() && !regions.empty() && read_manager.good()) {
@@ -671,12 +777,14 @@ void GenomeCallingComponents::Components::setup_filter_read_pipe(const options::
 
 void GenomeCallingComponents::update_dependents() noexcept
 {
+    components_.read_manager.set_fetch_workers(components_.thread_pool.get());
     components_.read_pipe.set_read_manager(components_.read_manager);
     if (components_.filter_read_pipe) {
         components_.filter_read_pipe->set_read_manager(components_.read_manager);
     }
     components_.caller_factory.set_reference(components_.reference);
     components_.caller_factory.set_read_pipe(components_.read_pipe);
+    components_.caller_factory.set_likelihood_workers(components_.thread_pool.get());
 }
 
 namespace {
@@ -725,23 +833,36 @@ private:
     std::string reference_name_, why_;
 };
 
-VcfWriter make_output_vcf_writer(const options::OptionMap& options)
+VcfWriter make_output_vcf_writer(const options::OptionMap& options, HtslibThreadPool* thread_pool)
+{
+    return make_vcf_writer(options::get_output_path(options), thread_pool);
+}
+
+// BGZF and CRAM (de)compression for all input and output files runs on this pool
+std::unique_ptr<HtslibThreadPool> make_htslib_thread_pool(const options::OptionMap& options)
 {
-    return make_vcf_writer(options::get_output_path(options));
+    const auto num_io_threads = get_num_io_threads(options);
+    if (num_io_threads > 0) {
+        return std::make_unique<HtslibThreadPool>(num_io_threads);
+    } else {
+        return nullptr;
+    }
 }
 
 } // namespace
 
 GenomeCallingComponents collate_genome_calling_components(const options::OptionMap& options)
 {
+    auto htslib_thread_pool = make_htslib_thread_pool(options);
     auto reference    = options::make_reference(options);
-    auto read_manager = options::make_read_manager(options);
+    auto read_manager = options::make_read_manager(options, htslib_thread_pool.get());
     // Check this here to avoid creating output file on error
     if (!options::ignore_unmapped_contigs(options) && !all_reference_contigs_mapped(read_manager, reference)) {
         throw UnmatchedReference {reference};
     }
-    auto output = make_output_vcf_writer(options);
+    auto output = make_output_vcf_writer(options, htslib_thread_pool.get());
     return GenomeCallingComponents {
+        std::move(htslib_thread_pool),
         std::move(reference),
         std::move(read_manager),
         std::move(output),
@@ -787,6 +908,7 @@ ContigCallingComponents::ContigCallingComponents(const GenomicRegion::ContigName
 , read_buffer_size {genome_components.read_buffer_size()}
 , output {genome_components.output()}
 , progress_meter {genome_components.progress_meter()}
+, call_filter {genome_components.fused_call_filter()}
 {}
 
 ContigCallingComponents::ContigCallingComponents(const GenomicRegion::ContigName& contig, VcfWriter& output,
@@ -799,6 +921,7 @@ ContigCallingComponents::ContigCallingComponents(const GenomicRegion::ContigName
 , read_buffer_size {genome_components.read_buffer_size()}
 , output {output}
 , progress_meter {genome_components.progress_meter()}
+, call_filter {genome_components.fused_call_filter()}
 {}
 
 } // namespace octopus
@@ -17,6 +17,7 @@
 #include "basics/genomic_region.hpp"
 #include "basics/ploidy_map.hpp"
 #include "basics/pedigree.hpp"
+#include "io/htslib_thread_pool.hpp"
 #include "io/reference/reference_genome.hpp"
 #include "io/read/read_manager.hpp"
 #include "io/variant/vcf_writer.hpp"
@@ -27,11 +28,19 @@
 #include "core/tools/bam_realigner.hpp"
 #include "core/tools/indel_profiler.hpp"
 #include "utils/memory_footprint.hpp"
+#include "utils/thread_pool.hpp"
 #include "utils/input_reads_profiler.hpp"
 #include "logging/progress_meter.hpp"
 
 namespace octopus {
 
+// A streamable call filter that calling tasks apply to their own calls, and the header of the filtered output
+struct FusedCallFilter
+{
+    std::unique_ptr<const VariantCallFilter> filter;
+    VcfHeader output_header;
+};
+
 class GenomeCallingComponents
 {
 public:
@@ -39,7 +48,8 @@ public:
     
     GenomeCallingComponents() = delete;
     
-    GenomeCallingComponents(ReferenceGenome&& reference, ReadManager&& read_manager,
+    GenomeCallingComponents(std::unique_ptr<HtslibThreadPool> htslib_thread_pool,
+                            ReferenceGenome&& reference, ReadManager&& read_manager,
                             VcfWriter&& output, const options::OptionMap& options);
     
     GenomeCallingComponents(const GenomeCallingComponents&)            = delete;
@@ -63,6 +73,9 @@ public:
     std::size_t read_buffer_size() const noexcept;
     const boost::optional<Path>& temp_directory() const noexcept;
     boost::optional<unsigned> num_threads() const noexcept;
+    ThreadPool* thread_pool() noexcept;
+    const ThreadPool* thread_pool() const noexcept;
+    HtslibThreadPool* htslib_thread_pool() const noexcept;
     const HaplotypeLikelihoodModel& haplotype_likelihood_model() const noexcept;
     const CallerFactory& caller_factory() const noexcept;
     boost::optional<VcfWriter&> filtered_output() noexcept;
@@ -70,6 +83,9 @@ public:
     const VariantCallFilterFactory& call_filter_factory() const;
     ReadPipe& filter_read_pipe() noexcept;
     const ReadPipe& filter_read_pipe() const noexcept;
+    bool fused_call_filtering_requested() const noexcept;
+    void set_fused_call_filter(FusedCallFilter filter);
+    boost::optional<const FusedCallFilter&> fused_call_filter() const noexcept;
     ProgressMeter& progress_meter() noexcept;
     bool sites_only() const noexcept;
     const PloidyMap& ploidies() const noexcept;
@@ -86,7 +102,8 @@ private:
     {
         Components() = delete;
         
-        Components(ReferenceGenome&& reference, ReadManager&& read_manager,
+        Components(std::unique_ptr<HtslibThreadPool> htslib_thread_pool,
+                   ReferenceGenome&& reference, ReadManager&& read_manager,
                    VcfWriter&& output, const options::OptionMap& options);
         
         Components(const Components&)            = delete;
@@ -96,6 +113,8 @@ private:
         
         ~Components() = default;
         
+        // Declared first so it outlives every file attached to it
+        std::unique_ptr<HtslibThreadPool> htslib_thread_pool;
         ReferenceGenome reference;
         ReadManager read_manager;
         std::vector<SampleName> samples;
@@ -110,11 +129,13 @@ private:
         VcfWriter output;
         boost::optional<VcfWriter> filtered_output;
         boost::optional<unsigned> num_threads;
+        std::unique_ptr<ThreadPool> thread_pool;
         MemoryFootprint read_buffer_footprint;
         std::size_t read_buffer_size;
         ProgressMeter progress_meter;
         boost::optional<Pedigree> pedigree;
         bool sites_only;
+        bool fused_call_filtering;
         boost::optional<Path> filter_request;
         boost::optional<Path> bamout;
         BAMRealigner::Config bamout_config;
@@ -125,11 +146,13 @@ private:
         // exception handling easier.
         boost::optional<Path> temp_directory;
         std::unique_ptr<VariantCallFilterFactory> call_filter_factory;
+        boost::optional<FusedCallFilter> fused_call_filter;
         
         void setup_progress_meter(const options::OptionMap& options);
         void set_read_buffer_size(const options::OptionMap& options);
         void setup_writers(const options::OptionMap& options);
         void setup_filter_read_pipe(const options::OptionMap& options);
+        void setup_read_coverage_index(const options::OptionMap& options);
     };
     
     Components components_;
@@ -153,6 +176,7 @@ struct ContigCallingComponents
     std::size_t read_buffer_size;
     std::reference_wrapper<VcfWriter> output;
     std::reference_wrapper<ProgressMeter> progress_meter;
+    boost::optional<const FusedCallFilter&> call_filter;
     
     ContigCallingComponents() = delete;
     
@@ -238,7 +238,7 @@ FacetFactory::make(const std::vector<std::string>& names,
             }));
         }
         for (auto& fut : futures) {
-            result.push_back(fut.get());
+            result.push_back(workers.wait(fut));
         }
     } else {
         for (const auto& block : blocks) {
@@ -249,6 +249,40 @@ FacetFactory::make(const std::vector<std::string>& names,
     return result;
 }
 
+std::vector<FacetFactory::FacetBlock>
+FacetFactory::make(const std::vector<std::string>& names,
+                   const std::vector<CallBlock>& blocks,
+                   const ReadMap& reads,
+                   const GenomicRegion& reads_region) const
+{
+    if (blocks.empty()) return {};
+    check_requirements(names);
+    std::vector<FacetBlock> result {};
+    result.reserve(blocks.size());
+    const auto copy_reads = requires_reads(names);
+    const auto extract_block_genotypes = requires_genotypes(names);
+    for (const auto& block : blocks) {
+        BlockData data {};
+        data.calls = std::addressof(block);
+        if (!block.empty()) {
+            data.region = encompassing_region(block);
+            if (copy_reads) {
+                if (contains(reads_region, *data.region)) {
+                    data.reads = copy_overlapped(reads, *data.region);
+                } else {
+                    // The buffered pipe is not thread safe, so go straight to the source
+                    data.reads = read_pipe_->source().fetch_reads(*data.region);
+                }
+            }
+            if (extract_block_genotypes) {
+                data.genotypes = extract_genotypes(block, samples_, *reference_);
+            }
+        }
+        result.push_back(make(names, data));
+    }
+    return result;
+}
+
 // private methods
 
 void FacetFactory::setup_facet_makers()
@@ -56,6 +56,9 @@ public:
     FacetWrapper make(const std::string& name, const CallBlock& block) const;
     FacetBlock make(const std::vector<std::string>& names, const CallBlock& block) const;
     std::vector<FacetBlock> make(const std::vector<std::string>& names, const std::vector<CallBlock>& blocks, ThreadPool& workers) const;
+    // Reads for blocks contained by reads_region are copied from reads rather than fetched. Safe to call concurrently.
+    std::vector<FacetBlock> make(const std::vector<std::string>& names, const std::vector<CallBlock>& blocks,
+                                 const ReadMap& reads, const GenomicRegion& reads_region) const;
 
 private:
     struct BlockData
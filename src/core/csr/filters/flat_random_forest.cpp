@@ -0,0 +1,213 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include "flat_random_forest.hpp"
+
+#include <deque>
+#include <fstream>
+#include <algorithm>
+#include <iterator>
+#include <future>
+#include <utility>
+#include <cmath>
+#include <stdexcept>
+#include <cassert>
+
+#include "ranger/Forest.h"
+#include "ranger/utility.h"
+#include "ranger/globals.h"
+
+namespace octopus { namespace csr {
+
+namespace {
+
+void check_forest(const bool ok, const FlatRandomForest::Path& path)
+{
+    if (!ok) {
+        throw std::runtime_error {"FlatRandomForest: " + path.string() + " is not a valid ranger probability forest"};
+    }
+}
+
+} // namespace
+
+FlatRandomForest::FlatRandomForest(const Path& ranger_forest)
+{
+    std::ifstream file {ranger_forest.string(), std::ios::binary};
+    check_forest(file.good(), ranger_forest);
+    ranger::Forest::MetaInfo meta {};
+    ranger::read_meta(file, meta);
+    ranger::TreeType tree_type;
+    file.read(reinterpret_cast<char*>(&tree_type), sizeof(tree_type));
+    check_forest(file && tree_type == ranger::TREE_PROBABILITY && meta.num_trees > 0, ranger_forest);
+    ranger::readVector1D(class_values_, file);
+    variable_names_ = std::move(meta.independent_variable_names);
+    is_ordered_ = std::move(meta.ordered_variable_indicators);
+    is_ordered_.resize(variable_names_.size(), true);
+    const auto num_classes = class_values_.size();
+    roots_.reserve(meta.num_trees);
+    for (std::size_t tree_idx {0}; tree_idx < meta.num_trees; ++tree_idx) {
+        std::vector<std::vector<std::size_t>> child_node_ids;
+        ranger::readVector2D(child_node_ids, file);
+        std::vector<std::size_t> split_variables;
+        ranger::readVector1D(split_variables, file);
+        std::vector<double> split_values;
+        ranger::readVector1D(split_values, file);
+        std::vector<std::size_t> terminal_nodes;
+        ranger::readVector1D(terminal_nodes, file);
+        std::vector<std::vector<double>> terminal_class_counts;
+        ranger::readVector2D(terminal_class_counts, file);
+        check_forest(file && child_node_ids.size() == 2, ranger_forest);
+        const auto num_nodes = split_variables.size();
+        check_forest(num_nodes > 0 && child_node_ids[0].size() == num_nodes && child_node_ids[1].size() == num_nodes
+                     && split_values.size() == num_nodes && terminal_nodes.size() == terminal_class_counts.size(),
+                     ranger_forest);
+        std::vector<const std::vector<double>*> leaf_counts(num_nodes, nullptr);
+        for (std::size_t i {0}; i < terminal_nodes.size(); ++i) {
+            check_forest(terminal_nodes[i] < num_nodes && terminal_class_counts[i].size() == num_classes, ranger_forest);
+            leaf_counts[terminal_nodes[i]] = &terminal_class_counts[i];
+        }
+        // Breadth first, so the top of every tree is packed together and siblings are adjacent
+        const auto root = static_cast<std::uint32_t>(nodes_.size());
+        roots_.push_back(root);
+        nodes_.emplace_back();
+        std::deque<std::pair<std::size_t, std::uint32_t>> pending {{0, root}};
+        while (!pending.empty()) {
+            const auto ranger_id = pending.front().first;
+            const auto idx = pending.front().second;
+            pending.pop_front();
+            const auto left = child_node_ids[0][ranger_id], right = child_node_ids[1][ranger_id];
+            if (left == 0 && right == 0) {
+                check_forest(leaf_counts[ranger_id] != nullptr, ranger_forest);
+                nodes_[idx] = {0, static_cast<std::uint32_t>(leaf_probabilities_.size()), 0};
+                leaf_probabilities_.insert(std::cend(leaf_probabilities_),
+                                           std::cbegin(*leaf_counts[ranger_id]), std::cend(*leaf_counts[ranger_id]));
+            } else {
+                check_forest(left < num_nodes && right < num_nodes && split_variables[ranger_id] < variable_names_.size()
+                             && nodes_.size() - root + 2 <= num_nodes, ranger_forest);
+                const auto left_idx = static_cast<std::uint32_t>(nodes_.size());
+                nodes_[idx] = {split_values[ranger_id], static_cast<std::uint32_t>(split_variables[ranger_id]), left_idx};
+                nodes_.resize(nodes_.size() + 2);
+                pending.emplace_back(left, left_idx);
+                pending.emplace_back(right, left_idx + 1);
+            }
+        }
+    }
+    nodes_.shrink_to_fit();
+    leaf_probabilities_.shrink_to_fit();
+}
+
+std::size_t FlatRandomForest::num_trees() const noexcept
+{
+    return roots_.size();
+}
+
+const std::vector<std::string>& FlatRandomForest::variable_names() const noexcept
+{
+    return variable_names_;
+}
+
+bool FlatRandomForest::has_class(const double class_value) const noexcept
+{
+    return std::find(std::cbegin(class_values_), std::cend(class_values_), class_value) != std::cend(class_values_);
+}
+
+namespace {
+
+void check_data(const FlatRandomForest::DataColumns& data, const std::size_t num_variables)
+{
+    if (data.size() != num_variables) {
+        throw std::invalid_argument {"FlatRandomForest: data has the wrong number of variables"};
+    }
+    if (!data.empty() && std::any_of(std::next(std::cbegin(data)), std::cend(data),
+                                     [&] (const auto& column) { return column.size() != data.front().size(); })) {
+        throw std::invalid_argument {"FlatRandomForest: data columns have different lengths"};
+    }
+}
+
+auto num_rows(const FlatRandomForest::DataColumns& data) noexcept
+{
+    return data.empty() ? std::size_t {0} : data.front().size();
+}
+
+} // namespace
+
+std::vector<double> FlatRandomForest::predict(const DataColumns& data, const double class_value) const
+{
+    check_data(data, variable_names_.size());
+    const auto class_idx = class_index(class_value);
+    std::vector<double> result(num_rows(data), 0.0);
+    predict(data, class_idx, 0, result.size(), result);
+    return result;
+}
+
+std::vector<double> FlatRandomForest::predict(const DataColumns& data, const double class_value, ThreadPool& workers) const
+{
+    if (workers.empty()) return predict(data, class_value);
+    check_data(data, variable_names_.size());
+    const auto class_idx = class_index(class_value);
+    std::vector<double> result(num_rows(data), 0.0);
+    const auto num_chunks = std::min(workers.size(), result.size());
+    if (num_chunks == 0) return result;
+    const auto chunk_size = (result.size() + num_chunks - 1) / num_chunks;
+    std::vector<std::future<void>> chunks {};
+    chunks.reserve(num_chunks);
+    for (std::size_t first_row {0}; first_row < result.size(); first_row += chunk_size) {
+        const auto last_row = std::min(first_row + chunk_size, result.size());
+        chunks.push_back(workers.push([&, first_row, last_row] () { predict(data, class_idx, first_row, last_row, result); }));
+    }
+    for (auto& chunk : chunks) workers.wait(chunk);
+    return result;
+}
+
+// private methods
+
+std::size_t FlatRandomForest::class_index(const double class_value) const
+{
+    const auto itr = std::find(std::cbegin(class_values_), std::cend(class_values_), class_value);
+    if (itr == std::cend(class_values_)) {
+        throw std::invalid_argument {"FlatRandomForest: unknown class"};
+    }
+    return std::distance(std::cbegin(class_values_), itr);
+}
+
+double FlatRandomForest::predict(const std::uint32_t root, const DataColumns& data, const std::size_t row,
+                                 const std::size_t class_idx) const noexcept
+{
+    const Node* node {&nodes_[root]};
+    while (node->left_child != 0) {
+        const auto value = data[node->variable][row];
+        bool go_left;
+        if (is_ordered_[node->variable]) {
+            go_left = value <= node->split_value;
+        } else {
+            // ranger encodes unordered splits as a bitset of the factor levels that go right
+            const auto factor_idx = static_cast<std::uint64_t>(std::floor(value) - 1);
+            const auto split_levels = static_cast<std::uint64_t>(std::floor(node->split_value));
+            go_left = !(split_levels & (1ULL << factor_idx));
+        }
+        node = &nodes_[go_left ? node->left_child : node->left_child + 1];
+    }
+    return leaf_probabilities_[node->variable + class_idx];
+}
+
+void FlatRandomForest::predict(const DataColumns& data, const std::size_t class_idx,
+                               const std::size_t first_row, const std::size_t last_row,
+                               std::vector<double>& result) const
+{
+    // Rows are processed in small blocks so the top of each tree stays in cache across rows
+    constexpr std::size_t rowBlockSize {64};
+    for (auto block_begin = first_row; block_begin < last_row; block_begin += rowBlockSize) {
+        const auto block_end = std::min(block_begin + rowBlockSize, last_row);
+        for (const auto root : roots_) {
+            for (auto row = block_begin; row < block_end; ++row) {
+                result[row] += predict(root, data, row, class_idx);
+            }
+        }
+        for (auto row = block_begin; row < block_end; ++row) {
+            result[row] /= roots_.size();
+        }
+    }
+}
+
+} // namespace csr
+} // namespace octopus
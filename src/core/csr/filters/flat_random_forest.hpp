@@ -0,0 +1,74 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef flat_random_forest_hpp
+#define flat_random_forest_hpp
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#include <boost/filesystem/path.hpp>
+
+#include "utils/thread_pool.hpp"
+
+namespace octopus { namespace csr {
+
+/*
+    FlatRandomForest is a read-only copy of a ranger probability forest for fast batch prediction.
+    All tree nodes are stored in one array, with sibling nodes next to each other so a branch is
+    a single offset, and the data to predict is given as columns so nothing needs to be written
+    to disk.
+ */
+class FlatRandomForest
+{
+public:
+    using Path = boost::filesystem::path;
+    // data[variable][row]
+    using DataColumns = std::vector<std::vector<double>>;
+
+    FlatRandomForest() = default;
+
+    FlatRandomForest(const Path& ranger_forest);
+
+    FlatRandomForest(const FlatRandomForest&)            = default;
+    FlatRandomForest& operator=(const FlatRandomForest&) = default;
+    FlatRandomForest(FlatRandomForest&&)                 = default;
+    FlatRandomForest& operator=(FlatRandomForest&&)      = default;
+
+    ~FlatRandomForest() = default;
+
+    std::size_t num_trees() const noexcept;
+    const std::vector<std::string>& variable_names() const noexcept;
+    bool has_class(double class_value) const noexcept;
+
+    // The forest probability that each row belongs to the given class
+    std::vector<double> predict(const DataColumns& data, double class_value) const;
+    std::vector<double> predict(const DataColumns& data, double class_value, ThreadPool& workers) const;
+
+private:
+    struct Node
+    {
+        double split_value;
+        std::uint32_t variable; // or the first class probability index for leaves
+        std::uint32_t left_child; // zero for leaves, the right child is always next to the left child
+    };
+
+    std::vector<std::string> variable_names_;
+    std::vector<bool> is_ordered_;
+    std::vector<double> class_values_;
+    std::vector<Node> nodes_;
+    std::vector<std::uint32_t> roots_;
+    std::vector<double> leaf_probabilities_;
+
+    std::size_t class_index(double class_value) const;
+    double predict(std::uint32_t root, const DataColumns& data, std::size_t row, std::size_t class_idx) const noexcept;
+    void predict(const DataColumns& data, std::size_t class_idx, std::size_t first_row, std::size_t last_row,
+                 std::vector<double>& result) const;
+};
+
+} // namespace csr
+} // namespace octopus
+
+#endif
@@ -16,7 +16,7 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/filesystem/operations.hpp>
 
-#include "ranger/ForestProbability.h"
+#include "ranger/Forest.h"
 
 #include "utils/concat.hpp"
 #include "utils/append.hpp"
@@ -113,6 +113,35 @@ auto concat(const std::vector<std::vector<MeasureWrapper>>& measures)
 
 } // namespace
 
+class MalformedForestFile : public MalformedFileError
+{
+    std::string do_where() const override { return "RandomForestFilter"; }
+    std::string do_help() const override
+    {
+        return "make sure the forest was trained with the same measures and in the same order as the prediction measures";
+    }
+public:
+    MalformedForestFile(boost::filesystem::path file) : MalformedFileError {std::move(file)} {}
+};
+
+namespace {
+
+auto load_forests(const std::vector<RandomForestFilter::Path>& forest_paths)
+{
+    std::vector<FlatRandomForest> result {};
+    result.reserve(forest_paths.size());
+    for (const auto& path : forest_paths) {
+        try {
+            result.emplace_back(path);
+        } catch (const std::runtime_error& e) {
+            throw MalformedForestFile {path};
+        }
+    }
+    return result;
+}
+
+} // namespace
+
 RandomForestFilter::RandomForestFilter(FacetFactory facet_factory,
                                        std::vector<std::vector<MeasureWrapper>> forest_measures,
                                        std::vector<MeasureWrapper> chooser_measures,
@@ -127,13 +156,13 @@ RandomForestFilter::RandomForestFilter(FacetFactory facet_factory,
                                concat(concat(forest_measures), chooser_measures),
                                std::move(output_config), threading, std::move(temp_directory), progress}
 , forest_paths_ {std::move(ranger_forests)}
+, forests_ {load_forests(forest_paths_)}
 , chooser_ {std::move(chooser)}
 , forest_measure_info_ {}
 , num_chooser_measures_ {chooser_measures.size()}
 , options_ {std::move(options)}
-, threading_ {threading}
 , num_records_ {0}
-, data_buffer_ {}
+, predictions_ {}
 {
     forest_measure_info_.reserve(ranger_forests.size());
     std::size_t index {0};
@@ -151,11 +180,6 @@ std::string RandomForestFilter::do_name() const
 const std::string RandomForestFilter::genotype_quality_name_ = "RFGQ";
 const std::string RandomForestFilter::call_quality_name_ = "RFGQ_ALL";
 
-std::unique_ptr<ranger::Forest> RandomForestFilter::make_forest() const
-{
-    return std::make_unique<ranger::ForestProbability>();
-}
-
 boost::optional<std::string> RandomForestFilter::genotype_quality_name() const
 {
     return genotype_quality_name_;
@@ -189,36 +213,14 @@ std::int8_t RandomForestFilter::choose_forest(const MeasureVector& measures) con
     return chooser_(chooser_measures);
 }
 
-template <typename T>
-static void write_line(const std::vector<T>& data, std::ostream& out)
-{
-    std::copy(std::cbegin(data), std::prev(std::cend(data)), std::ostream_iterator<T> {out, " "});
-    out << data.back() << '\n';
-}
-
 void RandomForestFilter::prepare_for_registration(const SampleList& samples) const
 {
-    const auto num_forests = forest_paths_.size();
+    const auto num_forests = forests_.size();
     data_.resize(num_forests);
     for (std::size_t forest_idx {0}; forest_idx < num_forests; ++forest_idx) {
         const auto& info = forest_measure_info_[forest_idx];
-        std::vector<std::string> data_header {};
-        const auto first_measure = std::next(std::cbegin(measures_), info.start_index);
-        data_header.reserve(info.number + 1);
-        std::transform(first_measure, std::next(first_measure, info.number),
-                       std::back_inserter(data_header), [] (const auto& measure) { return measure.name(); });
-        data_header.push_back("TP");
-        data_[forest_idx].reserve(samples.size());
-        for (const auto& sample : samples) {
-            auto data_path = temp_directory();
-            Path fname {"octopus_ranger_temp_forest_data_" + std::to_string(forest_idx) + "_" + sample + ".dat"};
-            data_path /= fname;
-            data_[forest_idx].emplace_back(data_path.string(), data_path);
-            write_line(data_header, data_[forest_idx].back().handle);
-        }
+        data_[forest_idx].assign(samples.size(), FlatRandomForest::DataColumns(info.number));
     }
-    data_buffer_.resize(num_forests);
-    for (auto& buffer : data_buffer_) buffer.resize(samples.size());
     choices_.resize(samples.size());
 }
 
@@ -279,36 +281,25 @@ class NanMeasure : public ProgramError
     std::string do_help() const override { return "submit an error report"; }
 };
 
-void check_nan(const std::vector<double>& values)
+double check_nan(const double value)
 {
-    if (std::any_of(std::cbegin(values), std::cend(values), [] (auto v) { return std::isnan(v); })) {
-        throw NanMeasure {};
-    }
+    if (std::isnan(value)) throw NanMeasure {};
+    return value;
 }
 
-void skip_lines(std::istream& in, int n = 1)
-{
-    for (; n > 0; --n) in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-}
-    
 } // namespace
 
 void RandomForestFilter::record(const std::size_t call_idx, std::size_t sample_idx, MeasureVector measures) const
 {
     assert(!measures.empty());
     const auto forest_idx = choose_forest(measures);
-    const auto num_forests = static_cast<std::remove_const_t<decltype(forest_idx)>>(data_buffer_.size());
+    const auto num_forests = static_cast<std::remove_const_t<decltype(forest_idx)>>(forests_.size());
     if (forest_idx >= 0 && forest_idx < num_forests) {
-        auto& buffer = data_buffer_[forest_idx][sample_idx];
+        auto& columns = data_[forest_idx][sample_idx];
         const auto& info = forest_measure_info_[forest_idx];
-        const auto first_measure = std::next(std::cbegin(measures), info.start_index);
-        buffer.reserve(info.number);
-        std::transform(first_measure, std::next(first_measure, info.number),
-                       std::back_inserter(buffer), cast_to_double);
-        buffer.push_back(0); // dummy TP value
-        check_nan(buffer);
-        write_line(buffer, data_[forest_idx][sample_idx].handle);
-        buffer.clear();
+        for (std::size_t i {0}; i < info.number; ++i) {
+            columns[i].push_back(check_nan(cast_to_double(measures[info.start_index + i])));
+        }
     } else {
         hard_filtered_record_indices_.push_back(call_idx);
     }
@@ -316,96 +307,38 @@ void RandomForestFilter::record(const std::size_t call_idx, std::size_t sample_i
     choices_[sample_idx].push_back(forest_idx);
 }
 
-void RandomForestFilter::close_data_files() const
-{
-    for (auto& forest : data_) {
-        for (auto& sample : forest) {
-            sample.handle.close();
-        }
-    }
-}
-
-namespace {
-
-bool read_header(std::ifstream& prediction_file)
-{
-    skip_lines(prediction_file);
-    std::string order;
-    std::getline(prediction_file, order);
-    skip_lines(prediction_file);
-    return order.front() == '1';
-}
-
-static double get_prob_false(std::string& prediction_line, const bool tp_first)
-{
-    using std::cbegin; using std::cend;
-    if (tp_first) {
-        prediction_line.erase(cbegin(prediction_line), std::next(std::find(cbegin(prediction_line), cend(prediction_line), ' ')));
-        prediction_line.erase(std::find(cbegin(prediction_line), cend(prediction_line), ' '), cend(prediction_line));
-    } else {
-        prediction_line.erase(std::find(cbegin(prediction_line), cend(prediction_line), ' '), cend(prediction_line));
-    }
-    return boost::lexical_cast<double>(prediction_line);
-}
-    
-} // namespace
-
-class MalformedForestFile : public MalformedFileError
-{
-    std::string do_where() const override { return "RandomForestFilter"; }
-    std::string do_help() const override
-    {
-        return "make sure the forest was trained with the same measures and in the same order as the prediction measures";
-    }
-public:
-    MalformedForestFile(boost::filesystem::path file) : MalformedFileError {std::move(file)} {}
-};
-
 void RandomForestFilter::prepare_for_classification(boost::optional<Log>& log) const
 {
-    close_data_files();
     if (num_records_ == 0) return;
-    const Path ranger_prefix {temp_directory() / "octopus_ranger_temp"};
-    const Path ranger_prediction_fname {ranger_prefix.string() + ".prediction"};
-    data_buffer_.resize(1);
-    auto& predictions = data_buffer_[0];
-    predictions.resize(num_records_);
     const auto num_samples = choices_.size();
-    for (std::size_t forest_idx {0}; forest_idx < forest_paths_.size(); ++forest_idx) {
+    predictions_.assign(num_records_, std::vector<double>(num_samples, 0.0));
+    for (std::size_t forest_idx {0}; forest_idx < forests_.size(); ++forest_idx) {
+        const auto& forest = forests_[forest_idx];
         for (std::size_t sample_idx {0}; sample_idx < num_samples; ++sample_idx) {
-            auto forest_choice_itr = std::find(std::cbegin(choices_[sample_idx]), std::cend(choices_[sample_idx]), forest_idx);
-            if (forest_choice_itr != std::cend(choices_[sample_idx])) {
-                const auto& file = data_[forest_idx][sample_idx];
-                std::vector<std::string> tmp {}, cat_vars {};
-                const auto ranger_threads = threading_.max_threads ? *threading_.max_threads : 1u;
-                const auto forest = make_forest();
-                try {
-                    forest->initCpp("", ranger::MemoryMode::MEM_DOUBLE, file.path.string(), 0, ranger_prefix.string(),
-                                    1000, nullptr, 12, ranger_threads, forest_paths_[forest_idx].string(), ranger::ImportanceMode::IMP_GINI, 1, "",
-                                    tmp, "", true, cat_vars, false, ranger::SplitRule::LOGRANK, "", false, 1.0,
-                                    ranger::DEFAULT_ALPHA, ranger::DEFAULT_MINPROP, false,
-                                    ranger::PredictionType::RESPONSE, ranger::DEFAULT_NUM_RANDOM_SPLITS, ranger::DEFAULT_MAXDEPTH);
-                } catch (const std::runtime_error& e) {
-                    throw MalformedForestFile {forest_paths_[forest_idx]};
-                }
-                forest->run(false, false);
-                forest->writePredictionFile();
-                std::ifstream prediction_file {ranger_prediction_fname.string()};
-                const auto tp_first = read_header(prediction_file);
-                std::string line;
-                while (std::getline(prediction_file, line)) {
-                    if (!line.empty()) {
-                        const auto record_idx = std::distance(std::cbegin(choices_[sample_idx]), forest_choice_itr);
-                        predictions[record_idx].push_back(get_prob_false(line, tp_first));
-                        assert(forest_choice_itr != std::cend(choices_[sample_idx]));
-                        forest_choice_itr = std::find(std::next(forest_choice_itr), std::cend(choices_[sample_idx]), forest_idx);
+            const auto& sample_choices = choices_[sample_idx];
+            if (std::find(std::cbegin(sample_choices), std::cend(sample_choices), forest_idx) == std::cend(sample_choices)) {
+                continue;
+            }
+            auto& sample_data = data_[forest_idx][sample_idx];
+            // Training data labels false calls 0, so a forest without that class never saw a false call
+            std::vector<double> probs_false {};
+            if (forest.has_class(0)) {
+                probs_false = forest.predict(sample_data, 0, workers());
+            }
+            // Rows are in the order of the records that chose this forest
+            std::size_t row_idx {0};
+            for (std::size_t record_idx {0}; record_idx < sample_choices.size(); ++record_idx) {
+                if (sample_choices[record_idx] == static_cast<std::int8_t>(forest_idx)) {
+                    if (!probs_false.empty()) {
+                        assert(row_idx < probs_false.size());
+                        predictions_[record_idx][sample_idx] = probs_false[row_idx];
                     }
+                    ++row_idx;
                 }
-                boost::filesystem::remove(file.path);
             }
+            FlatRandomForest::DataColumns {}.swap(sample_data);
         }
     }
-    boost::filesystem::remove(ranger_prediction_fname);
     data_.clear();
     data_.shrink_to_fit();
     choices_.clear();
@@ -429,9 +362,8 @@ VariantCallFilter::Classification RandomForestFilter::classify(const std::size_t
 {
     Classification result {};
     if (hard_filtered_.empty() || !hard_filtered_[call_idx]) {
-        const auto& predictions = data_buffer_[0];
-        assert(call_idx < predictions.size() && sample_idx < predictions[call_idx].size());
-        const auto prob_false = predictions[call_idx][sample_idx];
+        assert(call_idx < predictions_.size() && sample_idx < predictions_[call_idx].size());
+        const auto prob_false = predictions_[call_idx][sample_idx];
         result.quality = probability_false_to_phred(std::max(prob_false, 1e-10));
         if (*result.quality >= min_soft_genotype_quality()) {
             result.category = Classification::Category::unfiltered;
@@ -75,17 +75,25 @@ void SinglePassVariantCallFilter::filter(const CallBlock& block, const MeasureBl
 
 void SinglePassVariantCallFilter::filter(const VcfRecord& call, const MeasureVector& measures, VcfWriter& dest,
                                          const VcfHeader& dest_header, const SampleList& samples) const
+{
+    const auto filtered_call = filter(call, measures, dest_header, samples);
+    if (filtered_call) dest << *filtered_call;
+    log_progress(mapped_region(call));
+}
+
+boost::optional<VcfRecord>
+SinglePassVariantCallFilter::filter(const VcfRecord& call, const MeasureVector& measures,
+                                    const VcfHeader& dest_header, const SampleList& samples) const
 {
     const auto sample_classifications = classify(measures, samples);
     const auto call_classification = merge(sample_classifications, measures);
     if (measure_annotations_requested()) {
         VcfRecord::Builder annotation_builder {call};
         annotate(annotation_builder, measures, dest_header);
-        write(annotation_builder.build_once(), call_classification, samples, sample_classifications, dest);
+        return make_filtered_call(annotation_builder.build_once(), call_classification, samples, sample_classifications);
     } else {
-        write(call, call_classification, samples, sample_classifications, dest);
+        return make_filtered_call(call, call_classification, samples, sample_classifications);
     }
-    log_progress(mapped_region(call));
 }
 
 VariantCallFilter::ClassificationList
@@ -41,6 +41,9 @@ private:
     
     virtual Classification classify(const MeasureVector& call_measures) const = 0;
     
+    bool do_is_streamable() const noexcept override { return true; }
+    boost::optional<VcfRecord> filter(const VcfRecord& call, const MeasureVector& measures,
+                                      const VcfHeader& dest_header, const SampleList& samples) const override;
     void filter(const VcfReader& source, VcfWriter& dest, const VcfHeader& dest_header) const override;
     void filter(const VcfRecord& call, VcfWriter& dest, const VcfHeader& dest_header, const SampleList& samples) const;
     void filter(const CallBlock& block, VcfWriter& dest, const VcfHeader& dest_header, const SampleList& samples) const;
@@ -30,6 +30,7 @@
 #include "utils/parallel_transform.hpp"
 #include "io/variant/vcf_writer.hpp"
 #include "io/variant/vcf_spec.hpp"
+#include "exceptions/program_error.hpp"
 
 namespace octopus { namespace csr {
 
@@ -55,6 +56,17 @@ bool contains(const std::vector<MeasureWrapper>& measures, const std::string& na
                         [&] (const auto& measure) { return measure.name() == name; }) != std::cend(measures);
 }
 
+auto make_map(const std::vector<std::string>& names, std::vector<FacetWrapper>&& facets)
+{
+    assert(names.size() == facets.size());
+    Measure::FacetMap result {};
+    result.reserve(names.size());
+    for (auto tup : boost::combine(names, std::move(facets))) {
+        result.emplace(tup.get<0>(), std::move(tup.get<1>()));
+    }
+    return result;
+}
+
 } // namespace
 
 // public methods
@@ -113,6 +125,82 @@ void VariantCallFilter::filter(const VcfReader& source, VcfWriter& dest) const
     }
 }
 
+bool VariantCallFilter::is_streamable() const noexcept
+{
+    return do_is_streamable();
+}
+
+VcfHeader VariantCallFilter::make_header(const VcfHeader& source) const
+{
+    VcfHeader::Builder builder {source};
+    if (output_config_.clear_info) {
+        builder.clear_info();
+    }
+    if (measure_annotations_requested()) {
+        for (const auto& measure : measures_) {
+            if (is_requested_annotation(measure)) {
+                measure.annotate(builder);
+            }
+        }
+    }
+    if (output_config_.emit_sites_only) {
+        builder.clear_format();
+    }
+    annotate(builder);
+    return builder.build_once();
+}
+
+namespace {
+
+class UnstreamableFilter : public ProgramError
+{
+    std::string filter_;
+    std::string do_where() const override { return "VariantCallFilter::filter"; }
+    std::string do_why() const override
+    {
+        return "The filter " + filter_ + " cannot filter calls independently";
+    }
+    std::string do_help() const override
+    {
+        return "submit an error report";
+    }
+public:
+    UnstreamableFilter(std::string filter) : filter_ {std::move(filter)} {}
+};
+
+} // namespace
+
+std::deque<VcfRecord>
+VariantCallFilter::filter(const std::deque<VcfRecord>& calls, const ReadMap& reads, const GenomicRegion& reads_region,
+                          const VcfHeader& dest_header) const
+{
+    if (!is_streamable()) throw UnstreamableFilter {name()};
+    std::deque<VcfRecord> result {};
+    if (calls.empty()) return result;
+    const auto samples = dest_header.samples();
+    std::vector<CallBlock> blocks {};
+    for (auto first = std::cbegin(calls), last = std::cend(calls); first != last;) {
+        blocks.push_back(read_next_block(first, last, samples));
+    }
+    std::vector<Measure::FacetMap> facets {};
+    if (!facet_names_.empty()) {
+        auto block_facets = facet_factory_.make(facet_names_, blocks, reads, reads_region);
+        facets.reserve(blocks.size());
+        for (auto& block : block_facets) {
+            facets.push_back(make_map(facet_names_, std::move(block)));
+        }
+    }
+    for (std::size_t block_idx {0}; block_idx < blocks.size(); ++block_idx) {
+        const auto& block = blocks[block_idx];
+        const auto measures = facets.empty() ? measure(block) : measure(block, facets[block_idx]);
+        for (auto tup : boost::combine(block, measures)) {
+            auto filtered_call = this->filter(tup.get<0>(), tup.get<1>(), dest_header, samples);
+            if (filtered_call) result.push_back(std::move(*filtered_call));
+        }
+    }
+    return result;
+}
+
 // protected methods
 
 namespace {
@@ -193,10 +281,8 @@ std::vector<T> copy_each_first(const std::vector<std::pair<T, _>>& items)
     return result;
 }
 
-} // namespace
-
-VariantCallFilter::CallBlock
-VariantCallFilter::read_next_block(VcfIterator& first, const VcfIterator& last, const SampleList& samples) const
+template <typename ForwardIterator>
+std::vector<VcfRecord> read_next_phase_block(ForwardIterator& first, const ForwardIterator& last, const std::vector<SampleName>& samples)
 {
     std::vector<std::pair<VcfRecord, GenomicRegion>> block {};
     for (; first != last; ++first) {
@@ -210,6 +296,21 @@ VariantCallFilter::read_next_block(VcfIterator& first, const VcfIterator& last,
     return copy_each_first(block);
 }
 
+} // namespace
+
+VariantCallFilter::CallBlock
+VariantCallFilter::read_next_block(VcfIterator& first, const VcfIterator& last, const SampleList& samples) const
+{
+    return read_next_phase_block(first, last, samples);
+}
+
+VariantCallFilter::CallBlock
+VariantCallFilter::read_next_block(std::deque<VcfRecord>::const_iterator& first, const std::deque<VcfRecord>::const_iterator& last,
+                                   const SampleList& samples) const
+{
+    return read_next_phase_block(first, last, samples);
+}
+
 std::vector<VariantCallFilter::CallBlock>
 VariantCallFilter::read_next_blocks(VcfIterator& first, const VcfIterator& last, const SampleList& samples) const
 {
@@ -292,12 +393,19 @@ void VariantCallFilter::write(const VcfRecord& call, const Classification& class
                               const SampleList& samples, const ClassificationList& sample_classifications,
                               VcfWriter& dest) const
 {
-    if (!is_hard_filtered(classification)) {
-        auto filtered_call = construct_template(call);
-        annotate(filtered_call, classification);
-        annotate(filtered_call, samples, sample_classifications);
-        dest << filtered_call.build_once();
-    }
+    auto filtered_call = make_filtered_call(call, classification, samples, sample_classifications);
+    if (filtered_call) dest << *filtered_call;
+}
+
+boost::optional<VcfRecord>
+VariantCallFilter::make_filtered_call(const VcfRecord& call, const Classification& classification,
+                                      const SampleList& samples, const ClassificationList& sample_classifications) const
+{
+    if (is_hard_filtered(classification)) return boost::none;
+    auto result = construct_template(call);
+    annotate(result, classification);
+    annotate(result, samples, sample_classifications);
+    return result.build_once();
 }
 
 bool VariantCallFilter::measure_annotations_requested() const noexcept
@@ -319,8 +427,20 @@ void VariantCallFilter::annotate(VcfRecord::Builder& call, const MeasureVector&
     }
 }
 
+ThreadPool& VariantCallFilter::workers() const noexcept
+{
+    return workers_;
+}
+
 // private methods
 
+boost::optional<VcfRecord>
+VariantCallFilter::filter(const VcfRecord& call, const MeasureVector& measures,
+                          const VcfHeader& dest_header, const SampleList& samples) const
+{
+    throw UnstreamableFilter {name()};
+}
+
 boost::optional<Phred<double>>
 VariantCallFilter::compute_joint_quality(const ClassificationList& sample_classifications, const MeasureVector& measures) const
 {
@@ -385,22 +505,7 @@ std::vector<std::string> VariantCallFilter::compute_reason_union(const Classific
 
 VcfHeader VariantCallFilter::make_header(const VcfReader& source) const
 {
-    VcfHeader::Builder builder {source.fetch_header()};
-    if (output_config_.clear_info) {
-        builder.clear_info();
-    }
-    if (measure_annotations_requested()) {
-        for (const auto& measure : measures_) {
-            if (is_requested_annotation(measure)) {
-                measure.annotate(builder);
-            }
-        }
-    }
-    if (output_config_.emit_sites_only) {
-        builder.clear_format();
-    }
-    annotate(builder);
-    return builder.build_once();
+    return make_header(source.fetch_header());
 }
 
 VcfRecord::Builder VariantCallFilter::construct_template(const VcfRecord& call) const
@@ -461,7 +566,7 @@ void VariantCallFilter::annotate(VcfRecord::Builder& call, const SampleName& sam
     const auto quality_name = this->genotype_quality_name();
     if (quality_name) {
         if (status.quality) {
-            call.set_format(sample, *quality_name, utils::to_string(status.quality->score(), 2));
+            call.set_format(sample, *quality_name, maths::round(status.quality->score(), 2));
         } else {
             call.set_format_missing(sample, *quality_name);
         }
@@ -479,24 +584,13 @@ void VariantCallFilter::annotate(VcfRecord::Builder& call, const Classification
     if (quality_name) {
         call.add_info(*quality_name);
         if (status.quality) {
-            call.set_info(*quality_name, utils::to_string(status.quality->score(), 3, utils::PrecisionRule::sf));
+            call.set_info(*quality_name, maths::round_sf(status.quality->score(), 3));
         } else {
             call.set_info_missing(*quality_name);
         }
     }
 }
 
-auto make_map(const std::vector<std::string>& names, std::vector<FacetWrapper>&& facets)
-{
-    assert(names.size() == facets.size());
-    Measure::FacetMap result {};
-    result.reserve(names.size());
-    for (auto tup : boost::combine(names, std::move(facets))) {
-        result.emplace(tup.get<0>(), std::move(tup.get<1>()));
-    }
-    return result;
-}
-
 Measure::FacetMap VariantCallFilter::compute_facets(const CallBlock& block) const
 {
     return make_map(facet_names_, facet_factory_.make(facet_names_, block));
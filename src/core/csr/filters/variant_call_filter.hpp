@@ -5,6 +5,7 @@
 #define variant_call_filter_hpp
 
 #include <vector>
+#include <deque>
 #include <string>
 #include <cstddef>
 #include <type_traits>
@@ -69,6 +70,16 @@ public:
     
     void filter(const VcfReader& source, VcfWriter& dest) const;
     
+    // Streamable filters classify each call independently of all others, so can filter calls as they are made
+    bool is_streamable() const noexcept;
+    
+    VcfHeader make_header(const VcfHeader& source) const;
+    
+    // Filters calls made by a single calling task, using the reads fetched for calling where they cover
+    // reads_region. Only streamable filters support this, and it is safe to call concurrently.
+    std::deque<VcfRecord> filter(const std::deque<VcfRecord>& calls, const ReadMap& reads, const GenomicRegion& reads_region,
+                                 const VcfHeader& dest_header) const;
+    
 protected:
     using SampleList    = std::vector<SampleName>;
     using MeasureVector = std::vector<Measure::ResultType>;
@@ -93,6 +104,8 @@ protected:
     bool can_measure_single_call() const noexcept;
     bool can_measure_multiple_blocks() const noexcept;
     CallBlock read_next_block(VcfIterator& first, const VcfIterator& last, const SampleList& samples) const;
+    CallBlock read_next_block(std::deque<VcfRecord>::const_iterator& first, const std::deque<VcfRecord>::const_iterator& last,
+                              const SampleList& samples) const;
     std::vector<CallBlock> read_next_blocks(VcfIterator& first, const VcfIterator& last, const SampleList& samples) const;
     MeasureVector measure(const VcfRecord& call) const;
     MeasureBlock measure(const CallBlock& block) const;
@@ -101,10 +114,13 @@ protected:
     void write(const VcfRecord& call, const Classification& classification,
                const SampleList& samples, const ClassificationList& sample_classifications,
                VcfWriter& dest) const;
+    boost::optional<VcfRecord> make_filtered_call(const VcfRecord& call, const Classification& classification,
+                                                  const SampleList& samples, const ClassificationList& sample_classifications) const;
     bool measure_annotations_requested() const noexcept;
     void annotate(VcfRecord::Builder& call, const MeasureVector& measures, const VcfHeader& header) const;
     Phred<double> compute_joint_quality(const std::vector<Phred<double>>& qualities) const;
     std::vector<std::string> compute_reason_union(const ClassificationList& sample_classifications) const;
+    ThreadPool& workers() const noexcept;
     
 private:
     using FacetNameSet = std::vector<std::string>;
@@ -119,6 +135,9 @@ private:
     virtual std::string do_name() const = 0;
     virtual void annotate(VcfHeader::Builder& header) const = 0;
     virtual void filter(const VcfReader& source, VcfWriter& dest, const VcfHeader& dest_header) const = 0;
+    virtual bool do_is_streamable() const noexcept { return false; }
+    virtual boost::optional<VcfRecord> filter(const VcfRecord& call, const MeasureVector& measures,
+                                              const VcfHeader& dest_header, const SampleList& samples) const;
     virtual boost::optional<std::string> call_quality_name() const { return boost::none; }
     virtual boost::optional<std::string> genotype_quality_name() const { return boost::none; }
     virtual boost::optional<Phred<double>> compute_joint_quality(const ClassificationList& sample_classifications, const MeasureVector& measures) const;
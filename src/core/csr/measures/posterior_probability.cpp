@@ -25,8 +25,8 @@ Measure::ResultType PosteriorProbability::do_evaluate(const VcfRecord& call, con
     boost::optional<double> result {};
     if (call.has_info("PP")) {
         const auto& pp = call.info_value("PP");
-        if (pp.size() == 1 && pp.front() != vcfspec::missingValue) {
-            result = std::stod(pp.front());
+        if (pp.size() == 1 && !pp.front().is_missing()) {
+            result = pp.front().as_double();
         }
     }
     return result;
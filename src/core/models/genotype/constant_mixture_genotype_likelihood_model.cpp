@@ -9,8 +9,12 @@
 #include <numeric>
 #include <array>
 #include <limits>
+#include <unordered_map>
+#include <functional>
 #include <cassert>
 
+#include <boost/optional.hpp>
+
 #include "utils/maths.hpp"
 
 namespace octopus { namespace model {
@@ -36,14 +40,22 @@ void ConstantMixtureGenotypeLikelihoodModel::prime(const std::vector<Haplotype>&
     assert(likelihoods_.is_primed());
     indexed_likelihoods_.reserve(haplotypes.size());
     std::transform(std::cbegin(haplotypes), std::cend(haplotypes), std::back_inserter(indexed_likelihoods_),
-                   [this] (const auto& haplotype) -> const HaplotypeLikelihoodArray::LikelihoodVector& {
+                   [this] (const auto& haplotype) -> HaplotypeLikelihoodArray::LikelihoodSpan {
                        return likelihoods_[haplotype]; });
+    num_likelihoods_ = indexed_likelihoods_.empty() ? 0 : indexed_likelihoods_.front().size();
+    likelihood_matrix_.reserve(indexed_likelihoods_.size() * num_likelihoods_);
+    for (const auto& likelihoods : indexed_likelihoods_) {
+        likelihood_matrix_.insert(std::cend(likelihood_matrix_), std::cbegin(likelihoods), std::cend(likelihoods));
+    }
 }
 
 void ConstantMixtureGenotypeLikelihoodModel::unprime() noexcept
 {
     indexed_likelihoods_.clear();
     indexed_likelihoods_.shrink_to_fit();
+    likelihood_matrix_.clear();
+    likelihood_matrix_.shrink_to_fit();
+    num_likelihoods_ = 0;
 }
 
 bool ConstantMixtureGenotypeLikelihoodModel::is_primed() const noexcept
@@ -114,23 +126,149 @@ ConstantMixtureGenotypeLikelihoodModel::evaluate(const GenotypeIndex& genotype)
     }
 }
 
+namespace {
+
+using LikelihoodType = HaplotypeLikelihoodArray::LogProbability;
+
+// result[i] = ln(exp(lhs[i]) + exp(rhs[i])). The loop is branch free over contiguous rows so that
+// the compiler vectorises it, including the exp and log calls under the fast-math build flags.
+void log_sum_exp(const LikelihoodType* lhs, const LikelihoodType* rhs, LikelihoodType* result,
+                 const std::size_t n) noexcept
+{
+    for (std::size_t i {0}; i < n; ++i) {
+        const auto max = std::max(lhs[i], rhs[i]);
+        const auto min = std::min(lhs[i], rhs[i]);
+        result[i] = max + std::log(LikelihoodType {1} + std::exp(min - max));
+    }
+}
+
+std::size_t common_prefix_length(const GenotypeIndex& lhs, const GenotypeIndex& rhs) noexcept
+{
+    const auto n = std::min(lhs.size(), rhs.size());
+    const auto last = std::next(std::cbegin(lhs), n);
+    return std::distance(std::cbegin(lhs), std::mismatch(std::cbegin(lhs), last, std::cbegin(rhs)).first);
+}
+
+bool is_homozygous(const GenotypeIndex& genotype) noexcept
+{
+    return std::adjacent_find(std::cbegin(genotype), std::cend(genotype), std::not_equal_to<> {}) == std::cend(genotype);
+}
+
+// likelihoods is a row-major haplotype x read matrix. Row k of partial_sums holds ln sum p(read | haplotype)
+// over the first k + 1 haplotypes of the last evaluated genotype (row 0 is just the first haplotype's row,
+// so is never stored). A genotype only recomputes the rows past its common prefix with the previous one.
+std::vector<ConstantMixtureGenotypeLikelihoodModel::LogProbability>
+evaluate_genotypes(const std::vector<GenotypeIndex>& genotypes,
+                   const std::vector<LikelihoodType>& likelihoods,
+                   const std::size_t num_haplotypes,
+                   const std::size_t num_likelihoods)
+{
+    using LogProbability = ConstantMixtureGenotypeLikelihoodModel::LogProbability;
+    // A sample with no reads has no evidence for any genotype
+    if (num_likelihoods == 0) return std::vector<LogProbability>(genotypes.size(), 0);
+    const auto row = [&] (const unsigned haplotype_idx) { return likelihoods.data() + haplotype_idx * num_likelihoods; };
+    std::vector<boost::optional<LogProbability>> haplotype_sums(num_haplotypes);
+    const auto sum_row = [&] (const unsigned haplotype_idx) {
+        auto& result = haplotype_sums[haplotype_idx];
+        if (!result) result = std::accumulate(row(haplotype_idx), row(haplotype_idx) + num_likelihoods, LogProbability {0});
+        return *result;
+    };
+    std::vector<LikelihoodType> partial_sums {};
+    const GenotypeIndex* previous {nullptr};
+    std::vector<LogProbability> result(genotypes.size());
+    for (std::size_t genotype_idx {0}; genotype_idx < genotypes.size(); ++genotype_idx) {
+        const auto& genotype = genotypes[genotype_idx];
+        const auto ploidy = genotype.size();
+        if (ploidy == 0) {
+            result[genotype_idx] = 0;
+            continue;
+        }
+        if (is_homozygous(genotype)) {
+            result[genotype_idx] = sum_row(genotype.front());
+            continue;
+        }
+        if (partial_sums.size() < ploidy * num_likelihoods) partial_sums.resize(ploidy * num_likelihoods);
+        const auto partial_row = [&] (const std::size_t k) {
+            return k == 0 ? row(genotype.front()) : partial_sums.data() + k * num_likelihoods;
+        };
+        std::size_t k {1};
+        if (previous) k = std::max(k, common_prefix_length(*previous, genotype));
+        for (; k < ploidy; ++k) {
+            log_sum_exp(partial_row(k - 1), row(genotype[k]), partial_sums.data() + k * num_likelihoods, num_likelihoods);
+        }
+        const auto last_row = partial_row(ploidy - 1);
+        result[genotype_idx] = std::accumulate(last_row, last_row + num_likelihoods, LogProbability {0})
+                               - static_cast<LogProbability>(num_likelihoods) * std::log(ploidy);
+        previous = &genotype;
+    }
+    return result;
+}
+
+} // namespace
+
+std::vector<ConstantMixtureGenotypeLikelihoodModel::LogProbability>
+ConstantMixtureGenotypeLikelihoodModel::evaluate(const std::vector<GenotypeIndex>& genotypes) const
+{
+    assert(is_primed());
+    return evaluate_genotypes(genotypes, likelihood_matrix_, indexed_likelihoods_.size(), num_likelihoods_);
+}
+
+std::vector<ConstantMixtureGenotypeLikelihoodModel::LogProbability>
+ConstantMixtureGenotypeLikelihoodModel::evaluate(const std::vector<Genotype<Haplotype>>& genotypes) const
+{
+    return evaluate_batch(genotypes);
+}
+
+std::vector<ConstantMixtureGenotypeLikelihoodModel::LogProbability>
+ConstantMixtureGenotypeLikelihoodModel::evaluate(const MappableBlock<Genotype<Haplotype>>& genotypes) const
+{
+    return evaluate_batch(genotypes);
+}
+
 // private methods
 
+template <typename Range>
+std::vector<ConstantMixtureGenotypeLikelihoodModel::LogProbability>
+ConstantMixtureGenotypeLikelihoodModel::evaluate_batch(const Range& genotypes) const
+{
+    assert(likelihoods_.is_primed());
+    std::unordered_map<std::reference_wrapper<const Haplotype>, unsigned> haplotype_indices {};
+    std::vector<GenotypeIndex> genotype_indices {};
+    genotype_indices.reserve(genotypes.size());
+    std::vector<LikelihoodType> likelihood_matrix {};
+    std::size_t num_likelihoods {0};
+    for (const auto& genotype : genotypes) {
+        GenotypeIndex genotype_index {};
+        genotype_index.reserve(genotype.ploidy());
+        for (const auto& haplotype : genotype) {
+            const auto itr = haplotype_indices.emplace(haplotype, static_cast<unsigned>(haplotype_indices.size()));
+            if (itr.second) {
+                const auto likelihoods = likelihoods_[haplotype];
+                num_likelihoods = likelihoods.size();
+                likelihood_matrix.insert(std::cend(likelihood_matrix), std::cbegin(likelihoods), std::cend(likelihoods));
+            }
+            genotype_index.push_back(itr.first->second);
+        }
+        genotype_indices.push_back(std::move(genotype_index));
+    }
+    return evaluate_genotypes(genotype_indices, likelihood_matrix, haplotype_indices.size(), num_likelihoods);
+}
+
 ConstantMixtureGenotypeLikelihoodModel::LogProbability
 ConstantMixtureGenotypeLikelihoodModel::evaluate_haploid(const Genotype<Haplotype>& genotype) const
 {
-    const auto& log_likelihoods = likelihoods_[genotype[0]];
+    const auto log_likelihoods = likelihoods_[genotype[0]];
     return std::accumulate(std::cbegin(log_likelihoods), std::cend(log_likelihoods), LogProbability {0});
 }
 
 ConstantMixtureGenotypeLikelihoodModel::LogProbability
 ConstantMixtureGenotypeLikelihoodModel::evaluate_diploid(const Genotype<Haplotype>& genotype) const
 {
-    const auto& log_likelihoods1 = likelihoods_[genotype[0]];
+    const auto log_likelihoods1 = likelihoods_[genotype[0]];
     if (genotype.is_homozygous()) {
         return std::accumulate(std::cbegin(log_likelihoods1), std::cend(log_likelihoods1), LogProbability {0});
     }
-    const auto& log_likelihoods2 = likelihoods_[genotype[1]];
+    const auto log_likelihoods2 = likelihoods_[genotype[1]];
     return std::inner_product(std::cbegin(log_likelihoods1), std::cend(log_likelihoods1),
                               std::cbegin(log_likelihoods2), LogProbability {0}, std::plus<> {},
                               [] (const auto a, const auto b) -> LogProbability {
@@ -142,13 +280,13 @@ ConstantMixtureGenotypeLikelihoodModel::LogProbability
 ConstantMixtureGenotypeLikelihoodModel::evaluate_triploid(const Genotype<Haplotype>& genotype) const
 {
     using std::cbegin; using std::cend;
-    const auto& log_likelihoods1 = likelihoods_[genotype[0]];
+    const auto log_likelihoods1 = likelihoods_[genotype[0]];
     if (genotype.is_homozygous()) {
         return std::accumulate(cbegin(log_likelihoods1), cend(log_likelihoods1), LogProbability {0});
     }
     if (genotype.zygosity() == 3) {
-        const auto& log_likelihoods2 = likelihoods_[genotype[1]];
-        const auto& log_likelihoods3 = likelihoods_[genotype[2]];
+        const auto log_likelihoods2 = likelihoods_[genotype[1]];
+        const auto log_likelihoods3 = likelihoods_[genotype[2]];
         return maths::inner_product(cbegin(log_likelihoods1), cend(log_likelihoods1),
                                     cbegin(log_likelihoods2), cbegin(log_likelihoods3),
                                     LogProbability {0}, std::plus<> {},
@@ -157,14 +295,14 @@ ConstantMixtureGenotypeLikelihoodModel::evaluate_triploid(const Genotype<Haploty
                                     });
     }
     if (genotype[0] != genotype[1]) {
-        const auto& log_likelihoods2 = likelihoods_[genotype[1]];
+        const auto log_likelihoods2 = likelihoods_[genotype[1]];
         return std::inner_product(cbegin(log_likelihoods1), cend(log_likelihoods1),
                                   cbegin(log_likelihoods2), LogProbability {0}, std::plus<> {},
                                   [] (const auto a, const auto b) -> LogProbability {
                                       return maths::log_sum_exp(a, ln<decltype(a)>(2) + b) - ln<decltype(a)>(3);
                                   });
     }
-    const auto& log_likelihoods3 = likelihoods_[genotype[2]];
+    const auto log_likelihoods3 = likelihoods_[genotype[2]];
     return std::inner_product(cbegin(log_likelihoods1), cend(log_likelihoods1),
                               cbegin(log_likelihoods3), LogProbability {0}, std::plus<> {},
                               [] (const auto a, const auto b) -> LogProbability {
@@ -176,14 +314,14 @@ ConstantMixtureGenotypeLikelihoodModel::LogProbability
 ConstantMixtureGenotypeLikelihoodModel::evaluate_tetraploid(const Genotype<Haplotype>& genotype) const
 {
     const auto z = genotype.zygosity();
-    const auto& log_likelihoods1 = likelihoods_[genotype[0]];
+    const auto log_likelihoods1 = likelihoods_[genotype[0]];
     if (z == 1) {
         return std::accumulate(std::cbegin(log_likelihoods1), std::cend(log_likelihoods1), LogProbability {0});
     }
     if (z == 4) {
-        const auto& log_likelihoods2 = likelihoods_[genotype[1]];
-        const auto& log_likelihoods3 = likelihoods_[genotype[2]];
-        const auto& log_likelihoods4 = likelihoods_[genotype[3]];
+        const auto log_likelihoods2 = likelihoods_[genotype[1]];
+        const auto log_likelihoods3 = likelihoods_[genotype[2]];
+        const auto log_likelihoods4 = likelihoods_[genotype[3]];
         return maths::inner_product(std::cbegin(log_likelihoods1), std::cend(log_likelihoods1),
                                     std::cbegin(log_likelihoods2), std::cbegin(log_likelihoods3),
                                     std::cbegin(log_likelihoods4), LogProbability {0}, std::plus<> {},
@@ -203,13 +341,13 @@ ConstantMixtureGenotypeLikelihoodModel::evaluate_polyploid(const Genotype<Haplot
     const auto ploidy = genotype.ploidy();
     const auto ln_ploidy = std::log(ploidy);
     const auto z = genotype.zygosity();
-    const auto& log_likelihoods1 = likelihoods_[genotype[0]];
+    const auto log_likelihoods1 = likelihoods_[genotype[0]];
     if (z == 1) {
         return std::accumulate(std::cbegin(log_likelihoods1), std::cend(log_likelihoods1), LogProbability {0});
     }
     if (z == 2) {
         const auto unique_haplotypes = genotype.copy_unique_ref();
-        const auto& log_likelihoods2 = likelihoods_[unique_haplotypes.back()];
+        const auto log_likelihoods2 = likelihoods_[unique_haplotypes.back()];
         const auto lnpm1 = static_cast<HaplotypeLikelihoodArray::LogProbability>(std::log(ploidy - 1));
         if (genotype.count(unique_haplotypes.front()) == 1) {
             return std::inner_product(std::cbegin(log_likelihoods1), std::cend(log_likelihoods1),
@@ -227,14 +365,14 @@ ConstantMixtureGenotypeLikelihoodModel::evaluate_polyploid(const Genotype<Haplot
     likelihood_refs_.reserve(ploidy);
     likelihood_refs_.push_back(log_likelihoods1);
     std::transform(std::next(std::cbegin(genotype)), std::cend(genotype), std::back_inserter(likelihood_refs_),
-                   [this] (const auto& haplotype) -> const HaplotypeLikelihoodArray::LikelihoodVector& {
+                   [this] (const auto& haplotype) -> HaplotypeLikelihoodArray::LikelihoodSpan {
                        return likelihoods_[haplotype]; });
     LogProbability result {0};
-    const auto num_likelihoods = likelihood_refs_.front().get().size();
+    const auto num_likelihoods = likelihood_refs_.front().size();
     buffer_.resize(ploidy);
     for (std::size_t read_idx {0}; read_idx < num_likelihoods; ++read_idx) {
         std::transform(std::cbegin(likelihood_refs_), std::cend(likelihood_refs_), std::begin(buffer_),
-                       [read_idx] (const auto& likelihoods) noexcept { return likelihoods.get()[read_idx]; });
+                       [read_idx] (const auto& likelihoods) noexcept { return likelihoods[read_idx]; });
         result += maths::log_sum_exp(buffer_) - ln_ploidy;
     }
     likelihood_refs_.clear();
@@ -244,18 +382,18 @@ ConstantMixtureGenotypeLikelihoodModel::evaluate_polyploid(const Genotype<Haplot
 ConstantMixtureGenotypeLikelihoodModel::LogProbability
 ConstantMixtureGenotypeLikelihoodModel::evaluate_haploid(const GenotypeIndex& genotype) const
 {
-    const auto& log_likelihoods = indexed_likelihoods_[genotype[0]].get();
+    const auto log_likelihoods = indexed_likelihoods_[genotype[0]];
     return std::accumulate(std::cbegin(log_likelihoods), std::cend(log_likelihoods), LogProbability {0});
 }
 
 ConstantMixtureGenotypeLikelihoodModel::LogProbability
 ConstantMixtureGenotypeLikelihoodModel::evaluate_diploid(const GenotypeIndex& genotype) const
 {
-    const auto& log_likelihoods1 = indexed_likelihoods_[genotype[0]].get();
+    const auto log_likelihoods1 = indexed_likelihoods_[genotype[0]];
     if (genotype[0] == genotype[1]) { // if homozygous
         return std::accumulate(std::cbegin(log_likelihoods1), std::cend(log_likelihoods1), LogProbability {0});
     } else {
-        const auto& log_likelihoods2 = indexed_likelihoods_[genotype[1]].get();
+        const auto log_likelihoods2 = indexed_likelihoods_[genotype[1]];
         return std::inner_product(std::cbegin(log_likelihoods1), std::cend(log_likelihoods1),
                                   std::cbegin(log_likelihoods2), LogProbability {0}, std::plus<> {},
                                   [] (const auto a, const auto b) -> LogProbability {
@@ -271,10 +409,10 @@ ConstantMixtureGenotypeLikelihoodModel::evaluate_polyploid(const GenotypeIndex&
     const auto ln_ploidy = std::log(ploidy);
     buffer_.resize(ploidy);
     LogProbability result {0};
-    const auto num_likelihoods = indexed_likelihoods_.front().get().size();
+    const auto num_likelihoods = indexed_likelihoods_.front().size();
     for (std::size_t read_idx {0}; read_idx < num_likelihoods; ++read_idx) {
         std::transform(std::cbegin(genotype), std::cend(genotype), std::begin(buffer_),
-                       [=] (auto haplotype_idx) noexcept { return indexed_likelihoods_[haplotype_idx].get()[read_idx]; });
+                       [=] (auto haplotype_idx) noexcept { return indexed_likelihoods_[haplotype_idx][read_idx]; });
         result += maths::log_sum_exp(buffer_) - ln_ploidy;
     }
     return result;
@@ -9,6 +9,7 @@
 #include "core/types/haplotype.hpp"
 #include "core/types/genotype.hpp"
 #include "core/models/haplotype_likelihood_array.hpp"
+#include "containers/mappable_block.hpp"
 
 namespace octopus { namespace model {
 
@@ -39,10 +40,19 @@ public:
     LogProbability evaluate(const Genotype<Haplotype>& genotype) const;
     LogProbability evaluate(const GenotypeIndex& genotype) const;
     
+    // Batched evaluation over a contiguous haplotype x read likelihood matrix. Consecutive genotypes
+    // with common leading haplotypes share per-read partial sums, so genotypes are best given in
+    // generation order. The GenotypeIndex overload requires the model to be primed.
+    std::vector<LogProbability> evaluate(const std::vector<GenotypeIndex>& genotypes) const;
+    std::vector<LogProbability> evaluate(const std::vector<Genotype<Haplotype>>& genotypes) const;
+    std::vector<LogProbability> evaluate(const MappableBlock<Genotype<Haplotype>>& genotypes) const;
+    
 private:
     const HaplotypeLikelihoodArray& likelihoods_;
-    std::vector<HaplotypeLikelihoodArray::LikelihoodVectorRef> indexed_likelihoods_;
-    mutable std::vector<HaplotypeLikelihoodArray::LikelihoodVectorRef> likelihood_refs_;
+    std::vector<HaplotypeLikelihoodArray::LikelihoodSpan> indexed_likelihoods_;
+    std::vector<HaplotypeLikelihoodArray::LogProbability> likelihood_matrix_;
+    std::size_t num_likelihoods_ = 0;
+    mutable std::vector<HaplotypeLikelihoodArray::LikelihoodSpan> likelihood_refs_;
     mutable std::vector<HaplotypeLikelihoodArray::LogProbability> buffer_;
     
     // These are just for optimisation
@@ -55,8 +65,35 @@ private:
     LogProbability evaluate_haploid(const GenotypeIndex& genotype) const;
     LogProbability evaluate_diploid(const GenotypeIndex& genotype) const;
     LogProbability evaluate_polyploid(const GenotypeIndex& genotype) const;
+    
+    template <typename Range>
+    std::vector<LogProbability> evaluate_batch(const Range& genotypes) const;
 };
 
+inline std::vector<ConstantMixtureGenotypeLikelihoodModel::LogProbability>&
+evaluate(const std::vector<GenotypeIndex>& genotypes, const ConstantMixtureGenotypeLikelihoodModel& model,
+         std::vector<ConstantMixtureGenotypeLikelihoodModel::LogProbability>& result)
+{
+    result = model.evaluate(genotypes);
+    return result;
+}
+
+inline std::vector<ConstantMixtureGenotypeLikelihoodModel::LogProbability>&
+evaluate(const std::vector<Genotype<Haplotype>>& genotypes, const ConstantMixtureGenotypeLikelihoodModel& model,
+         std::vector<ConstantMixtureGenotypeLikelihoodModel::LogProbability>& result)
+{
+    result = model.evaluate(genotypes);
+    return result;
+}
+
+inline std::vector<ConstantMixtureGenotypeLikelihoodModel::LogProbability>&
+evaluate(const MappableBlock<Genotype<Haplotype>>& genotypes, const ConstantMixtureGenotypeLikelihoodModel& model,
+         std::vector<ConstantMixtureGenotypeLikelihoodModel::LogProbability>& result)
+{
+    result = model.evaluate(genotypes);
+    return result;
+}
+
 template <typename Container1, typename Container2>
 Container2&
 evaluate(const Container1& genotypes, const ConstantMixtureGenotypeLikelihoodModel& model, Container2& result)
@@ -103,7 +103,7 @@ double calculate_frequency_update_norm(const std::size_t num_samples, const unsi
 
 double calculate_frequency_update_norm(const std::vector<unsigned>& sample_ploidies) noexcept
 {
-    return std::accumulate(std::cbegin(sample_ploidies), std::cend(sample_ploidies), 0.0, std::multiplies<> {});
+    return std::accumulate(std::cbegin(sample_ploidies), std::cend(sample_ploidies), 0.0);
 }
 
 struct EMOptions
@@ -162,15 +162,20 @@ struct ModelConstants
     {}
 };
 
-HardyWeinbergModel make_hardy_weinberg_model(const ModelConstants& constants)
+HardyWeinbergModel make_hardy_weinberg_model(const MappableBlock<Haplotype>& haplotypes)
 {
-    HardyWeinbergModel::HaplotypeFrequencyMap frequencies {constants.haplotypes.size()};
-    for (const auto& haplotype : constants.haplotypes) {
-        frequencies.emplace(haplotype, 1.0 / constants.haplotypes.size());
+    HardyWeinbergModel::HaplotypeFrequencyMap frequencies {haplotypes.size()};
+    for (const auto& haplotype : haplotypes) {
+        frequencies.emplace(haplotype, 1.0 / haplotypes.size());
     }
     return HardyWeinbergModel {std::move(frequencies)};
 }
 
+HardyWeinbergModel make_hardy_weinberg_model(const ModelConstants& constants)
+{
+    return make_hardy_weinberg_model(constants.haplotypes);
+}
+
 GenotypeLogLikelihoodMatrix
 compute_genotype_log_likelihoods(const std::vector<SampleName>& samples,
                                  const PopulationModel::GenotypeVector& genotypes,
@@ -182,13 +187,8 @@ compute_genotype_log_likelihoods(const std::vector<SampleName>& samples,
     result.reserve(samples.size());
     std::transform(std::cbegin(samples), std::cend(samples), std::back_inserter(result),
                    [&genotypes, &haplotype_likelihoods, &likelihood_model] (const auto& sample) {
-                       GenotypeLogLikelihoodVector likelihoods(genotypes.size());
                        haplotype_likelihoods.prime(sample);
-                       std::transform(std::cbegin(genotypes), std::cend(genotypes), std::begin(likelihoods),
-                                      [&likelihood_model] (const auto& genotype) {
-                                          return likelihood_model.evaluate(genotype);
-                                      });
-                       return likelihoods;
+                       return likelihood_model.evaluate(genotypes);
                    });
     return result;
 }
@@ -204,17 +204,37 @@ compute_genotype_log_likelihoods(const std::vector<SampleName>& samples,
     GenotypeLogLikelihoodMatrix result {};
     result.reserve(samples.size());
     std::transform(std::cbegin(samples), std::cend(samples), std::back_inserter(result), [&] (const auto& sample) {
-        GenotypeLogLikelihoodVector likelihoods(genotypes.size());
         haplotype_likelihoods.prime(sample);
         likelihood_model.prime(haplotypes);
-        std::transform(std::cbegin(genotypes), std::cend(genotypes), std::begin(likelihoods),
-                       [&] (const auto& genotype) { return likelihood_model.evaluate(genotype); });
+        auto likelihoods = likelihood_model.evaluate(genotypes);
         likelihood_model.unprime();
         return likelihoods;
     });
     return result;
 }
 
+template <typename Range>
+auto copy_unmasked(const Range& genotypes, const std::vector<bool>& mask)
+{
+    std::vector<typename Range::value_type> result {};
+    result.reserve(std::count(std::cbegin(mask), std::cend(mask), true));
+    for (std::size_t i {0}; i < genotypes.size(); ++i) {
+        if (mask[i]) result.push_back(genotypes[i]);
+    }
+    return result;
+}
+
+GenotypeLogLikelihoodVector
+unmask(const GenotypeLogLikelihoodVector& unmasked_likelihoods, const std::vector<bool>& mask)
+{
+    GenotypeLogLikelihoodVector result(mask.size(), -std::numeric_limits<LogProbability>::infinity());
+    auto likelihood_itr = std::cbegin(unmasked_likelihoods);
+    for (std::size_t i {0}; i < mask.size(); ++i) {
+        if (mask[i]) result[i] = *likelihood_itr++;
+    }
+    return result;
+}
+
 GenotypeLogLikelihoodMatrix
 compute_genotype_log_likelihoods(const std::vector<SampleName>& samples,
                                  const PopulationModel::GenotypeVector& genotypes,
@@ -227,13 +247,8 @@ compute_genotype_log_likelihoods(const std::vector<SampleName>& samples,
     result.reserve(samples.size());
     std::transform(std::cbegin(samples), std::cend(samples), std::cbegin(sample_genotype_masks),
                    std::back_inserter(result), [&] (const auto& sample, const auto& mask) {
-        GenotypeLogLikelihoodVector likelihoods(genotypes.size());
         haplotype_likelihoods.prime(sample);
-        std::transform(std::cbegin(genotypes), std::cend(genotypes), std::cbegin(mask), std::begin(likelihoods),
-                       [&] (const auto& genotype, bool ok) {
-                           return ok ? likelihood_model.evaluate(genotype) : -std::numeric_limits<LogProbability>::infinity();
-                       });
-        return likelihoods;
+        return unmask(likelihood_model.evaluate(copy_unmasked(genotypes, mask)), mask);
     });
     return result;
 }
@@ -251,13 +266,9 @@ compute_genotype_log_likelihoods(const std::vector<SampleName>& samples,
     result.reserve(samples.size());
     std::transform(std::cbegin(samples), std::cend(samples), std::cbegin(sample_genotype_masks),
                    std::back_inserter(result), [&] (const auto& sample, const auto& mask) {
-        GenotypeLogLikelihoodVector likelihoods(genotypes.size());
-        likelihood_model.prime(haplotypes);
         haplotype_likelihoods.prime(sample);
-        std::transform(std::cbegin(genotypes), std::cend(genotypes), std::cbegin(mask), std::begin(likelihoods),
-                       [&] (const auto& genotype, bool ok) {
-                           return ok ? likelihood_model.evaluate(genotype) : -std::numeric_limits<LogProbability>::infinity();
-                       });
+        likelihood_model.prime(haplotypes);
+        auto likelihoods = unmask(likelihood_model.evaluate(copy_unmasked(genotypes, mask)), mask);
         likelihood_model.unprime();
         return likelihoods;
     });
@@ -330,11 +341,10 @@ auto collapse_genotype_posteriors(const GenotypeMarginalPosteriorMatrix& genotyp
 
 double update_haplotype_frequencies(const MappableBlock<Haplotype>& haplotypes,
                                     HardyWeinbergModel& hw_model,
-                                    const GenotypeMarginalPosteriorMatrix& genotype_posteriors,
+                                    const std::vector<double>& collaped_posteriors,
                                     const InverseGenotypeTable& genotypes_containing_haplotypes,
                                     const double frequency_update_norm)
 {
-    const auto collaped_posteriors = collapse_genotype_posteriors(genotype_posteriors);
     double max_frequency_change {0};
     auto& current_haplotype_frequencies = hw_model.frequencies();
     for (std::size_t i {0}; i < haplotypes.size(); ++i) {
@@ -353,6 +363,17 @@ double update_haplotype_frequencies(const MappableBlock<Haplotype>& haplotypes,
     return max_frequency_change;
 }
 
+double update_haplotype_frequencies(const MappableBlock<Haplotype>& haplotypes,
+                                    HardyWeinbergModel& hw_model,
+                                    const GenotypeMarginalPosteriorMatrix& genotype_posteriors,
+                                    const InverseGenotypeTable& genotypes_containing_haplotypes,
+                                    const double frequency_update_norm)
+{
+    const auto collaped_posteriors = collapse_genotype_posteriors(genotype_posteriors);
+    return update_haplotype_frequencies(haplotypes, hw_model, collaped_posteriors,
+                                        genotypes_containing_haplotypes, frequency_update_norm);
+}
+
 double do_em_iteration(GenotypeMarginalPosteriorMatrix& genotype_posteriors,
                        HardyWeinbergModel& hw_model,
                        GenotypeLogMarginalVector& genotype_log_marginals,
@@ -741,6 +762,147 @@ void calculate_posterior_marginals(const Range& genotypes,
     result.log_evidence = norm;
 }
 
+// Sample block evaluation
+
+struct GenotypeLogLikelihoodSummary
+{
+    std::vector<std::size_t> genotype_indices;
+    GenotypeLogLikelihoodVector log_likelihoods;
+};
+
+using GenotypeLogLikelihoodSummaryVector = std::vector<GenotypeLogLikelihoodSummary>;
+
+bool use_sample_blocks(const PopulationModel::Options& options, const std::size_t num_samples) noexcept
+{
+    return options.sample_block_size && num_samples > *options.sample_block_size;
+}
+
+template <typename T>
+std::vector<T> copy_block(const std::vector<T>& values, const std::size_t block_begin, const std::size_t block_end)
+{
+    return {std::next(std::cbegin(values), block_begin), std::next(std::cbegin(values), block_end)};
+}
+
+GenotypeLogLikelihoodSummary
+summarise(const GenotypeLogLikelihoodVector& genotype_log_likelihoods, const double max_log_likelihood_loss)
+{
+    assert(!genotype_log_likelihoods.empty());
+    const auto max_log_likelihood = *std::max_element(std::cbegin(genotype_log_likelihoods), std::cend(genotype_log_likelihoods));
+    const auto min_log_likelihood = max_log_likelihood - max_log_likelihood_loss;
+    GenotypeLogLikelihoodSummary result {};
+    for (std::size_t genotype_idx {0}; genotype_idx < genotype_log_likelihoods.size(); ++genotype_idx) {
+        if (genotype_log_likelihoods[genotype_idx] >= min_log_likelihood) {
+            result.genotype_indices.push_back(genotype_idx);
+            result.log_likelihoods.push_back(genotype_log_likelihoods[genotype_idx]);
+        }
+    }
+    result.genotype_indices.shrink_to_fit();
+    result.log_likelihoods.shrink_to_fit();
+    return result;
+}
+
+// Only one block of dense genotype log likelihoods is alive at any time
+template <typename BlockLikelihoodFunction>
+GenotypeLogLikelihoodSummaryVector
+summarise_genotype_log_likelihoods(const std::size_t num_samples,
+                                   const std::size_t block_size,
+                                   const double max_log_likelihood_loss,
+                                   BlockLikelihoodFunction&& compute_block_log_likelihoods)
+{
+    assert(block_size > 0);
+    GenotypeLogLikelihoodSummaryVector result {};
+    result.reserve(num_samples);
+    for (std::size_t block_begin {0}; block_begin < num_samples; block_begin += block_size) {
+        const auto block_end = std::min(block_begin + block_size, num_samples);
+        for (const auto& sample_log_likelihoods : compute_block_log_likelihoods(block_begin, block_end)) {
+            result.push_back(summarise(sample_log_likelihoods, max_log_likelihood_loss));
+        }
+    }
+    return result;
+}
+
+double compute_genotype_posteriors(const GenotypeLogLikelihoodSummary& summary,
+                                   const GenotypeLogMarginalVector& genotype_log_marginals,
+                                   GenotypeMarginalPosteriorVector& result)
+{
+    result.resize(summary.genotype_indices.size());
+    std::transform(std::cbegin(summary.genotype_indices), std::cend(summary.genotype_indices),
+                   std::cbegin(summary.log_likelihoods), std::begin(result),
+                   [&] (const auto genotype_idx, const auto log_likelihood) {
+                       return genotype_log_marginals[genotype_idx].log_probability + log_likelihood;
+                   });
+    return maths::normalise_exp(result);
+}
+
+void run_em(HardyWeinbergModel& hw_model,
+            GenotypeLogMarginalVector& genotype_log_marginals,
+            const MappableBlock<Haplotype>& haplotypes,
+            const GenotypeLogLikelihoodSummaryVector& genotype_log_likelihoods,
+            const InverseGenotypeTable& genotypes_containing_haplotypes,
+            const double frequency_update_norm,
+            const EMOptions options)
+{
+    std::vector<double> collapsed_posteriors(genotype_log_marginals.size());
+    GenotypeMarginalPosteriorVector posteriors_buffer {};
+    for (unsigned n {1}; n <= options.max_iterations; ++n) {
+        std::fill(std::begin(collapsed_posteriors), std::end(collapsed_posteriors), 0.0);
+        for (const auto& summary : genotype_log_likelihoods) {
+            compute_genotype_posteriors(summary, genotype_log_marginals, posteriors_buffer);
+            for (std::size_t i {0}; i < posteriors_buffer.size(); ++i) {
+                collapsed_posteriors[summary.genotype_indices[i]] += posteriors_buffer[i];
+            }
+        }
+        const auto max_change = update_haplotype_frequencies(haplotypes, hw_model, collapsed_posteriors,
+                                                             genotypes_containing_haplotypes, frequency_update_norm);
+        update_genotype_log_marginals(genotype_log_marginals, hw_model);
+        if (max_change <= options.epsilon) break;
+    }
+}
+
+PopulationModel::InferredLatents
+calculate_posterior_marginals(const GenotypeLogMarginalVector& genotype_log_marginals,
+                              const GenotypeLogLikelihoodSummaryVector& genotype_log_likelihoods)
+{
+    PopulationModel::InferredLatents result {};
+    auto& marginals = result.posteriors.marginal_genotype_probabilities;
+    marginals.reserve(genotype_log_likelihoods.size());
+    result.log_evidence = 0;
+    GenotypeMarginalPosteriorVector posteriors_buffer {};
+    for (const auto& summary : genotype_log_likelihoods) {
+        result.log_evidence += compute_genotype_posteriors(summary, genotype_log_marginals, posteriors_buffer);
+        GenotypeMarginalPosteriorVector sample_marginals(genotype_log_marginals.size(), 0.0);
+        for (std::size_t i {0}; i < posteriors_buffer.size(); ++i) {
+            sample_marginals[summary.genotype_indices[i]] = posteriors_buffer[i];
+        }
+        marginals.push_back(std::move(sample_marginals));
+    }
+    return result;
+}
+
+// Samples are treated as independent given Hardy-Weinberg haplotype frequencies, which are estimated
+// from all samples. The joint prior model is not used as genotype combinations are never enumerated.
+template <typename BlockLikelihoodFunction>
+PopulationModel::InferredLatents
+evaluate_in_sample_blocks(const PopulationModel::GenotypeVector& genotypes,
+                          const std::size_t num_samples,
+                          const double frequency_update_norm,
+                          const PopulationModel::Options& options,
+                          BlockLikelihoodFunction&& compute_block_log_likelihoods)
+{
+    assert(!genotypes.empty() && options.sample_block_size);
+    const auto genotype_log_likelihoods = summarise_genotype_log_likelihoods(num_samples, *options.sample_block_size,
+                                                                             options.max_summary_log_likelihood_loss,
+                                                                             compute_block_log_likelihoods);
+    const MappableBlock<Haplotype> haplotypes {extract_unique_elements(genotypes)};
+    const auto genotypes_containing_haplotypes = make_inverse_genotype_table(haplotypes, genotypes);
+    auto hw_model = make_hardy_weinberg_model(haplotypes);
+    auto genotype_log_marginals = init_genotype_log_marginals(genotypes, hw_model);
+    const EMOptions em_options {options.max_em_iterations, options.em_epsilon};
+    run_em(hw_model, genotype_log_marginals, haplotypes, genotype_log_likelihoods,
+           genotypes_containing_haplotypes, frequency_update_norm, em_options);
+    return calculate_posterior_marginals(genotype_log_marginals, genotype_log_likelihoods);
+}
+
 } // namespace
 
 PopulationModel::InferredLatents
@@ -749,6 +911,14 @@ PopulationModel::evaluate(const SampleVector& samples,
                           const HaplotypeLikelihoodArray& haplotype_likelihoods) const
 {
     assert(!genotypes.empty());
+    if (use_sample_blocks(options_, samples.size())) {
+        const auto frequency_update_norm = calculate_frequency_update_norm(samples.size(), genotypes.front().ploidy());
+        return evaluate_in_sample_blocks(genotypes, samples.size(), frequency_update_norm, options_,
+                                         [&] (const auto block_begin, const auto block_end) {
+            const auto block_samples = copy_block(samples, block_begin, block_end);
+            return compute_genotype_log_likelihoods(block_samples, genotypes, haplotype_likelihoods);
+        });
+    }
     const auto genotype_log_likelihoods = compute_genotype_log_likelihoods(samples, genotypes, haplotype_likelihoods);
     const auto num_possible_genotype_combinations = compute_num_combinations(genotypes.size(), samples.size());
     InferredLatents result;
@@ -773,6 +943,14 @@ PopulationModel::evaluate(const SampleVector& samples,
                           const HaplotypeLikelihoodArray& haplotype_likelihoods) const
 {
     assert(!genotypes.empty());
+    if (use_sample_blocks(options_, samples.size())) {
+        const auto frequency_update_norm = calculate_frequency_update_norm(samples.size(), genotypes.front().ploidy());
+        return evaluate_in_sample_blocks(genotypes, samples.size(), frequency_update_norm, options_,
+                                         [&] (const auto block_begin, const auto block_end) {
+            const auto block_samples = copy_block(samples, block_begin, block_end);
+            return compute_genotype_log_likelihoods(block_samples, haplotypes, genotype_indices, haplotype_likelihoods);
+        });
+    }
     const auto genotype_log_likelihoods = compute_genotype_log_likelihoods(samples, haplotypes, genotype_indices, haplotype_likelihoods);
     const auto num_possible_genotype_combinations = compute_num_combinations(genotypes.size(), samples.size());
     InferredLatents result;
@@ -852,6 +1030,14 @@ PopulationModel::evaluate(const SampleVector& samples,
                           const HaplotypeLikelihoodArray& haplotype_likelihoods) const
 {
     const auto genotype_masks = make_genotype_masks(sample_ploidies, genotypes);
+    if (use_sample_blocks(options_, samples.size())) {
+        return evaluate_in_sample_blocks(genotypes, samples.size(), calculate_frequency_update_norm(sample_ploidies), options_,
+                                         [&] (const auto block_begin, const auto block_end) {
+            const auto block_samples = copy_block(samples, block_begin, block_end);
+            const auto block_masks = copy_block(genotype_masks, block_begin, block_end);
+            return compute_genotype_log_likelihoods(block_samples, genotypes, haplotype_likelihoods, block_masks);
+        });
+    }
     const auto genotype_log_likelihoods = compute_genotype_log_likelihoods(samples, genotypes, haplotype_likelihoods, genotype_masks);
     std::vector<std::size_t> sample_genotype_set_ids, genotype_set_sizes;
     std::tie(sample_genotype_set_ids, genotype_set_sizes) = get_genotype_sets(sample_ploidies, genotypes);
@@ -879,6 +1065,14 @@ PopulationModel::evaluate(const SampleVector& samples,
                           const HaplotypeLikelihoodArray& haplotype_likelihoods) const
 {
     const auto genotype_masks = make_genotype_masks(sample_ploidies, genotypes);
+    if (use_sample_blocks(options_, samples.size())) {
+        return evaluate_in_sample_blocks(genotypes, samples.size(), calculate_frequency_update_norm(sample_ploidies), options_,
+                                         [&] (const auto block_begin, const auto block_end) {
+            const auto block_samples = copy_block(samples, block_begin, block_end);
+            const auto block_masks = copy_block(genotype_masks, block_begin, block_end);
+            return compute_genotype_log_likelihoods(block_samples, haplotypes, genotype_indices, haplotype_likelihoods, block_masks);
+        });
+    }
     const auto genotype_log_likelihoods = compute_genotype_log_likelihoods(samples, haplotypes, genotype_indices, haplotype_likelihoods, genotype_masks);
     std::vector<std::size_t> sample_genotype_set_ids, genotype_set_sizes;
     std::tie(sample_genotype_set_ids, genotype_set_sizes) = get_genotype_sets(sample_ploidies, genotypes);
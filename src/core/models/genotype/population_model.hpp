@@ -28,6 +28,12 @@ public:
         boost::optional<std::size_t> max_genotype_combinations = boost::none;
         unsigned max_em_iterations = 100;
         double em_epsilon = 0.001;
+        // Cohorts with more samples than this are evaluated in blocks of this many samples. Haplotype
+        // frequencies are then estimated by EM over compact per-sample genotype likelihood summaries,
+        // and genotype combinations are not enumerated, so the prior model is not used.
+        boost::optional<std::size_t> sample_block_size = boost::none;
+        // Genotypes with log likelihood this far below a sample's best are dropped from its summary
+        double max_summary_log_likelihood_loss = 50;
     };
     struct Latents
     {
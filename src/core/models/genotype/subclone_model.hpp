@@ -212,8 +212,8 @@ flatten(const Genotype<Haplotype>& genotype, const SampleName& sample,
     VBGenotype<K> result {};
     std::transform(std::cbegin(genotype), std::cend(genotype), std::begin(result),
                    [&sample, &haplotype_likelihoods] (const Haplotype& haplotype)
-                   -> std::reference_wrapper<const VBReadLikelihoodArray::BaseType> {
-                       return std::cref(haplotype_likelihoods(sample, haplotype));
+                   -> VBReadLikelihoodArray::BaseType {
+                       return haplotype_likelihoods(sample, haplotype);
                    });
     return result;
 }
@@ -225,8 +225,8 @@ auto copy_cref(const Genotype<Haplotype>& genotype, const SampleName& sample,
 {
     return std::transform(std::cbegin(genotype), std::cend(genotype), result_itr,
                           [&sample, &haplotype_likelihoods] (const Haplotype& haplotype)
-                          -> std::reference_wrapper<const VBReadLikelihoodArray::BaseType> {
-                              return std::cref(haplotype_likelihoods(sample, haplotype));
+                          -> VBReadLikelihoodArray::BaseType {
+                              return haplotype_likelihoods(sample, haplotype);
                           });
 }
 
@@ -131,11 +131,12 @@ bool operator>(const ParentsProbabilityPair& lhs, const ParentsProbabilityPair&
 auto compute_likelihoods(const std::vector<Genotype<Haplotype>>& genotypes,
                          const ConstantMixtureGenotypeLikelihoodModel& model)
 {
+    const auto likelihoods = model.evaluate(genotypes);
     std::vector<GenotypeRefProbabilityPair> result {};
     result.reserve(genotypes.size());
-    std::transform(std::cbegin(genotypes), std::cend(genotypes), std::back_inserter(result),
-                   [&model] (const auto& genotype) {
-                       return GenotypeRefProbabilityPair {genotype, model.evaluate(genotype)};
+    std::transform(std::cbegin(genotypes), std::cend(genotypes), std::cbegin(likelihoods), std::back_inserter(result),
+                   [] (const auto& genotype, const auto likelihood) {
+                       return GenotypeRefProbabilityPair {genotype, likelihood};
                    });
     return result;
 }
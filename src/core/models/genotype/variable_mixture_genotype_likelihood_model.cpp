@@ -60,7 +60,7 @@ void VariableMixtureGenotypeLikelihoodModel::prime(const std::vector<Haplotype>&
     assert(likelihoods_.is_primed());
     indexed_likelihoods_.reserve(haplotypes.size());
     std::transform(std::cbegin(haplotypes), std::cend(haplotypes), std::back_inserter(indexed_likelihoods_),
-                   [this] (const auto& haplotype) -> const HaplotypeLikelihoodArray::LikelihoodVector& {
+                   [this] (const auto& haplotype) -> HaplotypeLikelihoodArray::LikelihoodSpan {
                        return likelihoods_[haplotype]; });
 }
 
@@ -91,15 +91,15 @@ VariableMixtureGenotypeLikelihoodModel::evaluate(const Genotype<Haplotype>& geno
     assert(buffer_.size() == mixtures_.size());
     likelihood_refs_.clear();
     std::transform(std::cbegin(genotype), std::cend(genotype), std::back_inserter(likelihood_refs_),
-                   [this] (const auto& haplotype) -> const HaplotypeLikelihoodArray::LikelihoodVector& {
+                   [this] (const auto& haplotype) -> HaplotypeLikelihoodArray::LikelihoodSpan {
                        return likelihoods_[haplotype]; });
     LogProbability result {0};
-    const auto num_reads = likelihood_refs_.front().get().size();
+    const auto num_reads = likelihood_refs_.front().size();
     for (std::size_t read_idx {0}; read_idx < num_reads; ++read_idx) {
         std::transform(std::cbegin(likelihood_refs_), std::cend(likelihood_refs_),
                        std::cbegin(log_mixtures_), std::begin(buffer_),
                        [read_idx] (const auto& likelihoods, auto log_mixture) noexcept {
-                            return log_mixture + likelihoods.get()[read_idx]; });
+                            return log_mixture + likelihoods[read_idx]; });
         result += maths::log_sum_exp(buffer_);
     }
     return result;
@@ -112,11 +112,11 @@ VariableMixtureGenotypeLikelihoodModel::evaluate(const GenotypeIndex& genotype)
     assert(genotype.size() == mixtures_.size());
     assert(buffer_.size() == mixtures_.size());
     LogProbability result {0};
-    const auto num_reads = indexed_likelihoods_.front().get().size();
+    const auto num_reads = indexed_likelihoods_.front().size();
     for (std::size_t read_idx {0}; read_idx < num_reads; ++read_idx) {
         std::transform(std::cbegin(genotype), std::cend(genotype), std::cbegin(log_mixtures_), std::begin(buffer_),
                        [this, read_idx] (auto haplotype_idx, auto log_mixture) noexcept {
-                           return log_mixture + indexed_likelihoods_[haplotype_idx].get()[read_idx]; });
+                           return log_mixture + indexed_likelihoods_[haplotype_idx][read_idx]; });
         result += maths::log_sum_exp(buffer_);
     }
     return result;
@@ -129,16 +129,16 @@ VariableMixtureGenotypeLikelihoodModel::evaluate(const CancerGenotype<Haplotype>
     assert(buffer_.size() == mixtures_.size());
     likelihood_refs_.clear();
     std::transform(std::cbegin(genotype.germline()), std::cend(genotype.germline()), std::back_inserter(likelihood_refs_),
-                  [this] (const auto& haplotype) -> const HaplotypeLikelihoodArray::LikelihoodVector& { return likelihoods_[haplotype]; });
+                  [this] (const auto& haplotype) -> HaplotypeLikelihoodArray::LikelihoodSpan { return likelihoods_[haplotype]; });
     std::transform(std::cbegin(genotype.somatic()), std::cend(genotype.somatic()), std::back_inserter(likelihood_refs_),
-                   [this] (const auto& haplotype) -> const HaplotypeLikelihoodArray::LikelihoodVector& { return likelihoods_[haplotype]; });
+                   [this] (const auto& haplotype) -> HaplotypeLikelihoodArray::LikelihoodSpan { return likelihoods_[haplotype]; });
     LogProbability result {0};
-    const auto num_reads = likelihood_refs_.front().get().size();
+    const auto num_reads = likelihood_refs_.front().size();
     for (std::size_t read_idx {0}; read_idx < num_reads; ++read_idx) {
         std::transform(std::cbegin(likelihood_refs_), std::cend(likelihood_refs_),
                        std::cbegin(log_mixtures_), std::begin(buffer_),
                        [read_idx] (const auto& likelihoods, auto log_mixture) noexcept {
-                           return log_mixture + likelihoods.get()[read_idx]; });
+                           return log_mixture + likelihoods[read_idx]; });
         result += maths::log_sum_exp(buffer_);
     }
     return result;
@@ -151,16 +151,16 @@ VariableMixtureGenotypeLikelihoodModel::evaluate(const CancerGenotypeIndex& geno
     assert((genotype.germline.size() + genotype.somatic.size()) == mixtures_.size());
     assert(buffer_.size() == mixtures_.size());
     LogProbability result {0};
-    const auto num_reads = indexed_likelihoods_.front().get().size();
+    const auto num_reads = indexed_likelihoods_.front().size();
     for (std::size_t read_idx {0}; read_idx < num_reads; ++read_idx) {
         auto buffer_itr = std::transform(std::cbegin(genotype.germline), std::cend(genotype.germline),
                                          std::cbegin(log_mixtures_), std::begin(buffer_),
                                          [=] (auto haplotype_idx, auto log_mixture) noexcept {
-                                             return log_mixture + indexed_likelihoods_[haplotype_idx].get()[read_idx]; });
+                                             return log_mixture + indexed_likelihoods_[haplotype_idx][read_idx]; });
         std::transform(std::cbegin(genotype.somatic), std::cend(genotype.somatic),
                        std::next(std::cbegin(log_mixtures_), genotype.germline.size()), buffer_itr,
                        [this, read_idx] (auto haplotype_idx, auto log_mixture) noexcept {
-                           return log_mixture + indexed_likelihoods_[haplotype_idx].get()[read_idx]; });
+                           return log_mixture + indexed_likelihoods_[haplotype_idx][read_idx]; });
         result += maths::log_sum_exp(buffer_);
     }
     return result;
@@ -54,11 +54,11 @@ using VBAlphaVector = std::vector<VBAlpha<K>>;
 class VBReadLikelihoodArray
 {
 public:
-    using BaseType = HaplotypeLikelihoodArray::LikelihoodVector;
+    using BaseType = HaplotypeLikelihoodArray::LikelihoodSpan;
     
     VBReadLikelihoodArray() = default;
     
-    explicit VBReadLikelihoodArray(const BaseType&);
+    explicit VBReadLikelihoodArray(BaseType);
     
     VBReadLikelihoodArray(const VBReadLikelihoodArray&)            = default;
     VBReadLikelihoodArray& operator=(const VBReadLikelihoodArray&) = default;
@@ -67,15 +67,14 @@ public:
     
     ~VBReadLikelihoodArray() = default;
     
-    void operator=(const BaseType&);
-    void operator=(std::reference_wrapper<const BaseType>);
+    void operator=(BaseType);
     std::size_t size() const noexcept;
     BaseType::const_iterator begin() const noexcept;
     BaseType::const_iterator end() const noexcept;
     BaseType::value_type operator[](const std::size_t n) const noexcept;
 
 private:
-    const BaseType* likelihoods;
+    BaseType likelihoods;
 };
 
 template <std::size_t K>
@@ -671,37 +670,32 @@ run_variational_bayes(const VBAlphaVector<K>& prior_alphas,
     return {std::move(latents[max_evidence_idx]), log_evidences[max_evidence_idx], std::move(weighted_genotype_posteriors)};
 }
 
-inline VBReadLikelihoodArray::VBReadLikelihoodArray(const BaseType& underlying_likelihoods)
-: likelihoods{std::addressof(underlying_likelihoods)} {}
+inline VBReadLikelihoodArray::VBReadLikelihoodArray(BaseType underlying_likelihoods)
+: likelihoods {underlying_likelihoods} {}
 
-inline void VBReadLikelihoodArray::operator=(const BaseType& other)
+inline void VBReadLikelihoodArray::operator=(BaseType other)
 {
-    likelihoods = std::addressof(other);
-}
-
-inline void VBReadLikelihoodArray::operator=(std::reference_wrapper<const BaseType> other)
-{
-    likelihoods = std::addressof(other.get());
+    likelihoods = other;
 }
 
 inline std::size_t VBReadLikelihoodArray::size() const noexcept
 {
-    return likelihoods->size();
+    return likelihoods.size();
 }
 
 inline VBReadLikelihoodArray::BaseType::const_iterator VBReadLikelihoodArray::begin() const noexcept
 {
-    return likelihoods->begin();
+    return likelihoods.begin();
 }
 
 inline VBReadLikelihoodArray::BaseType::const_iterator VBReadLikelihoodArray::end() const noexcept
 {
-    return likelihoods->end();
+    return likelihoods.end();
 }
 
 inline VBReadLikelihoodArray::BaseType::value_type VBReadLikelihoodArray::operator[](const std::size_t n) const noexcept
 {
-    return likelihoods->operator[](n);
+    return likelihoods[n];
 }
 
 template <std::size_t K>
@@ -4,15 +4,22 @@
 #include "haplotype_likelihood_array.hpp"
 
 #include <utility>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
 #include <cassert>
 
+#include "utils/thread_pool.hpp"
+
 namespace octopus {
 
 // public methods
 
 HaplotypeLikelihoodArray::HaplotypeLikelihoodArray(const unsigned max_haplotypes,
                                                    const std::vector<SampleName>& samples)
-: cache_ {max_haplotypes}
+: haplotype_indices_ {max_haplotypes}
 , sample_indices_ {samples.size()}
 {
     mapping_positions_.resize(maxMappingPositions);
@@ -22,7 +29,7 @@ HaplotypeLikelihoodArray::HaplotypeLikelihoodArray(HaplotypeLikelihoodModel like
                                                    unsigned max_haplotypes,
                                                    const std::vector<SampleName>& samples)
 : likelihood_model_ {std::move(likelihood_model)}
-, cache_ {max_haplotypes}
+, haplotype_indices_ {max_haplotypes}
 , sample_indices_ {samples.size()}
 {
     mapping_positions_.resize(maxMappingPositions);
@@ -40,54 +47,66 @@ HaplotypeLikelihoodArray::TemplatePacket::TemplatePacket(Iterator first, Iterato
 , num_templates {static_cast<std::size_t>(std::distance(first, last))}
 {}
 
+void HaplotypeLikelihoodArray::set_cache(ReadLikelihoodCache* cache) noexcept
+{
+    likelihood_model_.set_cache(cache);
+}
+
+void HaplotypeLikelihoodArray::set_workers(ThreadPool* workers) noexcept
+{
+    workers_ = workers;
+}
+
+void HaplotypeLikelihoodArray::set_arena(MemoryArena* arena) noexcept
+{
+    arena_ = arena;
+}
+
 void HaplotypeLikelihoodArray::populate(const ReadMap& reads,
                                         const MappableBlock<Haplotype>& haplotypes,
                                         boost::optional<FlankState> flank_state)
 {
     // This code is not very pretty because it is a bottleneck for the entire application.
     // We want to try a minimise memory allocations for the mapping.
-    cache_.clear();
-    if (cache_.bucket_count() < haplotypes.size()) {
-        cache_.rehash(haplotypes.size());
-    }
+    index_haplotypes(haplotypes);
     set_read_iterators_and_sample_indices(reads);
     assert(reads.size() == read_iterators_.size());
     const auto num_samples = reads.size();
+    std::vector<std::size_t> num_reads(num_samples);
+    std::transform(std::cbegin(read_iterators_), std::cend(read_iterators_), std::begin(num_reads),
+                   [] (const auto& t) { return t.num_reads; });
+    allocate_likelihoods(num_reads);
     // Precompute all read hashes so we don't have to recompute for each haplotype
-    std::vector<std::vector<KmerPerfectHashes>> read_hashes {};
+    ReadHashes read_hashes {};
     read_hashes.reserve(num_samples);
     for (const auto& t : read_iterators_) {
-        std::vector<KmerPerfectHashes> sample_read_hashes {};
+        ArenaVector<ReadKmerHashes> sample_read_hashes {arena_};
         sample_read_hashes.reserve(t.num_reads);
-        std::transform(t.first, t.last, std::back_inserter(sample_read_hashes),
-                       [] (const AlignedRead& read) { return compute_kmer_hashes<mapperKmerSize>(read.sequence()); });
-        read_hashes.emplace_back(std::move(sample_read_hashes));
+        std::for_each(t.first, t.last, [&] (const AlignedRead& read) {
+            sample_read_hashes.emplace_back(arena_);
+            compute_kmer_hashes<mapperKmerSize>(read.sequence(), sample_read_hashes.back());
+        });
+        read_hashes.push_back(std::move(sample_read_hashes));
+    }
+    if (use_workers(haplotypes)) {
+        populate_parallel(read_hashes, haplotypes, flank_state);
+        read_iterators_.clear();
+        return;
     }
     auto haplotype_hashes = init_kmer_hash_table<mapperKmerSize>();
-    const auto first_mapping_position = std::begin(mapping_positions_);
-    for (const auto& haplotype : haplotypes) {
+    MappedIndexCounts haplotype_mapping_counts {};
+    const auto evaluation_order = order_haplotypes(haplotypes);
+    for (auto itr = std::cbegin(evaluation_order); itr != std::cend(evaluation_order); ++itr) {
+        const Haplotype& haplotype {**itr};
+        const auto haplotype_index = haplotype_indices_.at(haplotype);
         populate_kmer_hash_table<mapperKmerSize>(haplotype.sequence(), haplotype_hashes);
-        auto haplotype_mapping_counts = init_mapping_counts(haplotype_hashes);
-        auto itr = std::begin(cache_.emplace(std::piecewise_construct,
-                                             std::forward_as_tuple(haplotype),
-                                             std::forward_as_tuple(num_samples)).first->second);
+        haplotype_mapping_counts.resize(haplotype_hashes.num_indices); // mapping leaves counts zeroed
         likelihood_model_.reset(haplotype, flank_state);
-        auto read_hash_itr = std::cbegin(read_hashes);
-        for (const auto& t : read_iterators_) { // for each sample
-            *itr = std::vector<LogProbability>(t.num_reads);
-            std::transform(t.first, t.last, std::cbegin(*read_hash_itr), std::begin(*itr),
-                           [&] (const AlignedRead& read, const auto& read_hashes) {
-                               const auto last_mapping_position = map_query_to_target(read_hashes, haplotype_hashes,
-                                                                                      haplotype_mapping_counts,
-                                                                                      first_mapping_position,
-                                                                                      maxMappingPositions);
-                               reset_mapping_counts(haplotype_mapping_counts);
-                               return likelihood_model_.evaluate(read, first_mapping_position, last_mapping_position);
-                           });
-            ++read_hash_itr;
-            ++itr;
+        if (std::next(itr) != std::cend(evaluation_order)) likelihood_model_.share_prefix(**std::next(itr));
+        for (std::size_t s {0}; s < num_samples; ++s) {
+            evaluate(likelihood_model_, read_iterators_[s], read_hashes[s], haplotype_hashes, haplotype_mapping_counts,
+                     mapping_positions_, read_mapping_positions_, row(s, haplotype_index));
         }
-        clear_kmer_hash_table(haplotype_hashes);
     }
     likelihood_model_.clear();
     read_iterators_.clear();
@@ -96,40 +115,46 @@ void HaplotypeLikelihoodArray::populate(const ReadMap& reads,
 void HaplotypeLikelihoodArray::populate(const TemplateMap& reads, const MappableBlock<Haplotype>& haplotypes,
                                         boost::optional<FlankState> flank_state)
 {
-    cache_.clear();
-    if (cache_.bucket_count() < haplotypes.size()) {
-        cache_.rehash(haplotypes.size());
-    }
+    index_haplotypes(haplotypes);
     set_template_iterators_and_sample_indices(reads);
     assert(reads.size() == template_iterators_.size());
     const auto num_samples = reads.size();
+    std::vector<std::size_t> num_templates(num_samples);
+    std::transform(std::cbegin(template_iterators_), std::cend(template_iterators_), std::begin(num_templates),
+                   [] (const auto& t) { return t.num_templates; });
+    allocate_likelihoods(num_templates);
     // Precompute all read hashes so we don't have to recompute for each haplotype
-    std::vector<std::vector<std::vector<KmerPerfectHashes>>> template_hashes {};
+    std::vector<ArenaVector<ArenaVector<ReadKmerHashes>>> template_hashes {};
     template_hashes.reserve(num_samples);
     for (const auto& t : template_iterators_) {
-        std::vector<std::vector<KmerPerfectHashes>> sample_read_hashes {};
+        ArenaVector<ArenaVector<ReadKmerHashes>> sample_read_hashes {arena_};
         sample_read_hashes.reserve(t.num_templates);
-        std::transform(t.first, t.last, std::back_inserter(sample_read_hashes), [] (const AlignedTemplate& reads) {
-            std::vector<KmerPerfectHashes> result {};
+        std::for_each(t.first, t.last, [&] (const AlignedTemplate& reads) {
+            sample_read_hashes.emplace_back(arena_);
+            auto& result = sample_read_hashes.back();
             result.reserve(reads.size());
-            for (const auto& read : reads) result.push_back(compute_kmer_hashes<mapperKmerSize>(read.sequence()));
-            return result;
+            for (const auto& read : reads) {
+                result.emplace_back(arena_);
+                compute_kmer_hashes<mapperKmerSize>(read.sequence(), result.back());
+            }
         });
-        template_hashes.emplace_back(std::move(sample_read_hashes));
+        template_hashes.push_back(std::move(sample_read_hashes));
     }
     auto haplotype_hashes = init_kmer_hash_table<mapperKmerSize>();
+    MappedIndexCounts haplotype_mapping_counts {};
     thread_local std::vector<HaplotypeLikelihoodModel::MappingPositionVector> mapping_positions {};
-    for (const auto& haplotype : haplotypes) {
+    const auto evaluation_order = order_haplotypes(haplotypes);
+    for (auto itr = std::cbegin(evaluation_order); itr != std::cend(evaluation_order); ++itr) {
+        const Haplotype& haplotype {**itr};
+        const auto haplotype_index = haplotype_indices_.at(haplotype);
         populate_kmer_hash_table<mapperKmerSize>(haplotype.sequence(), haplotype_hashes);
-        auto haplotype_mapping_counts = init_mapping_counts(haplotype_hashes);
-        auto itr = std::begin(cache_.emplace(std::piecewise_construct,
-                                             std::forward_as_tuple(haplotype),
-                                             std::forward_as_tuple(num_samples)).first->second);
+        haplotype_mapping_counts.resize(haplotype_hashes.num_indices); // mapping leaves counts zeroed
         likelihood_model_.reset(haplotype, flank_state);
+        if (std::next(itr) != std::cend(evaluation_order)) likelihood_model_.share_prefix(**std::next(itr));
         auto template_hash_itr = std::cbegin(template_hashes);
+        std::size_t sample_index {0};
         for (const auto& t : template_iterators_) { // for each sample
-            *itr = std::vector<LogProbability>(t.num_templates);
-            std::transform(t.first, t.last, std::cbegin(*template_hash_itr), std::begin(*itr),
+            std::transform(t.first, t.last, std::cbegin(*template_hash_itr), row(sample_index, haplotype_index),
                            [&] (const AlignedTemplate& read_template, const auto& template_hashes) {
                                mapping_positions.resize(read_template.size());
                                assert(read_template.size() == template_hashes.size());
@@ -140,14 +165,12 @@ void HaplotypeLikelihoodArray::populate(const TemplateMap& reads, const Mappable
                                                                                   std::begin(mapping_positions[i]),
                                                                                   maxMappingPositions),
                                                               std::end(mapping_positions[i]));
-                                   reset_mapping_counts(haplotype_mapping_counts);
                                }
                                return likelihood_model_.evaluate(read_template, mapping_positions);
                            });
             ++template_hash_itr;
-            ++itr;
+            ++sample_index;
         }
-        clear_kmer_hash_table(haplotype_hashes);
     }
     likelihood_model_.clear();
     read_iterators_.clear();
@@ -155,46 +178,77 @@ void HaplotypeLikelihoodArray::populate(const TemplateMap& reads, const Mappable
 
 std::size_t HaplotypeLikelihoodArray::num_likelihoods(const SampleName& sample) const
 {
-    return std::cbegin(cache_)->second.at(sample_indices_.at(sample)).size();
+    return num_likelihoods(sample_indices_.at(sample));
 }
 
-const HaplotypeLikelihoodArray::LikelihoodVector&
+std::size_t HaplotypeLikelihoodArray::num_likelihoods(const std::size_t sample_index) const noexcept
+{
+    return likelihoods_[sample_index].num_likelihoods;
+}
+
+HaplotypeLikelihoodArray::LikelihoodSpan
 HaplotypeLikelihoodArray::operator()(const SampleName& sample, const Haplotype& haplotype) const
 {
-    return cache_.at(haplotype)[sample_indices_.at(sample)];
+    return operator()(sample_index(sample), haplotype_index(haplotype));
 }
 
-const HaplotypeLikelihoodArray::LikelihoodVector&
+HaplotypeLikelihoodArray::LikelihoodSpan
 HaplotypeLikelihoodArray::operator[](const Haplotype& haplotype) const
 {
-    return cache_.at(haplotype)[*primed_sample_];
+    return operator[](haplotype_index(haplotype));
+}
+
+std::size_t HaplotypeLikelihoodArray::sample_index(const SampleName& sample) const
+{
+    return sample_indices_.at(sample);
+}
+
+std::size_t HaplotypeLikelihoodArray::haplotype_index(const Haplotype& haplotype) const
+{
+    return haplotype_indices_.at(haplotype);
+}
+
+HaplotypeLikelihoodArray::LikelihoodSpan
+HaplotypeLikelihoodArray::operator()(const std::size_t sample_index, const std::size_t haplotype_index) const noexcept
+{
+    const auto& matrix = likelihoods_[sample_index];
+    assert((haplotype_index + 1) * matrix.num_likelihoods <= matrix.values.size());
+    return {matrix.values.data() + haplotype_index * matrix.num_likelihoods, matrix.num_likelihoods};
+}
+
+HaplotypeLikelihoodArray::LikelihoodSpan
+HaplotypeLikelihoodArray::operator[](const std::size_t haplotype_index) const noexcept
+{
+    return operator()(*primed_sample_, haplotype_index);
 }
 
 HaplotypeLikelihoodArray::SampleLikelihoodMap
 HaplotypeLikelihoodArray::extract_sample(const SampleName& sample) const
 {
-    const auto sample_index = sample_indices_.at(sample);
-    SampleLikelihoodMap result {cache_.size()};
-    for (const auto& p : cache_) {
-        result.emplace(p.first, p.second[sample_index]);
+    const auto sample_idx = sample_index(sample);
+    SampleLikelihoodMap result {haplotype_indices_.size()};
+    for (const auto& p : haplotype_indices_) {
+        result.emplace(p.first, operator()(sample_idx, p.second));
     }
     return result;
 }
 
 bool HaplotypeLikelihoodArray::contains(const Haplotype& haplotype) const noexcept
 {
-    return cache_.count(haplotype) == 1;
+    return haplotype_indices_.count(haplotype) == 1;
 }
 
 bool HaplotypeLikelihoodArray::is_empty() const noexcept
 {
-    return cache_.empty();
+    return haplotype_indices_.empty();
 }
 
 void HaplotypeLikelihoodArray::clear() noexcept
 {
-    cache_.clear();
+    haplotype_indices_.clear();
+    num_rows_ = 0;
     sample_indices_.clear();
+    likelihoods_.clear();
     unprime();
 }
 
@@ -215,6 +269,172 @@ void HaplotypeLikelihoodArray::unprime() const noexcept
 
 // private methods
 
+namespace {
+
+// Runs job(i, slot) for each i in [0, num_jobs) on the calling thread and up to num_slots - 1 pool
+// threads. Slots are unique among the threads running jobs, so can index per thread state. Pool threads
+// that start after all jobs have been claimed return without touching any job state, so the calling
+// thread never waits on pool threads that are busy with other work. The first exception is rethrown.
+template <typename Job>
+void run_jobs(ThreadPool& pool, const std::size_t num_jobs, const std::size_t num_slots, Job& job)
+{
+    struct SharedState
+    {
+        std::atomic<std::size_t> next_job {0}, next_slot {0};
+        std::size_t num_completed {0};
+        std::exception_ptr error {};
+        std::mutex mutex {};
+        std::condition_variable completed {};
+    };
+    auto state = std::make_shared<SharedState>();
+    const auto worker = [state, num_jobs, &job] () {
+        boost::optional<std::size_t> slot {};
+        for (auto i = state->next_job++; i < num_jobs; i = state->next_job++) {
+            if (!slot) slot = state->next_slot++;
+            std::exception_ptr error {};
+            try {
+                job(i, *slot);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock {state->mutex};
+            if (error && !state->error) state->error = error;
+            if (++state->num_completed == num_jobs) state->completed.notify_all();
+        }
+    };
+    for (std::size_t i {1}; i < std::min(num_slots, num_jobs); ++i) {
+        pool.push(worker);
+    }
+    worker();
+    std::unique_lock<std::mutex> lock {state->mutex};
+    state->completed.wait(lock, [&] () { return state->num_completed == num_jobs; });
+    if (state->error) std::rethrow_exception(state->error);
+}
+
+} // namespace
+
+bool HaplotypeLikelihoodArray::use_workers(const MappableBlock<Haplotype>& haplotypes) const noexcept
+{
+    if (!workers_ || workers_->empty() || haplotypes.size() * read_iterators_.size() < 2) return false;
+    std::size_t num_reads {0};
+    for (const auto& t : read_iterators_) num_reads += t.num_reads;
+    return haplotypes.size() * num_reads >= minParallelEvaluations;
+}
+
+void HaplotypeLikelihoodArray::populate_parallel(const ReadHashes& read_hashes,
+                                                 const MappableBlock<Haplotype>& haplotypes,
+                                                 const boost::optional<FlankState>& flank_state)
+{
+    // Results are allocated up front so each worker only writes to the rows it claims
+    struct Cell
+    {
+        const Haplotype* haplotype;
+        std::size_t sample;
+        LogProbability* result;
+        std::size_t num_reads;
+    };
+    const auto num_samples = read_iterators_.size();
+    std::vector<Cell> cells {};
+    cells.reserve(haplotypes.size() * num_samples);
+    std::size_t num_evaluations {0};
+    for (const Haplotype* haplotype : order_haplotypes(haplotypes)) {
+        const auto haplotype_index = haplotype_indices_.at(*haplotype);
+        for (std::size_t s {0}; s < num_samples; ++s) {
+            const auto num_reads = read_iterators_[s].num_reads;
+            cells.push_back({haplotype, s, row(s, haplotype_index), num_reads});
+            num_evaluations += num_reads;
+        }
+    }
+    // Cells are haplotype major, so contiguous chunks let workers reuse haplotype k-mer tables
+    const auto num_threads = workers_->size() + 1;
+    const auto target_chunk_size = std::max(num_evaluations / (chunksPerThread * num_threads), std::size_t {1});
+    std::vector<std::size_t> chunk_ends {};
+    std::size_t chunk_size {0};
+    for (std::size_t i {0}; i < cells.size(); ++i) {
+        chunk_size += cells[i].num_reads;
+        if (chunk_size >= target_chunk_size) {
+            chunk_ends.push_back(i + 1);
+            chunk_size = 0;
+        }
+    }
+    if (chunk_ends.empty() || chunk_ends.back() != cells.size()) chunk_ends.push_back(cells.size());
+    const auto num_slots = std::min(num_threads, chunk_ends.size());
+    if (worker_states_.size() < num_slots) {
+        worker_states_.resize(num_slots, {likelihood_model_, init_kmer_hash_table<mapperKmerSize>(), {}, {}, {}, nullptr});
+    }
+    for (std::size_t i {0}; i < num_slots; ++i) {
+        worker_states_[i].likelihood_model = likelihood_model_;
+        worker_states_[i].mapping_positions.resize(maxMappingPositions);
+    }
+    auto evaluate_chunk = [&] (const std::size_t chunk, const std::size_t slot) {
+        auto& worker = worker_states_[slot];
+        const auto first_cell = std::next(std::cbegin(cells), chunk > 0 ? chunk_ends[chunk - 1] : 0);
+        const auto last_cell = std::next(std::cbegin(cells), chunk_ends[chunk]);
+        for (auto cell = first_cell; cell != last_cell; ++cell) {
+            if (worker.haplotype != cell->haplotype) {
+                populate_kmer_hash_table<mapperKmerSize>(cell->haplotype->sequence(), worker.haplotype_hashes);
+                worker.haplotype_mapping_counts.resize(worker.haplotype_hashes.num_indices);
+                worker.likelihood_model.reset(*cell->haplotype, flank_state);
+                worker.haplotype = cell->haplotype;
+                const auto next_cell = std::find_if(cell, last_cell, [&] (const Cell& other) { return other.haplotype != cell->haplotype; });
+                if (next_cell != last_cell) worker.likelihood_model.share_prefix(*next_cell->haplotype);
+            }
+            evaluate(worker.likelihood_model, read_iterators_[cell->sample], read_hashes[cell->sample],
+                     worker.haplotype_hashes, worker.haplotype_mapping_counts, worker.mapping_positions,
+                     worker.read_mapping_positions, cell->result);
+        }
+    };
+    auto reset_workers = [&] () {
+        for (std::size_t i {0}; i < num_slots; ++i) {
+            auto& worker = worker_states_[i];
+            worker.haplotype = nullptr;
+            worker.likelihood_model.clear();
+        }
+    };
+    try {
+        run_jobs(*workers_, chunk_ends.size(), num_slots, evaluate_chunk);
+    } catch (...) {
+        reset_workers();
+        throw;
+    }
+    reset_workers();
+}
+
+void HaplotypeLikelihoodArray::evaluate(HaplotypeLikelihoodModel& likelihood_model, const ReadPacket& reads,
+                                        const ArenaVector<ReadKmerHashes>& read_hashes,
+                                        const KmerHashTable& haplotype_hashes,
+                                        MappedIndexCounts& haplotype_mapping_counts,
+                                        std::vector<std::size_t>& mapping_positions,
+                                        std::vector<HaplotypeLikelihoodModel::MappingPositionVector>& read_mapping_positions,
+                                        LogProbability* result)
+{
+    assert(mapping_positions.size() >= maxMappingPositions);
+    const auto min_batch_size = likelihood_model.config().min_batch_size;
+    if (min_batch_size && reads.num_reads >= *min_batch_size) {
+        // Map all reads first so they can be evaluated together
+        read_mapping_positions.resize(reads.num_reads);
+        auto read_mapping_positions_itr = std::begin(read_mapping_positions);
+        for (const auto& hashes : read_hashes) {
+            auto& positions = *read_mapping_positions_itr++;
+            positions.resize(maxMappingPositions);
+            positions.erase(map_query_to_target(hashes, haplotype_hashes, haplotype_mapping_counts,
+                                                std::begin(positions), maxMappingPositions),
+                            std::end(positions));
+        }
+        likelihood_model.evaluate(reads.first, reads.last, read_mapping_positions, result);
+    } else {
+        const auto first_mapping_position = std::begin(mapping_positions);
+        std::transform(reads.first, reads.last, std::cbegin(read_hashes), result,
+                       [&] (const AlignedRead& read, const auto& hashes) {
+                           const auto last_mapping_position = map_query_to_target(hashes, haplotype_hashes,
+                                                                                  haplotype_mapping_counts,
+                                                                                  first_mapping_position,
+                                                                                  maxMappingPositions);
+                           return likelihood_model.evaluate(read, first_mapping_position, last_mapping_position);
+                       });
+    }
+}
+
 void HaplotypeLikelihoodArray::set_read_iterators_and_sample_indices(const ReadMap& reads)
 {
     read_iterators_.clear();
@@ -251,6 +471,72 @@ void HaplotypeLikelihoodArray::set_template_iterators_and_sample_indices(const T
     }
 }
 
+void HaplotypeLikelihoodArray::index_haplotypes(const MappableBlock<Haplotype>& haplotypes)
+{
+    haplotype_indices_.clear();
+    if (haplotype_indices_.bucket_count() < haplotypes.size()) {
+        haplotype_indices_.rehash(haplotypes.size());
+    }
+    num_rows_ = 0;
+    for (const auto& haplotype : haplotypes) {
+        if (haplotype_indices_.emplace(haplotype, num_rows_).second) ++num_rows_;
+    }
+}
+
+std::vector<const Haplotype*> HaplotypeLikelihoodArray::order_haplotypes(const MappableBlock<Haplotype>& haplotypes) const
+{
+    std::vector<const Haplotype*> result {};
+    result.reserve(num_rows_);
+    for (const auto& haplotype : haplotypes) {
+        if (haplotype_indices_.at(haplotype) == result.size()) result.push_back(std::addressof(haplotype)); // skip duplicates
+    }
+    if (likelihood_model_.config().share_haplotype_prefixes) {
+        // Lexicographic order puts haplotypes with the longest shared prefixes next to each other
+        std::sort(std::begin(result), std::end(result), [] (const Haplotype* lhs, const Haplotype* rhs) { return *lhs < *rhs; });
+    }
+    return result;
+}
+
+void HaplotypeLikelihoodArray::allocate_likelihoods(const std::vector<std::size_t>& num_likelihoods)
+{
+    // Matrices are reused between calls to populate so their storage is only reallocated when it grows
+    likelihoods_.resize(num_likelihoods.size());
+    for (std::size_t s {0}; s < num_likelihoods.size(); ++s) {
+        likelihoods_[s].num_likelihoods = num_likelihoods[s];
+        likelihoods_[s].values.resize(num_rows_ * num_likelihoods[s]);
+    }
+}
+
+void HaplotypeLikelihoodArray::compact_rows()
+{
+    // Rows keep their relative order, so each live row moves to an equal or lower position
+    std::vector<std::size_t> live_rows {};
+    live_rows.reserve(haplotype_indices_.size());
+    for (const auto& p : haplotype_indices_) live_rows.push_back(p.second);
+    std::sort(std::begin(live_rows), std::end(live_rows));
+    std::vector<std::size_t> new_indices(num_rows_);
+    for (std::size_t i {0}; i < live_rows.size(); ++i) new_indices[live_rows[i]] = i;
+    for (auto& matrix : likelihoods_) {
+        const auto n = matrix.num_likelihoods;
+        for (std::size_t i {0}; i < live_rows.size(); ++i) {
+            if (live_rows[i] != i) {
+                const auto old_row = std::next(std::begin(matrix.values), live_rows[i] * n);
+                std::copy(old_row, std::next(old_row, n), std::next(std::begin(matrix.values), i * n));
+            }
+        }
+        matrix.values.resize(live_rows.size() * n);
+    }
+    for (auto& p : haplotype_indices_) p.second = new_indices[p.second];
+    num_rows_ = live_rows.size();
+}
+
+HaplotypeLikelihoodArray::LogProbability*
+HaplotypeLikelihoodArray::row(const std::size_t sample_index, const std::size_t haplotype_index) noexcept
+{
+    auto& matrix = likelihoods_[sample_index];
+    return matrix.values.data() + haplotype_index * matrix.num_likelihoods;
+}
+
 // non-member methods
 
 HaplotypeLikelihoodArray
@@ -260,14 +546,14 @@ merge_samples(const std::vector<SampleName>& samples,
               const HaplotypeLikelihoodArray& haplotype_likelihoods)
 {
     HaplotypeLikelihoodArray result {static_cast<unsigned>(haplotypes.size()), {new_sample}};
+    HaplotypeLikelihoodArray::LikelihoodVector likelihoods {};
     for (const auto& haplotype : haplotypes) {
-        HaplotypeLikelihoodArray::LikelihoodVector likelihoods {};
+        likelihoods.clear();
         for (const auto& sample : samples) {
-            const auto& m = haplotype_likelihoods(sample, haplotype);
+            const auto m = haplotype_likelihoods(sample, haplotype);
             likelihoods.insert(std::end(likelihoods), std::cbegin(m), std::cend(m));
         }
-        likelihoods.shrink_to_fit();
-        result.insert(new_sample, haplotype, std::move(likelihoods));
+        result.insert(new_sample, haplotype, likelihoods);
     }
     result.prime(new_sample);
     return result;
@@ -278,16 +564,15 @@ merge_samples(const HaplotypeLikelihoodArray& haplotype_likelihoods)
 {
     SampleName merged_sample_name {};
     for (const auto& p : haplotype_likelihoods.sample_indices_) merged_sample_name += p.first;
-    HaplotypeLikelihoodArray result {static_cast<unsigned>(haplotype_likelihoods.cache_.size()), {merged_sample_name}};
-    for (const auto& p : haplotype_likelihoods.cache_) {
-        const auto& haplotype = p.first;
-        HaplotypeLikelihoodArray::LikelihoodVector likelihoods {};
+    HaplotypeLikelihoodArray result {static_cast<unsigned>(haplotype_likelihoods.haplotype_indices_.size()), {merged_sample_name}};
+    HaplotypeLikelihoodArray::LikelihoodVector likelihoods {};
+    for (const auto& p : haplotype_likelihoods.haplotype_indices_) {
+        likelihoods.clear();
         for (const auto& s : haplotype_likelihoods.sample_indices_) {
-            const auto& m = haplotype_likelihoods(s.first, haplotype);
+            const auto m = haplotype_likelihoods(s.second, p.second);
             likelihoods.insert(std::end(likelihoods), std::cbegin(m), std::cend(m));
         }
-        likelihoods.shrink_to_fit();
-        result.insert(merged_sample_name, haplotype, std::move(likelihoods));
+        result.insert(merged_sample_name, p.first, likelihoods);
     }
     result.prime(merged_sample_name);
     return result;
@@ -302,7 +587,7 @@ rank_haplotypes(const MappableBlock<Haplotype>& haplotypes, const SampleName& sa
     std::vector<std::pair<std::reference_wrapper<const Haplotype>, HaplotypeLikelihoodArray::LogProbability>> ranks {};
     ranks.reserve(haplotypes.size());
     for (const auto& haplotype : haplotypes) {
-        const auto& likelihoods = haplotype_likelihoods(sample, haplotype);
+        const auto likelihoods = haplotype_likelihoods(sample, haplotype);
         ranks.emplace_back(haplotype, std::accumulate(std::cbegin(likelihoods), std::cend(likelihoods), 0.0));
     }
     std::sort(std::begin(ranks), std::end(ranks),
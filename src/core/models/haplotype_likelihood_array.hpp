@@ -12,6 +12,7 @@
 #include <iostream>
 #include <iomanip>
 #include <limits>
+#include <stdexcept>
 
 #include <boost/optional.hpp>
 
@@ -21,16 +22,29 @@
 #include "containers/mappable_block.hpp"
 #include "core/types/haplotype.hpp"
 #include "utils/kmer_mapper.hpp"
+#include "utils/memory_arena.hpp"
 #include "haplotype_likelihood_model.hpp"
+#include "read_likelihood_cache.hpp"
 
 namespace octopus {
 
+class ThreadPool;
+
 /*
     HaplotypeLikelihoodArray is essentially a matrix of haplotype likelihoods, i.e.
     p(read | haplotype) for a given set of AlignedReads and Haplotypes.
  
     The matrix can be efficiently populated as the read mapping and alignment are
     done internally which allows minimal memory allocation.
+ 
+    Each sample has one contiguous row-major haplotype x read matrix. Haplotypes are
+    assigned a row index when first added, so callers that look up the same haplotypes
+    repeatedly can hash each haplotype once with haplotype_index and then address rows
+    directly.
+ 
+    If given a worker pool, populate splits the haplotype x sample grid into chunks
+    which are evaluated concurrently by the calling thread and any idle workers. Each
+    thread uses its own copy of the likelihood model and its own k-mer tables.
  */
 class HaplotypeLikelihoodArray
 {
@@ -39,9 +53,37 @@ public:
     
     using LogProbability       = HaplotypeLikelihoodModel::LogProbability;
     using LikelihoodVector     = std::vector<LogProbability>;
-    using LikelihoodVectorRef  = std::reference_wrapper<const LikelihoodVector>;
+    
+    // A non-owning view of one row of a likelihood matrix, i.e. ln p(read | haplotype) for each read
+    class LikelihoodSpan
+    {
+    public:
+        using value_type     = LogProbability;
+        using const_iterator = const LogProbability*;
+        using iterator       = const_iterator;
+        
+        LikelihoodSpan() = default;
+        LikelihoodSpan(const LogProbability* data, std::size_t size) noexcept : data_ {data}, size_ {size} {}
+        LikelihoodSpan(const LikelihoodVector& likelihoods) noexcept : data_ {likelihoods.data()}, size_ {likelihoods.size()} {}
+        
+        const LogProbability* data() const noexcept { return data_; }
+        std::size_t size() const noexcept { return size_; }
+        bool empty() const noexcept { return size_ == 0; }
+        const_iterator begin() const noexcept { return data_; }
+        const_iterator end() const noexcept { return data_ + size_; }
+        const_iterator cbegin() const noexcept { return data_; }
+        const_iterator cend() const noexcept { return data_ + size_; }
+        LogProbability operator[](std::size_t n) const noexcept { return data_[n]; }
+        LogProbability front() const noexcept { return data_[0]; }
+        LogProbability back() const noexcept { return data_[size_ - 1]; }
+    
+    private:
+        const LogProbability* data_ = nullptr;
+        std::size_t size_ = 0;
+    };
+    
     using HaplotypeRef         = std::reference_wrapper<const Haplotype>;
-    using SampleLikelihoodMap  = std::unordered_map<HaplotypeRef, LikelihoodVectorRef>;
+    using SampleLikelihoodMap  = std::unordered_map<HaplotypeRef, LikelihoodSpan>;
     
     HaplotypeLikelihoodArray() = default;
     
@@ -58,15 +100,34 @@ public:
     
     ~HaplotypeLikelihoodArray() = default;
     
+    // Likelihoods computed by earlier calls to populate are reused through the cache, which must outlive
+    // this array. nullptr disables caching.
+    void set_cache(ReadLikelihoodCache* cache) noexcept;
+    
+    // The pool may be shared with other arrays and must outlive this array. nullptr disables
+    // parallel population.
+    void set_workers(ThreadPool* workers) noexcept;
+    
+    // Working memory for populate is taken from the arena, which must outlive this array. It is
+    // safe to reset the arena between calls to populate. nullptr uses the heap.
+    void set_arena(MemoryArena* arena) noexcept;
+    
     void populate(const ReadMap& reads, const MappableBlock<Haplotype>& haplotypes,
                   boost::optional<FlankState> flank_state = boost::none);
     void populate(const TemplateMap& reads, const MappableBlock<Haplotype>& haplotypes,
                   boost::optional<FlankState> flank_state = boost::none);
     
     std::size_t num_likelihoods(const SampleName& sample) const;
+    std::size_t num_likelihoods(std::size_t sample_index) const noexcept;
+    
+    LikelihoodSpan operator()(const SampleName& sample, const Haplotype& haplotype) const;
+    LikelihoodSpan operator[](const Haplotype& haplotype) const; // when primed with a sample
     
-    const LikelihoodVector& operator()(const SampleName& sample, const Haplotype& haplotype) const;
-    const LikelihoodVector& operator[](const Haplotype& haplotype) const; // when primed with a sample
+    // Indices are stable until the next call to populate, erase, or clear
+    std::size_t sample_index(const SampleName& sample) const;
+    std::size_t haplotype_index(const Haplotype& haplotype) const;
+    LikelihoodSpan operator()(std::size_t sample_index, std::size_t haplotype_index) const noexcept;
+    LikelihoodSpan operator[](std::size_t haplotype_index) const noexcept; // when primed with a sample
     
     SampleLikelihoodMap extract_sample(const SampleName& sample) const;
     
@@ -91,8 +152,12 @@ public:
 private:
     static constexpr unsigned char mapperKmerSize {6};
     static constexpr std::size_t maxMappingPositions {10};
+    static constexpr std::size_t minParallelEvaluations {1'000};
+    static constexpr std::size_t chunksPerThread {4};
     
     HaplotypeLikelihoodModel likelihood_model_;
+    ThreadPool* workers_ = nullptr;
+    MemoryArena* arena_ = nullptr;
     
     struct ReadPacket
     {
@@ -109,8 +174,16 @@ private:
         std::size_t num_templates;
     };
     
-    std::unordered_map<Haplotype, std::vector<LikelihoodVector>, HaplotypeHash> cache_;
+    struct LikelihoodMatrix
+    {
+        std::size_t num_likelihoods = 0;
+        std::vector<LogProbability> values = {}; // row-major, one row per haplotype index
+    };
+    
+    std::unordered_map<Haplotype, std::size_t, HaplotypeHash> haplotype_indices_;
+    std::size_t num_rows_ = 0;
     std::unordered_map<SampleName, std::size_t> sample_indices_;
+    std::vector<LikelihoodMatrix> likelihoods_; // one per sample index
     
     mutable boost::optional<std::size_t> primed_sample_;
     
@@ -118,25 +191,76 @@ private:
     std::vector<ReadPacket> read_iterators_;
     std::vector<TemplatePacket> template_iterators_;
     std::vector<std::size_t> mapping_positions_;
+    std::vector<HaplotypeLikelihoodModel::MappingPositionVector> read_mapping_positions_;
+    
+    // Per thread state for parallel population, kept between calls to avoid reallocation
+    struct WorkerState
+    {
+        HaplotypeLikelihoodModel likelihood_model;
+        KmerHashTable haplotype_hashes;
+        MappedIndexCounts haplotype_mapping_counts;
+        std::vector<std::size_t> mapping_positions;
+        std::vector<HaplotypeLikelihoodModel::MappingPositionVector> read_mapping_positions;
+        const Haplotype* haplotype;
+    };
     
+    std::vector<WorkerState> worker_states_;
+    
+    template <typename T> using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+    using ReadKmerHashes = ArenaVector<KmerHashType>;
+    using ReadHashes = std::vector<ArenaVector<ReadKmerHashes>>;
+    
+    bool use_workers(const MappableBlock<Haplotype>& haplotypes) const noexcept;
+    void populate_parallel(const ReadHashes& read_hashes, const MappableBlock<Haplotype>& haplotypes,
+                           const boost::optional<FlankState>& flank_state);
+    static void evaluate(HaplotypeLikelihoodModel& likelihood_model, const ReadPacket& reads,
+                         const ArenaVector<ReadKmerHashes>& read_hashes, const KmerHashTable& haplotype_hashes,
+                         MappedIndexCounts& haplotype_mapping_counts, std::vector<std::size_t>& mapping_positions,
+                         std::vector<HaplotypeLikelihoodModel::MappingPositionVector>& read_mapping_positions,
+                         LogProbability* result);
     void set_read_iterators_and_sample_indices(const ReadMap& reads);
     void set_template_iterators_and_sample_indices(const TemplateMap& reads);
+    void index_haplotypes(const MappableBlock<Haplotype>& haplotypes);
+    std::vector<const Haplotype*> order_haplotypes(const MappableBlock<Haplotype>& haplotypes) const;
+    void allocate_likelihoods(const std::vector<std::size_t>& num_likelihoods);
+    void compact_rows();
+    LogProbability* row(std::size_t sample_index, std::size_t haplotype_index) noexcept;
 };
 
 template <typename S, typename Container>
 void HaplotypeLikelihoodArray::insert(S&& sample, const Haplotype& haplotype,
                                       Container&& likelihoods)
 {
-    sample_indices_.emplace(std::forward<S>(sample), sample_indices_.size());
-    cache_[haplotype].emplace_back(std::forward<Container>(likelihoods));
+    const auto num_likelihoods = static_cast<std::size_t>(std::distance(std::cbegin(likelihoods), std::cend(likelihoods)));
+    const auto sample_itr = sample_indices_.emplace(std::forward<S>(sample), sample_indices_.size()).first;
+    if (sample_itr->second == likelihoods_.size()) likelihoods_.emplace_back();
+    auto& matrix = likelihoods_[sample_itr->second];
+    if (matrix.values.empty()) {
+        matrix.num_likelihoods = num_likelihoods;
+    } else if (num_likelihoods != matrix.num_likelihoods) {
+        throw std::invalid_argument {"HaplotypeLikelihoodArray: likelihoods must have one value per sample read"};
+    }
+    const auto haplotype_itr = haplotype_indices_.emplace(haplotype, num_rows_).first;
+    if (haplotype_itr->second == num_rows_) {
+        // Every sample matrix needs a row for the new haplotype, not just this sample's
+        ++num_rows_;
+        for (auto& sample_matrix : likelihoods_) {
+            sample_matrix.values.resize(num_rows_ * sample_matrix.num_likelihoods);
+        }
+    } else {
+        matrix.values.resize(num_rows_ * matrix.num_likelihoods);
+    }
+    std::copy(std::cbegin(likelihoods), std::cend(likelihoods), row(sample_itr->second, haplotype_itr->second));
 }
 
 template <typename Container>
 void HaplotypeLikelihoodArray::erase(const Container& haplotypes)
 {
+    std::size_t num_erased {0};
     for (const auto& haplotype : haplotypes) {
-        cache_.erase(haplotype);
+        num_erased += haplotype_indices_.erase(haplotype);
     }
+    if (num_erased > 0) compact_rows();
 }
 
 // non-member methods
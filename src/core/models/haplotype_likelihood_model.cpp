@@ -4,10 +4,13 @@
 #include "haplotype_likelihood_model.hpp"
 
 #include <utility>
+#include <array>
 #include <cmath>
 #include <limits>
 #include <cassert>
 
+#include <boost/functional/hash.hpp>
+
 #include "core/models/error/error_model_factory.hpp"
 #include "concepts/mappable.hpp"
 #include "utils/maths.hpp"
@@ -57,28 +60,38 @@ unsigned HaplotypeLikelihoodModel::pad_requirement() const noexcept
 
 void HaplotypeLikelihoodModel::reset(const Haplotype& haplotype, boost::optional<FlankState> flank_state)
 {
+    const bool has_checkpoints {!checkpoints_.empty()};
+    if (has_checkpoints) save_previous_inputs();
     haplotype_ = std::addressof(haplotype);
     haplotype_flank_state_ = std::move(flank_state);
-    if (snv_error_model_) {
-        snv_error_model_->evaluate(haplotype,
-                                   haplotype_snv_forward_mask_, haplotype_snv_forward_priors_,
-                                   haplotype_snv_reverse_mask_, haplotype_snv_reverse_priors_);
-    } else {
-        // TODO: refactor HaplotypeLikelihoodModel to use another HMM evaluate overload without SNV model
-        haplotype_snv_forward_priors_.assign(sequence_size(haplotype), 100);
-        haplotype_snv_forward_mask_.assign(std::cbegin(haplotype.sequence()), std::cend(haplotype.sequence()));
-        haplotype_snv_reverse_priors_.assign(sequence_size(haplotype), 100);
-        haplotype_snv_reverse_mask_.assign(std::cbegin(haplotype.sequence()), std::cend(haplotype.sequence()));
-    }
-    if (indel_error_model_) {
-        indel_error_model_->set_penalties(haplotype, haplotype_gap_open_penalities_, haplotype_gap_extend_penalities_);
-    }
+    set_inputs(haplotype, haplotype_snv_forward_mask_, haplotype_snv_forward_priors_,
+               haplotype_snv_reverse_mask_, haplotype_snv_reverse_priors_,
+               haplotype_gap_open_penalities_, haplotype_gap_extend_penalities_);
+    if (cache_) hash_haplotype();
+    if (has_checkpoints) prune_checkpoints(shared_input_prefix_size());
+    checkpoint_truth_end_ = 0;
+}
+
+void HaplotypeLikelihoodModel::share_prefix(const Haplotype& next_haplotype)
+{
+    checkpoint_truth_end_ = 0;
+    if (!config_.share_haplotype_prefixes || haplotype_ == nullptr) return;
+    if (contig_name(next_haplotype) != contig_name(*haplotype_) || mapped_begin(next_haplotype) != mapped_begin(*haplotype_)) return;
+    // The error models depend on sequence context, so the inputs can diverge before the sequences do
+    other_region_ = next_haplotype.mapped_region();
+    other_sequence_ = next_haplotype.sequence();
+    set_inputs(next_haplotype, other_snv_forward_mask_, other_snv_forward_priors_,
+               other_snv_reverse_mask_, other_snv_reverse_priors_,
+               other_gap_open_penalities_, other_gap_extend_penalities_);
+    checkpoint_truth_end_ = shared_input_prefix_size();
 }
 
 void HaplotypeLikelihoodModel::clear() noexcept
 {
     haplotype_ = nullptr;
     haplotype_flank_state_ = boost::none;
+    checkpoints_.clear();
+    checkpoint_truth_end_ = 0;
 }
 
 HaplotypeLikelihoodModel::HaplotypeLikelihoodModel()
@@ -102,6 +115,11 @@ HaplotypeLikelihoodModel::HaplotypeLikelihoodModel(std::unique_ptr<SnvErrorModel
 , haplotype_gap_extend_penalities_ {}
 , config_ {config}
 , hmm_ {config.max_indel_error}
+, cache_ {nullptr}
+, haplotype_forward_hash_ {}
+, haplotype_reverse_hash_ {}
+, checkpoints_ {}
+, checkpoint_truth_end_ {0}
 {
     if (config_.mapping_quality_cap_trigger && *config_.mapping_quality_cap_trigger >= config_.mapping_quality_cap) {
         config_.mapping_quality_cap_trigger = boost::none;
@@ -130,6 +148,19 @@ HaplotypeLikelihoodModel::HaplotypeLikelihoodModel(const HaplotypeLikelihoodMode
     haplotype_gap_extend_penalities_ = other.haplotype_gap_extend_penalities_;
     config_ = other.config_;
     hmm_ = other.hmm_;
+    cache_ = other.cache_;
+    haplotype_forward_hash_ = other.haplotype_forward_hash_;
+    haplotype_reverse_hash_ = other.haplotype_reverse_hash_;
+    checkpoints_ = other.checkpoints_;
+    checkpoint_truth_end_ = other.checkpoint_truth_end_;
+    other_region_ = other.other_region_;
+    other_sequence_ = other.other_sequence_;
+    other_snv_forward_mask_ = other.other_snv_forward_mask_;
+    other_snv_reverse_mask_ = other.other_snv_reverse_mask_;
+    other_snv_forward_priors_ = other.other_snv_forward_priors_;
+    other_snv_reverse_priors_ = other.other_snv_reverse_priors_;
+    other_gap_open_penalities_ = other.other_gap_open_penalities_;
+    other_gap_extend_penalities_ = other.other_gap_extend_penalities_;
 }
 
 HaplotypeLikelihoodModel& HaplotypeLikelihoodModel::operator=(const HaplotypeLikelihoodModel& other)
@@ -156,6 +187,19 @@ void swap(HaplotypeLikelihoodModel& lhs, HaplotypeLikelihoodModel& rhs) noexcept
     swap(lhs.haplotype_gap_extend_penalities_, rhs.haplotype_gap_extend_penalities_);
     swap(lhs.config_, rhs.config_);
     swap(lhs.hmm_, rhs.hmm_);
+    swap(lhs.cache_, rhs.cache_);
+    swap(lhs.haplotype_forward_hash_, rhs.haplotype_forward_hash_);
+    swap(lhs.haplotype_reverse_hash_, rhs.haplotype_reverse_hash_);
+    swap(lhs.checkpoints_, rhs.checkpoints_);
+    swap(lhs.checkpoint_truth_end_, rhs.checkpoint_truth_end_);
+    swap(lhs.other_region_, rhs.other_region_);
+    swap(lhs.other_sequence_, rhs.other_sequence_);
+    swap(lhs.other_snv_forward_mask_, rhs.other_snv_forward_mask_);
+    swap(lhs.other_snv_reverse_mask_, rhs.other_snv_reverse_mask_);
+    swap(lhs.other_snv_forward_priors_, rhs.other_snv_forward_priors_);
+    swap(lhs.other_snv_reverse_priors_, rhs.other_snv_reverse_priors_);
+    swap(lhs.other_gap_open_penalities_, rhs.other_gap_open_penalities_);
+    swap(lhs.other_gap_extend_penalities_, rhs.other_gap_extend_penalities_);
 }
 
 bool HaplotypeLikelihoodModel::can_use_flank_state() const noexcept
@@ -163,6 +207,12 @@ bool HaplotypeLikelihoodModel::can_use_flank_state() const noexcept
     return config_.use_flank_state;
 }
 
+void HaplotypeLikelihoodModel::set_cache(ReadLikelihoodCache* cache) noexcept
+{
+    cache_ = cache;
+    if (cache_ && haplotype_) hash_haplotype();
+}
+
 HaplotypeLikelihoodModel::LogProbability
 HaplotypeLikelihoodModel::evaluate(const AlignedRead& read) const
 {
@@ -200,19 +250,33 @@ bool is_in_range(const std::size_t mapping_position, const AlignedRead& read, co
     return num_out_of_range_bases(mapping_position, read, haplotype, hmm) == 0;
 }
 
+template <typename T>
+PrefixHash::Symbol to_symbol(const std::vector<T>& values, const std::size_t i) noexcept
+{
+    return i < values.size() ? static_cast<std::uint8_t>(values[i]) : 0;
+}
+
+PrefixHash::Digest hash(const AlignedRead& read) noexcept
+{
+    const auto& sequence = read.sequence();
+    const auto& base_qualities = read.base_qualities();
+    return PrefixHash::hash(sequence.size(), [&] (const std::size_t i) {
+        return static_cast<std::uint8_t>(sequence[i]) | (to_symbol(base_qualities, i) << 8);
+    });
+}
+
 } // namespace
 
-template <typename InputIt, typename pHMM>
-HaplotypeLikelihoodModel::LogProbability
-max_score(const AlignedRead& read, const Haplotype& haplotype,
-          InputIt first_mapping_position, InputIt last_mapping_position,
-          const pHMM& hmm)
+// Calls f for each in range mapping position, including the original mapping position. If there
+// are no in range mapping positions then f is called once with the nearest in range position.
+template <typename InputIt, typename pHMM, typename UnaryFunction>
+void for_each_mapping_position(const AlignedRead& read, const Haplotype& haplotype,
+                               InputIt first_mapping_position, InputIt last_mapping_position,
+                               const pHMM& hmm, UnaryFunction f)
 {
     assert(contains(haplotype, read));
-    using LogProbability = HaplotypeLikelihoodModel::LogProbability;
     using PositionType = typename std::iterator_traits<InputIt>::value_type;
     const auto original_mapping_position = static_cast<PositionType>(begin_distance(haplotype, read));
-    auto max_log_probability = std::numeric_limits<LogProbability>::lowest();
     bool is_original_position_mapped {false}, has_in_range_mapping_position {false};
     std::for_each(first_mapping_position, last_mapping_position, [&] (const auto position) {
         if (position == original_mapping_position) {
@@ -220,14 +284,12 @@ max_score(const AlignedRead& read, const Haplotype& haplotype,
         }
         if (is_in_range(position, read, haplotype, hmm)) {
             has_in_range_mapping_position = true;
-            auto p = hmm.evaluate(read.sequence(), haplotype.sequence(), read.base_qualities(), position);
-            max_log_probability = std::max(static_cast<LogProbability>(p), max_log_probability);
+            f(position);
         }
     });
     if (!is_original_position_mapped && is_in_range(original_mapping_position, read, haplotype, hmm)) {
         has_in_range_mapping_position = true;
-        auto p = hmm.evaluate(read.sequence(), haplotype.sequence(), read.base_qualities(), original_mapping_position);
-        max_log_probability = std::max(static_cast<LogProbability>(p), max_log_probability);
+        f(original_mapping_position);
     }
     if (!has_in_range_mapping_position) {
         const auto min_shift = num_out_of_range_bases(original_mapping_position, read, haplotype, hmm);
@@ -246,8 +308,22 @@ max_score(const AlignedRead& read, const Haplotype& haplotype,
                 throw HaplotypeLikelihoodModel::ShortHaplotypeError {haplotype, required_extension};
             }
         }
-        max_log_probability = hmm.evaluate(read.sequence(), haplotype.sequence(), read.base_qualities(), final_mapping_position);
+        f(final_mapping_position);
     }
+}
+
+template <typename InputIt, typename pHMM>
+HaplotypeLikelihoodModel::LogProbability
+max_score(const AlignedRead& read, const Haplotype& haplotype,
+          InputIt first_mapping_position, InputIt last_mapping_position,
+          const pHMM& hmm)
+{
+    using LogProbability = HaplotypeLikelihoodModel::LogProbability;
+    auto max_log_probability = std::numeric_limits<LogProbability>::lowest();
+    for_each_mapping_position(read, haplotype, first_mapping_position, last_mapping_position, hmm, [&] (const auto position) {
+        auto p = hmm.evaluate(read.sequence(), haplotype.sequence(), read.base_qualities(), position);
+        max_log_probability = std::max(static_cast<LogProbability>(p), max_log_probability);
+    });
     assert(max_log_probability > std::numeric_limits<LogProbability>::lowest() && max_log_probability <= 0);
     return max_log_probability;
 }
@@ -260,41 +336,86 @@ HaplotypeLikelihoodModel::evaluate(const AlignedRead& read,
     if (haplotype_ == nullptr) {
         throw std::runtime_error {"HaplotypeLikelihoodModel: no buffered Haplotype"};
     }
-    const auto is_forward = !read.is_marked_reverse_mapped();
-    HMM::ParameterType model {
-        haplotype_gap_open_penalities_,
-        haplotype_gap_extend_penalities_,
-        is_forward ? haplotype_snv_forward_mask_ : haplotype_snv_reverse_mask_,
-        is_forward ? haplotype_snv_forward_priors_ : haplotype_snv_reverse_priors_
-    };
-    if (haplotype_flank_state_) {
-        model.lhs_flank_size = haplotype_flank_state_->lhs_flank;
-        model.rhs_flank_size = haplotype_flank_state_->rhs_flank;
-    } else {
-        model.lhs_flank_size = 0;
-        model.rhs_flank_size = 0;
-    }
+    const auto model = make_hmm_parameters(!read.is_marked_reverse_mapped());
     hmm_.set(model);
+    if (cache_ || config_.share_haplotype_prefixes) {
+        const auto read_digest = cache_ ? hash(read) : PrefixHash::Digest {0};
+        auto ln_prob_given_mapped = std::numeric_limits<LogProbability>::lowest();
+        for_each_mapping_position(read, *haplotype_, first_mapping_position, last_mapping_position, hmm_, [&] (const auto position) {
+            const auto ln_prob = cache_ ? cached_evaluate(read, read_digest, position) : evaluate_alignment(read, position);
+            ln_prob_given_mapped = std::max(ln_prob, ln_prob_given_mapped);
+        });
+        return adjust_for_mapping_quality(read, ln_prob_given_mapped);
+    }
     const auto ln_prob_given_mapped = max_score(read, *haplotype_, first_mapping_position, last_mapping_position, hmm_);
-    if (config_.use_mapping_quality) {
-        // This calculation is approximately
-        // p(read | hap) = p(read missmapped) p(read | hap, missmapped)
-        //                  + p(read correctly mapped) p(read | hap, correctly mapped)
-        // = p(read correctly mapped) p(read | hap, correctly mapped)
-        //      + p(read missmapped)
-        // assuming p(read | hap, missmapped) = 1
-        auto mapping_quality = read.mapping_quality();
-        if (config_.mapping_quality_cap_trigger && mapping_quality >= *config_.mapping_quality_cap_trigger) {
-            mapping_quality = config_.mapping_quality_cap;
+    return adjust_for_mapping_quality(read, ln_prob_given_mapped);
+}
+
+void
+HaplotypeLikelihoodModel::evaluate(ReadIterator first_read, ReadIterator last_read,
+                                   const std::vector<MappingPositionVector>& mapping_positions,
+                                   LogProbability* result) const
+{
+    if (haplotype_ == nullptr) {
+        throw std::runtime_error {"HaplotypeLikelihoodModel: no buffered Haplotype"};
+    }
+    const auto num_reads = static_cast<std::size_t>(std::distance(first_read, last_read));
+    assert(mapping_positions.size() >= num_reads);
+    if (!config_.min_batch_size || config_.share_haplotype_prefixes) {
+        std::transform(first_read, last_read, std::cbegin(mapping_positions), result,
+                       [this] (const AlignedRead& read, const MappingPositionVector& positions) {
+                           return this->evaluate(read, positions);
+                       });
+        return;
+    }
+    // Each read is expanded into one alignment per candidate mapping position. The HMM parameters
+    // depend on the read direction, so forward and reverse reads are batched separately.
+    using BatchTarget = hmm::BatchTarget<AlignedRead::NucleotideSequence>;
+    thread_local std::array<std::vector<BatchTarget>, 2> targets {};
+    thread_local std::array<std::vector<std::size_t>, 2> target_reads {};
+    thread_local std::array<std::vector<boost::optional<ReadLikelihoodCache::Key>>, 2> target_keys {};
+    thread_local std::vector<double> target_scores {};
+    for (auto& t : targets) t.clear();
+    for (auto& t : target_reads) t.clear();
+    for (auto& t : target_keys) t.clear();
+    std::fill_n(result, num_reads, std::numeric_limits<LogProbability>::lowest());
+    std::size_t read_idx {0};
+    std::for_each(first_read, last_read, [&] (const AlignedRead& read) {
+        const auto is_reverse = read.is_marked_reverse_mapped();
+        const auto& positions = mapping_positions[read_idx];
+        const auto read_digest = cache_ ? hash(read) : PrefixHash::Digest {0};
+        for_each_mapping_position(read, *haplotype_, std::cbegin(positions), std::cend(positions), hmm_, [&] (const auto position) {
+            if (cache_) {
+                const auto key = make_cache_key(read, read_digest, position);
+                const auto cached_score = key ? cache_->find(*key) : boost::none;
+                if (cached_score) {
+                    result[read_idx] = std::max(*cached_score, result[read_idx]);
+                    return;
+                }
+                target_keys[is_reverse].push_back(key);
+            }
+            targets[is_reverse].push_back({std::addressof(read.sequence()), std::addressof(read.base_qualities()), position});
+            target_reads[is_reverse].push_back(read_idx);
+        });
+        ++read_idx;
+    });
+    for (const bool is_reverse : {false, true}) {
+        if (targets[is_reverse].empty()) continue;
+        const auto model = make_hmm_parameters(!is_reverse);
+        hmm_.set(model);
+        hmm_.evaluate(targets[is_reverse], haplotype_->sequence(), *config_.min_batch_size, target_scores);
+        for (std::size_t i {0}; i < target_scores.size(); ++i) {
+            auto& read_result = result[target_reads[is_reverse][i]];
+            read_result = std::max(static_cast<LogProbability>(target_scores[i]), read_result);
+            if (cache_ && target_keys[is_reverse][i]) cache_->insert(*target_keys[is_reverse][i], target_scores[i]);
         }
-        using octopus::maths::constants::ln10Div10;
-        const auto ln_prob_missmapped = -ln10Div10<> * mapping_quality;
-        const auto ln_prob_mapped = std::log(1.0 - std::exp(ln_prob_missmapped));
-        const auto result = maths::log_sum_exp(ln_prob_mapped + ln_prob_given_mapped, ln_prob_missmapped);
-        return result > -1e-15 ? 0.0 : result;
-    } else {
-        return ln_prob_given_mapped  > -1e-15 ? 0.0 : ln_prob_given_mapped;
     }
+    read_idx = 0;
+    std::for_each(first_read, last_read, [&] (const AlignedRead& read) {
+        assert(result[read_idx] > std::numeric_limits<LogProbability>::lowest() && result[read_idx] <= 0);
+        result[read_idx] = adjust_for_mapping_quality(read, result[read_idx]);
+        ++read_idx;
+    });
 }
 
 HaplotypeLikelihoodModel::LogProbability
@@ -394,21 +515,207 @@ HaplotypeLikelihoodModel::align(const AlignedRead& read, MappingPositionItr firs
     if (haplotype_ == nullptr) {
         throw std::runtime_error {"HaplotypeLikelihoodModel: no buffered Haplotype"};
     }
-    const auto is_forward = !read.is_marked_reverse_mapped();
-    HMM::ParameterType model {haplotype_gap_open_penalities_,
-                              haplotype_gap_extend_penalities_,
-                              is_forward ? haplotype_snv_forward_mask_ : haplotype_snv_reverse_mask_,
-                              is_forward ? haplotype_snv_forward_priors_ : haplotype_snv_reverse_priors_};
+    const auto model = make_hmm_parameters(!read.is_marked_reverse_mapped());
+    hmm_.set(model);
+    auto result = compute_optimal_alignment(read, *haplotype_, first_mapping_position, last_mapping_position, hmm_);
+    result.likelihood = adjust_for_mapping_quality(read, result.likelihood);
+    return result;
+}
+
+// private methods
+
+void HaplotypeLikelihoodModel::hash_haplotype()
+{
+    // Every haplotype input to the PairHMM at each position, so a window hash identifies
+    // the alignment inputs exactly (up to hash collisions).
+    const auto& sequence = haplotype_->sequence();
+    const auto hash_position = [&] (const std::size_t i, const std::vector<char>& snv_mask, const std::vector<Penalty>& snv_priors) {
+        return static_cast<std::uint8_t>(sequence[i])
+               | (to_symbol(snv_mask, i) << 8)
+               | (to_symbol(snv_priors, i) << 16)
+               | (to_symbol(haplotype_gap_open_penalities_, i) << 24)
+               | (to_symbol(haplotype_gap_extend_penalities_, i) << 32);
+    };
+    haplotype_forward_hash_.assign(sequence.size(), [&] (const std::size_t i) {
+        return hash_position(i, haplotype_snv_forward_mask_, haplotype_snv_forward_priors_);
+    });
+    haplotype_reverse_hash_.assign(sequence.size(), [&] (const std::size_t i) {
+        return hash_position(i, haplotype_snv_reverse_mask_, haplotype_snv_reverse_priors_);
+    });
+}
+
+boost::optional<ReadLikelihoodCache::Key>
+HaplotypeLikelihoodModel::make_cache_key(const AlignedRead& read, const PrefixHash::Digest read_digest,
+                                         const MappingPosition mapping_position) const noexcept
+{
+    // The PairHMM only reads the haplotype in the window the read is banded to, and the flanks
+    // only matter where they overlap the window.
+    const auto pad = static_cast<std::size_t>(hmm_.band_size());
+    const bool is_forward {!read.is_marked_reverse_mapped()};
+    const auto& haplotype_hash = is_forward ? haplotype_forward_hash_ : haplotype_reverse_hash_;
+    // Reads shifted to fit a short haplotype may be banded past either end, so the window can't be hashed
+    if (mapping_position < pad) return boost::none;
+    const auto window_begin = mapping_position - pad;
+    const auto window_end = mapping_position + sequence_size(read) + pad - 1;
+    if (window_end > haplotype_hash.size()) return boost::none;
+    std::uint64_t lhs_flank_overlap {0}, rhs_flank_overlap {0};
+    if (haplotype_flank_state_) {
+        const auto lhs_flank_end = static_cast<std::size_t>(haplotype_flank_state_->lhs_flank);
+        const auto rhs_flank_begin = sequence_size(*haplotype_) - std::min(sequence_size(*haplotype_), static_cast<std::size_t>(haplotype_flank_state_->rhs_flank));
+        if (lhs_flank_end > window_begin) lhs_flank_overlap = std::min(lhs_flank_end, window_end) - window_begin;
+        if (rhs_flank_begin < window_end) rhs_flank_overlap = window_end - std::max(rhs_flank_begin, window_begin);
+    }
+    const auto context = static_cast<std::uint64_t>(is_forward) | (lhs_flank_overlap << 1) | (rhs_flank_overlap << 32);
+    return ReadLikelihoodCache::make_key(read_digest, haplotype_hash(window_begin, window_end), context);
+}
+
+HaplotypeLikelihoodModel::LogProbability
+HaplotypeLikelihoodModel::cached_evaluate(const AlignedRead& read, const PrefixHash::Digest read_digest,
+                                          const MappingPosition mapping_position) const
+{
+    assert(cache_);
+    const auto key = make_cache_key(read, read_digest, mapping_position);
+    if (!key) return evaluate_alignment(read, mapping_position);
+    const auto cached_result = cache_->find(*key);
+    if (cached_result) return *cached_result;
+    const auto result = evaluate_alignment(read, mapping_position);
+    cache_->insert(*key, result);
+    return result;
+}
+
+HaplotypeLikelihoodModel::LogProbability
+HaplotypeLikelihoodModel::evaluate_alignment(const AlignedRead& read, const MappingPosition mapping_position) const
+{
+    if (!config_.share_haplotype_prefixes) {
+        return hmm_.evaluate(read.sequence(), haplotype_->sequence(), read.base_qualities(), mapping_position);
+    }
+    const CheckpointKey key {std::addressof(read), mapping_position};
+    if (checkpoint_truth_end_ == 0) {
+        const auto itr = checkpoints_.find(key);
+        const auto resume = itr != std::cend(checkpoints_) && !itr->second.empty() ? std::addressof(itr->second.back()) : nullptr;
+        return hmm_.evaluate(read.sequence(), haplotype_->sequence(), read.base_qualities(), mapping_position, resume, 0, nullptr);
+    }
+    auto& stack = checkpoints_[key];
+    const auto resume = !stack.empty() ? std::addressof(stack.back()) : nullptr;
+    hmm::AlignmentCheckpoint checkpoint {};
+    const auto result = hmm_.evaluate(read.sequence(), haplotype_->sequence(), read.base_qualities(), mapping_position,
+                                      resume, checkpoint_truth_end_, std::addressof(checkpoint));
+    if (!checkpoint.state.empty() && (stack.empty() || checkpoint.truth_end > stack.back().truth_end)) {
+        stack.push_back(std::move(checkpoint));
+    }
+    return result;
+}
+
+std::size_t HaplotypeLikelihoodModel::CheckpointKeyHash::operator()(const CheckpointKey& key) const noexcept
+{
+    std::size_t result {0};
+    boost::hash_combine(result, key.read);
+    boost::hash_combine(result, key.mapping_position);
+    return result;
+}
+
+void HaplotypeLikelihoodModel::set_inputs(const Haplotype& haplotype,
+                                          std::vector<char>& snv_forward_mask, std::vector<Penalty>& snv_forward_priors,
+                                          std::vector<char>& snv_reverse_mask, std::vector<Penalty>& snv_reverse_priors,
+                                          std::vector<Penalty>& gap_open_penalities,
+                                          std::vector<Penalty>& gap_extend_penalities) const
+{
+    if (snv_error_model_) {
+        snv_error_model_->evaluate(haplotype, snv_forward_mask, snv_forward_priors, snv_reverse_mask, snv_reverse_priors);
+    } else {
+        // TODO: refactor HaplotypeLikelihoodModel to use another HMM evaluate overload without SNV model
+        snv_forward_priors.assign(sequence_size(haplotype), 100);
+        snv_forward_mask.assign(std::cbegin(haplotype.sequence()), std::cend(haplotype.sequence()));
+        snv_reverse_priors.assign(sequence_size(haplotype), 100);
+        snv_reverse_mask.assign(std::cbegin(haplotype.sequence()), std::cend(haplotype.sequence()));
+    }
+    if (indel_error_model_) {
+        indel_error_model_->set_penalties(haplotype, gap_open_penalities, gap_extend_penalities);
+    }
+}
+
+void HaplotypeLikelihoodModel::save_previous_inputs()
+{
+    if (haplotype_) {
+        other_region_ = haplotype_->mapped_region();
+        other_sequence_ = haplotype_->sequence();
+    } else {
+        other_sequence_.clear();
+    }
+    // The current inputs are recomputed by reset, so can be swapped rather than copied
+    using std::swap;
+    swap(other_snv_forward_mask_, haplotype_snv_forward_mask_);
+    swap(other_snv_reverse_mask_, haplotype_snv_reverse_mask_);
+    swap(other_snv_forward_priors_, haplotype_snv_forward_priors_);
+    swap(other_snv_reverse_priors_, haplotype_snv_reverse_priors_);
+    swap(other_gap_open_penalities_, haplotype_gap_open_penalities_);
+    swap(other_gap_extend_penalities_, haplotype_gap_extend_penalities_);
+}
+
+namespace {
+
+template <typename Range>
+std::size_t shared_prefix_size(const Range& lhs, const Range& rhs, const std::size_t max) noexcept
+{
+    if (lhs.empty() && rhs.empty()) return max; // input not used
+    const auto divergence = std::mismatch(std::cbegin(lhs), std::cend(lhs), std::cbegin(rhs), std::cend(rhs));
+    return std::min(static_cast<std::size_t>(std::distance(std::cbegin(lhs), divergence.first)), max);
+}
+
+} // namespace
+
+std::size_t HaplotypeLikelihoodModel::shared_input_prefix_size() const noexcept
+{
+    // Every PairHMM input that depends on the haplotype must match for checkpoints to remain valid
+    if (other_region_.contig_name() != contig_name(*haplotype_) || other_region_.begin() != mapped_begin(*haplotype_)) {
+        return 0;
+    }
+    auto result = shared_prefix_size(other_sequence_, haplotype_->sequence(), other_sequence_.size());
+    result = shared_prefix_size(other_snv_forward_mask_, haplotype_snv_forward_mask_, result);
+    result = shared_prefix_size(other_snv_reverse_mask_, haplotype_snv_reverse_mask_, result);
+    result = shared_prefix_size(other_snv_forward_priors_, haplotype_snv_forward_priors_, result);
+    result = shared_prefix_size(other_snv_reverse_priors_, haplotype_snv_reverse_priors_, result);
+    result = shared_prefix_size(other_gap_open_penalities_, haplotype_gap_open_penalities_, result);
+    result = shared_prefix_size(other_gap_extend_penalities_, haplotype_gap_extend_penalities_, result);
+    return result;
+}
+
+void HaplotypeLikelihoodModel::prune_checkpoints(const std::size_t truth_end)
+{
+    for (auto& p : checkpoints_) {
+        auto& stack = p.second;
+        while (!stack.empty() && stack.back().truth_end > truth_end) stack.pop_back();
+    }
+}
+
+HaplotypeLikelihoodModel::HMM::ParameterType HaplotypeLikelihoodModel::make_hmm_parameters(const bool is_forward) const noexcept
+{
+    HMM::ParameterType result {
+        haplotype_gap_open_penalities_,
+        haplotype_gap_extend_penalities_,
+        is_forward ? haplotype_snv_forward_mask_ : haplotype_snv_reverse_mask_,
+        is_forward ? haplotype_snv_forward_priors_ : haplotype_snv_reverse_priors_
+    };
     if (haplotype_flank_state_) {
-        model.lhs_flank_size = haplotype_flank_state_->lhs_flank;
-        model.rhs_flank_size = haplotype_flank_state_->rhs_flank;
+        result.lhs_flank_size = haplotype_flank_state_->lhs_flank;
+        result.rhs_flank_size = haplotype_flank_state_->rhs_flank;
     } else {
-        model.lhs_flank_size = 0;
-        model.rhs_flank_size = 0;
+        result.lhs_flank_size = 0;
+        result.rhs_flank_size = 0;
     }
-    hmm_.set(model);
-    auto result = compute_optimal_alignment(read, *haplotype_, first_mapping_position, last_mapping_position, hmm_);
+    return result;
+}
+
+HaplotypeLikelihoodModel::LogProbability
+HaplotypeLikelihoodModel::adjust_for_mapping_quality(const AlignedRead& read, const LogProbability ln_prob_given_mapped) const noexcept
+{
     if (config_.use_mapping_quality) {
+        // This calculation is approximately
+        // p(read | hap) = p(read missmapped) p(read | hap, missmapped)
+        //                  + p(read correctly mapped) p(read | hap, correctly mapped)
+        // = p(read correctly mapped) p(read | hap, correctly mapped)
+        //      + p(read missmapped)
+        // assuming p(read | hap, missmapped) = 1
         auto mapping_quality = read.mapping_quality();
         if (config_.mapping_quality_cap_trigger && mapping_quality >= *config_.mapping_quality_cap_trigger) {
             mapping_quality = config_.mapping_quality_cap;
@@ -416,14 +723,15 @@ HaplotypeLikelihoodModel::align(const AlignedRead& read, MappingPositionItr firs
         using octopus::maths::constants::ln10Div10;
         const auto ln_prob_missmapped = -ln10Div10<> * mapping_quality;
         const auto ln_prob_mapped = std::log(1.0 - std::exp(ln_prob_missmapped));
-        result.likelihood = maths::log_sum_exp(ln_prob_mapped + result.likelihood, ln_prob_missmapped);
-        result.likelihood = result.likelihood > -1e-15 ? 0.0 : result.likelihood;
+        const auto result = maths::log_sum_exp(ln_prob_mapped + ln_prob_given_mapped, ln_prob_missmapped);
+        return result > -1e-15 ? 0.0 : result;
     } else {
-        result.likelihood = result.likelihood > -1e-15 ? 0.0 : result.likelihood;
+        return ln_prob_given_mapped  > -1e-15 ? 0.0 : ln_prob_given_mapped;
     }
-    return result;
 }
 
+// non-member methods
+
 HaplotypeLikelihoodModel make_haplotype_likelihood_model(const std::string label, bool use_mapping_quality)
 {
     HaplotypeLikelihoodModel::Config config {};
@@ -12,11 +12,13 @@
 #include <functional>
 #include <memory>
 #include <stdexcept>
+#include <unordered_map>
 
 #include <boost/optional.hpp>
 
 #include "config/common.hpp"
 #include "basics/contig_region.hpp"
+#include "basics/genomic_region.hpp"
 #include "basics/cigar_string.hpp"
 #include "basics/aligned_read.hpp"
 #include "basics/aligned_template.hpp"
@@ -24,6 +26,7 @@
 #include "core/models/error/snv_error_model.hpp"
 #include "core/models/error/indel_error_model.hpp"
 #include "pairhmm/pair_hmm.hpp"
+#include "read_likelihood_cache.hpp"
 
 namespace octopus {
 
@@ -40,6 +43,13 @@ public:
         AlignedRead::MappingQuality mapping_quality_cap = 120;
         bool use_flank_state = true;
         unsigned max_indel_error = 8;
+        // Reads of the same length and strand are evaluated with the inter-read PairHMM kernel, one read
+        // per SIMD lane, when there are at least this many of them. boost::none disables batching.
+        boost::optional<unsigned> min_batch_size = 8;
+        // Alignments against consecutive haplotypes resume from PairHMM checkpoints saved at the point the
+        // haplotypes diverge (see share_prefix), rather than realigning the shared prefix. Reads are then
+        // evaluated one at a time, so this takes precedence over min_batch_size.
+        bool share_haplotype_prefixes = false;
     };
     
     struct FlankState
@@ -52,6 +62,7 @@ public:
     using MappingPosition       = std::size_t;
     using MappingPositionVector = std::vector<MappingPosition>;
     using MappingPositionItr    = MappingPositionVector::const_iterator;
+    using ReadIterator          = ReadContainer::const_iterator;
     
     struct Alignment
     {
@@ -84,8 +95,17 @@ public:
     
     bool can_use_flank_state() const noexcept;
     
+    // PairHMM results are looked up in, and added to, the cache if one is set. The cache is not owned and
+    // must outlive any use of this model. nullptr disables caching.
+    void set_cache(ReadLikelihoodCache* cache) noexcept;
+    
     void reset(const Haplotype& haplotype, boost::optional<FlankState> flank_state = boost::none);
     
+    // If Config::share_haplotype_prefixes is set, alignments against the current haplotype save checkpoints
+    // where the PairHMM inputs for next_haplotype diverge from it, which alignments against next_haplotype can resume from once it
+    // is reset. Checkpoints are kept, keyed by read address, until clear is called.
+    void share_prefix(const Haplotype& next_haplotype);
+    
     void clear() noexcept;
     
     // ln p(read | haplotype, model)
@@ -93,6 +113,13 @@ public:
     LogProbability evaluate(const AlignedRead& read, const MappingPositionVector& mapping_positions) const;
     LogProbability evaluate(const AlignedRead& read, MappingPositionItr first_mapping_position, MappingPositionItr last_mapping_position) const;
     
+    // ln p(read | haplotype, model) for each read, written to result which must have room for one
+    // value per read. Results are the same as evaluating each read individually, but reads may be
+    // evaluated in batches (see Config::min_batch_size).
+    void evaluate(ReadIterator first_read, ReadIterator last_read,
+                  const std::vector<MappingPositionVector>& mapping_positions,
+                  LogProbability* result) const;
+    
     // ln p(read template | haplotype, model)
     LogProbability evaluate(const AlignedTemplate& reads) const;
     LogProbability evaluate(const AlignedTemplate& reads, const std::vector<MappingPositionVector>& mapping_positions) const;
@@ -117,6 +144,51 @@ private:
     std::vector<Penalty> haplotype_gap_open_penalities_, haplotype_gap_extend_penalities_;
     Config config_;
     mutable HMM hmm_;
+    
+    ReadLikelihoodCache* cache_;
+    PrefixHash haplotype_forward_hash_, haplotype_reverse_hash_;
+    
+    struct CheckpointKey
+    {
+        const AlignedRead* read;
+        MappingPosition mapping_position;
+        friend bool operator==(const CheckpointKey& lhs, const CheckpointKey& rhs) noexcept
+        {
+            return lhs.read == rhs.read && lhs.mapping_position == rhs.mapping_position;
+        }
+    };
+    struct CheckpointKeyHash
+    {
+        std::size_t operator()(const CheckpointKey& key) const noexcept;
+    };
+    // Each stack only holds checkpoints valid for the current haplotype, deepest last
+    using CheckpointStack = std::vector<hmm::AlignmentCheckpoint>;
+    
+    mutable std::unordered_map<CheckpointKey, CheckpointStack, CheckpointKeyHash> checkpoints_;
+    std::size_t checkpoint_truth_end_;
+    // Another haplotype's PairHMM inputs to compare with the current haplotype's: the next haplotype's
+    // after share_prefix, and the previous haplotype's on reset to find which checkpoints remain valid
+    GenomicRegion other_region_;
+    Haplotype::NucleotideSequence other_sequence_;
+    std::vector<char> other_snv_forward_mask_, other_snv_reverse_mask_;
+    std::vector<Penalty> other_snv_forward_priors_, other_snv_reverse_priors_;
+    std::vector<Penalty> other_gap_open_penalities_, other_gap_extend_penalities_;
+    
+    HMM::ParameterType make_hmm_parameters(bool is_forward) const noexcept;
+    LogProbability adjust_for_mapping_quality(const AlignedRead& read, LogProbability ln_prob_given_mapped) const noexcept;
+    void hash_haplotype();
+    boost::optional<ReadLikelihoodCache::Key>
+    make_cache_key(const AlignedRead& read, PrefixHash::Digest read_digest, MappingPosition mapping_position) const noexcept;
+    LogProbability cached_evaluate(const AlignedRead& read, PrefixHash::Digest read_digest,
+                                   MappingPosition mapping_position) const;
+    LogProbability evaluate_alignment(const AlignedRead& read, MappingPosition mapping_position) const;
+    void set_inputs(const Haplotype& haplotype,
+                    std::vector<char>& snv_forward_mask, std::vector<Penalty>& snv_forward_priors,
+                    std::vector<char>& snv_reverse_mask, std::vector<Penalty>& snv_reverse_priors,
+                    std::vector<Penalty>& gap_open_penalities, std::vector<Penalty>& gap_extend_penalities) const;
+    void save_previous_inputs();
+    std::size_t shared_input_prefix_size() const noexcept;
+    void prune_checkpoints(std::size_t truth_end);
 };
 
 class HaplotypeLikelihoodModel::ShortHaplotypeError : public std::runtime_error
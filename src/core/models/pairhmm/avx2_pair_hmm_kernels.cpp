@@ -0,0 +1,70 @@
+// Copyright (c) 2015-2019 Daniel Cooke and Gerton Lunter
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+// This translation unit is compiled with AVX2 code generation enabled, regardless of the target
+// architecture of the rest of the build. It must only instantiate AVX2 kernels: any other inline
+// code emitted here may be selected by the linker and then executed on hosts without AVX2.
+
+#include "pair_hmm_kernel.hpp"
+
+#include <type_traits>
+
+#include "simd_pair_hmm_factory.hpp"
+#include "batch_pair_hmm.hpp"
+
+namespace octopus { namespace hmm { namespace simd {
+
+#if defined(AVX2_PHMM)
+
+namespace {
+
+template <unsigned BandSize, typename ScoreType>
+struct AVX2KernelMaker
+{
+    static PairHMMKernel make(std::true_type) noexcept { return make_kernel<AVX2PairHMM<BandSize, ScoreType>>(); }
+    static PairHMMKernel make(std::false_type) noexcept { return {}; }
+    static PairHMMKernel make() noexcept
+    {
+        return make(std::integral_constant<bool, BandSize % (32 / sizeof(ScoreType)) == 0> {});
+    }
+};
+
+// Batch kernels vectorise across reads rather than along the band, so all band sizes are viable
+template <unsigned BandSize, typename ScoreType>
+struct AVX2BatchKernelMaker
+{
+    static PairHMMBatchKernel make() noexcept
+    {
+        return make_batch_kernel<BatchPairHMM<BandSize, ScoreType, 32 / sizeof(ScoreType)>>("AVX2");
+    }
+};
+
+} // namespace
+
+const PairHMMKernel* get_avx2_kernel(const int band_size, const ScorePrecision precision) noexcept
+{
+    return find_kernel<AVX2KernelMaker>(band_size, precision);
+}
+
+const PairHMMBatchKernel* get_avx2_batch_kernel(const int band_size, const ScorePrecision precision) noexcept
+{
+    return find_kernel<AVX2BatchKernelMaker>(band_size, precision);
+}
+
+#else
+
+const PairHMMKernel* get_avx2_kernel(const int band_size, const ScorePrecision precision) noexcept
+{
+    return nullptr;
+}
+
+const PairHMMBatchKernel* get_avx2_batch_kernel(const int band_size, const ScorePrecision precision) noexcept
+{
+    return nullptr;
+}
+
+#endif // defined(AVX2_PHMM)
+
+} // namespace simd
+} // namespace hmm
+} // namespace octopus
@@ -0,0 +1,278 @@
+// Copyright (c) 2015-2019 Daniel Cooke and Gerton Lunter
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef batch_pair_hmm_hpp
+#define batch_pair_hmm_hpp
+
+#include <cstdint>
+#include <limits>
+#include <cassert>
+
+namespace octopus { namespace hmm { namespace simd {
+
+/*
+    BatchPairHMM is the inter-read counterpart of simd::PairHMM. Rather than vectorising the band of a
+    single alignment, each SIMD lane holds a separate alignment, so BatchSize targets of the same length
+    are scored against their truths at once. The recurrence is exactly the banded recurrence of
+    simd::PairHMM::align (score only, SNV mask and per-position gap penalties), so scores are identical.
+
+    All inputs are interleaved: element j of lane l is at index j * BatchSize + l. The DP state is stored
+    band-major ([band][lane]) and the input rows covered by the band are kept in ring buffers that store
+    each row twice, so that every band window is contiguous. Each step is then a flat loop over
+    BandSize * BatchSize scores, which the compiler vectorises with whatever instruction set the including
+    translation unit is compiled for.
+
+    Standard library functions are deliberately not used, as inline code emitted from ISA specific
+    translation units must not be shared with other translation units. For the same reason, BatchSize
+    is always the register width of the instruction set, so each instruction set instantiates distinct
+    classes.
+ */
+template <int BandSize, typename ScoreType, int BatchSize>
+class BatchPairHMM
+{
+public:
+    static_assert(BandSize > 0, "BandSize must be positive");
+    static_assert(BatchSize > 0, "BatchSize must be positive");
+
+    static constexpr int band_size() noexcept { return BandSize; }
+    static constexpr int batch_size() noexcept { return BatchSize; }
+
+    void
+    align(const char* truths,
+          const char* targets,
+          const std::int8_t* qualities,
+          const int truth_len,
+          const int target_len,
+          const char* snv_masks,
+          const std::int8_t* snv_priors,
+          const std::int8_t* gap_open,
+          const std::int8_t* gap_extend,
+          const short nuc_prior,
+          int* scores) const noexcept
+    {
+        assert(target_len > 0 && truth_len > BandSize && (truth_len == target_len + 2 * BandSize - 1));
+        TruthWindow truth;
+        TargetWindow target;
+        for (int j {0}; j < BandSize; ++j) {
+            truth.load(j, truths, snv_masks, snv_priors, gap_open, gap_extend);
+        }
+        target.clear();
+        alignas(64) Band m1, i1, d1, m2, i2, d2;
+        alignas(64) Lanes minscore;
+        fill(m1, infinity_); fill(i1, infinity_); fill(d1, infinity_);
+        fill(m2, infinity_); fill(i2, infinity_); fill(d2, infinity_);
+        fill(minscore, infinity_);
+        const ScoreType nuc {penalty(static_cast<std::int8_t>(nuc_prior))};
+        const int num_steps {target_len + BandSize};
+        for (int i {0}; i < num_steps; ++i) {
+            // Truth positions k + i in the first half step and k + i + 1 in the second; target positions i - k
+            const bool is_last_step {i == num_steps - 1};
+            if (!is_last_step) truth.load(i + BandSize, truths, snv_masks, snv_priors, gap_open, gap_extend);
+            if (i < target_len) {
+                target.load(i, targets, qualities);
+            } else {
+                target.load_end(i);
+            }
+            const auto tw = target.window(i);
+            const auto t0 = truth.window(i);
+            if (i < BandSize) {
+                fill(m1 + i * BatchSize, null_score_);
+                fill(m2 + i * BatchSize, null_score_);
+            }
+            for (int x {0}; x < band_words_; ++x) {
+                m1[x] = min(m1[x], min(i1[x], d1[x]));
+            }
+            if (i >= target_len) update_min(minscore, m1 + (i - target_len) * BatchSize);
+            update_match(m1, tw, t0);
+            for (int x {0}; x < BatchSize; ++x) {
+                d1[x] = infinity_;
+            }
+            for (int x {BatchSize}; x < band_words_; ++x) {
+                d1[x] = min(add(d2[x - BatchSize], t0.gap_extend[x - BatchSize]),
+                            add(min(m2[x - BatchSize], i2[x - BatchSize]), t0.gap_open[x]));
+            }
+            for (int x {0}; x < band_words_; ++x) {
+                i1[x] = add(min(add(i2[x], t0.gap_extend[x]), add(m2[x], t0.gap_open[x])), nuc);
+            }
+            for (int x {0}; x < band_words_; ++x) {
+                m2[x] = min(m2[x], min(i2[x], d2[x]));
+            }
+            if (i >= target_len) update_min(minscore, m2 + (i - target_len) * BatchSize);
+            // The rest of the last step does not contribute to the score, and would run off the end of the truth
+            if (is_last_step) break;
+            const auto t1 = truth.window(i + 1);
+            update_match(m2, tw, t1);
+            for (int x {0}; x < band_words_; ++x) {
+                d2[x] = min(add(d1[x], t1.gap_extend[x]), add(min(m1[x], i1[x]), t1.gap_open[x]));
+            }
+            for (int x {0}; x < band_words_ - BatchSize; ++x) {
+                i2[x] = add(min(add(i1[x + BatchSize], t1.gap_extend[x]), add(m1[x + BatchSize], t1.gap_open[x])), nuc);
+            }
+            for (int x {band_words_ - BatchSize}; x < band_words_; ++x) {
+                i2[x] = infinity_;
+            }
+        }
+        for (int l {0}; l < BatchSize; ++l) {
+            scores[l] = (minscore[l] - null_score_) >> trace_bits_;
+        }
+    }
+
+private:
+    // These must match simd::PairHMM
+    constexpr static ScoreType infinity_tolerance_ {0x7FF};
+    constexpr static ScoreType infinity_ {std::numeric_limits<ScoreType>::max() - infinity_tolerance_};
+    constexpr static int trace_bits_ {2};
+    constexpr static ScoreType n_score_ {2 << trace_bits_};
+    constexpr static ScoreType max_quality_score_ {64};
+    constexpr static ScoreType null_score_ {std::numeric_limits<ScoreType>::min()};
+
+    constexpr static int band_words_ {BandSize * BatchSize};
+
+    using Lanes = ScoreType[BatchSize];
+    using Band  = ScoreType[band_words_];
+
+    // SIMD addition wraps on overflow
+    static ScoreType add(const ScoreType lhs, const ScoreType rhs) noexcept
+    {
+        return static_cast<ScoreType>(lhs + rhs);
+    }
+    static ScoreType min(const ScoreType lhs, const ScoreType rhs) noexcept
+    {
+        return lhs < rhs ? lhs : rhs;
+    }
+    // Branch free, so the loops it is used in can be vectorised
+    static ScoreType select(const bool condition, const ScoreType lhs, const ScoreType rhs) noexcept
+    {
+        const ScoreType mask = -static_cast<ScoreType>(condition);
+        return (lhs & mask) | (rhs & ~mask);
+    }
+    static ScoreType penalty(const std::int8_t value) noexcept
+    {
+        return static_cast<ScoreType>(value << trace_bits_);
+    }
+
+    template <int N>
+    static void fill(ScoreType (&values)[N], const ScoreType value) noexcept
+    {
+        for (int x {0}; x < N; ++x) values[x] = value;
+    }
+    static void fill(ScoreType* lanes, const ScoreType value) noexcept
+    {
+        for (int l {0}; l < BatchSize; ++l) lanes[l] = value;
+    }
+    static void update_min(Lanes& result, const ScoreType* lanes) noexcept
+    {
+        for (int l {0}; l < BatchSize; ++l) result[l] = min(result[l], lanes[l]);
+    }
+
+    // Holds the last Rows rows of an interleaved input. Row r is stored in two slots, Rows apart, so any
+    // Rows consecutive rows can be read contiguously in either ascending or descending row order.
+    template <int Rows, bool Ascending>
+    struct RowRing
+    {
+        alignas(64) ScoreType values[2 * Rows * BatchSize];
+
+        static int slot(const int row) noexcept
+        {
+            const int r {row % Rows};
+            return Ascending ? r : Rows - 1 - r;
+        }
+        ScoreType* row(const int row, const int copy) noexcept
+        {
+            return values + (slot(row) + copy * Rows) * BatchSize;
+        }
+        const ScoreType* window(const int first_row) const noexcept
+        {
+            return values + slot(first_row) * BatchSize;
+        }
+    };
+
+    struct TruthView
+    {
+        const ScoreType *truth, *truth_n, *snv_mask, *snv_prior, *gap_open, *gap_extend;
+    };
+
+    // Truth rows i, ..., i + BandSize are needed in step i
+    struct TruthWindow
+    {
+        RowRing<BandSize + 1, true> truth, truth_n, snv_mask, snv_prior, gap_open, gap_extend;
+
+        void load(const int j, const char* truths, const char* snv_masks, const std::int8_t* snv_priors,
+                  const std::int8_t* gap_opens, const std::int8_t* gap_extends) noexcept
+        {
+            const int offset {j * BatchSize};
+            for (int copy {0}; copy < 2; ++copy) {
+                ScoreType *t {truth.row(j, copy)}, *n {truth_n.row(j, copy)}, *m {snv_mask.row(j, copy)};
+                ScoreType *p {snv_prior.row(j, copy)}, *o {gap_open.row(j, copy)}, *e {gap_extend.row(j, copy)};
+                for (int l {0}; l < BatchSize; ++l) {
+                    t[l] = truths[offset + l];
+                    n[l] = truths[offset + l] == 'N' ? n_score_ : infinity_;
+                    m[l] = snv_masks[offset + l];
+                    p[l] = penalty(snv_priors[offset + l]);
+                    o[l] = penalty(gap_opens[offset + l]);
+                    e[l] = penalty(gap_extends[offset + l]);
+                }
+            }
+        }
+        TruthView window(const int first_row) const noexcept
+        {
+            return {truth.window(first_row), truth_n.window(first_row), snv_mask.window(first_row),
+                    snv_prior.window(first_row), gap_open.window(first_row), gap_extend.window(first_row)};
+        }
+    };
+
+    struct TargetView
+    {
+        const ScoreType *target, *quality;
+    };
+
+    // Target rows i, i - 1, ..., i - BandSize + 1 are needed in step i
+    struct TargetWindow
+    {
+        RowRing<BandSize, false> target, quality;
+
+        // Out of range target bases never match and take the maximum quality
+        void clear() noexcept
+        {
+            fill(target.values, infinity_);
+            fill(quality.values, max_quality_score_ << trace_bits_);
+        }
+        void load(const int y, const char* targets, const std::int8_t* qualities) noexcept
+        {
+            const int offset {y * BatchSize};
+            for (int copy {0}; copy < 2; ++copy) {
+                ScoreType *t {target.row(y, copy)}, *q {quality.row(y, copy)};
+                for (int l {0}; l < BatchSize; ++l) {
+                    t[l] = targets[offset + l];
+                    q[l] = penalty(qualities[offset + l]);
+                }
+            }
+        }
+        void load_end(const int y) noexcept
+        {
+            for (int copy {0}; copy < 2; ++copy) {
+                fill(target.row(y, copy), '0');
+                fill(quality.row(y, copy), max_quality_score_ << trace_bits_);
+            }
+        }
+        TargetView window(const int first_row) const noexcept
+        {
+            return {target.window(first_row), quality.window(first_row)};
+        }
+    };
+
+    static void update_match(Band& m, const TargetView& target, const TruthView& truth) noexcept
+    {
+        for (int x {0}; x < band_words_; ++x) {
+            const ScoreType base {target.target[x]}, quality {target.quality[x]};
+            const ScoreType mismatch {min(quality, select(base == truth.snv_mask[x], truth.snv_prior[x], infinity_))};
+            m[x] = add(m[x], min(select(base == truth.truth[x], ScoreType {0}, mismatch), truth.truth_n[x]));
+        }
+    }
+};
+
+} // namespace simd
+} // namespace hmm
+} // namespace octopus
+
+#endif
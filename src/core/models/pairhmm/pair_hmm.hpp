@@ -24,7 +24,6 @@
 #include "basics/cigar_string.hpp"
 #include "exceptions/program_error.hpp"
 #include "utils/maths.hpp"
-#include "simd_pair_hmm_factory.hpp"
 #include "simd_pair_hmm_wrapper.hpp"
 
 namespace octopus { namespace hmm {
@@ -65,6 +64,24 @@ private:
 
 struct NullType {};
 
+// A target for batched evaluation. offset is the target position in the truth, as for evaluate.
+template <typename Sequence>
+struct BatchTarget
+{
+    const Sequence* sequence;
+    const std::vector<std::uint8_t>* base_qualities;
+    std::size_t offset;
+};
+
+// The state of an alignment part way along the truth. The state only depends on the truth (and model
+// parameters) before truth_end, so the alignment of the same target at the same offset against any
+// truth that matches on this prefix can resume from it rather than starting again.
+struct AlignmentCheckpoint
+{
+    std::size_t target_offset, truth_end;
+    std::vector<char> state;
+};
+
 using Penalty          = std::int8_t;
 using PenaltyVector    = std::vector<Penalty>;
 using NucleotideVector = std::vector<char>;
@@ -93,8 +110,6 @@ using FlatGapMutationModel           = Parameters<Penalty, Penalty, NullType, Nu
 
 using octopus::maths::constants::ln10Div10;
 
-const static auto default_hmm = simd::make_simd_pair_hmm<16>();
-
 namespace detail {
 
 template <typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
@@ -781,6 +796,205 @@ simd_evaluate(const Sequence1& truth,
                                 std::is_same<decltype(hmm_params.lhs_flank_size), NullType> {});
 }
 
+template <typename Sequence1,
+          typename Sequence2,
+          typename PairHMM,
+          typename PairHMMParameters>
+auto
+simd_checkpoint_evaluate(const Sequence1& truth,
+                         const Sequence2& target,
+                         const std::vector<std::uint8_t>& target_base_qualities,
+                         const std::size_t target_offset,
+                         const PairHMM& hmm,
+                         const PairHMMParameters& hmm_params,
+                         const AlignmentCheckpoint* resume,
+                         const std::size_t checkpoint_truth_end,
+                         AlignmentCheckpoint* checkpoint)
+{
+    const auto pad = hmm.band_size();
+    const auto truth_size  = static_cast<int>(truth.size());
+    const auto target_size = static_cast<int>(target.size());
+    const auto truth_alignment_size = static_cast<int>(target_size + 2 * pad - 1);
+    const auto alignment_offset = std::max(0, static_cast<int>(target_offset) - pad);
+    if (alignment_offset + truth_alignment_size > truth_size
+        || use_adjusted_alignment_score(truth, target, target_offset, hmm, hmm_params)) {
+        // Flank adjusted scores need the full traceback
+        return simd_evaluate(truth, target, target_base_qualities, target_offset, hmm, hmm_params);
+    }
+    // Checkpoint positions are relative to the aligned window of the truth
+    int resume_pos {0};
+    const void* resume_state {nullptr};
+    if (resume && resume->target_offset == target_offset && !resume->state.empty()) {
+        const auto pos = static_cast<int>(resume->truth_end) - alignment_offset;
+        if (pos >= pad && pos <= truth_alignment_size) {
+            resume_pos = pos;
+            resume_state = resume->state.data();
+        }
+    }
+    int checkpoint_pos {0};
+    void* checkpoint_state {nullptr};
+    if (checkpoint) {
+        const auto pos = std::min(static_cast<int>(checkpoint_truth_end) - alignment_offset, truth_alignment_size);
+        if (pos >= pad && pos > resume_pos) {
+            checkpoint->target_offset = target_offset;
+            checkpoint->truth_end = alignment_offset + pos;
+            checkpoint->state.resize(hmm.checkpoint_size());
+            checkpoint_pos = pos;
+            checkpoint_state = checkpoint->state.data();
+        }
+    }
+    const auto qualities = reinterpret_cast<const std::int8_t*>(target_base_qualities.data());
+    const auto score = hmm.align(truth.data() + alignment_offset,
+                                 target.data(),
+                                 qualities,
+                                 truth_alignment_size,
+                                 target_size,
+                                 data(hmm_params.snv_mask, alignment_offset),
+                                 data(hmm_params.snv_priors, alignment_offset),
+                                 data(hmm_params.gap_open, alignment_offset),
+                                 data(hmm_params.gap_extend, alignment_offset),
+                                 hmm_params.nuc_prior,
+                                 resume_pos, resume_state,
+                                 checkpoint_pos, checkpoint_state);
+    return -ln10Div10<> * static_cast<double>(score);
+}
+
+template <typename Sequence1,
+          typename Sequence2,
+          typename PairHMM,
+          typename PairHMMParameters>
+bool
+use_flank_adjusted_score(const Sequence1& truth,
+                         const Sequence2& target,
+                         const std::size_t target_offset,
+                         const PairHMM& hmm,
+                         const PairHMMParameters& hmm_params,
+                         std::true_type) noexcept
+{
+    return false;
+}
+template <typename Sequence1,
+          typename Sequence2,
+          typename PairHMM,
+          typename PairHMMParameters>
+bool
+use_flank_adjusted_score(const Sequence1& truth,
+                         const Sequence2& target,
+                         const std::size_t target_offset,
+                         const PairHMM& hmm,
+                         const PairHMMParameters& hmm_params,
+                         std::false_type) noexcept
+{
+    return use_adjusted_alignment_score(truth, target, target_offset, hmm, hmm_params);
+}
+
+template <typename Sequence1,
+          typename Sequence2,
+          typename PairHMM,
+          typename PairHMMParameters>
+bool
+is_batchable(const Sequence1& truth,
+             const Sequence2& target,
+             const std::size_t target_offset,
+             const PairHMM& hmm,
+             const PairHMMParameters& hmm_params,
+             std::true_type) noexcept
+{
+    return false; // batch kernels require an SNV mask
+}
+template <typename Sequence1,
+          typename Sequence2,
+          typename PairHMM,
+          typename PairHMMParameters>
+bool
+is_batchable(const Sequence1& truth,
+             const Sequence2& target,
+             const std::size_t target_offset,
+             const PairHMM& hmm,
+             const PairHMMParameters& hmm_params,
+             std::false_type) noexcept
+{
+    const auto pad = hmm.band_size();
+    const auto truth_alignment_size = static_cast<int>(target.size() + 2 * pad - 1);
+    const auto alignment_offset = std::max(0, static_cast<int>(target_offset) - pad);
+    if (alignment_offset + truth_alignment_size > static_cast<int>(truth.size())) return false;
+    // Flank adjustment requires a traceback, which the batch kernels do not compute
+    return !use_flank_adjusted_score(truth, target, target_offset, hmm, hmm_params,
+                                     std::is_same<decltype(hmm_params.lhs_flank_size), NullType> {});
+}
+template <typename Sequence1,
+          typename Sequence2,
+          typename PairHMM,
+          typename PairHMMParameters>
+bool
+is_batchable(const Sequence1& truth,
+             const Sequence2& target,
+             const std::size_t target_offset,
+             const PairHMM& hmm,
+             const PairHMMParameters& hmm_params) noexcept
+{
+    return is_batchable(truth, target, target_offset, hmm, hmm_params,
+                        std::is_same<decltype(hmm_params.snv_mask), NullType> {});
+}
+
+// Evaluates up to hmm.batch_size() batchable targets of the same length with the inter-read kernel.
+// Unused lanes are filled by repeating the last target.
+template <typename Sequence1,
+          typename Sequence2,
+          typename PairHMM,
+          typename PairHMMParameters,
+          typename InputIt>
+void
+simd_batch_evaluate(const Sequence1& truth,
+                    const std::vector<BatchTarget<Sequence2>>& targets,
+                    InputIt first_index, InputIt last_index,
+                    const PairHMM& hmm,
+                    const PairHMMParameters& hmm_params,
+                    std::vector<double>& result) noexcept
+{
+    const auto batch_size = static_cast<std::size_t>(hmm.batch_size());
+    const auto num_targets = static_cast<std::size_t>(std::distance(first_index, last_index));
+    assert(num_targets > 0 && num_targets <= batch_size);
+    const auto pad = hmm.band_size();
+    const auto target_size = static_cast<int>(targets[*first_index].sequence->size());
+    const auto truth_alignment_size = static_cast<int>(target_size + 2 * pad - 1);
+    thread_local std::vector<char> truths {}, targets_buffer {}, snv_masks {};
+    thread_local std::vector<std::int8_t> qualities {}, snv_priors {}, gap_open {}, gap_extend {};
+    thread_local std::vector<int> scores {};
+    truths.resize(truth_alignment_size * batch_size);
+    snv_masks.resize(truths.size());
+    snv_priors.resize(truths.size());
+    gap_open.resize(truths.size());
+    gap_extend.resize(truths.size());
+    targets_buffer.resize(target_size * batch_size);
+    qualities.resize(targets_buffer.size());
+    scores.resize(batch_size);
+    for (std::size_t lane {0}; lane < batch_size; ++lane) {
+        const auto& target = targets[first_index[std::min(lane, num_targets - 1)]];
+        assert(static_cast<int>(target.sequence->size()) == target_size);
+        const auto alignment_offset = static_cast<std::size_t>(std::max(0, static_cast<int>(target.offset) - pad));
+        for (int j {0}; j < truth_alignment_size; ++j) {
+            const auto truth_idx = alignment_offset + j;
+            const auto buffer_idx = j * batch_size + lane;
+            truths[buffer_idx]     = truth[truth_idx];
+            snv_masks[buffer_idx]  = get(hmm_params.snv_mask, truth_idx);
+            snv_priors[buffer_idx] = get(hmm_params.snv_priors, truth_idx);
+            gap_open[buffer_idx]   = get(hmm_params.gap_open, truth_idx);
+            gap_extend[buffer_idx] = get(hmm_params.gap_extend, truth_idx);
+        }
+        for (int j {0}; j < target_size; ++j) {
+            targets_buffer[j * batch_size + lane] = (*target.sequence)[j];
+            qualities[j * batch_size + lane] = static_cast<std::int8_t>((*target.base_qualities)[j]);
+        }
+    }
+    hmm.batch_align(truths.data(), targets_buffer.data(), qualities.data(), truth_alignment_size, target_size,
+                    snv_masks.data(), snv_priors.data(), gap_open.data(), gap_extend.data(), hmm_params.nuc_prior,
+                    scores.data());
+    for (std::size_t lane {0}; lane < num_targets; ++lane) {
+        result[first_index[lane]] = -ln10Div10<> * static_cast<double>(scores[lane]);
+    }
+}
+
 template <typename Sequence1,
           typename Sequence2,
           typename PairHMM,
@@ -840,6 +1054,32 @@ evaluate(const Sequence1& truth,
     return p.second ? p.first : detail::simd_evaluate(truth, target, target_base_qualities, target_offset, hmm, model_params);
 }
 
+// As evaluate, but the alignment resumes from resume (if not nullptr), which the caller must ensure was
+// saved by an alignment of target against a truth, and with parameters, matching these before
+// resume->truth_end. If checkpoint is not nullptr then the alignment state at checkpoint_truth_end is
+// saved to it, or its state is cleared if no checkpoint can be saved. Only SNV models are supported.
+template <typename Sequence1,
+          typename Sequence2,
+          typename PairHMM,
+          typename PairHMMParameters>
+double
+evaluate(const Sequence1& truth,
+         const Sequence2& target,
+         const std::vector<std::uint8_t>& target_base_qualities,
+         const std::size_t target_offset,
+         const PairHMM& hmm,
+         const PairHMMParameters& model_params,
+         const AlignmentCheckpoint* resume,
+         const std::size_t checkpoint_truth_end,
+         AlignmentCheckpoint* checkpoint)
+{
+    if (checkpoint) checkpoint->state.clear();
+    auto p = detail::try_naive_evaluate(truth, target, target_base_qualities, target_offset, model_params);
+    if (p.second) return p.first;
+    return detail::simd_checkpoint_evaluate(truth, target, target_base_qualities, target_offset, hmm, model_params,
+                                            resume, checkpoint_truth_end, checkpoint);
+}
+
 template <typename Sequence1,
           typename Sequence2,
           typename PairHMM,
@@ -855,6 +1095,58 @@ evaluate(const Sequence1& truth,
     return evaluate(truth, target, target_base_qualities, hmm.band_size(), hmm, model_params);
 }
 
+// Equivalent to calling evaluate for each target, but groups of at least min_batch_size targets of the
+// same length are evaluated with the inter-read batch kernel, one target per SIMD lane.
+template <typename Sequence1,
+          typename Sequence2,
+          typename PairHMM,
+          typename PairHMMParameters>
+void
+evaluate(const Sequence1& truth,
+         const std::vector<BatchTarget<Sequence2>>& targets,
+         const PairHMM& hmm,
+         const PairHMMParameters& model_params,
+         const std::size_t min_batch_size,
+         std::vector<double>& result)
+{
+    result.resize(targets.size());
+    thread_local std::vector<std::size_t> batchable_indices {};
+    batchable_indices.clear();
+    for (std::size_t i {0}; i < targets.size(); ++i) {
+        const auto& target = targets[i];
+        const auto p = detail::try_naive_evaluate(truth, *target.sequence, *target.base_qualities, target.offset, model_params);
+        if (p.second) {
+            result[i] = p.first;
+        } else if (detail::is_batchable(truth, *target.sequence, target.offset, hmm, model_params)) {
+            batchable_indices.push_back(i);
+        } else {
+            result[i] = detail::simd_evaluate(truth, *target.sequence, *target.base_qualities, target.offset, hmm, model_params);
+        }
+    }
+    const auto target_size = [&targets] (const std::size_t i) noexcept { return targets[i].sequence->size(); };
+    std::sort(std::begin(batchable_indices), std::end(batchable_indices),
+              [&] (const auto lhs, const auto rhs) noexcept { return target_size(lhs) < target_size(rhs); });
+    const auto batch_size = static_cast<std::size_t>(hmm.batch_size());
+    for (auto first = std::cbegin(batchable_indices); first != std::cend(batchable_indices);) {
+        const auto last = std::find_if(first, std::cend(batchable_indices),
+                                       [&] (const auto i) noexcept { return target_size(i) != target_size(*first); });
+        for (; first != last;) {
+            const auto num_remaining = static_cast<std::size_t>(std::distance(first, last));
+            if (num_remaining < std::max(min_batch_size, std::size_t {1})) {
+                std::for_each(first, last, [&] (const auto i) {
+                    const auto& target = targets[i];
+                    result[i] = detail::simd_evaluate(truth, *target.sequence, *target.base_qualities, target.offset, hmm, model_params);
+                });
+                first = last;
+            } else {
+                const auto batch_last = std::next(first, std::min(num_remaining, batch_size));
+                detail::simd_batch_evaluate(truth, targets, first, batch_last, hmm, model_params, result);
+                first = batch_last;
+            }
+        }
+    }
+}
+
 template <typename Sequence1,
           typename Sequence2,
           typename PairHMM,
@@ -928,6 +1220,22 @@ public:
         return octopus::hmm::evaluate(truth, target, target_base_qualities, target_offset, hmm_, *params_);
     }
     
+    template <typename Sequence1,
+              typename Sequence2>
+    double
+    evaluate(const Sequence1& target,
+             const Sequence2& truth,
+             const std::vector<std::uint8_t>& target_base_qualities,
+             const std::size_t target_offset,
+             const AlignmentCheckpoint* resume,
+             const std::size_t checkpoint_truth_end,
+             AlignmentCheckpoint* checkpoint) const
+    {
+        assert(params_);
+        return octopus::hmm::evaluate(truth, target, target_base_qualities, target_offset, hmm_, *params_,
+                                      resume, checkpoint_truth_end, checkpoint);
+    }
+    
     template <typename Sequence1,
               typename Sequence2>
     double
@@ -938,6 +1246,20 @@ public:
         return octopus::hmm::evaluate(truth, target, hmm_, *params_);
     }
     
+    template <typename Sequence1,
+              typename Sequence2>
+    void
+    evaluate(const std::vector<BatchTarget<Sequence1>>& targets,
+             const Sequence2& truth,
+             const std::size_t min_batch_size,
+             std::vector<double>& result) const
+    {
+        assert(params_);
+        octopus::hmm::evaluate(truth, targets, hmm_, *params_, min_batch_size, result);
+    }
+    
+    int batch_size() const noexcept { return hmm_.batch_size(); }
+    
     template <typename Sequence1,
               typename Sequence2>
     void
@@ -985,29 +1307,33 @@ public:
     }
     
 private:
-    using SIMDHMM = std::conditional_t<(BandSize > 0), simd::SimdPairHMM<BandSize, ScoreType>, simd::PairHMMWrapper>;
+    // Kernels are dispatched at runtime for both static and dynamic band sizes, so the fastest
+    // instruction set supported by the host is always used.
+    using SIMDHMM = simd::PairHMMWrapper;
     
     static constexpr bool is_static = BandSize > 0 && !std::is_same<ScoreType, NullType>::value;
     
-    SIMDHMM hmm_;
+    SIMDHMM hmm_ = make_default_hmm(std::conditional_t<is_static, std::true_type, std::false_type> {});
     const Parameters* params_ = nullptr;
     
+    static SIMDHMM make_default_hmm(std::true_type) { return SIMDHMM {BandSize, score_precision()}; }
+    static SIMDHMM make_default_hmm(std::false_type) { return SIMDHMM {}; }
     void reset(unsigned min_band_size) { reset(min_band_size, std::conditional_t<is_static, std::true_type, std::false_type> {}); }
     void reset(unsigned min_band_size, std::true_type) const noexcept {}
     void reset(unsigned min_band_size, std::false_type) { hmm_.reset(min_band_size, score_precision()); }
-    simd::PairHMMWrapper::ScorePrecision score_precision(NullType) const noexcept
+    static simd::ScorePrecision score_precision(NullType) noexcept
     {
-        return simd::PairHMMWrapper::ScorePrecision::int16;
+        return simd::ScorePrecision::int16;
     }
-    simd::PairHMMWrapper::ScorePrecision score_precision(short) const noexcept
+    static simd::ScorePrecision score_precision(short) noexcept
     {
-        return simd::PairHMMWrapper::ScorePrecision::int16;
+        return simd::ScorePrecision::int16;
     }
-    simd::PairHMMWrapper::ScorePrecision score_precision(int) const noexcept
+    static simd::ScorePrecision score_precision(int) noexcept
     {
-        return simd::PairHMMWrapper::ScorePrecision::int32;
+        return simd::ScorePrecision::int32;
     }
-    simd::PairHMMWrapper::ScorePrecision score_precision() const noexcept
+    static simd::ScorePrecision score_precision() noexcept
     {
         return score_precision(ScoreType {});
     }
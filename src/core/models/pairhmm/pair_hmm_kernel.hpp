@@ -0,0 +1,222 @@
+// Copyright (c) 2015-2019 Daniel Cooke and Gerton Lunter
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef pair_hmm_kernel_hpp
+#define pair_hmm_kernel_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <utility>
+
+namespace octopus { namespace hmm { namespace simd {
+
+enum class ScorePrecision { int16, int32 };
+
+// A PairHMMKernel is a type-erased handle to a single SimdPairHMM instantiation. Kernels are
+// instantiated in translation units compiled for their own instruction set, so callers compiled
+// for the baseline architecture can only reach SIMD code through these function pointers.
+// All gap penalties are passed as arrays; constant penalties must be expanded by the caller.
+struct PairHMMKernel
+{
+    using Penalties = const std::int8_t*;
+
+    using AlignFunction = int (*)(const char*, const char*, const std::int8_t*, int, int,
+                                  Penalties, Penalties, short);
+    using SnvAlignFunction = int (*)(const char*, const char*, const std::int8_t*, int, int,
+                                     const char*, const std::int8_t*, Penalties, Penalties, short);
+    using TracebackAlignFunction = int (*)(const char*, const char*, const std::int8_t*, int, int,
+                                           Penalties, Penalties, short, int&, char*, char*);
+    using SnvTracebackAlignFunction = int (*)(const char*, const char*, const std::int8_t*, int, int,
+                                              const char*, const std::int8_t*, Penalties, Penalties, short,
+                                              int&, char*, char*);
+    using FlankScoreFunction = int (*)(int, int, int, const std::int8_t*, Penalties, Penalties, short,
+                                       int, const char*, const char*, int&);
+    using SnvFlankScoreFunction = int (*)(int, int, int, const char*, const std::int8_t*, const char*, const std::int8_t*,
+                                          Penalties, Penalties, short, int, const char*, const char*, int&);
+    using SnvCheckpointAlignFunction = int (*)(const char*, const char*, const std::int8_t*, int, int,
+                                               const char*, const std::int8_t*, Penalties, Penalties, short,
+                                               int, const void*, int, void*);
+
+    const char* name = nullptr;
+    int band_size = 0;
+    AlignFunction align = nullptr;
+    SnvAlignFunction snv_align = nullptr;
+    TracebackAlignFunction traceback_align = nullptr;
+    SnvTracebackAlignFunction snv_traceback_align = nullptr;
+    FlankScoreFunction flank_score = nullptr;
+    SnvFlankScoreFunction snv_flank_score = nullptr;
+    SnvCheckpointAlignFunction snv_checkpoint_align = nullptr;
+    std::size_t checkpoint_size = 0; // bytes of state saved by snv_checkpoint_align
+};
+
+// A PairHMMBatchKernel is a type-erased handle to a single BatchPairHMM instantiation, which aligns
+// batch_size targets of the same length at once, one target per SIMD lane. All arguments are
+// interleaved by lane (element j of lane l is at j * batch_size + l) and scores has batch_size elements.
+struct PairHMMBatchKernel
+{
+    using Penalties = const std::int8_t*;
+    
+    using SnvAlignFunction = void (*)(const char*, const char*, const std::int8_t*, int, int,
+                                      const char*, const std::int8_t*, Penalties, Penalties, short, int*);
+    
+    const char* name = nullptr;
+    int band_size = 0;
+    int batch_size = 0;
+    SnvAlignFunction snv_align = nullptr;
+};
+
+constexpr std::size_t num_kernel_band_sizes {6}; // 8, 16, ..., 256
+
+constexpr unsigned kernel_band_size(const std::size_t index) noexcept
+{
+    return 8u << index;
+}
+
+// Kernel tables. Each of these is defined in its own translation unit which is compiled with the
+// corresponding instruction set flags. nullptr is returned if the instruction set was not compiled
+// or there is no viable kernel of the requested band size.
+const PairHMMKernel* get_sse2_kernel(int band_size, ScorePrecision precision) noexcept;
+const PairHMMKernel* get_avx2_kernel(int band_size, ScorePrecision precision) noexcept;
+const PairHMMKernel* get_avx512_kernel(int band_size, ScorePrecision precision) noexcept;
+const PairHMMBatchKernel* get_sse2_batch_kernel(int band_size, ScorePrecision precision) noexcept;
+const PairHMMBatchKernel* get_avx2_batch_kernel(int band_size, ScorePrecision precision) noexcept;
+const PairHMMBatchKernel* get_avx512_batch_kernel(int band_size, ScorePrecision precision) noexcept;
+
+namespace detail {
+
+template <typename HMM>
+struct KernelAdapter
+{
+    using Penalties = PairHMMKernel::Penalties;
+
+    static int
+    align(const char* truth, const char* target, const std::int8_t* qualities, int truth_len, int target_len,
+          Penalties gap_open, Penalties gap_extend, short nuc_prior)
+    {
+        return HMM {}.align(truth, target, qualities, truth_len, target_len, gap_open, gap_extend, nuc_prior);
+    }
+    static int
+    snv_align(const char* truth, const char* target, const std::int8_t* qualities, int truth_len, int target_len,
+              const char* snv_mask, const std::int8_t* snv_prior, Penalties gap_open, Penalties gap_extend, short nuc_prior)
+    {
+        return HMM {}.align(truth, target, qualities, truth_len, target_len, snv_mask, snv_prior, gap_open, gap_extend, nuc_prior);
+    }
+    static int
+    traceback_align(const char* truth, const char* target, const std::int8_t* qualities, int truth_len, int target_len,
+                    Penalties gap_open, Penalties gap_extend, short nuc_prior,
+                    int& first_pos, char* align1, char* align2)
+    {
+        return HMM {}.align(truth, target, qualities, truth_len, target_len, gap_open, gap_extend, nuc_prior,
+                            first_pos, align1, align2);
+    }
+    static int
+    snv_traceback_align(const char* truth, const char* target, const std::int8_t* qualities, int truth_len, int target_len,
+                        const char* snv_mask, const std::int8_t* snv_prior, Penalties gap_open, Penalties gap_extend,
+                        short nuc_prior, int& first_pos, char* align1, char* align2)
+    {
+        return HMM {}.align(truth, target, qualities, truth_len, target_len, snv_mask, snv_prior, gap_open, gap_extend,
+                            nuc_prior, first_pos, align1, align2);
+    }
+    static int
+    flank_score(int truth_len, int lhs_flank_len, int rhs_flank_len, const std::int8_t* quals,
+                Penalties gap_open, Penalties gap_extend, short nuc_prior,
+                int first_pos, const char* aln1, const char* aln2, int& target_mask_size)
+    {
+        return HMM {}.calculate_flank_score(truth_len, lhs_flank_len, rhs_flank_len, quals, gap_open, gap_extend, nuc_prior,
+                                            first_pos, aln1, aln2, target_mask_size);
+    }
+    static int
+    snv_flank_score(int truth_len, int lhs_flank_len, int rhs_flank_len, const char* target, const std::int8_t* quals,
+                    const char* snv_mask, const std::int8_t* snv_prior, Penalties gap_open, Penalties gap_extend,
+                    short nuc_prior, int first_pos, const char* aln1, const char* aln2, int& target_mask_size)
+    {
+        return HMM {}.calculate_flank_score(truth_len, lhs_flank_len, rhs_flank_len, target, quals, snv_mask, snv_prior,
+                                            gap_open, gap_extend, nuc_prior, first_pos, aln1, aln2, target_mask_size);
+    }
+    static int
+    snv_checkpoint_align(const char* truth, const char* target, const std::int8_t* qualities, int truth_len, int target_len,
+                         const char* snv_mask, const std::int8_t* snv_prior, Penalties gap_open, Penalties gap_extend,
+                         short nuc_prior, int resume_pos, const void* resume_state, int checkpoint_pos, void* checkpoint_state)
+    {
+        return HMM {}.align(truth, target, qualities, truth_len, target_len, snv_mask, snv_prior, gap_open, gap_extend,
+                            nuc_prior, resume_pos, resume_state, checkpoint_pos, checkpoint_state);
+    }
+};
+
+template <typename HMM>
+struct BatchKernelAdapter
+{
+    using Penalties = PairHMMBatchKernel::Penalties;
+    
+    static void
+    snv_align(const char* truths, const char* targets, const std::int8_t* qualities, int truth_len, int target_len,
+              const char* snv_masks, const std::int8_t* snv_priors, Penalties gap_open, Penalties gap_extend, short nuc_prior,
+              int* scores)
+    {
+        HMM {}.align(truths, targets, qualities, truth_len, target_len, snv_masks, snv_priors, gap_open, gap_extend,
+                     nuc_prior, scores);
+    }
+};
+
+template <template <unsigned, typename> class KernelMaker, typename ScoreType, std::size_t... Is>
+auto make_kernel_table(std::index_sequence<Is...>) noexcept
+{
+    using Kernel = decltype(KernelMaker<kernel_band_size(0), ScoreType>::make());
+    return std::array<Kernel, sizeof...(Is)> {{KernelMaker<kernel_band_size(Is), ScoreType>::make()...}};
+}
+
+} // namespace detail
+
+template <typename HMM>
+PairHMMKernel make_kernel() noexcept
+{
+    using Adapter = detail::KernelAdapter<HMM>;
+    PairHMMKernel result {};
+    result.name                = HMM::name();
+    result.band_size           = HMM::band_size();
+    result.align               = &Adapter::align;
+    result.snv_align           = &Adapter::snv_align;
+    result.traceback_align     = &Adapter::traceback_align;
+    result.snv_traceback_align = &Adapter::snv_traceback_align;
+    result.flank_score         = &Adapter::flank_score;
+    result.snv_flank_score     = &Adapter::snv_flank_score;
+    result.snv_checkpoint_align = &Adapter::snv_checkpoint_align;
+    result.checkpoint_size     = HMM::checkpoint_size();
+    return result;
+}
+
+template <typename HMM>
+PairHMMBatchKernel make_batch_kernel(const char* name) noexcept
+{
+    PairHMMBatchKernel result {};
+    result.name       = name;
+    result.band_size  = HMM::band_size();
+    result.batch_size = HMM::batch_size();
+    result.snv_align  = &detail::BatchKernelAdapter<HMM>::snv_align;
+    return result;
+}
+
+// KernelMaker<BandSize, ScoreType>::make() must return the kernel (PairHMMKernel or PairHMMBatchKernel)
+// for the given configuration, or a default constructed kernel if the configuration is not viable for
+// the instruction set.
+template <template <unsigned, typename> class KernelMaker,
+          typename Kernel = decltype(KernelMaker<kernel_band_size(0), short>::make())>
+const Kernel* find_kernel(const int band_size, const ScorePrecision precision) noexcept
+{
+    using Indices = std::make_index_sequence<num_kernel_band_sizes>;
+    static const auto int16_kernels = detail::make_kernel_table<KernelMaker, short>(Indices {});
+    static const auto int32_kernels = detail::make_kernel_table<KernelMaker, int>(Indices {});
+    const auto& kernels = precision == ScorePrecision::int16 ? int16_kernels : int32_kernels;
+    // Use a raw loop rather than a std algorithm to avoid emitting shared inline code from kernel translation units
+    for (std::size_t i {0}; i < num_kernel_band_sizes; ++i) {
+        if (kernels[i].band_size == band_size) return &kernels[i];
+    }
+    return nullptr;
+}
+
+} // namespace simd
+} // namespace hmm
+} // namespace octopus
+
+#endif
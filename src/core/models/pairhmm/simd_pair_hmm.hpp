@@ -14,6 +14,7 @@
 #include <cassert>
 #include <limits>
 #include <vector>
+#include <cstring>
 #include <emmintrin.h>
 #include <immintrin.h>
 
@@ -35,6 +36,18 @@ private:
     
     struct NullType {};
     
+    // The complete DP state at the start of an iteration of align_helper
+    template <typename SnvVectorOrNull>
+    struct Checkpoint
+    {
+        VectorType truthwin, targetwin, qualitieswin, gap_open, gap_extend;
+        SnvVectorOrNull snvmaskwin, snv_priorwin;
+        VectorType truthnqual, m1, i1, d1, m2, i2, d2;
+        Initializer rollinginit;
+        ScoreType minscore;
+        int minscoreidx;
+    };
+    
     // Methods
     using InstructionSet::vectorise;
     using InstructionSet::vectorise_zero_set_last;
@@ -243,7 +256,11 @@ private:
                  const ScoreType nuc_prior,
                  PositionOrNull& first_pos,
                  CharArrayOrNull align1,
-                 CharArrayOrNull align2) const noexcept
+                 CharArrayOrNull align2,
+                 const int resume_pos = 0,
+                 const void* resume_state = nullptr,
+                 const int checkpoint_pos = 0,
+                 void* checkpoint_state = nullptr) const noexcept
     {
         assert(target_len > 0 && truth_len > band_size_ && (truth_len == target_len + 2 * band_size_ - 1));
         const static VectorType _inf = vectorise(infinity_);
@@ -261,7 +278,32 @@ private:
         Initializer rollinginit {null_score_};
         ScoreType minscore {infinity_}, cur_score;
         int minscoreidx {-1};
-        for (int s = 0; s < 2 * (target_len + band_size_); s += 2) {
+        // A checkpoint at truth position pos is the state at the start of iteration s = 2 * (pos - band_size_),
+        // which only depends on truth[0, pos) and the corresponding penalties
+        using CheckpointType = Checkpoint<decltype(_snvmaskwin)>;
+        int s {0};
+        if (resume_state) {
+            assert(resume_pos >= band_size_ && resume_pos <= truth_len);
+            CheckpointType checkpoint {_truthwin, _targetwin, _qualitieswin, _gap_open, _gap_extend, _snvmaskwin, _snv_priorwin,
+                                       _truthnqual, _m1, _i1, _d1, _m2, _i2, _d2, rollinginit, minscore, minscoreidx};
+            std::memcpy(&checkpoint, resume_state, sizeof(CheckpointType));
+            _truthwin = checkpoint.truthwin; _targetwin = checkpoint.targetwin; _qualitieswin = checkpoint.qualitieswin;
+            _gap_open = checkpoint.gap_open; _gap_extend = checkpoint.gap_extend;
+            _snvmaskwin = checkpoint.snvmaskwin; _snv_priorwin = checkpoint.snv_priorwin;
+            _truthnqual = checkpoint.truthnqual;
+            _m1 = checkpoint.m1; _i1 = checkpoint.i1; _d1 = checkpoint.d1;
+            _m2 = checkpoint.m2; _i2 = checkpoint.i2; _d2 = checkpoint.d2;
+            rollinginit = checkpoint.rollinginit;
+            minscore = checkpoint.minscore;
+            minscoreidx = checkpoint.minscoreidx;
+            s = 2 * (resume_pos - band_size_);
+        }
+        for (; s < 2 * (target_len + band_size_); s += 2) {
+            if (checkpoint_state && s == 2 * (checkpoint_pos - band_size_)) {
+                const CheckpointType checkpoint {_truthwin, _targetwin, _qualitieswin, _gap_open, _gap_extend, _snvmaskwin, _snv_priorwin,
+                                                 _truthnqual, _m1, _i1, _d1, _m2, _i2, _d2, rollinginit, minscore, minscoreidx};
+                std::memcpy(checkpoint_state, &checkpoint, sizeof(CheckpointType));
+            }
             // s even. truth is current; target needs updating
             _targetwin    = _left_shift_word(_targetwin);
             _qualitieswin = _left_shift_word(_qualitieswin);
@@ -328,7 +370,7 @@ private:
         return (snv_mask[x] == target[y]) ? std::min(quals[y], caps[x]) : quals[y];
     }
     auto
-    get_mismatch_quality(const char* target,
+    get_mismatch_quality(NullType,
                          const std::int8_t* quals,
                          int x, int y,
                          NullType,
@@ -502,6 +544,37 @@ public:
         return align_helper(truth, target, qualities, truth_len, target_len, gap_open, gap_extend, snv_mask, snv_prior, nuc_prior, first_pos, align1, align2);
     }
     
+    // As the SNV align, but the alignment resumes from the state saved in resume_state (if not nullptr)
+    // at truth position resume_pos, and the state at truth position checkpoint_pos is saved to
+    // checkpoint_state (if not nullptr), which must have room for checkpoint_size() bytes. The state at
+    // truth position pos only depends on truth[0, pos) and the corresponding snv and gap arrays, so can be
+    // resumed by any alignment of the same target against a truth that matches on that prefix.
+    // Positions must be in [band_size(), truth_len].
+    template <typename OpenPenaltyArrayOrConstant,
+              typename ExtendPenaltyArrayOrConstant>
+    int
+    align(const char* truth,
+          const char* target,
+          const std::int8_t* qualities,
+          const int truth_len,
+          const int target_len,
+          const char* snv_mask,
+          const std::int8_t* snv_prior,
+          const OpenPenaltyArrayOrConstant gap_open,
+          const ExtendPenaltyArrayOrConstant gap_extend,
+          short nuc_prior,
+          int resume_pos,
+          const void* resume_state,
+          int checkpoint_pos,
+          void* checkpoint_state) const noexcept
+    {
+        constexpr static NullType null {};
+        return align_helper(truth, target, qualities, truth_len, target_len, gap_open, gap_extend, snv_mask, snv_prior, nuc_prior, null, null, null,
+                            resume_pos, resume_state, checkpoint_pos, checkpoint_state);
+    }
+    
+    constexpr static std::size_t checkpoint_size() noexcept { return sizeof(Checkpoint<VectorType>); }
+    
     template <typename OpenPenaltyArrayOrConstant,
               typename ExtendPenaltyArrayOrConstant>
     int
@@ -0,0 +1,116 @@
+// Copyright (c) 2015-2019 Daniel Cooke and Gerton Lunter
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include "simd_pair_hmm_dispatch.hpp"
+
+#include <ostream>
+#include <stdexcept>
+
+namespace octopus { namespace hmm { namespace simd {
+
+bool is_compiled(const PairHMMInstructionSet instruction_set) noexcept
+{
+    switch (instruction_set) {
+        case PairHMMInstructionSet::sse2: return true;
+        case PairHMMInstructionSet::avx2: return get_avx2_kernel(32, ScorePrecision::int16) != nullptr;
+        case PairHMMInstructionSet::avx512: return get_avx512_kernel(32, ScorePrecision::int16) != nullptr;
+    }
+    return false;
+}
+
+bool is_supported(const PairHMMInstructionSet instruction_set) noexcept
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    switch (instruction_set) {
+        case PairHMMInstructionSet::sse2: return __builtin_cpu_supports("sse2");
+        case PairHMMInstructionSet::avx2: return __builtin_cpu_supports("avx2");
+        case PairHMMInstructionSet::avx512: return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+    }
+    return false;
+#else
+    return instruction_set == PairHMMInstructionSet::sse2;
+#endif
+}
+
+namespace {
+
+bool is_usable(const PairHMMInstructionSet instruction_set) noexcept
+{
+    return is_compiled(instruction_set) && is_supported(instruction_set);
+}
+
+PairHMMInstructionSet detect_instruction_set() noexcept
+{
+    if (is_usable(PairHMMInstructionSet::avx512)) {
+        return PairHMMInstructionSet::avx512;
+    } else if (is_usable(PairHMMInstructionSet::avx2)) {
+        return PairHMMInstructionSet::avx2;
+    } else {
+        return PairHMMInstructionSet::sse2;
+    }
+}
+
+} // namespace
+
+PairHMMInstructionSet get_instruction_set() noexcept
+{
+    static const PairHMMInstructionSet result {detect_instruction_set()};
+    return result;
+}
+
+const PairHMMKernel& get_kernel(const int band_size, const ScorePrecision precision, const PairHMMInstructionSet max_instruction_set)
+{
+    const PairHMMKernel* result {nullptr};
+    if (max_instruction_set == PairHMMInstructionSet::avx512) {
+        result = get_avx512_kernel(band_size, precision);
+    }
+    if (!result && max_instruction_set != PairHMMInstructionSet::sse2) {
+        result = get_avx2_kernel(band_size, precision);
+    }
+    if (!result) {
+        result = get_sse2_kernel(band_size, precision);
+    }
+    if (!result) {
+        throw std::invalid_argument {"get_kernel: no PairHMM kernel with band size " + std::to_string(band_size)};
+    }
+    return *result;
+}
+
+const PairHMMBatchKernel& get_batch_kernel(const int band_size, const ScorePrecision precision, const PairHMMInstructionSet max_instruction_set)
+{
+    const PairHMMBatchKernel* result {nullptr};
+    if (max_instruction_set == PairHMMInstructionSet::avx512) {
+        result = get_avx512_batch_kernel(band_size, precision);
+    }
+    if (!result && max_instruction_set != PairHMMInstructionSet::sse2) {
+        result = get_avx2_batch_kernel(band_size, precision);
+    }
+    if (!result) {
+        result = get_sse2_batch_kernel(band_size, precision);
+    }
+    if (!result) {
+        throw std::invalid_argument {"get_batch_kernel: no PairHMM batch kernel with band size " + std::to_string(band_size)};
+    }
+    return *result;
+}
+
+std::string to_string(const PairHMMInstructionSet instruction_set)
+{
+    switch (instruction_set) {
+        case PairHMMInstructionSet::sse2: return "SSE2";
+        case PairHMMInstructionSet::avx2: return "AVX2";
+        case PairHMMInstructionSet::avx512: return "AVX512";
+    }
+    return "";
+}
+
+std::ostream& operator<<(std::ostream& os, const PairHMMInstructionSet instruction_set)
+{
+    os << to_string(instruction_set);
+    return os;
+}
+
+} // namespace simd
+} // namespace hmm
+} // namespace octopus
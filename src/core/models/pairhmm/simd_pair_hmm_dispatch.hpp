@@ -0,0 +1,41 @@
+// Copyright (c) 2015-2019 Daniel Cooke and Gerton Lunter
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef simd_pair_hmm_dispatch_hpp
+#define simd_pair_hmm_dispatch_hpp
+
+#include <string>
+#include <iosfwd>
+
+#include "pair_hmm_kernel.hpp"
+
+namespace octopus { namespace hmm { namespace simd {
+
+enum class PairHMMInstructionSet { sse2, avx2, avx512 };
+
+// Was the instruction set compiled into this binary?
+bool is_compiled(PairHMMInstructionSet instruction_set) noexcept;
+// Does the host CPU (and OS) support the instruction set?
+bool is_supported(PairHMMInstructionSet instruction_set) noexcept;
+
+// The fastest instruction set that is both compiled and supported by the host.
+// This is detected once with CPUID and then cached.
+PairHMMInstructionSet get_instruction_set() noexcept;
+
+// Returns the kernel of the requested band size for the fastest viable instruction set up to
+// and including max_instruction_set. A kernel is always returned for band sizes 8, 16, ..., 256.
+const PairHMMKernel& get_kernel(int band_size, ScorePrecision precision,
+                                PairHMMInstructionSet max_instruction_set = get_instruction_set());
+
+// As get_kernel, but for the inter-read batch kernels.
+const PairHMMBatchKernel& get_batch_kernel(int band_size, ScorePrecision precision,
+                                           PairHMMInstructionSet max_instruction_set = get_instruction_set());
+
+std::string to_string(PairHMMInstructionSet instruction_set);
+std::ostream& operator<<(std::ostream& os, PairHMMInstructionSet instruction_set);
+
+} // namespace simd
+} // namespace hmm
+} // namespace octopus
+
+#endif
@@ -4,43 +4,22 @@
 #ifndef simd_pair_hmm_wrapper_hpp
 #define simd_pair_hmm_wrapper_hpp
 
-#include <tuple>
-
-#include <boost/variant.hpp>
+#include <cstdint>
+#include <vector>
+#include <stdexcept>
 
 #include "exceptions/user_error.hpp"
-#include "simd_pair_hmm_factory.hpp"
+#include "pair_hmm_kernel.hpp"
+#include "simd_pair_hmm_dispatch.hpp"
 
 namespace octopus { namespace hmm { namespace simd {
 
-namespace detail {
-
-constexpr unsigned ipow(unsigned base, unsigned exponent) noexcept
-{
-    return exponent == 0 ? 1 : base * ipow(base, exponent - 1);
-}
-
-template <typename T, std::size_t... I>
-constexpr auto make_phmm_tuple(std::index_sequence<I...>) { return std::make_tuple(SimdPairHMM<ipow(2, I + 3), T>{}...); }
-
-template <typename Tuple>
-struct to_variant;
-
-template <typename... Ts>
-struct to_variant<std::tuple<Ts...>>
-{
-    using type = boost::variant<Ts...>;
-};
-
-template <typename Tuple>
-using to_variant_t = typename to_variant<Tuple>::type;
-
-} // namespace detail
-
+// Runtime dispatched SIMD PairHMM. The kernel is selected by band size and the fastest instruction
+// set supported by the host CPU, so a single binary can use the best kernels on any machine.
 class PairHMMWrapper
 {
 public:
-    enum class ScorePrecision { int16, int32 };
+    using ScorePrecision = simd::ScorePrecision;
     
     class TooLargeBandSizeError : public std::runtime_error
     {
@@ -64,6 +43,10 @@ public:
     {
         reset(min_band_size, score_precision);
     }
+    PairHMMWrapper(int min_band_size, ScorePrecision score_precision, PairHMMInstructionSet max_instruction_set)
+    {
+        reset(min_band_size, score_precision, max_instruction_set);
+    }
     
     PairHMMWrapper(const PairHMMWrapper&)            = default;
     PairHMMWrapper& operator=(const PairHMMWrapper&) = default;
@@ -74,17 +57,31 @@ public:
     
     int band_size() const noexcept
     {
-        return boost::apply_visitor([] (const auto& hmm) noexcept { return hmm.band_size(); }, hmm_);
+        return kernel_->band_size;
     }
     
     const char* name() const noexcept
     {
-        return boost::apply_visitor([] (const auto& hmm) noexcept { return hmm.name(); }, hmm_);
+        return kernel_->name;
     }
     
-    void reset(int min_band_size, ScorePrecision score_precision = ScorePrecision::int16)
+    // The number of bytes of alignment state saved by checkpointing align
+    std::size_t checkpoint_size() const noexcept
     {
-        hmm_ = make_simd_pair_hmm(min_band_size, score_precision);
+        return kernel_->checkpoint_size;
+    }
+    
+    // The number of targets aligned at once by batch_align
+    int batch_size() const noexcept
+    {
+        return batch_kernel_->batch_size;
+    }
+    
+    void reset(int min_band_size, ScorePrecision score_precision = ScorePrecision::int16,
+               PairHMMInstructionSet max_instruction_set = get_instruction_set())
+    {
+        kernel_ = &get_kernel(get_band_size(min_band_size), score_precision, max_instruction_set);
+        batch_kernel_ = &get_batch_kernel(kernel_->band_size, score_precision, max_instruction_set);
     }
     
     template <typename OpenPenaltyArrayOrConstant,
@@ -99,9 +96,9 @@ public:
           const ExtendPenaltyArrayOrConstant gap_extend,
           short nuc_prior) const noexcept
     {
-        return boost::apply_visitor([&] (const auto& hmm) noexcept {
-            return hmm.align(truth, target, qualities, truth_len, target_len, gap_open, gap_extend, nuc_prior);
-        }, hmm_);
+        return kernel_->align(truth, target, qualities, truth_len, target_len,
+                              expand(gap_open, truth_len, gap_open_buffer()), expand(gap_extend, truth_len, gap_extend_buffer()),
+                              nuc_prior);
     }
     template <typename OpenPenaltyArrayOrConstant,
               typename ExtendPenaltyArrayOrConstant>
@@ -117,9 +114,9 @@ public:
           const ExtendPenaltyArrayOrConstant gap_extend,
           short nuc_prior) const noexcept
     {
-        return boost::apply_visitor([&] (const auto& hmm) noexcept {
-            return hmm.align(truth, target, qualities, truth_len, target_len, snv_mask, snv_prior, gap_open, gap_extend, nuc_prior);
-        }, hmm_);
+        return kernel_->snv_align(truth, target, qualities, truth_len, target_len, snv_mask, snv_prior,
+                                  expand(gap_open, truth_len, gap_open_buffer()), expand(gap_extend, truth_len, gap_extend_buffer()),
+                                  nuc_prior);
     }
     template <typename OpenPenaltyArrayOrConstant,
               typename ExtendPenaltyArrayOrConstant>
@@ -136,9 +133,9 @@ public:
           char* align1,
           char* align2) const noexcept
     {
-        return boost::apply_visitor([&] (const auto& hmm) noexcept {
-            return hmm.align(truth, target, qualities, truth_len, target_len, gap_open, gap_extend, nuc_prior, first_pos, align1, align2);
-        }, hmm_);
+        return kernel_->traceback_align(truth, target, qualities, truth_len, target_len,
+                                        expand(gap_open, truth_len, gap_open_buffer()), expand(gap_extend, truth_len, gap_extend_buffer()),
+                                        nuc_prior, first_pos, align1, align2);
     }
     template <typename OpenPenaltyArrayOrConstant,
               typename ExtendPenaltyArrayOrConstant>
@@ -157,9 +154,32 @@ public:
           char* align1,
           char* align2) const noexcept
     {
-        return boost::apply_visitor([&] (const auto& hmm) noexcept {
-            return hmm.align(truth, target, qualities, truth_len, target_len, snv_mask, snv_prior, gap_open, gap_extend, nuc_prior, first_pos, align1, align2);
-        }, hmm_);
+        return kernel_->snv_traceback_align(truth, target, qualities, truth_len, target_len, snv_mask, snv_prior,
+                                            expand(gap_open, truth_len, gap_open_buffer()), expand(gap_extend, truth_len, gap_extend_buffer()),
+                                            nuc_prior, first_pos, align1, align2);
+    }
+    // Resumes from and saves alignment checkpoints, see SIMD PairHMM align
+    template <typename OpenPenaltyArrayOrConstant,
+              typename ExtendPenaltyArrayOrConstant>
+    int
+    align(const char* truth,
+          const char* target,
+          const std::int8_t* qualities,
+          const int truth_len,
+          const int target_len,
+          const char* snv_mask,
+          const std::int8_t* snv_prior,
+          const OpenPenaltyArrayOrConstant gap_open,
+          const ExtendPenaltyArrayOrConstant gap_extend,
+          short nuc_prior,
+          int resume_pos,
+          const void* resume_state,
+          int checkpoint_pos,
+          void* checkpoint_state) const noexcept
+    {
+        return kernel_->snv_checkpoint_align(truth, target, qualities, truth_len, target_len, snv_mask, snv_prior,
+                                             expand(gap_open, truth_len, gap_open_buffer()), expand(gap_extend, truth_len, gap_extend_buffer()),
+                                             nuc_prior, resume_pos, resume_state, checkpoint_pos, checkpoint_state);
     }
     template <typename OpenPenaltyArrayOrConstant,
               typename ExtendPenaltyArrayOrConstant>
@@ -176,9 +196,9 @@ public:
                           const char* aln2,
                           int& target_mask_size) const noexcept
     {
-        return boost::apply_visitor([&] (const auto& hmm) noexcept {
-            return hmm.calculate_flank_score(truth_len, lhs_flank_len, rhs_flank_len, quals, gap_open, gap_extend, nuc_prior, first_pos, aln1, aln2, target_mask_size);
-        }, hmm_);
+        return kernel_->flank_score(truth_len, lhs_flank_len, rhs_flank_len, quals,
+                                    expand(gap_open, truth_len, gap_open_buffer()), expand(gap_extend, truth_len, gap_extend_buffer()),
+                                    nuc_prior, first_pos, aln1, aln2, target_mask_size);
     }
     template <typename OpenPenaltyArrayOrConstant,
               typename ExtendPenaltyArrayOrConstant>
@@ -198,56 +218,78 @@ public:
                           const char* aln2,
                           int& target_mask_size) const noexcept
     {
-        return boost::apply_visitor([&] (const auto& hmm) noexcept {
-            return hmm.calculate_flank_score(truth_len, lhs_flank_len, rhs_flank_len, target, quals, snv_mask, snv_prior, gap_open, gap_extend, nuc_prior, first_pos, aln1, aln2, target_mask_size);
-        }, hmm_);
+        return kernel_->snv_flank_score(truth_len, lhs_flank_len, rhs_flank_len, target, quals, snv_mask, snv_prior,
+                                        expand(gap_open, truth_len, gap_open_buffer()), expand(gap_extend, truth_len, gap_extend_buffer()),
+                                        nuc_prior, first_pos, aln1, aln2, target_mask_size);
+    }
+
+    // Aligns batch_size() targets of length target_len, one per lane. All arrays are interleaved by lane,
+    // i.e. element j of lane l is at j * batch_size() + l, and the score of lane l is written to scores[l].
+    void
+    batch_align(const char* truths,
+                const char* targets,
+                const std::int8_t* qualities,
+                const int truth_len,
+                const int target_len,
+                const char* snv_masks,
+                const std::int8_t* snv_priors,
+                const std::int8_t* gap_open,
+                const std::int8_t* gap_extend,
+                short nuc_prior,
+                int* scores) const noexcept
+    {
+        batch_kernel_->snv_align(truths, targets, qualities, truth_len, target_len, snv_masks, snv_priors,
+                                 gap_open, gap_extend, nuc_prior, scores);
     }
 
 private:
-    using ShortPairHMMs = decltype(detail::make_phmm_tuple<short>(std::make_index_sequence<6>()));
-    using IntPairHMMs   = decltype(detail::make_phmm_tuple<int>(std::make_index_sequence<6>()));
-    using PairHMMs      = decltype(std::tuple_cat(ShortPairHMMs {}, IntPairHMMs {}));
+    using PenaltyBuffer = std::vector<std::int8_t>;
     
-    using PairHmmVariant = detail::to_variant_t<PairHMMs>;
+    const PairHMMKernel* kernel_;
+    const PairHMMBatchKernel* batch_kernel_;
     
-    PairHmmVariant hmm_;
+    constexpr static int max_band_size_ = kernel_band_size(num_kernel_band_sizes - 1);
     
-    template <typename Hmms>
-    constexpr static int max_band_size() { return std::tuple_element_t<std::tuple_size<Hmms>::value - 1, Hmms>::band_size(); }
-    
-    template <typename Hmms, std::size_t... Is>
-    PairHmmVariant make_simd_pair_hmm_helper(const int min_band_size, std::index_sequence<Is...>) const
+    static int get_band_size(const int min_band_size)
     {
-        if (min_band_size <= max_band_size<Hmms>()) {
-            PairHmmVariant result {};
-            int unused[] = {((Is == 0 || std::tuple_element_t<(Is > 0 ? Is - 1 : 0), Hmms>::band_size() < min_band_size)
-                            && min_band_size <= std::tuple_element_t<Is, Hmms>::band_size()
-                            ? (result = std::tuple_element_t<Is, Hmms> {}, 0) : 0)...};
-            (void) unused;
-            return result;
-        } else {
-            throw TooLargeBandSizeError {min_band_size, max_band_size<Hmms>()};
+        if (min_band_size > max_band_size_) {
+            throw TooLargeBandSizeError {min_band_size, max_band_size_};
+        }
+        for (std::size_t i {0}; i < num_kernel_band_sizes; ++i) {
+            if (min_band_size <= static_cast<int>(kernel_band_size(i))) {
+                return kernel_band_size(i);
+            }
         }
+        return max_band_size_;
+    }
+    
+    static PenaltyBuffer& gap_open_buffer() noexcept
+    {
+        thread_local PenaltyBuffer result {};
+        return result;
     }
-    PairHmmVariant make_simd_pair_hmm(const int min_band_size, const ScorePrecision score_precision) const
+    static PenaltyBuffer& gap_extend_buffer() noexcept
     {
-        if (score_precision == ScorePrecision::int16) {
-            using Hmms = ShortPairHMMs;
-            return make_simd_pair_hmm_helper<Hmms>(min_band_size, std::make_index_sequence<std::tuple_size<Hmms>::value>());
-        } else {
-            using Hmms = IntPairHMMs;
-            return make_simd_pair_hmm_helper<Hmms>(min_band_size, std::make_index_sequence<std::tuple_size<Hmms>::value>());
-        }
+        thread_local PenaltyBuffer result {};
+        return result;
+    }
+    
+    // The kernels only take penalty arrays, so constant penalties are expanded. The array is padded by
+    // one on the left as flank scoring may look at the penalty just before the first truth position.
+    static const std::int8_t* expand(const std::int8_t* penalties, int, PenaltyBuffer&) noexcept
+    {
+        return penalties;
+    }
+    static const std::int8_t* expand(const std::int8_t penalty, const int truth_len, PenaltyBuffer& buffer) noexcept
+    {
+        buffer.assign(truth_len + 1, penalty);
+        return buffer.data() + 1;
     }
 
 public:
-    static int max_band_size(ScorePrecision score_precision) noexcept
+    static int max_band_size(ScorePrecision) noexcept
     {
-        if (score_precision == ScorePrecision::int16) {
-            return max_band_size<ShortPairHMMs>();
-        } else {
-            return max_band_size<IntPairHMMs>();
-        }
+        return max_band_size_;
     }
 };
 
@@ -120,7 +120,11 @@ private:
     template <int index>
     static auto do_extract(const BlockType& a, int) noexcept
     {
+#if defined(__SSE4_1__)
         return _mm_extract_epi32(a, index);
+#else
+        return _mm_cvtsi128_si32(_mm_srli_si128(a, index * sizeof(int)));
+#endif
     }
 protected:
     template <int index>
@@ -156,7 +160,12 @@ private:
     template <int index, typename T>
     static BlockType do_insert(const BlockType& a, T value, int) noexcept
     {
+#if defined(__SSE4_1__)
         return _mm_insert_epi32(a, value, index);
+#else
+        const auto mask = _mm_set_epi32(index == 3 ? -1 : 0, index == 2 ? -1 : 0, index == 1 ? -1 : 0, index == 0 ? -1 : 0);
+        return _mm_or_si128(_mm_andnot_si128(mask, a), _mm_and_si128(mask, _mm_set1_epi32(value)));
+#endif
     }
 protected:
     template <int index, typename T>
@@ -294,7 +303,12 @@ private:
     }
     static BlockType do_min(const BlockType& lhs, const BlockType& rhs, int) noexcept
     {
+#if defined(__SSE4_1__)
         return _mm_min_epi32(lhs, rhs);
+#else
+        const auto mask = _mm_cmplt_epi32(lhs, rhs);
+        return _mm_or_si128(_mm_and_si128(mask, lhs), _mm_andnot_si128(mask, rhs));
+#endif
     }
 protected:
     static VectorType _min(const VectorType& lhs, const VectorType& rhs) noexcept
@@ -308,7 +322,12 @@ private:
     }
     static BlockType do_max(const BlockType& lhs, const BlockType& rhs, int) noexcept
     {
+#if defined(__SSE4_1__)
         return _mm_max_epi32(lhs, rhs);
+#else
+        const auto mask = _mm_cmpgt_epi32(lhs, rhs);
+        return _mm_or_si128(_mm_and_si128(mask, lhs), _mm_andnot_si128(mask, rhs));
+#endif
     }
 protected:
     static VectorType _max(const VectorType& lhs, const VectorType& rhs) noexcept
@@ -0,0 +1,42 @@
+// Copyright (c) 2015-2019 Daniel Cooke and Gerton Lunter
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include "pair_hmm_kernel.hpp"
+
+#include "simd_pair_hmm_factory.hpp"
+#include "batch_pair_hmm.hpp"
+
+namespace octopus { namespace hmm { namespace simd {
+
+namespace {
+
+template <unsigned BandSize, typename ScoreType>
+struct SSE2KernelMaker
+{
+    static PairHMMKernel make() noexcept { return make_kernel<SSE2PairHMM<BandSize, ScoreType>>(); }
+};
+
+template <unsigned BandSize, typename ScoreType>
+struct SSE2BatchKernelMaker
+{
+    static PairHMMBatchKernel make() noexcept
+    {
+        return make_batch_kernel<BatchPairHMM<BandSize, ScoreType, 16 / sizeof(ScoreType)>>("SSE2");
+    }
+};
+
+} // namespace
+
+const PairHMMKernel* get_sse2_kernel(const int band_size, const ScorePrecision precision) noexcept
+{
+    return find_kernel<SSE2KernelMaker>(band_size, precision);
+}
+
+const PairHMMBatchKernel* get_sse2_batch_kernel(const int band_size, const ScorePrecision precision) noexcept
+{
+    return find_kernel<SSE2BatchKernelMaker>(band_size, precision);
+}
+
+} // namespace simd
+} // namespace hmm
+} // namespace octopus
@@ -0,0 +1,153 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include "read_likelihood_cache.hpp"
+
+#include <utility>
+#include <cassert>
+
+namespace octopus {
+
+ReadLikelihoodCache::ReadLikelihoodCache(const std::size_t capacity)
+: capacity_ {capacity}
+, recent_ {}
+, old_ {}
+, stats_ {}
+{}
+
+std::size_t ReadLikelihoodCache::capacity() const noexcept
+{
+    return capacity_;
+}
+
+std::size_t ReadLikelihoodCache::size() const
+{
+    std::lock_guard<std::mutex> lock {mutex_};
+    return recent_.size() + old_.size();
+}
+
+bool ReadLikelihoodCache::empty() const
+{
+    std::lock_guard<std::mutex> lock {mutex_};
+    return recent_.empty() && old_.empty();
+}
+
+boost::optional<ReadLikelihoodCache::LogProbability> ReadLikelihoodCache::find(const Key key)
+{
+    std::lock_guard<std::mutex> lock {mutex_};
+    const auto recent_itr = recent_.find(key);
+    if (recent_itr != std::cend(recent_)) {
+        ++stats_.hits;
+        return recent_itr->second;
+    }
+    const auto old_itr = old_.find(key);
+    if (old_itr != std::cend(old_)) {
+        ++stats_.hits;
+        const auto result = old_itr->second;
+        old_.erase(old_itr);
+        insert_unsynchronised(key, result); // promote
+        return result;
+    }
+    ++stats_.misses;
+    return boost::none;
+}
+
+void ReadLikelihoodCache::insert(const Key key, const LogProbability likelihood)
+{
+    if (capacity_ == 0) return;
+    std::lock_guard<std::mutex> lock {mutex_};
+    insert_unsynchronised(key, likelihood);
+}
+
+void ReadLikelihoodCache::clear()
+{
+    std::lock_guard<std::mutex> lock {mutex_};
+    recent_.clear();
+    old_.clear();
+}
+
+ReadLikelihoodCache::Stats ReadLikelihoodCache::stats() const
+{
+    std::lock_guard<std::mutex> lock {mutex_};
+    return stats_;
+}
+
+double ReadLikelihoodCache::hit_rate() const
+{
+    const auto result = stats();
+    const auto num_lookups = result.hits + result.misses;
+    return num_lookups > 0 ? static_cast<double>(result.hits) / num_lookups : 0.0;
+}
+
+// private methods
+
+void ReadLikelihoodCache::insert_unsynchronised(const Key key, const LogProbability likelihood)
+{
+    if (capacity_ == 0) return;
+    if (2 * recent_.size() >= capacity_) {
+        old_ = std::move(recent_);
+        recent_.clear();
+    }
+    recent_.emplace(key, likelihood);
+}
+
+namespace {
+
+// splitmix64 finaliser
+std::uint64_t mix(std::uint64_t x) noexcept
+{
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+} // namespace
+
+ReadLikelihoodCache::Key
+ReadLikelihoodCache::make_key(const std::uint64_t read_digest, const std::uint64_t haplotype_digest,
+                              const std::uint64_t context) noexcept
+{
+    return mix(mix(mix(read_digest) ^ haplotype_digest) ^ context);
+}
+
+// PrefixHash
+
+namespace {
+
+constexpr std::uint64_t mersenne61 {(std::uint64_t {1} << 61) - 1};
+constexpr std::uint64_t hash_base {0x1fffffffffffcb9ull};
+
+} // namespace
+
+std::size_t PrefixHash::size() const noexcept
+{
+    return prefixes_.empty() ? 0 : prefixes_.size() - 1;
+}
+
+PrefixHash::Digest PrefixHash::operator()(const std::size_t begin, const std::size_t end) const noexcept
+{
+    assert(begin <= end && end < prefixes_.size());
+    const auto shifted_begin = multiply(prefixes_[begin], powers_[end - begin]);
+    auto result = prefixes_[end] + mersenne61 - shifted_begin;
+    if (result >= mersenne61) result -= mersenne61;
+    // Include the length so windows with a common suffix of zero symbols differ
+    return extend(result, end - begin);
+}
+
+PrefixHash::Digest PrefixHash::extend(const Digest digest, const Symbol symbol) noexcept
+{
+    assert(symbol < mersenne61);
+    auto result = multiply(digest, hash_base) + symbol;
+    if (result >= mersenne61) result -= mersenne61;
+    return result;
+}
+
+PrefixHash::Digest PrefixHash::multiply(const Digest lhs, const Digest rhs) noexcept
+{
+    const auto product = static_cast<unsigned __int128>(lhs) * rhs;
+    auto result = static_cast<std::uint64_t>(product & mersenne61) + static_cast<std::uint64_t>(product >> 61);
+    if (result >= mersenne61) result -= mersenne61;
+    return result;
+}
+
+} // namespace octopus
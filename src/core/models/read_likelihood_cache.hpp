@@ -0,0 +1,144 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef read_likelihood_cache_hpp
+#define read_likelihood_cache_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <mutex>
+
+#include <boost/optional.hpp>
+
+namespace octopus {
+
+/*
+    ReadLikelihoodCache is a bounded map from a digest of every PairHMM input (see
+    HaplotypeLikelihoodModel) to the resulting log likelihood. It is intended to live across
+    active regions, as lagging and backtracking mean many read-haplotype alignments are
+    evaluated several times.
+ 
+    The cache keeps two generations of entries. When the newest generation is full the
+    oldest is dropped, so the cache holds at most capacity entries and recently used
+    entries survive.
+ 
+    All lookups and insertions are synchronised, so a single cache may be shared by the
+    workers of a parallel HaplotypeLikelihoodArray::populate.
+ */
+class ReadLikelihoodCache
+{
+public:
+    using Key = std::uint64_t;
+    using LogProbability = double;
+    
+    struct Stats
+    {
+        std::size_t hits = 0, misses = 0;
+    };
+    
+    ReadLikelihoodCache() = default;
+    
+    ReadLikelihoodCache(std::size_t capacity);
+    
+    ReadLikelihoodCache(const ReadLikelihoodCache&)            = delete;
+    ReadLikelihoodCache& operator=(const ReadLikelihoodCache&) = delete;
+    ReadLikelihoodCache(ReadLikelihoodCache&&)                 = delete;
+    ReadLikelihoodCache& operator=(ReadLikelihoodCache&&)      = delete;
+    
+    ~ReadLikelihoodCache() = default;
+    
+    std::size_t capacity() const noexcept;
+    std::size_t size() const;
+    bool empty() const;
+    
+    boost::optional<LogProbability> find(Key key);
+    void insert(Key key, LogProbability likelihood);
+    
+    void clear();
+    
+    Stats stats() const;
+    double hit_rate() const;
+    
+    static Key make_key(std::uint64_t read_digest, std::uint64_t haplotype_digest, std::uint64_t context) noexcept;
+    
+private:
+    using Generation = std::unordered_map<Key, LogProbability>;
+    
+    std::size_t capacity_ = 0;
+    Generation recent_, old_;
+    Stats stats_;
+    mutable std::mutex mutex_;
+    
+    void insert_unsynchronised(Key key, LogProbability likelihood);
+};
+
+/*
+    PrefixHash stores polynomial hashes of every prefix of a sequence of symbols, so the hash
+    of any subsequence can be computed in constant time. Symbols must be less than 2^61 - 1.
+ */
+class PrefixHash
+{
+public:
+    using Symbol = std::uint64_t;
+    using Digest = std::uint64_t;
+    
+    PrefixHash() = default;
+    
+    PrefixHash(const PrefixHash&)            = default;
+    PrefixHash& operator=(const PrefixHash&) = default;
+    PrefixHash(PrefixHash&&)                 = default;
+    PrefixHash& operator=(PrefixHash&&)      = default;
+    
+    ~PrefixHash() = default;
+    
+    template <typename UnaryFunction>
+    void assign(std::size_t n, UnaryFunction symbol);
+    
+    std::size_t size() const noexcept;
+    
+    Digest operator()(std::size_t begin, std::size_t end) const noexcept;
+    
+    template <typename UnaryFunction>
+    static Digest hash(std::size_t n, UnaryFunction symbol) noexcept;
+    
+private:
+    std::vector<Digest> prefixes_, powers_;
+    
+    static Digest extend(Digest digest, Symbol symbol) noexcept;
+    static Digest multiply(Digest lhs, Digest rhs) noexcept;
+};
+
+template <typename UnaryFunction>
+void PrefixHash::assign(const std::size_t n, UnaryFunction symbol)
+{
+    prefixes_.resize(n + 1);
+    prefixes_[0] = 0;
+    for (std::size_t i {0}; i < n; ++i) {
+        prefixes_[i + 1] = extend(prefixes_[i], symbol(i));
+    }
+    if (powers_.size() < n + 1) {
+        const auto old_size = powers_.size();
+        powers_.resize(n + 1);
+        if (old_size == 0) powers_[0] = 1;
+        for (auto i = std::max(old_size, std::size_t {1}); i <= n; ++i) {
+            powers_[i] = extend(powers_[i - 1], 0);
+        }
+    }
+}
+
+template <typename UnaryFunction>
+PrefixHash::Digest PrefixHash::hash(const std::size_t n, UnaryFunction symbol) noexcept
+{
+    Digest result {0};
+    for (std::size_t i {0}; i < n; ++i) {
+        result = extend(result, symbol(i));
+    }
+    return extend(result, n);
+}
+
+} // namespace octopus
+
+#endif
@@ -8,6 +8,7 @@
 #include <queue>
 #include <map>
 #include <set>
+#include <array>
 #include <algorithm>
 #include <numeric>
 #include <memory>
@@ -42,6 +43,7 @@
 #include "config/octopus_vcf.hpp"
 #include "core/callers/caller_factory.hpp"
 #include "core/callers/caller.hpp"
+#include "core/task_cost.hpp"
 #include "utils/maths.hpp"
 #include "logging/progress_meter.hpp"
 #include "logging/logging.hpp"
@@ -56,6 +58,7 @@
 #include "readpipe/buffered_read_pipe.hpp"
 #include "core/tools/bam_realigner.hpp"
 #include "core/tools/indel_profiler.hpp"
+#include "core/models/pairhmm/simd_pair_hmm_dispatch.hpp"
 
 #include "timers.hpp" // BENCHMARK
 
@@ -140,8 +143,18 @@ auto get_call_types(const GenomeCallingComponents& components, const std::vector
     return result;
 }
 
+bool is_fused_call_filtering(const GenomeCallingComponents& components) noexcept
+{
+    return static_cast<bool>(components.fused_call_filter());
+}
+
 void write_caller_output_header(GenomeCallingComponents& components, const UserCommandInfo& info)
 {
+    if (is_fused_call_filtering(components)) {
+        // Calls are filtered by the calling tasks so go straight to the filtered output
+        *components.filtered_output() << components.fused_call_filter()->output_header;
+        return;
+    }
     const auto call_types = get_call_types(components, components.contigs());
     if (components.sites_only() && !apply_csr(components)) {
         components.output() << make_vcf_header({}, components.contigs(), components.reference(),
@@ -203,6 +216,7 @@ void log_startup_info(const GenomeCallingComponents& components)
     str.pop_back(); // the extra whitespace
     log << str;
     stream(log) << "Invoked calling model: " << get_caller_name(components);
+    stream(log) << "Using " << hmm::simd::get_instruction_set() << " PairHMM kernels";
     {
         const auto search_size = utils::format_with_commas(sum_region_sizes(components.search_regions()));
         const auto num_threads = components.num_threads();
@@ -245,6 +259,15 @@ VcfWriter& get_final_output(GenomeCallingComponents& components)
     }
 }
 
+VcfWriter& get_calling_output(GenomeCallingComponents& components)
+{
+    if (is_fused_call_filtering(components)) {
+        return *components.filtered_output();
+    } else {
+        return components.output();
+    }
+}
+
 auto get_final_output_path(const GenomeCallingComponents& components)
 {
     if (components.filtered_output()) {
@@ -369,6 +392,30 @@ bool is_consistent(const std::deque<VcfRecord>& merged_calls)
     return true; // TODO
 }
 
+std::deque<VcfRecord> call(const GenomicRegion& region, const ContigCallingComponents& components)
+{
+    if (components.call_filter) {
+        // Filter with the reads fetched for calling while they are still in memory
+        ReadMap reads {};
+        const auto calls = components.caller->call(region, components.progress_meter, reads);
+        return components.call_filter->filter->filter(calls, reads, region, components.call_filter->output_header);
+    } else {
+        return components.caller->call(region, components.progress_meter);
+    }
+}
+
+std::deque<VcfRecord> call(const GenomicRegion& region, const ContigCallingComponents& components,
+                           Caller::PrefetchedReads prefetched)
+{
+    if (components.call_filter) {
+        ReadMap reads {};
+        const auto calls = components.caller->call(region, components.progress_meter, std::move(prefetched), reads);
+        return components.call_filter->filter->filter(calls, reads, region, components.call_filter->output_header);
+    } else {
+        return components.caller->call(region, components.progress_meter, std::move(prefetched));
+    }
+}
+
 void resolve_connecting_calls(std::vector<VcfRecord>& old_connecting_calls,
                               std::deque<VcfRecord>& calls,
                               const ContigCallingComponents& components)
@@ -395,7 +442,7 @@ void resolve_connecting_calls(std::vector<VcfRecord>& old_connecting_calls,
             const auto unresolved_region = encompassing_region(merged_calls);
             merged_calls.clear();
             merged_calls.shrink_to_fit();
-            auto new_calls = components.caller->call(unresolved_region, components.progress_meter);
+            auto new_calls = call(unresolved_region, components);
             // TODO: we need to make sure the new calls don't contain any calls
             // outside the unresolved_region, and also possibly adjust phase regions
             // in calls past unresolved_region.
@@ -426,7 +473,7 @@ void run_octopus_on_contig(ContigCallingComponents&& components)
         if (debug_log) stream(*debug_log) << "Processing subregion " << subregion;
         
         try {
-            calls = components.caller->call(subregion, components.progress_meter);
+            calls = call(subregion, components);
         } catch(...) {
             // TODO: which exceptions can we recover from?
             throw;
@@ -462,7 +509,7 @@ void run_octopus_single_threaded(GenomeCallingComponents& components)
     #endif
     components.progress_meter().start();
     for (const auto& contig : components.contigs()) {
-        run_octopus_on_contig(ContigCallingComponents {contig, components});
+        run_octopus_on_contig(ContigCallingComponents {contig, get_calling_output(components), components});
     }
     components.progress_meter().stop();
     #ifdef BENCHMARK
@@ -499,12 +546,17 @@ auto create_unique_temp_output_file_path(const GenomicRegion& region,
 VcfHeader make_temp_vcf_header(const GenomeCallingComponents& components, const GenomicRegion& region)
 {
     const auto call_types = get_call_types(components, {region.contig_name()});
-    return make_vcf_header(components.samples(), region.contig_name(), components.reference(), call_types, {"octopus-internal", ""});
+    auto result = make_vcf_header(components.samples(), region.contig_name(), components.reference(), call_types, {"octopus-internal", ""});
+    if (is_fused_call_filtering(components)) {
+        result = components.fused_call_filter()->filter->make_header(result);
+    }
+    return result;
 }
 
 VcfWriter create_unique_temp_output_file(const GenomicRegion& region, const GenomeCallingComponents& components)
 {
-    return {create_unique_temp_output_file_path(region, components), make_temp_vcf_header(components, region)};
+    return {create_unique_temp_output_file_path(region, components), make_temp_vcf_header(components, region),
+            components.htslib_thread_pool()};
 }
 
 VcfWriter create_unique_temp_output_file(const GenomicRegion::ContigName& contig, const GenomeCallingComponents& components)
@@ -533,12 +585,14 @@ struct Task : public Mappable<Task>
 {
     GenomicRegion region;
     ExecutionPolicy policy;
+    TaskCost cost;
     
     Task() = delete;
     
-    Task(GenomicRegion region, ExecutionPolicy policy = ExecutionPolicy::seq)
+    Task(GenomicRegion region, ExecutionPolicy policy = ExecutionPolicy::seq, TaskCost cost = {})
     : region {std::move(region)}
     , policy {policy}
+    , cost {cost}
     {};
     
     const GenomicRegion& mapped_region() const noexcept { return region; }
@@ -550,6 +604,16 @@ std::ostream& operator<<(std::ostream& os, const Task& task)
     return os;
 }
 
+// Orders tasks for a max heap so the most expensive task is dispatched first, breaking ties by position
+struct TaskCostOrder
+{
+    bool operator()(const Task& lhs, const Task& rhs) const noexcept
+    {
+        if (lhs.cost.predicted == rhs.cost.predicted) return rhs < lhs;
+        return lhs.cost.predicted < rhs.cost.predicted;
+    }
+};
+
 struct ContigOrder
 {
     using ContigName = GenomicRegion::ContigName;
@@ -593,6 +657,66 @@ struct TaskMakerSyncPacket
     std::atomic_bool all_done;
 };
 
+constexpr unsigned maxNumCostDepthBins {8};
+constexpr GenomicRegion::Size minCostDepthBinSize {1'000};
+// Windows predicted to cost more than this many read buffers are split
+constexpr double maxTaskCostFactor {2.0};
+
+// Candidate density and soft clipping would be better signals, but both need the reads to be fetched,
+// which is the expensive part of calling. Depth bins are only counted when the coverage index can answer
+// them, otherwise the window gets a single read index query.
+TaskCost estimate_task_cost(const GenomicRegion& region, const ContigCallingComponents& components)
+{
+    if (is_empty(region)) return {};
+    const auto& rm = components.read_manager.get();
+    std::vector<std::size_t> bin_counts {};
+    if (rm.is_coverage_indexed(components.samples, region)) {
+        const auto num_bins = std::max(std::min(maxNumCostDepthBins, static_cast<unsigned>(size(region) / minCostDepthBinSize)), 1u);
+        bin_counts.resize(num_bins);
+        const auto bin_size = size(region) / num_bins;
+        for (unsigned i {0}; i < num_bins; ++i) {
+            const auto bin_begin = region.begin() + i * bin_size;
+            const auto bin_end = i + 1 < num_bins ? bin_begin + bin_size : region.end();
+            // Reads overlapping bin boundaries are counted twice, which is fine for an estimate
+            bin_counts[i] = rm.count_reads(components.samples, GenomicRegion {region.contig_name(), bin_begin, bin_end});
+        }
+    } else {
+        bin_counts.push_back(rm.count_reads(components.samples, region));
+    }
+    if (std::all_of(std::cbegin(bin_counts), std::cend(bin_counts), [] (auto count) { return count == 0; })) {
+        return make_task_cost(bin_counts, 0);
+    }
+    return make_task_cost(bin_counts, calculate_tandem_repeat_fraction(components.reference.get().fetch_sequence(region)));
+}
+
+Task propose_task(const ContigCallingComponents& components,
+                  const GenomicRegion& remaining_call_region,
+                  const ExecutionPolicy policy,
+                  const WindowConfig& config)
+{
+    auto region = propose_call_subregion(components, remaining_call_region, config);
+    auto cost = estimate_task_cost(region, components);
+    const auto max_cost = maxTaskCostFactor * components.read_buffer_size;
+    const GenomicRegion::Size min_size {config.min_size ? *config.min_size : 1};
+    const auto split_size = calculate_split_size(size(region), cost, max_cost, min_size);
+    if (split_size < size(region)) {
+        // Scaled rather than re-estimated, as that would repeat the read and reference queries
+        cost = head_task_cost(cost, static_cast<double>(split_size) / size(region));
+        region = head_region(region, split_size);
+    }
+    return {std::move(region), policy, cost};
+}
+
+Task propose_task(const ContigCallingComponents& components,
+                  const GenomicRegion& current_subregion,
+                  const GenomicRegion& input_region,
+                  const ExecutionPolicy policy,
+                  const WindowConfig& config)
+{
+    assert(contains(input_region, current_subregion));
+    return propose_task(components, right_overhang_region(input_region, current_subregion), policy, config);
+}
+
 void make_region_tasks(const GenomicRegion& region,
                        const ContigCallingComponents& components,
                        const ExecutionPolicy policy,
@@ -603,11 +727,11 @@ void make_region_tasks(const GenomicRegion& region,
                        const WindowConfig& window_config)
 {
     std::unique_lock<std::mutex> lock {sync.mutex, std::defer_lock};
-    auto subregion = propose_call_subregion(components, region, window_config);
-    if (ends_equal(subregion, region)) {
+    auto task = propose_task(components, region, policy, window_config);
+    if (ends_equal(task, region)) {
         lock.lock();
         sync.cv.wait(lock, [&] () { return sync.ready; });
-        result.emplace(std::move(subregion), policy);
+        result.push(std::move(task));
         ++sync.num_tasks;
         if (last_region_in_contig) {
             sync.finished.at(region.contig_name()) = true;
@@ -616,15 +740,15 @@ void make_region_tasks(const GenomicRegion& region,
         lock.unlock();
         sync.cv.notify_one();
     } else {
-        std::deque<GenomicRegion> batch {};
-        batch.push_back(subregion);
+        std::deque<Task> batch {};
+        batch.push_back(task);
         bool done {false};
         while (true) {
             while (batch.size() < std::max(sync.batch_size_hint.load(), 1u) || !sync.waiting) {
-                subregion = propose_call_subregion(components, subregion, region, window_config);
-                batch.push_back(subregion);
-                assert(!ends_before(region, subregion));
-                if (ends_equal(subregion, region)) {
+                task = propose_task(components, task.region, region, policy, window_config);
+                batch.push_back(task);
+                assert(!ends_before(region, task));
+                if (ends_equal(task, region)) {
                     done = true;
                     break;
                 }
@@ -633,7 +757,7 @@ void make_region_tasks(const GenomicRegion& region,
             assert(!lock.owns_lock());
             lock.lock();
             sync.cv.wait(lock, [&] () { return sync.ready; });
-            for (auto&& r : batch) result.emplace(std::move(r), policy);
+            for (auto&& t : batch) result.push(std::move(t));
             sync.num_tasks += batch.size();
             if (done) {
                 if (last_region_in_contig) {
@@ -740,6 +864,9 @@ make_task_maker_thread(TaskMap& tasks,
 
 unsigned calculate_num_task_threads(const GenomeCallingComponents& components)
 {
+    if (components.thread_pool()) {
+        return components.thread_pool()->size(); // excludes htslib threads
+    }
     if (components.num_threads()) {
         return *components.num_threads();
     }
@@ -750,7 +877,15 @@ unsigned calculate_num_task_threads(const GenomeCallingComponents& components)
     return num_cores;
 }
 
-Task pop(TaskMap& tasks, TaskMakerSyncPacket& sync)
+// Read prefetches mostly wait on htslib decompression, so their threads come from the I/O budget
+unsigned calculate_num_prefetch_threads(const GenomeCallingComponents& components, const unsigned num_task_threads)
+{
+    const auto num_io_threads = components.htslib_thread_pool() ? components.htslib_thread_pool()->size() : 1u;
+    return std::max(std::min(num_io_threads, num_task_threads), 1u);
+}
+
+// Pops up to max_tasks consecutive tasks from the first contig with pending tasks
+std::deque<Task> pop(TaskMap& tasks, TaskMakerSyncPacket& sync, const unsigned max_tasks)
 {
     assert(!tasks.empty());
     std::unique_lock<std::mutex> lock {sync.mutex};
@@ -758,14 +893,17 @@ Task pop(TaskMap& tasks, TaskMakerSyncPacket& sync)
     assert(sync.num_tasks > 0);
     const auto contig_task_itr = std::begin(tasks);
     assert(!contig_task_itr->second.empty());
-    const auto result = std::move(contig_task_itr->second.front());
-    contig_task_itr->second.pop();
+    std::deque<Task> result {};
+    while (result.size() < std::max(max_tasks, 1u) && !contig_task_itr->second.empty()) {
+        result.push_back(std::move(contig_task_itr->second.front()));
+        contig_task_itr->second.pop();
+    }
     if (sync.finished.at(contig_task_itr->first) && contig_task_itr->second.empty()) {
         static auto debug_log = get_debug_log();
         if (debug_log) stream(*debug_log) << "Finished calling contig " << contig_task_itr->first;
         tasks.erase(contig_task_itr);
     }
-    --sync.num_tasks;
+    sync.num_tasks -= result.size();
     sync.ready = true;
     lock.unlock();
     sync.cv.notify_one();
@@ -774,9 +912,11 @@ Task pop(TaskMap& tasks, TaskMakerSyncPacket& sync)
 
 struct CompletedTask : public Task
 {
-    CompletedTask(Task task) : Task {std::move(task)}, calls {}, runtime {} {}
+    CompletedTask(Task task) : Task {std::move(task)}, calls {}, runtime {}, read_stall {}, prefetched_reads {false} {}
     std::deque<VcfRecord> calls;
     utils::TimeInterval runtime;
+    std::chrono::duration<double> read_stall; // time spent waiting for reads before calling could start
+    bool prefetched_reads;
 };
 
 std::string duration(const CompletedTask& task)
@@ -792,6 +932,105 @@ std::ostream& operator<<(std::ostream& os, const CompletedTask& task)
     return os;
 }
 
+struct TaskCostRecord
+{
+    double predicted, runtime, read_stall;
+    bool prefetched_reads;
+};
+
+using TaskCostLog = std::vector<TaskCostRecord>;
+
+void record(const CompletedTask& task, TaskCostLog& log)
+{
+    static auto debug_log = get_debug_log();
+    const std::chrono::duration<double> runtime {task.runtime.end - task.runtime.start};
+    log.push_back({task.cost.predicted, runtime.count(), task.read_stall.count(), task.prefetched_reads});
+    if (debug_log) {
+        stream(*debug_log) << "Task " << task << " waited " << task.read_stall.count() << "s for "
+                           << (task.prefetched_reads ? "prefetched" : "fetched") << " reads";
+    }
+}
+
+template <typename T>
+std::vector<double> rank(const std::vector<T>& values)
+{
+    std::vector<std::size_t> order(values.size());
+    std::iota(std::begin(order), std::end(order), 0);
+    std::sort(std::begin(order), std::end(order), [&] (auto lhs, auto rhs) { return values[lhs] < values[rhs]; });
+    std::vector<double> result(values.size());
+    for (std::size_t i {0}; i < order.size();) {
+        auto j = i + 1;
+        while (j < order.size() && values[order[j]] == values[order[i]]) ++j;
+        const auto tied_rank = (i + j - 1) / 2.0; // ties share their mean rank
+        for (; i < j; ++i) result[order[i]] = tied_rank;
+    }
+    return result;
+}
+
+// Spearman correlation between predicted cost and runtime
+boost::optional<double> evaluate_cost_model(const TaskCostLog& log)
+{
+    if (log.size() < 2) return boost::none;
+    std::vector<double> predicted(log.size()), runtimes(log.size());
+    std::transform(std::cbegin(log), std::cend(log), std::begin(predicted), [] (const auto& r) { return r.predicted; });
+    std::transform(std::cbegin(log), std::cend(log), std::begin(runtimes), [] (const auto& r) { return r.runtime; });
+    const auto x = rank(predicted), y = rank(runtimes);
+    const auto x_mean = maths::mean(x), y_mean = maths::mean(y);
+    double covariance {0}, x_ss {0}, y_ss {0};
+    for (std::size_t i {0}; i < log.size(); ++i) {
+        covariance += (x[i] - x_mean) * (y[i] - y_mean);
+        x_ss += std::pow(x[i] - x_mean, 2);
+        y_ss += std::pow(y[i] - y_mean, 2);
+    }
+    if (x_ss == 0 || y_ss == 0) return boost::none;
+    return covariance / std::sqrt(x_ss * y_ss);
+}
+
+void log_cost_model_evaluation(const TaskCostLog& log)
+{
+    static auto debug_log = get_debug_log();
+    if (debug_log) {
+        const auto correlation = evaluate_cost_model(log);
+        auto ds = stream(*debug_log);
+        ds << "Task cost model predicted " << log.size() << " tasks with runtime rank correlation ";
+        if (correlation) {
+            ds << *correlation;
+        } else {
+            ds << "undefined";
+        }
+    }
+}
+
+// Mean time tasks spent waiting for reads, split by whether the reads were prefetched, and the share of all
+// task time lost to waiting, which is the figure to compare between runs
+void log_read_stall_summary(const TaskCostLog& log)
+{
+    static auto debug_log = get_debug_log();
+    if (debug_log) {
+        std::array<std::size_t, 2> num_tasks {};
+        std::array<double, 2> total_stall {};
+        double total_runtime {0};
+        for (const auto& record : log) {
+            ++num_tasks[record.prefetched_reads];
+            total_stall[record.prefetched_reads] += record.read_stall;
+            total_runtime += record.runtime;
+        }
+        auto ds = stream(*debug_log);
+        ds << "Read stall was " << (total_stall[0] + total_stall[1]) << "s of " << total_runtime << "s task time";
+        if (total_runtime > 0) ds << " (" << 100 * (total_stall[0] + total_stall[1]) / total_runtime << "%)";
+        ds << "; per task: ";
+        for (const bool prefetched : {false, true}) {
+            ds << num_tasks[prefetched] << (prefetched ? " prefetched " : " unprefetched ") << "tasks waited ";
+            if (num_tasks[prefetched] > 0) {
+                ds << total_stall[prefetched] / num_tasks[prefetched] << "s on average";
+            } else {
+                ds << "-";
+            }
+            if (!prefetched) ds << ", ";
+        }
+    }
+}
+
 struct CallerSyncPacket
 {
     CallerSyncPacket() : num_finished {0} {}
@@ -806,15 +1045,23 @@ bool is_ready(const std::future<R>& f)
     return f.valid() && f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
 }
 
-auto run(Task task, ContigCallingComponents components, CallerSyncPacket& sync)
+using PrefetchedReadsFuture = std::future<Caller::PrefetchedReads>;
+
+// If prefetched_reads is not valid then the task fetches its own reads
+auto run(Task task, ContigCallingComponents components, PrefetchedReadsFuture prefetched_reads,
+         CallerSyncPacket& sync, ThreadPool& workers)
 {
     static auto debug_log = get_debug_log();
-    if (debug_log) stream(*debug_log) << "Spawning task " << task;
-    return std::async(std::launch::async, [task = std::move(task), components = std::move(components), &sync] () {
+    if (debug_log) stream(*debug_log) << "Spawning task " << task << " with predicted cost " << task.cost;
+    return workers.push([task = std::move(task), components = std::move(components),
+                         prefetched_reads = std::move(prefetched_reads), &sync] () mutable {
         try {
             CompletedTask result {task};
             result.runtime.start = std::chrono::system_clock::now();
-            result.calls = components.caller->call(task.region, components.progress_meter);
+            result.prefetched_reads = prefetched_reads.valid();
+            auto reads = result.prefetched_reads ? prefetched_reads.get() : components.caller->prefetch_reads(task.region);
+            result.read_stall = std::chrono::system_clock::now() - result.runtime.start;
+            result.calls = call(task.region, components, std::move(reads));
             result.runtime.end = std::chrono::system_clock::now();
             std::unique_lock<std::mutex> lock {sync.mutex};
             ++sync.num_finished;
@@ -875,6 +1122,51 @@ auto make_contig_calling_component_factory_map(GenomeCallingComponents& componen
     return result;
 }
 
+// A ready task whose reads are being fetched in the background
+struct PrefetchedTask
+{
+    PrefetchedTask(ContigCallingComponents components, PrefetchedReadsFuture reads, std::size_t num_reads)
+    : components {std::move(components)}, reads {std::move(reads)}, num_reads {num_reads} {}
+    PrefetchedTask(PrefetchedTask&&)            = default;
+    PrefetchedTask& operator=(PrefetchedTask&&) = default;
+    // The fetch references the caller in components, so must finish first
+    ~PrefetchedTask() { if (reads.valid()) reads.wait(); }
+    
+    ContigCallingComponents components;
+    PrefetchedReadsFuture reads;
+    std::size_t num_reads; // predicted
+};
+
+using PrefetchedTaskMap = std::map<GenomicRegion, PrefetchedTask>;
+
+// Starts fetching reads for the ready tasks that will run next, in dispatch order, so task threads do not
+// have to wait on I/O. Fetches run on their own I/O pool so they never take a calling thread. At most
+// max_prefetches tasks are prefetched at once, and the predicted reads of all prefetched tasks, plus the
+// num_running_reads held by running tasks, must fit in max_buffered_reads.
+void prefetch_reads(const std::vector<Task>& ready_tasks, PrefetchedTaskMap& prefetched_tasks,
+                    const ContigCallingComponentFactoryMap& calling_components, ThreadPool& io_workers,
+                    const std::size_t max_prefetches, const std::size_t max_buffered_reads,
+                    const std::size_t num_running_reads)
+{
+    if (prefetched_tasks.size() >= max_prefetches || num_running_reads >= max_buffered_reads) return;
+    const auto max_prefetched_reads = max_buffered_reads - num_running_reads;
+    std::size_t num_prefetched_reads {0};
+    for (const auto& p : prefetched_tasks) num_prefetched_reads += p.second.num_reads;
+    std::vector<std::reference_wrapper<const Task>> next_tasks {std::cbegin(ready_tasks), std::cend(ready_tasks)};
+    std::sort(std::begin(next_tasks), std::end(next_tasks),
+              [] (const Task& lhs, const Task& rhs) { return TaskCostOrder {}(rhs, lhs); });
+    for (const Task& task : next_tasks) {
+        if (prefetched_tasks.size() >= max_prefetches) break;
+        if (prefetched_tasks.count(task.region) == 1) continue;
+        if (num_prefetched_reads + task.cost.num_reads > max_prefetched_reads) break;
+        auto components = calling_components.at(contig_name(task))();
+        const Caller& caller = *components.caller;
+        auto reads = io_workers.push([&caller, region = task.region] () { return caller.prefetch_reads(region); });
+        prefetched_tasks.emplace(task.region, PrefetchedTask {std::move(components), std::move(reads), task.cost.num_reads});
+        num_prefetched_reads += task.cost.num_reads;
+    }
+}
+
 auto find_first_lhs_connecting(const std::deque<VcfRecord>& lhs_calls, const GenomicRegion& rhs_region)
 {
     const auto rhs_begin = mapped_begin(rhs_region);
@@ -928,7 +1220,7 @@ void resolve_connecting_calls(CompletedTask& lhs, CompletedTask& rhs,
             logging::WarningLogger warn_log {};
             stream(warn_log) << "Recalling " << unresolved_region
                              << " due to call inconsistency between thread tasks. This may increase expected runtime";
-            auto resolved_calls = components.caller->call(unresolved_region, components.progress_meter);
+            auto resolved_calls = call(unresolved_region, components);
             if (!resolved_calls.empty()) {
                 if (!contains(unresolved_region, encompassing_region(resolved_calls))) {
                     // TODO
@@ -970,7 +1262,8 @@ void write(std::deque<CompletedTask>& tasks, TempVcfWriterMap& writers)
     static auto debug_log = get_debug_log();
     for (auto&& task : tasks) {
         if (debug_log) {
-            stream(*debug_log) << "Writing completed task " << task << " that finished in " << duration(task);
+            stream(*debug_log) << "Writing completed task " << task << " that finished in " << duration(task)
+                               << " with predicted cost " << task.cost;
         }
         auto& writer = writers.at(contig_name(task));
         write_calls(std::move(task.calls), writer);
@@ -1020,7 +1313,8 @@ void write(std::deque<CompletedTask>&& tasks, VcfWriter& temp_vcf)
 {
     static auto debug_log = get_debug_log();
     for (auto&& task : tasks) {
-        if (debug_log) stream(*debug_log) << "Writing completed task " << task << " that finished in " << duration(task);
+        if (debug_log) stream(*debug_log) << "Writing completed task " << task << " that finished in " << duration(task)
+                                          << " with predicted cost " << task.cost;
         write_calls(std::move(task.calls), temp_vcf);
     }
 }
@@ -1103,10 +1397,12 @@ RemainingTaskMap make_map(std::deque<CompletedTask>& tasks)
     return result;
 }
 
-RemainingTaskMap extract_remaining_tasks(FutureCompletedTasks& futures, CompletedTaskMap& buffered_tasks)
+RemainingTaskMap extract_remaining_tasks(FutureCompletedTasks& futures, CompletedTaskMap& buffered_tasks,
+                                         TaskCostLog& cost_log)
 {
     std::deque<CompletedTask> tasks {};
     extract_remaining_future_tasks(futures, tasks);
+    for (const auto& task : tasks) record(task, cost_log);
     extract_buffered_tasks(buffered_tasks, tasks);
     return make_map(tasks);
 }
@@ -1127,11 +1423,11 @@ void write(RemainingTaskMap&& remaining_tasks, TempVcfWriterMap& temp_vcfs)
 }
 
 void write_remaining_tasks(FutureCompletedTasks& futures, CompletedTaskMap& buffered_tasks, TempVcfWriterMap& temp_vcfs,
-                           const ContigCallingComponentFactoryMap& calling_components)
+                           const ContigCallingComponentFactoryMap& calling_components, TaskCostLog& cost_log)
 {
     static auto debug_log = get_debug_log();
     if (debug_log) stream(*debug_log) << "Waiting for " << futures.size() << " running tasks to finish";
-    auto remaining_tasks = extract_remaining_tasks(futures, buffered_tasks);
+    auto remaining_tasks = extract_remaining_tasks(futures, buffered_tasks, cost_log);
     resolve_connecting_calls(remaining_tasks, calling_components);
     write(std::move(remaining_tasks), temp_vcfs);
 }
@@ -1157,7 +1453,11 @@ void merge(TempVcfWriterMap&& temp_vcf_writers, GenomeCallingComponents& compone
     static auto debug_log = get_debug_log();
     if (debug_log) stream(*debug_log) << "Merging " << temp_vcf_writers.size() << " temporary VCF files";
     auto temp_readers = extract_as_readers(std::move(temp_vcf_writers));
-    merge(temp_readers, components.output(), components.contigs());
+    if (components.thread_pool()) {
+        merge(temp_readers, get_calling_output(components), components.contigs(), *components.thread_pool());
+    } else {
+        merge(temp_readers, get_calling_output(components), components.contigs());
+    }
 }
 
 void run_octopus_multi_threaded(GenomeCallingComponents& components)
@@ -1166,6 +1466,7 @@ void run_octopus_multi_threaded(GenomeCallingComponents& components)
     static auto debug_log = get_debug_log();
     
     const auto num_task_threads = calculate_num_task_threads(components);
+    assert(components.thread_pool() && components.thread_pool()->size() == num_task_threads);
     
     TaskMap pending_tasks {components.contigs()};
     TaskMakerSyncPacket task_maker_sync {};
@@ -1190,6 +1491,29 @@ void run_octopus_multi_threaded(GenomeCallingComponents& components)
         holdbacks.emplace(contig, boost::none);
     }
     
+    // Tasks taken from the pending queue but not yet running, kept as a heap on predicted cost. They are
+    // already in running_tasks, so completed tasks are still written in order.
+    std::vector<Task> ready_tasks {};
+    TaskCostLog cost_log {};
+    // Prefetched reads share the read buffer budget with running tasks
+    ThreadPool prefetch_workers {calculate_num_prefetch_threads(components, num_task_threads)};
+    PrefetchedTaskMap prefetched_tasks {};
+    const auto max_buffered_reads = components.read_buffer_size();
+    std::size_t num_running_reads {0}; // predicted
+    const auto take_pending_tasks = [&] () {
+        pending_task_lock.lock();
+        if (task_maker_sync.num_tasks > 0) {
+            pending_task_lock.unlock(); // As pop will need to lock the mutex too == deadlock
+            for (auto&& task : pop(pending_tasks, task_maker_sync, num_task_threads)) {
+                running_tasks.at(contig_name(task)).push(task);
+                ready_tasks.push_back(std::move(task));
+                std::push_heap(std::begin(ready_tasks), std::end(ready_tasks), TaskCostOrder {});
+            }
+        } else {
+            pending_task_lock.unlock();
+        }
+    };
+    
     CallerSyncPacket caller_sync {};
     const auto calling_components = make_contig_calling_component_factory_map(components);
     unsigned num_idle_futures {0};
@@ -1215,10 +1539,10 @@ void run_octopus_multi_threaded(GenomeCallingComponents& components)
     
     components.progress_meter().start();
     
-    while (!task_maker_sync.all_done || task_maker_sync.num_tasks > 0) {
+    while (!task_maker_sync.all_done || task_maker_sync.num_tasks > 0 || !ready_tasks.empty()) {
         pending_task_lock.lock();
         assert(count_tasks(pending_tasks) == task_maker_sync.num_tasks);
-        if (!task_maker_sync.all_done && task_maker_sync.num_tasks == 0) {
+        if (!task_maker_sync.all_done && task_maker_sync.num_tasks == 0 && ready_tasks.empty()) {
             task_maker_sync.batch_size_hint = std::max(num_idle_futures, num_task_threads / 2);
             if (num_idle_futures < futures.size()) {
                 // If there are running futures then it's good periodically check to see if
@@ -1236,6 +1560,8 @@ void run_octopus_multi_threaded(GenomeCallingComponents& components)
         for (auto& future : futures) {
             if (is_ready(future)) {
                 auto completed_task = future.get();
+                num_running_reads -= std::min(completed_task.cost.num_reads, num_running_reads);
+                record(completed_task, cost_log);
                 const auto& contig = contig_name(completed_task.region);
                 write_or_buffer(std::move(completed_task), buffered_tasks.at(contig),
                                 running_tasks.at(contig), holdbacks.at(contig),
@@ -1243,18 +1569,30 @@ void run_octopus_multi_threaded(GenomeCallingComponents& components)
                 --caller_sync.num_finished;
             }
             if (!future.valid()) {
-                pending_task_lock.lock();
-                if (task_maker_sync.num_tasks > 0) {
-                    pending_task_lock.unlock(); // As pop will need to lock the mutex too == deadlock
-                    auto task = pop(pending_tasks, task_maker_sync);
-                    future = run(task, calling_components.at(contig_name(task))(), caller_sync);
-                    running_tasks.at(contig_name(task)).push(std::move(task));
+                if (ready_tasks.empty()) take_pending_tasks();
+                if (!ready_tasks.empty()) {
+                    std::pop_heap(std::begin(ready_tasks), std::end(ready_tasks), TaskCostOrder {});
+                    auto task = std::move(ready_tasks.back());
+                    ready_tasks.pop_back();
+                    num_running_reads += task.cost.num_reads;
+                    const auto prefetched_task = prefetched_tasks.find(task.region);
+                    if (prefetched_task != std::end(prefetched_tasks)) {
+                        future = run(std::move(task), std::move(prefetched_task->second.components),
+                                     std::move(prefetched_task->second.reads), caller_sync, *components.thread_pool());
+                        prefetched_tasks.erase(prefetched_task);
+                    } else {
+                        auto contig_components = calling_components.at(contig_name(task))();
+                        future = run(std::move(task), std::move(contig_components), {}, caller_sync, *components.thread_pool());
+                    }
                 } else {
-                    pending_task_lock.unlock();
                     ++num_idle_futures;
                 }
             }
         }
+        // Take the next tasks now, rather than when a thread becomes idle, so their reads can be prefetched
+        if (ready_tasks.empty()) take_pending_tasks();
+        prefetch_reads(ready_tasks, prefetched_tasks, calling_components, prefetch_workers,
+                       num_task_threads, max_buffered_reads, num_running_reads);
         // If there are no idle futures then all threads are busy and we must wait for one to finish,
         // otherwise we must have run out of tasks, so we should wait for new ones.
         if (num_idle_futures == 0 && caller_sync.num_finished == 0) {
@@ -1268,11 +1606,15 @@ void run_octopus_multi_threaded(GenomeCallingComponents& components)
     }
     assert(task_maker_sync.num_tasks == 0);
     assert(pending_tasks.empty());
+    assert(ready_tasks.empty());
+    assert(prefetched_tasks.empty());
     running_tasks.clear();
     holdbacks.clear(); // holdbacks are just references to buffered tasks
     if (debug_log) *debug_log << "Finished making new tasks. Waiting for task writer to complete existing jobs";
     wait_until_finished(task_writer_sync);
-    write_remaining_tasks(futures, buffered_tasks, temp_writers, calling_components);
+    write_remaining_tasks(futures, buffered_tasks, temp_writers, calling_components, cost_log);
+    log_cost_model_evaluation(cost_log);
+    log_read_stall_summary(cost_log);
     components.progress_meter().stop();
     merge(std::move(temp_writers), components);
 }
@@ -1281,7 +1623,8 @@ void run_octopus_multi_threaded(GenomeCallingComponents& components)
 
 bool is_multithreaded(const GenomeCallingComponents& components)
 {
-    return !components.num_threads() || *components.num_threads() > 1;
+    // No pool is made when only one thread is available, even if the thread count was left to the host
+    return components.thread_pool() != nullptr;
 }
 
 void run_calling(GenomeCallingComponents& components)
@@ -1370,9 +1713,33 @@ Pedigree get_pedigree(const GenomeCallingComponents& components)
     return *result;
 }
 
+void setup_fused_call_filter(GenomeCallingComponents& components, const UserCommandInfo& info)
+{
+    const auto call_types = get_call_types(components, components.contigs());
+    auto input_header = make_vcf_header(components.samples(), components.contigs(), components.reference(), call_types, info);
+    // Reads are normally taken from the calling tasks, so the buffer is only used for calls outside task regions
+    BufferedReadPipe::Config buffer_config {components.read_buffer_size()};
+    BufferedReadPipe buffered_rp {components.filter_read_pipe(), buffer_config};
+    auto filter = components.call_filter_factory().make(components.reference(), std::move(buffered_rp), input_header,
+                                                        components.ploidies(),
+                                                        make_filtering_haplotype_likelihood_model(components),
+                                                        get_pedigree(components));
+    assert(filter);
+    if (filter->is_streamable()) {
+        logging::InfoLogger log {};
+        log << "Filtering calls as they are made (fused CSR)";
+        auto output_header = filter->make_header(input_header);
+        components.set_fused_call_filter({std::move(filter), std::move(output_header)});
+    } else {
+        logging::WarningLogger warn_log {};
+        stream(warn_log) << "The " << filter->name() << " filter needs to see all calls before filtering"
+                         << " so calls will be filtered in a separate pass";
+    }
+}
+
 void run_csr(GenomeCallingComponents& components)
 {
-    if (apply_csr(components)) {
+    if (apply_csr(components) && !is_fused_call_filtering(components)) {
         log_filtering_info(components);
         ProgressMeter progress {components.search_regions()};
         const auto& filter_factory = components.call_filter_factory();
@@ -1442,6 +1809,9 @@ void run_variant_calling(GenomeCallingComponents& components, UserCommandInfo in
 {
     static auto debug_log = get_debug_log();
     log_run_start(components, info);
+    if (components.fused_call_filtering_requested() && apply_csr(components) && !components.filter_request()) {
+        setup_fused_call_filter(components, info);
+    }
     write_caller_output_header(components, info);
     const auto start = std::chrono::system_clock::now();
     try {
@@ -1468,6 +1838,9 @@ void run_variant_calling(GenomeCallingComponents& components, UserCommandInfo in
         throw CallingBug {};
     }
     components.output().close();
+    if (is_fused_call_filtering(components)) {
+        components.filtered_output()->close();
+    }
     try {
         run_csr(components);
     } catch (const Error& e) {
@@ -1653,7 +2026,7 @@ void run_data_profiler(GenomeCallingComponents& components)
         if (final_output_path) {
             info_log << "Starting indel profiler";
             final_output.close();
-            if (is_indexable(*final_output_path)) index_vcf(*final_output_path);
+            if (is_indexable(*final_output_path) && !is_indexed(*final_output_path)) index_vcf(*final_output_path);
             auto config = components.profiler_config();
             const auto profile = profile_indels(components.read_pipe(), *final_output_path, components.reference(), components.search_regions(), std::move(config));
             std::ofstream profile_file {data_profile_csv_path->string()};
@@ -0,0 +1,86 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include "task_cost.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <iterator>
+#include <cmath>
+#include <ostream>
+
+#include "utils/maths.hpp"
+
+namespace octopus {
+
+namespace {
+
+constexpr double repeatCostWeight {4.0}, depthVariationCostWeight {1.0};
+
+double predict_cost(const TaskCost& cost) noexcept
+{
+    return cost.num_reads * (1 + repeatCostWeight * cost.repeat_fraction)
+                          * (1 + depthVariationCostWeight * cost.depth_variation);
+}
+
+} // namespace
+
+std::ostream& operator<<(std::ostream& os, const TaskCost& cost)
+{
+    os << cost.predicted << " (" << cost.num_reads << " reads, depth variation " << cost.depth_variation
+       << ", repeat fraction " << cost.repeat_fraction << ")";
+    return os;
+}
+
+double calculate_tandem_repeat_fraction(const std::string& sequence)
+{
+    constexpr std::size_t maxPeriod {6}, minRepeatLength {12};
+    if (sequence.size() < minRepeatLength) return 0;
+    std::vector<bool> in_repeat(sequence.size(), false);
+    for (std::size_t period {1}; period <= maxPeriod; ++period) {
+        std::size_t run_length {0};
+        for (std::size_t i {period}; i <= sequence.size(); ++i) {
+            if (i < sequence.size() && sequence[i] == sequence[i - period] && sequence[i] != 'N') {
+                ++run_length;
+            } else {
+                if (run_length + period >= minRepeatLength) {
+                    std::fill(std::next(std::begin(in_repeat), i - run_length - period),
+                              std::next(std::begin(in_repeat), i), true);
+                }
+                run_length = 0;
+            }
+        }
+    }
+    return static_cast<double>(std::count(std::cbegin(in_repeat), std::cend(in_repeat), true)) / sequence.size();
+}
+
+TaskCost make_task_cost(const std::vector<std::size_t>& bin_read_counts, const double repeat_fraction)
+{
+    TaskCost result {};
+    result.num_reads = std::accumulate(std::cbegin(bin_read_counts), std::cend(bin_read_counts), std::size_t {0});
+    if (result.num_reads == 0) return result;
+    if (bin_read_counts.size() > 1) {
+        result.depth_variation = maths::stdev(bin_read_counts) / maths::mean(bin_read_counts);
+    }
+    result.repeat_fraction = repeat_fraction;
+    result.predicted = predict_cost(result);
+    return result;
+}
+
+TaskCost head_task_cost(const TaskCost& cost, const double fraction)
+{
+    auto result = cost;
+    result.num_reads = std::llround(cost.num_reads * std::min(std::max(fraction, 0.0), 1.0));
+    result.predicted = predict_cost(result);
+    return result;
+}
+
+GenomicRegion::Size calculate_split_size(const GenomicRegion::Size window_size, const TaskCost& cost,
+                                         const double max_cost, const GenomicRegion::Size min_size)
+{
+    if (cost.predicted <= max_cost || window_size <= min_size) return window_size;
+    const auto split_size = static_cast<GenomicRegion::Size>(window_size * max_cost / cost.predicted);
+    return std::min(std::max(split_size, min_size), window_size);
+}
+
+} // namespace octopus
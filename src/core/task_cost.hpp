@@ -0,0 +1,43 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef task_cost_hpp
+#define task_cost_hpp
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <iosfwd>
+
+#include "basics/genomic_region.hpp"
+
+namespace octopus {
+
+// Cheap signals used to predict how long a task will take to call, in units of reads
+struct TaskCost
+{
+    std::size_t num_reads = 0;
+    double depth_variation = 0, repeat_fraction = 0, predicted = 0;
+};
+
+std::ostream& operator<<(std::ostream& os, const TaskCost& cost);
+
+// Fraction of bases in short period (<= 6bp) tandem repeats of at least 12bp. This is a single
+// linear scan, rather than the suffix array based repeat finder, so it is cheap enough to run on
+// every window.
+double calculate_tandem_repeat_fraction(const std::string& sequence);
+
+// Read counts are for equal size bins spanning the window. A single bin gives no depth variation.
+TaskCost make_task_cost(const std::vector<std::size_t>& bin_read_counts, double repeat_fraction);
+
+// Cost of the leading fraction of a window, assuming its reads are spread evenly
+TaskCost head_task_cost(const TaskCost& cost, double fraction);
+
+// Size of the leading part of a window of window_size that is predicted to cost at most max_cost, but no
+// smaller than min_size. Returns window_size if the window does not need to be split.
+GenomicRegion::Size calculate_split_size(GenomicRegion::Size window_size, const TaskCost& cost,
+                                         double max_cost, GenomicRegion::Size min_size);
+
+} // namespace octopus
+
+#endif
@@ -560,8 +560,8 @@ BAMRealigner::Report
 realign(io::ReadReader::Path src, VcfReader::Path variants, io::ReadWriter::Path dst,
         const ReferenceGenome& reference, BAMRealigner::Config config)
 {
-    io::ReadWriter dst_bam {std::move(dst), src};
-    io::ReadReader src_bam {std::move(src)};
+    io::ReadWriter dst_bam {std::move(dst), src, config.htslib_thread_pool};
+    io::ReadReader src_bam {std::move(src), config.htslib_thread_pool};
     VcfReader vcf {std::move(variants)};
     BAMRealigner realigner {std::move(config)};
     return realigner.realign(src_bam, vcf, dst_bam, reference);
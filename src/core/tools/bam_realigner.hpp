@@ -40,6 +40,7 @@ public:
         ReadLinkageType read_linkage = ReadLinkageType::paired;
         MemoryFootprint max_buffer = *parse_footprint("50M");
         boost::optional<unsigned> max_threads = 1;
+        HtslibThreadPool* htslib_thread_pool = nullptr;
     };
     
     struct Report
@@ -22,7 +22,13 @@ namespace octopus {
 
 namespace {
 
-using HaplotypeLikelihoods = std::vector<std::vector<double>>;
+// Row-major haplotype x read matrix
+struct HaplotypeLikelihoods
+{
+    std::size_t num_reads;
+    std::vector<double> values;
+    double operator()(std::size_t haplotype, std::size_t read) const noexcept { return values[haplotype * num_reads + read]; }
+};
 
 auto vectorise(const std::vector<Haplotype>& haplotypes, const HaplotypeProbabilityMap& priors)
 {
@@ -48,7 +54,7 @@ void find_map_haplotypes(const std::vector<Haplotype>& haplotypes, const unsigne
     assert(result.empty());
     auto max_likelihood = std::numeric_limits<double>::lowest();
     for (unsigned k {0}; k < haplotypes.size(); ++k) {
-        const auto curr = likelihoods[k][read] + log_priors[k];
+        const auto curr = likelihoods(k, read) + log_priors[k];
         if (maths::almost_equal(curr, max_likelihood)) {
             result.push_back(k);
         } else if (curr > max_likelihood) {
@@ -219,7 +225,6 @@ map_query_to_target_helper(const std::vector<KmerPerfectHashes>& queries, const
     result.reserve(queries.size());
     for (const auto& query : queries) {
         result.push_back(map_query_to_target(query, target, mapping_counts));
-        reset_mapping_counts(mapping_counts);
     }
     return result;
 }
@@ -233,23 +238,20 @@ auto calculate_likelihoods(const std::vector<Haplotype>& haplotypes, const Conta
     const auto read_hashes = compute_read_hashes(reads);
     static constexpr unsigned char mapperKmerSize {6};
     auto haplotype_hashes = init_kmer_hash_table<mapperKmerSize>();
-    HaplotypeLikelihoods result {};
-    result.reserve(haplotypes.size());
+    MappedIndexCounts haplotype_mapping_counts {};
+    HaplotypeLikelihoods result {reads.size(), std::vector<double>(haplotypes.size() * reads.size())};
+    auto result_itr = std::begin(result.values);
     const auto indel_factor = estimate_max_indel_size(haplotypes) + estimate_max_indel_size(reads);
     for (const auto& haplotype : haplotypes) {
         const auto expanded_haplotype = expand_for_alignment(haplotype, reads_region, indel_factor, model);
         populate_kmer_hash_table<mapperKmerSize>(expanded_haplotype.sequence(), haplotype_hashes);
-        auto haplotype_mapping_counts = init_mapping_counts(haplotype_hashes);
+        haplotype_mapping_counts.resize(haplotype_hashes.num_indices); // mapping leaves counts zeroed
         model.reset(expanded_haplotype);
-        std::vector<double> likelihoods(reads.size());
-        std::transform(std::cbegin(reads), std::cend(reads), std::cbegin(read_hashes), std::begin(likelihoods),
-                       [&] (const auto& read, const auto& read_hash) {
-                           auto mapping_positions = map_query_to_target_helper(read_hash, haplotype_hashes, haplotype_mapping_counts);
-                           reset_mapping_counts(haplotype_mapping_counts);
-                           return model.evaluate(read, mapping_positions);
-                       });
-        clear_kmer_hash_table(haplotype_hashes);
-        result.push_back(std::move(likelihoods));
+        result_itr = std::transform(std::cbegin(reads), std::cend(reads), std::cbegin(read_hashes), result_itr,
+                                    [&] (const auto& read, const auto& read_hash) {
+                                        auto mapping_positions = map_query_to_target_helper(read_hash, haplotype_hashes, haplotype_mapping_counts);
+                                        return model.evaluate(read, mapping_positions);
+                                    });
     }
     return result;
 }
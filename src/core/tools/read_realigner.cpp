@@ -116,7 +116,6 @@ void realign(std::vector<AlignedRead>& reads, const Haplotype& haplotype,
         model.reset(haplotype);
         for (std::size_t i {0}; i < reads.size(); ++i) {
             auto mapping_positions = map_query_to_target(read_hashes[i], haplotype_hashes, haplotype_mapping_counts);
-            reset_mapping_counts(haplotype_mapping_counts);
             auto alignment = model.align(reads[i], mapping_positions);
             log_likelihoods[i] = alignment.likelihood;
             realign(reads[i], haplotype, std::move(alignment));
@@ -135,7 +134,6 @@ void realign(std::vector<AlignedRead>& reads, const Haplotype& haplotype, Haplot
         model.reset(haplotype);
         for (std::size_t i {0}; i < reads.size(); ++i) {
             auto mapping_positions = map_query_to_target(read_hashes[i], haplotype_hashes, haplotype_mapping_counts);
-            reset_mapping_counts(haplotype_mapping_counts);
             realign(reads[i], haplotype, model.align(reads[i], mapping_positions));
         }
     }
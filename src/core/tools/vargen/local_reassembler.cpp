@@ -7,8 +7,6 @@
 #include <iterator>
 #include <deque>
 #include <stdexcept>
-#include <thread>
-#include <future>
 #include <cassert>
 
 #include "tandem/tandem.hpp"
@@ -23,6 +21,7 @@
 #include "utils/global_aligner.hpp"
 #include "utils/read_stats.hpp"
 #include "utils/free_memory.hpp"
+#include "utils/parallel_transform.hpp"
 #include "io/reference/reference_genome.hpp"
 #include "logging/logging.hpp"
 
@@ -360,28 +359,23 @@ std::vector<Variant> LocalReassembler::do_generate(const RegionSet& regions) con
             bin.clear();
         }
     } else {
-        const std::size_t num_threads {4};
-        std::vector<std::future<std::deque<Variant>>> bin_futures(std::min(bins.size(), num_threads));
-        for (auto first_bin = std::begin(bins), last_bin = std::end(bins); first_bin != last_bin; ) {
-            const auto batch_size = std::min(num_threads, static_cast<std::size_t>(std::distance(first_bin, last_bin)));
-            const auto next_bin = std::next(first_bin, batch_size);
-            auto last_future = std::transform(first_bin, next_bin, std::begin(bin_futures), [&] (Bin& bin) {
-                if (debug_log_) {
-                    stream(*debug_log_) << "Assembling " << bin.size() << " reads in bin " << mapped_region(bin);
-                }
-                return std::async([&] () {
-                    std::deque<Variant> result {};
-                    const auto num_default_failures = try_assemble_with_defaults(bin, result);
-                    if (num_default_failures == default_kmer_sizes_.size()) {
-                        try_assemble_with_fallbacks(bin, result);
-                    }
-                    bin.clear();
-                    return result;
-                });
-            });
-            std::for_each(std::begin(bin_futures), last_future, [&] (auto& f) { utils::append(f.get(), candidates); });
-            first_bin = next_bin;
+        // Bins are assembled on the calling thread's pool, so this does not add threads
+        if (debug_log_) {
+            for (const auto& bin : bins) {
+                stream(*debug_log_) << "Assembling " << bin.size() << " reads in bin " << mapped_region(bin);
+            }
         }
+        std::vector<std::deque<Variant>> bin_candidates(bins.size());
+        parallel_transform(std::begin(bins), std::end(bins), std::begin(bin_candidates), [&] (Bin& bin) {
+            std::deque<Variant> result {};
+            const auto num_default_failures = try_assemble_with_defaults(bin, result);
+            if (num_default_failures == default_kmer_sizes_.size()) {
+                try_assemble_with_fallbacks(bin, result);
+            }
+            bin.clear();
+            return result;
+        });
+        for (auto& variants : bin_candidates) utils::append(std::move(variants), candidates);
     }
     remove_duplicates(candidates);
     remove_larger_than(candidates, max_variant_size_);
@@ -9,6 +9,7 @@
 #include <cmath>
 #include <numeric>
 #include <limits>
+#include <cstdint>
 #include <cassert>
 #include <iostream>
 
@@ -115,12 +116,12 @@ void Assembler::insert_read(const NucleotideSequence& sequence,
         auto base_quality_itr = std::next(std::cbegin(base_qualities), kmer_size());
         Kmer prev_kmer {kmer_begin, kmer_end};
         bool prev_kmer_good {true};
-        auto vertex_itr = vertex_cache_.find(prev_kmer);
+        const auto prev_vertex = vertex_cache_.find(prev_kmer);
         auto ref_kmer_itr = std::cbegin(reference_kmers_);
-        if (vertex_itr == std::cend(vertex_cache_)) {
+        if (!prev_vertex) {
             const auto u = add_vertex(prev_kmer);
             if (!u) prev_kmer_good = false;
-        } else if (is_reference(vertex_itr->second)) {
+        } else if (is_reference(*prev_vertex)) {
             ref_kmer_itr = std::find(std::cbegin(reference_kmers_), std::cend(reference_kmers_), prev_kmer);
             assert(ref_kmer_itr != std::cend(reference_kmers_));
             auto next_kmer_begin = std::next(kmer_begin);
@@ -149,13 +150,14 @@ void Assembler::insert_read(const NucleotideSequence& sequence,
         ++kmer_begin;
         ++kmer_end;
         for (; kmer_end <= std::cend(sequence); ++kmer_begin, ++kmer_end, ++base_quality_itr) {
-            Kmer kmer {kmer_begin, kmer_end};
-            const auto kmer_itr = vertex_cache_.find(kmer);
-            if (kmer_itr == std::cend(vertex_cache_)) {
+            auto kmer = prev_kmer.next();
+            assert(kmer.begin() == kmer_begin && kmer.end() == kmer_end);
+            const auto kmer_vertex = vertex_cache_.find(kmer);
+            if (!kmer_vertex) {
                 const auto v = add_vertex(kmer);
                 if (v) {
                     if (prev_kmer_good) {
-                        assert(vertex_cache_.count(prev_kmer) == 1);
+                        assert(vertex_cache_.contains(prev_kmer));
                         const auto u = vertex_cache_.at(prev_kmer);
                         add_edge(u, *v, 1, is_forward_strand, *base_quality_itr);
                     }
@@ -166,7 +168,7 @@ void Assembler::insert_read(const NucleotideSequence& sequence,
             } else {
                 if (prev_kmer_good) {
                     const auto u = vertex_cache_.at(prev_kmer);
-                    const auto v = kmer_itr->second;
+                    const auto v = *kmer_vertex;
                     Edge e; bool e_in_graph;
                     std::tie(e, e_in_graph) = boost::edge(u, v, graph_);
                     if (e_in_graph) {
@@ -175,7 +177,7 @@ void Assembler::insert_read(const NucleotideSequence& sequence,
                         add_edge(u, v, 1, is_forward_strand, *base_quality_itr);
                     }
                 }
-                if (is_reference(kmer_itr->second)) {
+                if (is_reference(*kmer_vertex)) {
                     ref_kmer_itr = std::find(ref_kmer_itr, std::cend(reference_kmers_), kmer);
                     if (ref_kmer_itr != std::cend(reference_kmers_)) {
                         auto next_kmer_begin = std::next(kmer_begin);
@@ -374,11 +376,59 @@ void Assembler::write_dot(std::ostream& out) const
 }
 
 // Kmer
+
+namespace {
+
+std::size_t pack(const char base) noexcept
+{
+    switch (base) {
+        case 'A': return 0;
+        case 'C': return 1;
+        case 'G': return 2;
+        case 'T': return 3;
+        default: return 4;
+    }
+}
+
+} // namespace
+
 Assembler::Kmer::Kmer(SequenceIterator first, SequenceIterator last) noexcept
 : first_ {first}
 , last_ {last}
-, hash_ {boost::hash_range(first_, last_)}
-{}
+, hash_ {0}
+, is_packed_ {static_cast<std::size_t>(std::distance(first, last)) <= maxPackedSize}
+{
+    if (is_packed_) {
+        unsigned shift {0};
+        for (auto itr = first_; itr != last_; ++itr, shift += 2) {
+            const auto code = pack(*itr);
+            if (code > 3) {
+                is_packed_ = false;
+                break;
+            }
+            hash_ |= code << shift;
+        }
+    }
+    if (!is_packed_) {
+        hash_ = boost::hash_range(first_, last_);
+    }
+}
+
+Assembler::Kmer Assembler::Kmer::next() const noexcept
+{
+    if (is_packed_) {
+        const auto code = pack(*last_);
+        if (code < 4) {
+            Kmer result {*this};
+            ++result.first_;
+            ++result.last_;
+            const auto last_shift = 2 * (std::distance(first_, last_) - 1);
+            result.hash_ = (hash_ >> 2) | (code << last_shift);
+            return result;
+        }
+    }
+    return Kmer {std::next(first_), std::next(last_)};
+}
 
 char Assembler::Kmer::front() const noexcept
 {
@@ -412,13 +462,123 @@ std::size_t Assembler::Kmer::hash() const noexcept
 
 bool operator==(const Assembler::Kmer& lhs, const Assembler::Kmer& rhs) noexcept
 {
-    return std::equal(lhs.first_, lhs.last_, rhs.first_);
+    if (lhs.is_packed_ && rhs.is_packed_) return lhs.hash_ == rhs.hash_;
+    return lhs.hash_ == rhs.hash_ && std::equal(lhs.first_, lhs.last_, rhs.first_);
 }
 
 bool operator<(const Assembler::Kmer& lhs, const Assembler::Kmer& rhs) noexcept
 {
     return std::lexicographical_compare(lhs.first_, lhs.last_, rhs.first_, rhs.last_);
 }
+
+// KmerVertexMap
+
+bool Assembler::KmerVertexMap::contains(const Kmer& kmer) const noexcept
+{
+    return find_slot(kmer) < slots_.size();
+}
+
+boost::optional<Assembler::Vertex> Assembler::KmerVertexMap::find(const Kmer& kmer) const noexcept
+{
+    const auto slot = find_slot(kmer);
+    if (slot < slots_.size()) return slots_[slot].vertex;
+    return boost::none;
+}
+
+Assembler::Vertex Assembler::KmerVertexMap::at(const Kmer& kmer) const
+{
+    const auto slot = find_slot(kmer);
+    if (slot == slots_.size()) throw std::out_of_range {"KmerVertexMap: kmer not found"};
+    return slots_[slot].vertex;
+}
+
+void Assembler::KmerVertexMap::insert(const Kmer& kmer, const Vertex v)
+{
+    assert(!contains(kmer));
+    if (4 * (size_ + 1) > 3 * slots_.size()) {
+        rehash(std::max(2 * slots_.size(), std::size_t {16}));
+    }
+    auto slot = home(kmer.hash());
+    const auto mask = slots_.size() - 1;
+    while (slots_[slot].kmer) slot = (slot + 1) & mask;
+    slots_[slot] = {kmer.hash(), std::addressof(kmer), v};
+    ++size_;
+}
+
+bool Assembler::KmerVertexMap::erase(const Kmer& kmer) noexcept
+{
+    auto hole = find_slot(kmer);
+    if (hole == slots_.size()) return false;
+    // Backward shift deletion, so lookups never need tombstones
+    const auto mask = slots_.size() - 1;
+    for (auto slot = (hole + 1) & mask; slots_[slot].kmer; slot = (slot + 1) & mask) {
+        const auto slot_home = home(slots_[slot].hash);
+        if (((slot - slot_home) & mask) >= ((slot - hole) & mask)) {
+            slots_[hole] = slots_[slot];
+            hole = slot;
+        }
+    }
+    slots_[hole].kmer = nullptr;
+    --size_;
+    return true;
+}
+
+std::size_t Assembler::KmerVertexMap::size() const noexcept
+{
+    return size_;
+}
+
+bool Assembler::KmerVertexMap::empty() const noexcept
+{
+    return size_ == 0;
+}
+
+void Assembler::KmerVertexMap::reserve(const std::size_t n)
+{
+    std::size_t capacity {16};
+    while (3 * capacity < 4 * n) capacity *= 2;
+    if (capacity > slots_.size()) rehash(capacity);
+}
+
+void Assembler::KmerVertexMap::clear() noexcept
+{
+    slots_.clear();
+    size_ = 0;
+    shift_ = 0;
+}
+
+std::size_t Assembler::KmerVertexMap::home(const std::size_t hash) const noexcept
+{
+    // Fibonacci hashing spreads the low entropy high bits of short packed kmers
+    return static_cast<std::size_t>((static_cast<std::uint64_t>(hash) * 11400714819323198485ull) >> shift_);
+}
+
+std::size_t Assembler::KmerVertexMap::find_slot(const Kmer& kmer) const noexcept
+{
+    if (slots_.empty()) return 0;
+    const auto mask = slots_.size() - 1;
+    for (auto slot = home(kmer.hash()); slots_[slot].kmer; slot = (slot + 1) & mask) {
+        if (slots_[slot].hash == kmer.hash() && *slots_[slot].kmer == kmer) return slot;
+    }
+    return slots_.size();
+}
+
+void Assembler::KmerVertexMap::rehash(const std::size_t capacity)
+{
+    assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+    std::vector<Slot> old_slots(capacity, Slot {0, nullptr, Vertex {}});
+    old_slots.swap(slots_);
+    shift_ = 64;
+    for (auto c = capacity; c > 1; c >>= 1) --shift_;
+    const auto mask = capacity - 1;
+    for (const auto& old_slot : old_slots) {
+        if (old_slot.kmer) {
+            auto slot = home(old_slot.hash);
+            while (slots_[slot].kmer) slot = (slot + 1) & mask;
+            slots_[slot] = old_slot;
+        }
+    }
+}
 //
 // Assembler private methods
 //
@@ -515,7 +675,6 @@ void Assembler::insert_reference_into_populated_graph(const NucleotideSequence&
             reference_edges_.push_back(e);
         }
     }
-    vertex_cache_.rehash(vertex_cache_.size());
     reference_kmers_.shrink_to_fit();
     reference_vertices_.shrink_to_fit();
     reference_edges_.shrink_to_fit();
@@ -525,12 +684,12 @@ void Assembler::insert_reference_into_populated_graph(const NucleotideSequence&
 
 bool Assembler::contains_kmer(const Kmer& kmer) const noexcept
 {
-    return vertex_cache_.count(kmer) == 1;
+    return vertex_cache_.contains(kmer);
 }
 
 std::size_t Assembler::count_kmer(const Kmer& kmer) const noexcept
 {
-    return vertex_cache_.count(kmer);
+    return vertex_cache_.contains(kmer) ? 1 : 0;
 }
 
 std::size_t Assembler::reference_size() const noexcept
@@ -576,7 +735,7 @@ boost::optional<Assembler::Vertex> Assembler::add_vertex(const Kmer& kmer, const
 {
     if (!utils::is_canonical_dna(kmer)) return boost::none;
     const auto u = boost::add_vertex({boost::num_vertices(graph_), kmer, is_reference}, graph_);
-    vertex_cache_.emplace(kmer, u);
+    vertex_cache_.insert(kmer_of(u), u);
     return u;
 }
 
@@ -751,9 +910,9 @@ boost::optional<Assembler::Vertex> Assembler::find_joining_kmer(const Vertex v)
     for (const auto base : bases) {
         adjacent_kmer.back() = base;
         const Kmer k {std::cbegin(adjacent_kmer), std::cend(adjacent_kmer)};
-        const auto itr = vertex_cache_.find(k);
-        if (itr != std::cend(vertex_cache_)) {
-            return itr->second;
+        const auto joining_vertex = vertex_cache_.find(k);
+        if (joining_vertex) {
+            return joining_vertex;
         }
     }
     return boost::none;
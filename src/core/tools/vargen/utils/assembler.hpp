@@ -99,12 +99,16 @@ public:
     void write_dot(std::ostream& out) const;
     
 private:
+    // Kmers of canonical DNA that fit in a word are packed two bits per base into the hash, so
+    // they can be compared without touching the sequence.
     class Kmer : public Comparable<Kmer>
     {
     public:
         using NucleotideSequence = Assembler::NucleotideSequence;
         using SequenceIterator   = NucleotideSequence::const_iterator;
         
+        static constexpr std::size_t maxPackedSize {4 * sizeof(std::size_t)};
+        
         Kmer() = delete;
         Kmer(SequenceIterator first, SequenceIterator last) noexcept;
         
@@ -125,21 +129,20 @@ private:
         
         std::size_t hash() const noexcept;
         
+        // The kmer one base along, which must be in the sequence. O(1) for packed kmers.
+        Kmer next() const noexcept;
+        
         friend bool operator==(const Kmer& lhs, const Kmer& rhs) noexcept;
         friend bool operator<(const Kmer& lhs, const Kmer& rhs) noexcept;
     private:
         SequenceIterator first_, last_;
         std::size_t hash_;
+        bool is_packed_;
     };
     
     friend bool operator==(const Kmer& lhs, const Kmer& rhs) noexcept;
     friend bool operator<(const Kmer& lhs, const Kmer& rhs) noexcept;
     
-    struct KmerHash
-    {
-        std::size_t operator()(const Kmer& k) const noexcept { return k.hash(); }
-    };
-    
     struct GraphEdge
     {
         using WeightType = unsigned;
@@ -166,6 +169,50 @@ private:
     
     using DominatorMap = std::unordered_map<Vertex, Vertex>;
     
+    // Open addressing (linear probing) map from kmers to their vertices. Keys point to the kmers
+    // stored in the graph, so a vertex must be erased from the map before it is removed from the graph.
+    class KmerVertexMap
+    {
+    public:
+        KmerVertexMap() = default;
+        
+        KmerVertexMap(const KmerVertexMap&)            = delete;
+        KmerVertexMap& operator=(const KmerVertexMap&) = delete;
+        KmerVertexMap(KmerVertexMap&&)                 = default;
+        KmerVertexMap& operator=(KmerVertexMap&&)      = default;
+        
+        ~KmerVertexMap() = default;
+        
+        bool contains(const Kmer& kmer) const noexcept;
+        boost::optional<Vertex> find(const Kmer& kmer) const noexcept;
+        Vertex at(const Kmer& kmer) const;
+        
+        // kmer must be the one stored in the graph for v
+        void insert(const Kmer& kmer, Vertex v);
+        bool erase(const Kmer& kmer) noexcept;
+        
+        std::size_t size() const noexcept;
+        bool empty() const noexcept;
+        void reserve(std::size_t n);
+        void clear() noexcept;
+    
+    private:
+        struct Slot
+        {
+            std::size_t hash;
+            const Kmer* kmer;
+            Vertex vertex;
+        };
+        
+        std::vector<Slot> slots_ = {};
+        std::size_t size_ = 0;
+        unsigned shift_ = 0;
+        
+        std::size_t home(std::size_t hash) const noexcept;
+        std::size_t find_slot(const Kmer& kmer) const noexcept;
+        void rehash(std::size_t capacity);
+    };
+    
     using Path = std::deque<Vertex>;
     using EdgePath = std::vector<Edge>;
     using PredecessorMap = std::unordered_map<Vertex, Vertex>;
@@ -192,7 +239,7 @@ private:
     
     KmerGraph graph_;
     
-    std::unordered_map<Kmer, Vertex, KmerHash> vertex_cache_;
+    KmerVertexMap vertex_cache_;
     Path reference_vertices_;
     std::deque<Edge> reference_edges_;
     
@@ -0,0 +1,43 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include "htslib_thread_pool.hpp"
+
+#include <stdexcept>
+
+#include "htslib/thread_pool.h"
+
+namespace octopus { namespace io {
+
+HtslibThreadPool::HtslibThreadPool(const unsigned num_threads)
+: pool_ {nullptr, 0}
+, size_ {num_threads}
+{
+    pool_.pool = hts_tpool_init(static_cast<int>(num_threads));
+    if (pool_.pool == nullptr) {
+        throw std::runtime_error {"HtslibThreadPool: could not create thread pool"};
+    }
+}
+
+HtslibThreadPool::~HtslibThreadPool() noexcept
+{
+    hts_tpool_destroy(pool_.pool);
+}
+
+unsigned HtslibThreadPool::size() const noexcept
+{
+    return size_;
+}
+
+bool HtslibThreadPool::attach(htsFile* file) noexcept
+{
+    return file != nullptr && hts_set_opt(file, HTS_OPT_THREAD_POOL, &pool_) == 0;
+}
+
+bool attach(htsFile* file, HtslibThreadPool* pool) noexcept
+{
+    return pool != nullptr && pool->attach(file);
+}
+
+} // namespace io
+} // namespace octopus
@@ -0,0 +1,49 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef htslib_thread_pool_hpp
+#define htslib_thread_pool_hpp
+
+#include "htslib/hts.h"
+
+namespace octopus { namespace io {
+
+/*
+ HtslibThreadPool owns a htslib thread pool which any number of htsFiles can share for BGZF
+ (de)compression and CRAM (de)coding. Files should be attached straight after they are opened,
+ and must be closed before the pool is destroyed.
+ */
+class HtslibThreadPool
+{
+public:
+    HtslibThreadPool() = delete;
+
+    explicit HtslibThreadPool(unsigned num_threads);
+
+    HtslibThreadPool(const HtslibThreadPool&)            = delete;
+    HtslibThreadPool& operator=(const HtslibThreadPool&) = delete;
+    HtslibThreadPool(HtslibThreadPool&&)                 = delete;
+    HtslibThreadPool& operator=(HtslibThreadPool&&)      = delete;
+
+    ~HtslibThreadPool() noexcept;
+
+    unsigned size() const noexcept;
+
+    // Files that are neither BGZF compressed nor CRAM are left untouched
+    bool attach(htsFile* file) noexcept;
+
+private:
+    htsThreadPool pool_;
+    unsigned size_;
+};
+
+// Does nothing if pool is nullptr
+bool attach(htsFile* file, HtslibThreadPool* pool) noexcept;
+
+} // namespace io
+
+using io::HtslibThreadPool;
+
+} // namespace octopus
+
+#endif
@@ -164,10 +164,12 @@ private:
 
 namespace {
 
-auto open_hts_file(const boost::filesystem::path& file)
+auto open_hts_file(const boost::filesystem::path& file, HtslibThreadPool* thread_pool)
 {
     hts_verbose = 0; // disable hts error reporting
-    return sam_open(file.c_str(), "r");
+    auto result = sam_open(file.c_str(), "r");
+    attach(result, thread_pool);
+    return result;
 }
 
 bool is_cram(const boost::filesystem::path& file)
@@ -177,9 +179,10 @@ bool is_cram(const boost::filesystem::path& file)
 
 } // namespace
 
-HtslibSamFacade::HtslibSamFacade(Path file_path)
+HtslibSamFacade::HtslibSamFacade(Path file_path, HtslibThreadPool* thread_pool)
 : file_path_ {std::move(file_path)}
-, hts_file_ {open_hts_file(file_path_), HtsFileDeleter {}}
+, thread_pool_ {thread_pool}
+, hts_file_ {open_hts_file(file_path_, thread_pool_), HtsFileDeleter {}}
 , hts_header_ {(hts_file_) ? sam_hdr_read(hts_file_.get()) : nullptr, HtsHeaderDeleter {}}
 , hts_index_ {(hts_file_) ? sam_index_load(hts_file_.get(), file_path_.c_str()) : nullptr, HtsIndexDeleter {}}
 , hts_targets_ {}
@@ -225,7 +228,7 @@ HtslibSamFacade::HtslibSamFacade(Path file_path)
     std::sort(std::begin(samples_), std::end(samples_));
 }
 
-auto open_hts_writable_file(const boost::filesystem::path& path)
+auto open_hts_writable_file(const boost::filesystem::path& path, HtslibThreadPool* thread_pool)
 {
     std::string mode {"[w]"};
     const auto extension = path.extension();
@@ -234,14 +237,17 @@ auto open_hts_writable_file(const boost::filesystem::path& path)
     } else if (extension == "cram") {
         mode += "c";
     }
-    return sam_open(path.c_str(), mode.c_str());
+    auto result = sam_open(path.c_str(), mode.c_str());
+    attach(result, thread_pool);
+    return result;
 }
 
-HtslibSamFacade::HtslibSamFacade(Path sam_out, Path sam_template)
+HtslibSamFacade::HtslibSamFacade(Path sam_out, Path sam_template, HtslibThreadPool* thread_pool)
 : HtslibSamFacade {std::move(sam_template)}
 {
     file_path_ = std::move(sam_out);
-    hts_file_.reset(open_hts_writable_file(file_path_));
+    thread_pool_ = thread_pool;
+    hts_file_.reset(open_hts_writable_file(file_path_, thread_pool_));
     if (!hts_file_) {
         throw UnwritableBAM {std::move(file_path_)};
     }
@@ -269,7 +275,7 @@ bool HtslibSamFacade::is_open() const noexcept
 
 void HtslibSamFacade::open()
 {
-    hts_file_.reset(sam_open(file_path_.string().c_str(), "r"));
+    hts_file_.reset(open_hts_file(file_path_, thread_pool_));
     if (hts_file_) {
         hts_header_.reset(sam_hdr_read(hts_file_.get()));
         hts_index_.reset(sam_index_load(hts_file_.get(), file_path_.c_str()));
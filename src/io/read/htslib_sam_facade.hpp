@@ -19,6 +19,7 @@
 #include "htslib/sam.h"
 
 #include "basics/aligned_read.hpp"
+#include "io/htslib_thread_pool.hpp"
 #include "read_reader_impl.hpp"
 
 namespace octopus {
@@ -47,8 +48,8 @@ public:
     
     HtslibSamFacade() = delete;
     
-    HtslibSamFacade(Path file_path);
-    HtslibSamFacade(Path sam_out, Path sam_template);
+    HtslibSamFacade(Path file_path, HtslibThreadPool* thread_pool = nullptr);
+    HtslibSamFacade(Path sam_out, Path sam_template, HtslibThreadPool* thread_pool = nullptr);
     
     HtslibSamFacade(const HtslibSamFacade&)            = delete;
     HtslibSamFacade& operator=(const HtslibSamFacade&) = delete;
@@ -177,6 +178,7 @@ private:
     };
     
     Path file_path_;
+    HtslibThreadPool* thread_pool_;
     
     std::unique_ptr<htsFile, HtsFileDeleter> hts_file_;
     std::unique_ptr<bam_hdr_t, HtsHeaderDeleter> hts_header_;
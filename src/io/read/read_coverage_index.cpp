@@ -0,0 +1,372 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include "read_coverage_index.hpp"
+
+#include <array>
+#include <algorithm>
+#include <iterator>
+#include <fstream>
+#include <limits>
+#include <cmath>
+#include <utility>
+
+#include <boost/filesystem/operations.hpp>
+
+#include "exceptions/missing_file_error.hpp"
+#include "exceptions/malformed_file_error.hpp"
+#include "exceptions/unwritable_file_error.hpp"
+#include "read_manager.hpp"
+
+namespace octopus { namespace io {
+
+namespace {
+
+constexpr std::array<char, 8> coverageIndexMagic {'O', 'C', 'T', 'O', 'C', 'O', 'V', '\0'};
+constexpr std::uint32_t coverageIndexVersion {2};
+
+class MissingReadCoverageIndex : public MissingFileError
+{
+    std::string do_where() const override
+    {
+        return "ReadCoverageIndex";
+    }
+public:
+    MissingReadCoverageIndex(ReadCoverageIndex::Path file) : MissingFileError {std::move(file), "read coverage index"} {}
+};
+
+class MalformedReadCoverageIndex : public MalformedFileError
+{
+    std::string do_where() const override
+    {
+        return "ReadCoverageIndex";
+    }
+public:
+    MalformedReadCoverageIndex(ReadCoverageIndex::Path file) : MalformedFileError {std::move(file), "read coverage index"} {}
+};
+
+class UnwritableReadCoverageIndex : public UnwritableFileError
+{
+    std::string do_where() const override
+    {
+        return "ReadCoverageIndex";
+    }
+public:
+    UnwritableReadCoverageIndex(ReadCoverageIndex::Path file) : UnwritableFileError {std::move(file), "read coverage index"} {}
+};
+
+} // namespace
+
+constexpr ReadCoverageIndex::BinSize ReadCoverageIndex::defaultBinSize;
+
+ReadCoverageIndex::ReadCoverageIndex(const BinSize bin_size)
+: bin_size_ {std::max(bin_size, BinSize {1})}
+, bins_ {}
+{}
+
+ReadCoverageIndex::BinSize ReadCoverageIndex::bin_size() const noexcept
+{
+    return bin_size_;
+}
+
+void ReadCoverageIndex::set_sources(const std::vector<Path>& read_paths)
+{
+    sources_ = make_sources(read_paths);
+}
+
+bool ReadCoverageIndex::is_current(const std::vector<Path>& read_paths) const
+{
+    if (read_paths.size() != sources_.size()) return false;
+    try {
+        return make_sources(read_paths) == sources_;
+    } catch (const boost::filesystem::filesystem_error&) {
+        return false;
+    }
+}
+
+void ReadCoverageIndex::add_contig(const SampleName& sample, const ContigName& contig, const GenomicRegion::Size contig_size)
+{
+    const auto num_bins = (contig_size + bin_size_ - 1) / bin_size_;
+    bins_[sample][contig] = ContigBins {contig_size, 0, std::vector<std::uint32_t>(std::max(num_bins, BinSize {1}), 0)};
+}
+
+void ReadCoverageIndex::add(const SampleName& sample, const ContigName& contig, const ContigRegion& read_region)
+{
+    auto& bins = bins_.at(sample).at(contig);
+    const auto bin = std::min(static_cast<std::size_t>(read_region.begin() / bin_size_), bins.read_starts.size() - 1);
+    if (bins.read_starts[bin] < std::numeric_limits<std::uint32_t>::max()) ++bins.read_starts[bin];
+    bins.max_read_length = std::max(bins.max_read_length, size(read_region));
+}
+
+bool ReadCoverageIndex::is_indexed(const std::vector<SampleName>& samples, const GenomicRegion& region) const noexcept
+{
+    return !samples.empty() && std::all_of(std::cbegin(samples), std::cend(samples), [&] (const auto& sample) {
+        const auto itr = bins_.find(sample);
+        return itr != std::cend(bins_) && itr->second.count(region.contig_name()) == 1;
+    });
+}
+
+namespace {
+
+// Reads starting this far before a region may overlap it
+auto lookback_region(const ContigRegion& region, const GenomicRegion::Size max_read_length) noexcept
+{
+    const auto begin = region.begin() > max_read_length ? region.begin() - max_read_length : 0;
+    return ContigRegion {begin, std::max(region.end(), region.begin() + 1)};
+}
+
+} // namespace
+
+bool ReadCoverageIndex::has_reads(const std::vector<SampleName>& samples, const GenomicRegion& region) const
+{
+    for (const auto bins : find_bins(samples, region.contig_name())) {
+        const auto query = lookback_region(region.contig_region(), bins->max_read_length);
+        const auto last_bin = std::min(static_cast<std::size_t>((query.end() - 1) / bin_size_), bins->read_starts.size() - 1);
+        for (auto bin = static_cast<std::size_t>(query.begin() / bin_size_); bin <= last_bin; ++bin) {
+            if (bins->read_starts[bin] > 0) return true;
+        }
+    }
+    return false;
+}
+
+std::size_t ReadCoverageIndex::count_reads(const std::vector<SampleName>& samples, const GenomicRegion& region) const
+{
+    double result {0};
+    for (const auto bins : find_bins(samples, region.contig_name())) {
+        result += count_read_starts({bins}, lookback_region(region.contig_region(), bins->max_read_length));
+    }
+    return static_cast<std::size_t>(std::ceil(result));
+}
+
+GenomicRegion ReadCoverageIndex::find_covered_subregion(const std::vector<SampleName>& samples, const GenomicRegion& region,
+                                                        const std::size_t max_reads) const
+{
+    if (samples.empty() || is_empty(region) || count_reads(samples, region) <= max_reads) return region;
+    const auto bins = find_bins(samples, region.contig_name());
+    // Count reads starting before the region that may overlap it, as count_reads does
+    double num_reads {0};
+    for (const auto contig_bins : bins) {
+        const auto lookback = lookback_region(region.contig_region(), contig_bins->max_read_length);
+        num_reads += count_read_starts({contig_bins}, ContigRegion {lookback.begin(), region.begin()});
+    }
+    if (num_reads >= max_reads) return head_region(region);
+    for (auto begin = region.begin(); begin < region.end();) {
+        const auto end = std::min((begin / bin_size_ + 1) * bin_size_, region.end());
+        const auto bin_reads = count_read_starts(bins, ContigRegion {begin, end});
+        if (num_reads + bin_reads > max_reads) {
+            // Assume read starts are uniform within the bin
+            const auto fraction = (max_reads - num_reads) / bin_reads;
+            const auto covered_end = begin + static_cast<GenomicRegion::Size>(fraction * (end - begin));
+            return GenomicRegion {region.contig_name(), region.begin(), covered_end};
+        }
+        num_reads += bin_reads;
+        begin = end;
+    }
+    return region;
+}
+
+namespace {
+
+template <typename T>
+void write_value(std::ofstream& file, const T value)
+{
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void write_string(std::ofstream& file, const std::string& str)
+{
+    write_value(file, static_cast<std::uint32_t>(str.size()));
+    file.write(str.data(), str.size());
+}
+
+template <typename Map>
+auto sorted_keys(const Map& map)
+{
+    std::vector<typename Map::key_type> result {};
+    result.reserve(map.size());
+    for (const auto& p : map) result.push_back(p.first);
+    std::sort(std::begin(result), std::end(result));
+    return result;
+}
+
+} // namespace
+
+/*
+    File layout (little endian):
+        header: char magic[8] = "OCTOCOV\0", uint32 version, uint64 bin_size, uint32 num_sources
+        source: uint32 path_length, char path[path_length], uint64 file_size, int64 last_write_time
+                uint32 num_samples
+        sample: uint32 name_length, char name[name_length], uint32 num_contigs
+        contig: uint32 name_length, char name[name_length], uint64 contig_size, uint64 max_read_length,
+                uint64 num_bins, uint32 read_starts[num_bins]
+ */
+void ReadCoverageIndex::write(const Path& path) const
+{
+    std::ofstream file {path.string(), std::ios::binary};
+    if (!file) throw UnwritableReadCoverageIndex {path};
+    file.write(coverageIndexMagic.data(), coverageIndexMagic.size());
+    write_value(file, coverageIndexVersion);
+    write_value(file, static_cast<std::uint64_t>(bin_size_));
+    write_value(file, static_cast<std::uint32_t>(sources_.size()));
+    for (const auto& source : sources_) {
+        write_string(file, source.path);
+        write_value(file, source.size);
+        write_value(file, source.last_write_time);
+    }
+    write_value(file, static_cast<std::uint32_t>(bins_.size()));
+    for (const auto& sample : sorted_keys(bins_)) {
+        const auto& contigs = bins_.at(sample);
+        write_string(file, sample);
+        write_value(file, static_cast<std::uint32_t>(contigs.size()));
+        for (const auto& contig : sorted_keys(contigs)) {
+            const auto& bins = contigs.at(contig);
+            write_string(file, contig);
+            write_value(file, static_cast<std::uint64_t>(bins.contig_size));
+            write_value(file, static_cast<std::uint64_t>(bins.max_read_length));
+            write_value(file, static_cast<std::uint64_t>(bins.read_starts.size()));
+            file.write(reinterpret_cast<const char*>(bins.read_starts.data()), bins.read_starts.size() * sizeof(std::uint32_t));
+        }
+    }
+    if (!file) throw UnwritableReadCoverageIndex {path};
+}
+
+// private methods
+
+bool operator==(const ReadCoverageIndex::SourceFile& lhs, const ReadCoverageIndex::SourceFile& rhs) noexcept
+{
+    return lhs.path == rhs.path && lhs.size == rhs.size && lhs.last_write_time == rhs.last_write_time;
+}
+
+std::vector<ReadCoverageIndex::SourceFile> ReadCoverageIndex::make_sources(const std::vector<Path>& read_paths)
+{
+    std::vector<SourceFile> result {};
+    result.reserve(read_paths.size());
+    for (const auto& path : read_paths) {
+        result.push_back({boost::filesystem::absolute(path).string(),
+                          static_cast<std::uint64_t>(boost::filesystem::file_size(path)),
+                          static_cast<std::int64_t>(boost::filesystem::last_write_time(path))});
+    }
+    std::sort(std::begin(result), std::end(result), [] (const auto& lhs, const auto& rhs) { return lhs.path < rhs.path; });
+    return result;
+}
+
+std::vector<const ReadCoverageIndex::ContigBins*>
+ReadCoverageIndex::find_bins(const std::vector<SampleName>& samples, const ContigName& contig) const
+{
+    std::vector<const ContigBins*> result {};
+    result.reserve(samples.size());
+    for (const auto& sample : samples) {
+        result.push_back(&bins_.at(sample).at(contig));
+    }
+    return result;
+}
+
+double ReadCoverageIndex::count_read_starts(const std::vector<const ContigBins*>& bins, const ContigRegion region) const noexcept
+{
+    double result {0};
+    if (is_empty(region)) return result;
+    const auto first_bin = static_cast<std::size_t>(region.begin() / bin_size_);
+    const auto last_bin = static_cast<std::size_t>((region.end() - 1) / bin_size_);
+    for (auto bin = first_bin; bin <= last_bin; ++bin) {
+        const auto bin_begin = bin * bin_size_, bin_end = bin_begin + bin_size_;
+        const auto overlap = std::min(bin_end, std::size_t {region.end()}) - std::max(bin_begin, std::size_t {region.begin()});
+        const auto fraction = static_cast<double>(overlap) / bin_size_;
+        for (const auto contig_bins : bins) {
+            if (bin < contig_bins->read_starts.size()) {
+                result += fraction * contig_bins->read_starts[bin];
+            }
+        }
+    }
+    return result;
+}
+
+// non-member methods
+
+ReadCoverageIndex make_read_coverage_index(const ReadManager& reads, const std::vector<GenomicRegion>& contigs,
+                                           const ReadCoverageIndex::BinSize bin_size)
+{
+    ReadCoverageIndex result {bin_size};
+    result.set_sources(reads.paths());
+    for (const auto& contig : contigs) {
+        for (const auto& sample : reads.samples()) {
+            result.add_contig(sample, contig.contig_name(), contig.end());
+        }
+        reads.iterate(contig, [&] (const ReadManager::SampleName& sample, ContigRegion read_region) {
+            result.add(sample, contig.contig_name(), read_region);
+            return true;
+        });
+    }
+    return result;
+}
+
+namespace {
+
+template <typename T>
+T read_value(std::ifstream& file, const ReadCoverageIndex::Path& path)
+{
+    T result;
+    if (!file.read(reinterpret_cast<char*>(&result), sizeof(T))) {
+        throw MalformedReadCoverageIndex {path};
+    }
+    return result;
+}
+
+std::string read_string(std::ifstream& file, const ReadCoverageIndex::Path& path)
+{
+    std::string result(read_value<std::uint32_t>(file, path), '\0');
+    if (!file.read(&result[0], result.size())) {
+        throw MalformedReadCoverageIndex {path};
+    }
+    return result;
+}
+
+} // namespace
+
+ReadCoverageIndex read_coverage_index(const ReadCoverageIndex::Path& path)
+{
+    if (!boost::filesystem::exists(path)) {
+        throw MissingReadCoverageIndex {path};
+    }
+    std::ifstream file {path.string(), std::ios::binary};
+    std::array<char, coverageIndexMagic.size()> magic {};
+    if (!file.read(magic.data(), magic.size()) || magic != coverageIndexMagic
+        || read_value<std::uint32_t>(file, path) != coverageIndexVersion) {
+        throw MalformedReadCoverageIndex {path};
+    }
+    const auto bin_size = read_value<std::uint64_t>(file, path);
+    if (bin_size == 0) throw MalformedReadCoverageIndex {path};
+    ReadCoverageIndex result {static_cast<ReadCoverageIndex::BinSize>(bin_size)};
+    const auto num_sources = read_value<std::uint32_t>(file, path);
+    result.sources_.reserve(num_sources);
+    for (std::uint32_t i {0}; i < num_sources; ++i) {
+        ReadCoverageIndex::SourceFile source {};
+        source.path = read_string(file, path);
+        source.size = read_value<std::uint64_t>(file, path);
+        source.last_write_time = read_value<std::int64_t>(file, path);
+        result.sources_.push_back(std::move(source));
+    }
+    const auto num_samples = read_value<std::uint32_t>(file, path);
+    for (std::uint32_t s {0}; s < num_samples; ++s) {
+        auto& contigs = result.bins_[read_string(file, path)];
+        const auto num_contigs = read_value<std::uint32_t>(file, path);
+        for (std::uint32_t c {0}; c < num_contigs; ++c) {
+            auto contig = read_string(file, path);
+            ReadCoverageIndex::ContigBins bins {};
+            bins.contig_size = static_cast<GenomicRegion::Size>(read_value<std::uint64_t>(file, path));
+            bins.max_read_length = static_cast<GenomicRegion::Size>(read_value<std::uint64_t>(file, path));
+            const auto num_bins = read_value<std::uint64_t>(file, path);
+            if (num_bins == 0 || num_bins != std::max((bins.contig_size + bin_size - 1) / bin_size, std::uint64_t {1})) {
+                throw MalformedReadCoverageIndex {path};
+            }
+            bins.read_starts.resize(num_bins);
+            if (!file.read(reinterpret_cast<char*>(bins.read_starts.data()), num_bins * sizeof(std::uint32_t))) {
+                throw MalformedReadCoverageIndex {path};
+            }
+            contigs.emplace(std::move(contig), std::move(bins));
+        }
+    }
+    return result;
+}
+
+} // namespace io
+} // namespace octopus
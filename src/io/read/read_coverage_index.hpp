@@ -0,0 +1,115 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef read_coverage_index_hpp
+#define read_coverage_index_hpp
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+#include <boost/filesystem/path.hpp>
+
+#include "basics/contig_region.hpp"
+#include "basics/genomic_region.hpp"
+
+namespace octopus { namespace io {
+
+class ReadManager;
+
+/*
+    ReadCoverageIndex counts read starts per sample in fixed size bins, so window sizing queries
+    (has_reads, count_reads, find_covered_subregion) can be answered without iterating alignments.
+    Answers are estimates at bin resolution: reads starting up to the longest indexed read before a
+    region are assumed to overlap it, so has_reads never misses reads but may report reads that
+    end before the region.
+
+    The index records the path, size, and modification time of each read file it was built from, so
+    it can be saved to a sidecar file and checked with is_current before being reused on later runs.
+ */
+class ReadCoverageIndex
+{
+public:
+    using Path       = boost::filesystem::path;
+    using SampleName = std::string;
+    using ContigName = GenomicRegion::ContigName;
+    using BinSize    = GenomicRegion::Size;
+
+    static constexpr BinSize defaultBinSize {1'000};
+
+    ReadCoverageIndex() = default;
+
+    ReadCoverageIndex(BinSize bin_size);
+
+    ReadCoverageIndex(const ReadCoverageIndex&)            = default;
+    ReadCoverageIndex& operator=(const ReadCoverageIndex&) = default;
+    ReadCoverageIndex(ReadCoverageIndex&&)                 = default;
+    ReadCoverageIndex& operator=(ReadCoverageIndex&&)      = default;
+
+    ~ReadCoverageIndex() = default;
+
+    BinSize bin_size() const noexcept;
+
+    // Records the read files the index is built from
+    void set_sources(const std::vector<Path>& read_paths);
+    // True if the index was built from exactly these read files, and none have changed since
+    bool is_current(const std::vector<Path>& read_paths) const;
+
+    // Allocates empty bins for a contig so reads on it can be added
+    void add_contig(const SampleName& sample, const ContigName& contig, GenomicRegion::Size contig_size);
+    void add(const SampleName& sample, const ContigName& contig, const ContigRegion& read_region);
+
+    // True if queries for these samples on the region's contig can be answered by the index
+    bool is_indexed(const std::vector<SampleName>& samples, const GenomicRegion& region) const noexcept;
+
+    bool has_reads(const std::vector<SampleName>& samples, const GenomicRegion& region) const;
+    std::size_t count_reads(const std::vector<SampleName>& samples, const GenomicRegion& region) const;
+    GenomicRegion find_covered_subregion(const std::vector<SampleName>& samples, const GenomicRegion& region,
+                                         std::size_t max_reads) const;
+
+    void write(const Path& path) const;
+
+private:
+    struct SourceFile
+    {
+        std::string path;
+        std::uint64_t size;
+        std::int64_t last_write_time;
+    };
+
+    struct ContigBins
+    {
+        GenomicRegion::Size contig_size;
+        GenomicRegion::Size max_read_length;
+        std::vector<std::uint32_t> read_starts;
+    };
+
+    using ContigBinsMap = std::unordered_map<ContigName, ContigBins>;
+
+    BinSize bin_size_ = defaultBinSize;
+    std::vector<SourceFile> sources_;
+    std::unordered_map<SampleName, ContigBinsMap> bins_;
+
+    friend ReadCoverageIndex read_coverage_index(const Path& path);
+
+    friend bool operator==(const SourceFile& lhs, const SourceFile& rhs) noexcept;
+
+    static std::vector<SourceFile> make_sources(const std::vector<Path>& read_paths);
+    std::vector<const ContigBins*> find_bins(const std::vector<SampleName>& samples, const ContigName& contig) const;
+    double count_read_starts(const std::vector<const ContigBins*>& bins, ContigRegion region) const noexcept;
+};
+
+// Makes an index with one pass over the reads in each region, which should span whole contigs. The index
+// sources are the read manager's files.
+ReadCoverageIndex make_read_coverage_index(const ReadManager& reads, const std::vector<GenomicRegion>& contigs,
+                                           ReadCoverageIndex::BinSize bin_size = ReadCoverageIndex::defaultBinSize);
+
+// Loads an index saved with ReadCoverageIndex::write
+ReadCoverageIndex read_coverage_index(const ReadCoverageIndex::Path& path);
+
+} // namespace io
+} // namespace octopus
+
+#endif
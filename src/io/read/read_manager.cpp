@@ -7,20 +7,24 @@
 #include <algorithm>
 #include <utility>
 #include <deque>
+#include <memory>
 #include <numeric>
+#include <future>
+#include <exception>
 #include <cassert>
 
 #include <boost/filesystem/operations.hpp>
 
 #include "basics/aligned_read.hpp"
-#include "utils/append.hpp"
 #include "utils/coverage_tracker.hpp"
 
 namespace octopus { namespace io {
 
-ReadManager::ReadManager(std::vector<Path> read_file_paths, unsigned max_open_files)
+ReadManager::ReadManager(std::vector<Path> read_file_paths, unsigned max_open_files,
+                         HtslibThreadPool* thread_pool)
 : max_open_files_ {max_open_files}
 , num_files_ {static_cast<unsigned>(read_file_paths.size())}
+, thread_pool_ {thread_pool}
 , all_readers_single_sample_ {true}
 , closed_readers_ {
     std::make_move_iterator(std::begin(read_file_paths)),
@@ -29,6 +33,7 @@ ReadManager::ReadManager(std::vector<Path> read_file_paths, unsigned max_open_fi
 , reader_paths_containing_sample_ {}
 , possible_regions_in_readers_ {}
 , samples_ {}
+, coverage_index_ {}
 {
     setup_reader_samples_and_regions();
     open_initial_files();
@@ -60,12 +65,15 @@ ReadManager::ReadManager(ReadManager&& other)
     using std::move;
     max_open_files_                 = move(other.max_open_files_);
     num_files_                      = move(other.num_files_);
+    thread_pool_                    = other.thread_pool_;
     all_readers_single_sample_      = move(other.all_readers_single_sample_);
     closed_readers_                 = move(other.closed_readers_);
     open_readers_                   = move(other.open_readers_);
     reader_paths_containing_sample_ = move(other.reader_paths_containing_sample_);
     possible_regions_in_readers_    = move(other.possible_regions_in_readers_);
     samples_                        = move(other.samples_);
+    coverage_index_                 = move(other.coverage_index_);
+    fetch_workers_                  = other.fetch_workers_;
 }
 
 ReadManager& ReadManager::operator=(ReadManager&& other)
@@ -76,12 +84,15 @@ ReadManager& ReadManager::operator=(ReadManager&& other)
         using std::move;
         max_open_files_                 = move(other.max_open_files_);
         num_files_                      = move(other.num_files_);
+        thread_pool_                    = other.thread_pool_;
         all_readers_single_sample_      = move(other.all_readers_single_sample_);
         closed_readers_                 = move(other.closed_readers_);
         open_readers_                   = move(other.open_readers_);
         reader_paths_containing_sample_ = move(other.reader_paths_containing_sample_);
         possible_regions_in_readers_    = move(other.possible_regions_in_readers_);
         samples_                        = move(other.samples_);
+        coverage_index_                 = move(other.coverage_index_);
+        fetch_workers_                  = other.fetch_workers_;
     }
     return *this;
 }
@@ -94,12 +105,15 @@ void swap(ReadManager& lhs, ReadManager& rhs) noexcept
     using std::swap;
     swap(lhs.max_open_files_,                 rhs.max_open_files_);
     swap(lhs.num_files_,                      rhs.num_files_);
+    swap(lhs.thread_pool_,                    rhs.thread_pool_);
     swap(lhs.all_readers_single_sample_,             rhs.all_readers_single_sample_);
     swap(lhs.closed_readers_,                 rhs.closed_readers_);
     swap(lhs.open_readers_,                   rhs.open_readers_);
     swap(lhs.reader_paths_containing_sample_, rhs.reader_paths_containing_sample_);
     swap(lhs.possible_regions_in_readers_,    rhs.possible_regions_in_readers_);
     swap(lhs.samples_,                        rhs.samples_);
+    swap(lhs.coverage_index_,                 rhs.coverage_index_);
+    swap(lhs.fetch_workers_,                  rhs.fetch_workers_);
 }
 
 void ReadManager::close() const noexcept
@@ -197,6 +211,21 @@ unsigned ReadManager::drop_samples(std::vector<SampleName> samples)
     return dropped_reader_paths.size();
 }
 
+void ReadManager::set_coverage_index(std::shared_ptr<const ReadCoverageIndex> index) noexcept
+{
+    coverage_index_ = std::move(index);
+}
+
+bool ReadManager::is_coverage_indexed(const std::vector<SampleName>& samples, const GenomicRegion& region) const noexcept
+{
+    return coverage_index_ && coverage_index_->is_indexed(samples, region);
+}
+
+void ReadManager::set_fetch_workers(ThreadPool* workers) noexcept
+{
+    fetch_workers_ = workers;
+}
+
 void ReadManager::iterate(const GenomicRegion& region,
                           AlignedReadReadVisitor visitor) const
 {
@@ -244,6 +273,9 @@ bool ReadManager::has_reads(const SampleName& sample, const GenomicRegion& regio
 
 bool ReadManager::has_reads(const std::vector<SampleName>& samples, const GenomicRegion& region) const
 {
+    if (coverage_index_ && coverage_index_->is_indexed(samples, region)) {
+        return coverage_index_->has_reads(samples, region);
+    }
     if (all_readers_are_open()) {
         return std::any_of(std::cbegin(open_readers_), std::cend(open_readers_),
                            [&] (const auto& p) { return p.second.has_reads(samples, region); });
@@ -267,6 +299,9 @@ bool ReadManager::has_reads(const std::vector<SampleName>& samples, const Genomi
 
 bool ReadManager::has_reads(const GenomicRegion& region) const
 {
+    if (coverage_index_ && coverage_index_->is_indexed(samples(), region)) {
+        return coverage_index_->has_reads(samples(), region);
+    }
     if (all_readers_are_open()) {
         return std::any_of(std::cbegin(open_readers_), std::cend(open_readers_),
                            [&] (const auto& p) { return p.second.has_reads(region); });
@@ -290,6 +325,9 @@ bool ReadManager::has_reads(const GenomicRegion& region) const
 
 std::size_t ReadManager::count_reads(const SampleName& sample, const GenomicRegion& region) const
 {
+    if (coverage_index_ && coverage_index_->is_indexed({sample}, region)) {
+        return coverage_index_->count_reads({sample}, region);
+    }
     if (all_readers_are_open()) {
         return std::accumulate(std::cbegin(open_readers_), std::cend(open_readers_), std::size_t {0},
                                [&] (std::size_t curr, const auto& p) {
@@ -314,6 +352,9 @@ std::size_t ReadManager::count_reads(const SampleName& sample, const GenomicRegi
 
 std::size_t ReadManager::count_reads(const std::vector<SampleName>& samples, const GenomicRegion& region) const
 {
+    if (coverage_index_ && coverage_index_->is_indexed(samples, region)) {
+        return coverage_index_->count_reads(samples, region);
+    }
     if (all_readers_are_open()) {
         return std::accumulate(std::cbegin(open_readers_), std::cend(open_readers_), std::size_t {0},
                                [&] (std::size_t curr, const auto& p) {
@@ -389,6 +430,9 @@ GenomicRegion ReadManager::find_covered_subregion(const std::vector<SampleName>&
                                                   const std::size_t max_reads) const
 {
     if (samples.empty() || is_empty(region)) return region;
+    if (coverage_index_ && coverage_index_->is_indexed(samples, region)) {
+        return coverage_index_->find_covered_subregion(samples, region, max_reads);
+    }
     CoverageTracker<ContigRegion> position_tracker {};
     if (all_readers_are_open()) {
         for (const auto& p : open_readers_) {
@@ -424,72 +468,150 @@ GenomicRegion ReadManager::find_covered_subregion(const GenomicRegion& region, c
 
 namespace {
 
-template <typename Container>
-void merge_insert(Container&& src, Container& dst)
+using ReadRun    = ReadManager::ReadContainer;
+using ReadRunMap = std::unordered_map<ReadManager::SampleName, std::vector<ReadRun>>;
+
+// Readers return reads in file coordinate order, which only orders reads by begin position. The
+// full AlignedRead ordering is restored by sorting each group of reads with the same begin.
+void sort_coordinate_sorted(ReadRun& reads)
 {
-    auto itr = octopus::utils::append(std::move(src), dst);
-    std::inplace_merge(std::begin(dst), itr, std::end(dst));
+    const auto begins_before = [] (const AlignedRead& lhs, const AlignedRead& rhs) {
+        return mapped_begin(lhs) < mapped_begin(rhs);
+    };
+    if (!std::is_sorted(std::cbegin(reads), std::cend(reads), begins_before)) {
+        std::sort(std::begin(reads), std::end(reads));
+        return;
+    }
+    for (auto first = std::begin(reads); first != std::end(reads);) {
+        const auto last = std::find_if(std::next(first), std::end(reads),
+                                       [first] (const AlignedRead& read) { return mapped_begin(read) != mapped_begin(*first); });
+        if (std::distance(first, last) > 1) std::sort(first, last);
+        first = last;
+    }
+}
+
+void sort_coordinate_sorted(ReadManager::SampleReadMap& reads)
+{
+    for (auto& p : reads) sort_coordinate_sorted(p.second);
+}
+
+void add_run(ReadRun&& reads, std::vector<ReadRun>& runs)
+{
+    if (!reads.empty()) runs.push_back(std::move(reads));
+}
+
+void add_runs(ReadManager::SampleReadMap&& reads, ReadRunMap& runs)
+{
+    for (auto& p : reads) add_run(std::move(p.second), runs[p.first]);
+}
+
+// k-way merge of sorted runs that moves each read once
+ReadRun merge(std::vector<ReadRun>& runs)
+{
+    if (runs.empty()) return {};
+    if (runs.size() == 1) return std::move(runs.front());
+    using RunItr  = ReadRun::iterator;
+    using RunHead = std::pair<RunItr, RunItr>;
+    std::vector<RunHead> heads {};
+    heads.reserve(runs.size());
+    std::size_t num_reads {0};
+    for (auto& run : runs) {
+        heads.emplace_back(std::begin(run), std::end(run));
+        num_reads += run.size();
+    }
+    const auto head_after = [] (const RunHead& lhs, const RunHead& rhs) { return *rhs.first < *lhs.first; };
+    std::make_heap(std::begin(heads), std::end(heads), head_after);
+    ReadRun result {};
+    result.reserve(num_reads);
+    while (!heads.empty()) {
+        std::pop_heap(std::begin(heads), std::end(heads), head_after);
+        auto& head = heads.back();
+        result.push_back(std::move(*head.first));
+        if (++head.first == head.second) {
+            heads.pop_back();
+        } else {
+            std::push_heap(std::begin(heads), std::end(heads), head_after);
+        }
+    }
+    runs.clear();
+    runs.shrink_to_fit();
+    return result;
 }
 
 } // namespace
 
 ReadManager::ReadContainer ReadManager::fetch_reads(const SampleName& sample, const GenomicRegion& region) const
 {
-    ReadContainer result {};
-    if (all_readers_are_open()) {
+    std::vector<ReadRun> runs {};
+    const auto fetch = [&] (const ReadReader& reader) {
+        auto result = reader.fetch_reads(sample, region);
+        sort_coordinate_sorted(result);
+        return result;
+    };
+    if (can_fetch_concurrently()) {
+        const auto readers = get_open_readers({sample}, region);
+        auto reads = fetch_concurrently(readers, fetch);
+        for (auto& reader_reads : reads) {
+            add_run(std::move(reader_reads), runs);
+        }
+    } else if (all_readers_are_open()) {
         for (const auto& p : open_readers_) {
-            merge_insert(p.second.fetch_reads(sample, region), result);
+            add_run(fetch(p.second), runs);
         }
     } else {
         std::lock_guard<std::mutex> lock {mutex_};
         auto reader_paths = get_possible_reader_paths({sample}, region);
         auto reader_itr = partition_open(reader_paths);
         while (!reader_paths.empty()) {
-            using std::begin; using std::end; using std::make_move_iterator; using std::for_each;
+            using std::begin; using std::end; using std::for_each;
             for_each(reader_itr, end(reader_paths), [&] (const auto& reader_path) {
-                merge_insert(open_readers_.at(reader_path).fetch_reads(sample, region), result);
+                add_run(fetch(open_readers_.at(reader_path)), runs);
             });
             reader_paths.erase(reader_itr, end(reader_paths));
             reader_itr = open_readers(begin(reader_paths), end(reader_paths));
         }
     }
-    return result;
+    return merge(runs);
 }
 
 ReadManager::SampleReadMap ReadManager::fetch_reads(const std::vector<SampleName>& samples, const GenomicRegion& region) const
 {
-    SampleReadMap result {samples.size()};
-    // Populate here so we can make unchecked access
+    ReadRunMap runs {samples.size()};
     for (const auto& sample : samples) {
-        result.emplace(std::piecewise_construct, std::forward_as_tuple(sample), std::forward_as_tuple());
+        runs.emplace(std::piecewise_construct, std::forward_as_tuple(sample), std::forward_as_tuple());
     }
-    if (all_readers_are_open()) {
+    const auto fetch = [&] (const ReadReader& reader) {
+        auto result = reader.fetch_reads(samples, region);
+        sort_coordinate_sorted(result);
+        return result;
+    };
+    if (can_fetch_concurrently()) {
+        const auto readers = get_open_readers(samples, region);
+        auto reads = fetch_concurrently(readers, fetch);
+        for (auto& reader_reads : reads) {
+            add_runs(std::move(reader_reads), runs);
+        }
+    } else if (all_readers_are_open()) {
         for (const auto& p : open_readers_) {
-            auto reads = p.second.fetch_reads(samples, region);
-            for (auto&& r : reads) {
-                merge_insert(std::move(r.second), result.at(r.first));
-                r.second.clear();
-                r.second.shrink_to_fit();
-            }
+            add_runs(fetch(p.second), runs);
         }
     } else {
         std::lock_guard<std::mutex> lock {mutex_};
         auto reader_paths = get_possible_reader_paths(samples, region);
         auto reader_itr = partition_open(reader_paths);
         while (!reader_paths.empty()) {
-            using std::begin; using std::end; using std::make_move_iterator; using std::for_each;
+            using std::begin; using std::end; using std::for_each;
             for_each(reader_itr, end(reader_paths), [&] (const auto& reader_path) {
-                auto reads = open_readers_.at(reader_path).fetch_reads(samples, region);
-                for (auto&& r : reads) {
-                    merge_insert(std::move(r.second), result.at(r.first));
-                    r.second.clear();
-                    r.second.shrink_to_fit();
-                }
+                add_runs(fetch(open_readers_.at(reader_path)), runs);
             });
             reader_paths.erase(reader_itr, end(reader_paths));
             reader_itr = open_readers(begin(reader_paths), end(reader_paths));
         }
     }
+    SampleReadMap result {samples.size()};
+    for (auto& p : runs) {
+        result.emplace(p.first, merge(p.second));
+    }
     return result;
 }
 
@@ -551,7 +673,7 @@ void ReadManager::open_initial_files()
 
 ReadReader ReadManager::make_reader(const Path& reader_path) const
 {
-    return ReadReader {reader_path};
+    return ReadReader {reader_path, thread_pool_};
 }
 
 bool ReadManager::all_readers_are_open() const noexcept
@@ -560,6 +682,59 @@ bool ReadManager::all_readers_are_open() const noexcept
     return num_files_ <= max_open_files_;
 }
 
+bool ReadManager::can_fetch_concurrently() const noexcept
+{
+    // Readers are only opened and closed under the lock when they don't all fit, so only fetch concurrently
+    // when they do. A task waiting on its fetches may run other work, which must not block on the lock.
+    return fetch_workers_ && !fetch_workers_->empty() && all_readers_are_open() && open_readers_.size() > 1;
+}
+
+std::vector<const ReadReader*>
+ReadManager::get_open_readers(const std::vector<SampleName>& samples, const GenomicRegion& region) const
+{
+    // In open_readers_ order, so reads are merged in the same order as the serial fetch
+    const auto reader_paths = get_possible_reader_paths(samples, region);
+    std::vector<const ReadReader*> result {};
+    result.reserve(reader_paths.size());
+    for (const auto& p : open_readers_) {
+        if (std::find(std::cbegin(reader_paths), std::cend(reader_paths), p.first) != std::cend(reader_paths)) {
+            result.push_back(std::addressof(p.second));
+        }
+    }
+    return result;
+}
+
+template <typename Fetcher>
+std::vector<std::result_of_t<Fetcher(const ReadReader&)>>
+ReadManager::fetch_concurrently(const std::vector<const ReadReader*>& readers, Fetcher fetcher) const
+{
+    using FetchResult = std::result_of_t<Fetcher(const ReadReader&)>;
+    std::vector<FetchResult> result(readers.size());
+    if (readers.empty()) return result;
+    std::vector<std::future<FetchResult>> fetches {};
+    fetches.reserve(readers.size() - 1);
+    for (auto itr = std::next(std::cbegin(readers)); itr != std::cend(readers); ++itr) {
+        const ReadReader& reader {**itr};
+        fetches.push_back(fetch_workers_->push([&fetcher, &reader] () { return fetcher(reader); }));
+    }
+    std::exception_ptr error {};
+    try {
+        result.front() = fetcher(*readers.front());
+    } catch (...) {
+        error = std::current_exception();
+    }
+    // Every task references fetcher, so all must finish before returning, even on error
+    for (std::size_t i {0}; i < fetches.size(); ++i) {
+        try {
+            result[i + 1] = fetch_workers_->wait(fetches[i]);
+        } catch (...) {
+            if (!error) error = std::current_exception();
+        }
+    }
+    if (error) std::rethrow_exception(error);
+    return result;
+}
+
 bool ReadManager::is_open(const Path& reader_path) const noexcept
 {
     return open_readers_.count(reader_path) == 1;
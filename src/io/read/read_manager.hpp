@@ -10,7 +10,9 @@
 #include <unordered_set>
 #include <initializer_list>
 #include <cstddef>
+#include <memory>
 #include <mutex>
+#include <type_traits>
 
 #include <boost/filesystem.hpp>
 
@@ -18,8 +20,11 @@
 #include "basics/genomic_region.hpp"
 #include "containers/mappable_map.hpp"
 #include "utils/hash_functions.hpp"
+#include "utils/thread_pool.hpp"
+#include "io/htslib_thread_pool.hpp"
 #include "read_reader.hpp"
 #include "read_reader_impl.hpp"
+#include "read_coverage_index.hpp"
 
 namespace octopus {
 
@@ -40,7 +45,8 @@ public:
     
     ReadManager() = default;
     
-    ReadManager(std::vector<Path> read_file_paths, unsigned max_open_files);
+    ReadManager(std::vector<Path> read_file_paths, unsigned max_open_files,
+                HtslibThreadPool* thread_pool = nullptr);
     ReadManager(std::initializer_list<Path> read_file_paths);
     
     ReadManager(const ReadManager&)            = delete;
@@ -61,6 +67,14 @@ public:
     const std::vector<SampleName>& samples() const;
     unsigned drop_samples(std::vector<SampleName> samples);
     
+    // has_reads, count_reads, and find_covered_subregion are answered by the index where possible
+    void set_coverage_index(std::shared_ptr<const ReadCoverageIndex> index) noexcept;
+    // True if count_reads for these samples and region will be answered by the index
+    bool is_coverage_indexed(const std::vector<SampleName>& samples, const GenomicRegion& region) const noexcept;
+    
+    // When all files are open, fetch_reads reads each file in a separate task of workers
+    void set_fetch_workers(ThreadPool* workers) noexcept;
+    
     void iterate(const GenomicRegion& region,
                  AlignedReadReadVisitor visitor) const;
     void iterate(const SampleName& sample,
@@ -113,6 +127,7 @@ private:
     
     unsigned max_open_files_ = 200;
     unsigned num_files_;
+    HtslibThreadPool* thread_pool_ = nullptr;
     bool all_readers_single_sample_;
     
     mutable ClosedReaderSet closed_readers_;
@@ -121,6 +136,8 @@ private:
     SampleIdToReaderPathMap reader_paths_containing_sample_;
     ReaderRegionsMap possible_regions_in_readers_;
     std::vector<SampleName> samples_;
+    std::shared_ptr<const ReadCoverageIndex> coverage_index_;
+    ThreadPool* fetch_workers_ = nullptr;
     
     mutable std::mutex mutex_;
     
@@ -141,6 +158,12 @@ private:
     Path choose_reader_to_close() const;
     void close_readers(unsigned n) const;
     
+    bool can_fetch_concurrently() const noexcept;
+    std::vector<const ReadReader*> get_open_readers(const std::vector<SampleName>& samples, const GenomicRegion& region) const;
+    template <typename Fetcher>
+    std::vector<std::result_of_t<Fetcher(const ReadReader&)>>
+    fetch_concurrently(const std::vector<const ReadReader*>& readers, Fetcher fetcher) const;
+    
     template <typename Visitor>
     void iterate_helper(const std::vector<SampleName>& samples,
                         const GenomicRegion& region,
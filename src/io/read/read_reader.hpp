@@ -15,6 +15,7 @@
 #include <boost/optional.hpp>
 
 #include "concepts/equitable.hpp"
+#include "io/htslib_thread_pool.hpp"
 #include "read_reader_impl.hpp"
 
 namespace octopus {
@@ -41,7 +42,7 @@ public:
     
     ReadReader() = default;
     
-    ReadReader(const Path& file_path);
+    ReadReader(const Path& file_path, HtslibThreadPool* thread_pool = nullptr);
     
     ReadReader(const ReadReader&)            = delete;
     ReadReader& operator=(const ReadReader&) = delete;
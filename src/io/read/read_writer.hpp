@@ -26,7 +26,7 @@ public:
     
     ReadWriter() = delete;
     
-    ReadWriter(Path bam_out, Path bam_template);
+    ReadWriter(Path bam_out, Path bam_template, HtslibThreadPool* thread_pool = nullptr);
     
     ReadWriter(const ReadWriter&)            = delete;
     ReadWriter& operator=(const ReadWriter&) = delete;
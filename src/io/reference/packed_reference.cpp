@@ -0,0 +1,362 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include "packed_reference.hpp"
+
+#include <array>
+#include <unordered_map>
+#include <algorithm>
+#include <iterator>
+#include <fstream>
+#include <cstring>
+#include <cctype>
+#include <utility>
+#include <stdexcept>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <boost/filesystem/operations.hpp>
+
+#include "basics/genomic_region.hpp"
+#include "utils/sequence_utils.hpp"
+#include "exceptions/missing_file_error.hpp"
+#include "exceptions/malformed_file_error.hpp"
+#include "exceptions/file_open_error.hpp"
+#include "exceptions/program_error.hpp"
+
+namespace octopus { namespace io {
+
+namespace {
+
+constexpr std::array<char, 8> packedReferenceMagic {'O', 'C', 'T', 'O', 'P', 'F', 'A', '\0'};
+constexpr std::uint32_t packedReferenceVersion {1};
+constexpr std::size_t headerSize {32}, contigRecordSize {64}, runRecordSize {16};
+
+template <typename T>
+T read(const char* data) noexcept
+{
+    T result;
+    std::memcpy(&result, data, sizeof(T));
+    return result;
+}
+
+class MissingPackedReference : public MissingFileError
+{
+    std::string do_where() const override
+    {
+        return "PackedReference";
+    }
+public:
+    MissingPackedReference(PackedReference::Path file) : MissingFileError {std::move(file), "packed reference"} {}
+};
+
+class MalformedPackedReference : public MalformedFileError
+{
+    std::string do_where() const override
+    {
+        return "PackedReference";
+    }
+public:
+    MalformedPackedReference(PackedReference::Path file) : MalformedFileError {std::move(file), "packed reference"} {}
+};
+
+class BadReferenceRequestRegion : public ProgramError
+{
+    GenomicRegion region;
+
+    std::string do_why() const override
+    {
+        return "Requested bad reference region " + to_string(region);
+    }
+    std::string do_help() const override
+    {
+        return "Send a debug report";
+    }
+    std::string do_where() const override
+    {
+        return "PackedReference";
+    }
+public:
+    BadReferenceRequestRegion(GenomicRegion region) : region {std::move(region)} {}
+};
+
+using DecodedByte = std::array<char, 4>;
+
+auto make_decode_table() noexcept
+{
+    constexpr std::array<char, 4> bases {'A', 'C', 'G', 'T'};
+    std::array<DecodedByte, 256> result {};
+    for (unsigned byte {0}; byte < 256; ++byte) {
+        for (unsigned i {0}; i < 4; ++i) {
+            result[byte][i] = bases[(byte >> (2 * i)) & 3u];
+        }
+    }
+    return result;
+}
+
+const std::array<DecodedByte, 256>& decode_table() noexcept
+{
+    static const auto result = make_decode_table();
+    return result;
+}
+
+} // namespace
+
+class PackedReference::MappedFile
+{
+public:
+    MappedFile(const Path& path)
+    {
+        const auto fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw FileOpenError {path, "packed reference"};
+        struct stat file_stats;
+        if (::fstat(fd, &file_stats) != 0) {
+            ::close(fd);
+            throw FileOpenError {path, "packed reference"};
+        }
+        size_ = static_cast<std::size_t>(file_stats.st_size);
+        if (size_ > 0) {
+            auto data = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+            if (data == MAP_FAILED) {
+                ::close(fd);
+                throw FileOpenError {path, "packed reference"};
+            }
+            data_ = static_cast<const char*>(data);
+        }
+        ::close(fd); // the mapping keeps the file open
+    }
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+        if (data_) ::munmap(const_cast<char*>(data_), size_);
+    }
+
+    const char* data() const noexcept { return data_; }
+    std::size_t size() const noexcept { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+struct PackedReference::Contig
+{
+    ContigName name;
+    GenomicSize length;
+    const unsigned char* bases;
+    const char* exceptions;
+    std::size_t num_exceptions;
+    const char* lowercase;
+    std::size_t num_lowercase;
+};
+
+struct PackedReference::Index
+{
+    std::vector<Contig> contigs;
+    std::unordered_map<ContigName, std::size_t> lookup;
+};
+
+namespace {
+
+bool in_file(const std::uint64_t offset, const std::uint64_t size, const std::size_t file_size) noexcept
+{
+    return offset <= file_size && size <= file_size - offset;
+}
+
+} // namespace
+
+PackedReference::PackedReference(Path path)
+: PackedReference {std::move(path), Options {}}
+{}
+
+PackedReference::PackedReference(Path path, Options options)
+: path_ {std::move(path)}
+, file_ {}
+, index_ {}
+, options_ {options}
+{
+    if (!boost::filesystem::exists(path_)) {
+        throw MissingPackedReference {path_};
+    }
+    if (!is_packed_reference(path_)) {
+        throw MalformedPackedReference {path_};
+    }
+    auto file = std::make_shared<MappedFile>(path_);
+    const auto data = file->data();
+    const auto file_size = file->size();
+    if (file_size < headerSize || read<std::uint32_t>(data + 8) != packedReferenceVersion) {
+        throw MalformedPackedReference {path_};
+    }
+    const auto num_contigs = read<std::uint32_t>(data + 12);
+    const auto contig_table_offset = read<std::uint64_t>(data + 16);
+    if (!in_file(contig_table_offset, std::uint64_t {num_contigs} * contigRecordSize, file_size)) {
+        throw MalformedPackedReference {path_};
+    }
+    auto index = std::make_shared<Index>();
+    index->contigs.reserve(num_contigs);
+    index->lookup.reserve(num_contigs);
+    for (std::size_t i {0}; i < num_contigs; ++i) {
+        const auto record = data + contig_table_offset + i * contigRecordSize;
+        const auto name_offset       = read<std::uint64_t>(record);
+        const auto name_length       = read<std::uint64_t>(record + 8);
+        const auto length            = read<std::uint64_t>(record + 16);
+        const auto bases_offset      = read<std::uint64_t>(record + 24);
+        const auto exceptions_offset = read<std::uint64_t>(record + 32);
+        const auto num_exceptions    = read<std::uint64_t>(record + 40);
+        const auto lowercase_offset  = read<std::uint64_t>(record + 48);
+        const auto num_lowercase     = read<std::uint64_t>(record + 56);
+        if (!in_file(name_offset, name_length, file_size)
+            || !in_file(bases_offset, (length + 3) / 4, file_size)
+            || !in_file(exceptions_offset, num_exceptions * runRecordSize, file_size)
+            || !in_file(lowercase_offset, num_lowercase * runRecordSize, file_size)) {
+            throw MalformedPackedReference {path_};
+        }
+        ContigName name {data + name_offset, data + name_offset + name_length};
+        index->lookup.emplace(name, i);
+        index->contigs.push_back({std::move(name), static_cast<GenomicSize>(length),
+                                  reinterpret_cast<const unsigned char*>(data + bases_offset),
+                                  data + exceptions_offset, num_exceptions,
+                                  data + lowercase_offset, num_lowercase});
+    }
+    file_ = std::move(file);
+    index_ = std::move(index);
+}
+
+// virtual private methods
+
+std::unique_ptr<ReferenceReader> PackedReference::do_clone() const
+{
+    return std::make_unique<PackedReference>(*this);
+}
+
+bool PackedReference::do_is_open() const noexcept
+{
+    return static_cast<bool>(file_);
+}
+
+std::string PackedReference::do_fetch_reference_name() const
+{
+    return path_.stem().string();
+}
+
+std::vector<PackedReference::ContigName> PackedReference::do_fetch_contig_names() const
+{
+    std::vector<ContigName> result {};
+    result.reserve(index_->contigs.size());
+    for (const auto& contig : index_->contigs) {
+        result.push_back(contig.name);
+    }
+    return result;
+}
+
+PackedReference::GenomicSize PackedReference::do_fetch_contig_size(const ContigName& contig) const
+{
+    return this->contig(contig).length;
+}
+
+namespace {
+
+// Runs are sorted and disjoint, so the first run overlapping [begin, end) can be found with
+// a binary search on run ends.
+template <typename RunEnd>
+std::size_t first_overlapping_run(const char* runs, const std::size_t num_runs, const std::uint64_t begin,
+                                  RunEnd run_end) noexcept
+{
+    std::size_t first {0}, count {num_runs};
+    while (count > 0) {
+        const auto step = count / 2;
+        if (run_end(runs + (first + step) * runRecordSize) <= begin) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+    return first;
+}
+
+} // namespace
+
+PackedReference::GeneticSequence PackedReference::do_fetch_sequence(const GenomicRegion& region) const
+{
+    const auto& contig = this->contig(region.contig_name());
+    const std::uint64_t begin {std::min(region.begin(), contig.length)};
+    const std::uint64_t end {std::min(region.end(), contig.length)};
+    GeneticSequence result(end - begin, 'N');
+    // Decode whole bytes where possible
+    const auto& decode = decode_table();
+    auto result_itr = std::begin(result);
+    std::uint64_t pos {begin};
+    for (; pos < end && pos % 4 != 0; ++pos) {
+        *result_itr++ = decode[contig.bases[pos / 4]][pos % 4];
+    }
+    for (; pos + 4 <= end; pos += 4) {
+        result_itr = std::copy_n(std::cbegin(decode[contig.bases[pos / 4]]), 4, result_itr);
+    }
+    for (; pos < end; ++pos) {
+        *result_itr++ = decode[contig.bases[pos / 4]][pos % 4];
+    }
+    bool has_exceptions {false};
+    const auto exception_end = [] (const char* run) { return read<std::uint64_t>(run) + read<std::uint32_t>(run + 8); };
+    for (auto i = first_overlapping_run(contig.exceptions, contig.num_exceptions, begin, exception_end);
+         i < contig.num_exceptions; ++i) {
+        const auto run = contig.exceptions + i * runRecordSize;
+        const auto run_begin = read<std::uint64_t>(run);
+        if (run_begin >= end) break;
+        const auto first = std::max(run_begin, begin), last = std::min(exception_end(run), end);
+        const auto symbol = static_cast<char>(read<std::uint32_t>(run + 12));
+        std::fill(std::next(std::begin(result), first - begin), std::next(std::begin(result), last - begin), symbol);
+        has_exceptions = true;
+    }
+    if (options_.base_transform_policy == Options::CapitalisationPolicy::maintain) {
+        const auto lowercase_end = [] (const char* run) { return read<std::uint64_t>(run + 8); };
+        for (auto i = first_overlapping_run(contig.lowercase, contig.num_lowercase, begin, lowercase_end);
+             i < contig.num_lowercase; ++i) {
+            const auto run = contig.lowercase + i * runRecordSize;
+            const auto run_begin = read<std::uint64_t>(run);
+            if (run_begin >= end) break;
+            const auto first = std::next(std::begin(result), std::max(run_begin, begin) - begin);
+            const auto last = std::next(std::begin(result), std::min(lowercase_end(run), end) - begin);
+            std::transform(first, last, first, [] (const char base) { return std::tolower(base); });
+        }
+    }
+    if (has_exceptions && options_.iupac_ambiguity_symbol_policy == Options::IUPACAmbiguitySymbolPolicy::disambiguate) {
+        utils::disambiguate_iupac_bases(result, true);
+    }
+    if (result.size() < size(region)) {
+        if (options_.base_fill_policy == Options::BaseFillPolicy::throw_exception) {
+            throw BadReferenceRequestRegion {region};
+        }
+        if (options_.base_fill_policy == Options::BaseFillPolicy::fill_with_ns) {
+            result.resize(size(region), 'N');
+        }
+    }
+    return result;
+}
+
+const PackedReference::Contig& PackedReference::contig(const ContigName& name) const
+{
+    const auto itr = index_->lookup.find(name);
+    if (itr == std::cend(index_->lookup)) {
+        throw std::runtime_error {"contig \"" + name + "\" not found in packed reference \"" + path_.string() + "\""};
+    }
+    return index_->contigs[itr->second];
+}
+
+// non-member methods
+
+bool is_packed_reference(const boost::filesystem::path& path)
+{
+    std::ifstream file {path.string(), std::ios::binary};
+    std::array<char, packedReferenceMagic.size()> magic {};
+    return file.read(magic.data(), magic.size()) && magic == packedReferenceMagic;
+}
+
+} // namespace io
+} // namespace octopus
@@ -0,0 +1,87 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef packed_reference_hpp
+#define packed_reference_hpp
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <memory>
+
+#include <boost/filesystem/path.hpp>
+
+#include "reference_reader.hpp"
+#include "fasta.hpp"
+
+namespace octopus {
+
+class GenomicRegion;
+
+namespace io {
+
+/*
+    PackedReference reads a memory mapped packed reference file, as made by scripts/pack_reference.py.
+    Bases are stored in 2 bits, with separate lists of non-ACGT runs and lowercase runs, so sequence
+    is decoded straight from the mapping. All methods are const and lock free, and clones share the
+    mapping, so a single instance can serve all threads and needs no cache.
+
+    File layout (little endian):
+        header:  char magic[8] = "OCTOPFA\0", uint32 version, uint32 num_contigs,
+                 uint64 contig_table_offset, uint64 reserved
+        contig:  uint64 name_offset, name_length, length, bases_offset,
+                 exceptions_offset, num_exceptions, lowercase_offset, num_lowercase
+        bases:   4 bases per byte, first base in the lowest bits (A=0, C=1, G=2, T=3)
+        exception run: uint64 begin, uint32 length, uint32 symbol (uppercase, e.g. 'N')
+        lowercase run: uint64 begin, uint64 end
+ */
+class PackedReference : public ReferenceReader
+{
+public:
+    using Path = boost::filesystem::path;
+
+    using ContigName      = ReferenceReader::ContigName;
+    using GenomicSize     = ReferenceReader::GenomicSize;
+    using GeneticSequence = ReferenceReader::GeneticSequence;
+
+    using Options = Fasta::Options;
+
+    PackedReference() = delete;
+
+    PackedReference(Path path);
+    PackedReference(Path path, Options options);
+
+    PackedReference(const PackedReference&)            = default;
+    PackedReference& operator=(const PackedReference&) = default;
+    PackedReference(PackedReference&&)                 = default;
+    PackedReference& operator=(PackedReference&&)      = default;
+
+    ~PackedReference() override = default;
+
+private:
+    class MappedFile;
+    struct Contig;
+    struct Index;
+
+    Path path_;
+    std::shared_ptr<const MappedFile> file_;
+    std::shared_ptr<const Index> index_;
+    Options options_;
+
+    std::unique_ptr<ReferenceReader> do_clone() const override;
+    bool do_is_open() const noexcept override;
+    std::string do_fetch_reference_name() const override;
+    std::vector<ContigName> do_fetch_contig_names() const override;
+    GenomicSize do_fetch_contig_size(const ContigName& contig) const override;
+    GeneticSequence do_fetch_sequence(const GenomicRegion& region) const override;
+
+    const Contig& contig(const ContigName& name) const;
+};
+
+// True if the file starts with the packed reference magic
+bool is_packed_reference(const boost::filesystem::path& path);
+
+} // namespace io
+} // namespace octopus
+
+#endif
@@ -18,6 +18,8 @@
 #include <boost/optional.hpp>
 #include <boost/container/small_vector.hpp>
 
+#include "htslib/bgzf.h"
+
 #include "basics/genomic_region.hpp"
 #include "utils/string_utils.hpp"
 #include "exceptions/file_open_error.hpp"
@@ -40,6 +42,16 @@ bool is_missing(const std::string& value) noexcept
 
 namespace bc = boost::container;
 
+std::string join(const std::vector<VcfValue>& values, const char delim)
+{
+    std::string result {};
+    for (auto itr = std::cbegin(values); itr != std::cend(values); ++itr) {
+        if (itr != std::cbegin(values)) result += delim;
+        result += itr->str();
+    }
+    return result;
+}
+
 } // namespace
 
 char* malloc_copy(const std::string& source)
@@ -88,6 +100,7 @@ HtslibBcfFacade::HtslibBcfFacade()
 , file_ {bcf_open("-", "[w]"), HtsFileDeleter {}}
 , header_ {bcf_hdr_init("w"), HtsHeaderDeleter {}}
 , samples_ {}
+, is_indexing_ {false}
 {
     if (file_ == nullptr) {
         throw std::runtime_error {"HtslibBcfFacade: could not open stdout writer"};
@@ -97,11 +110,12 @@ HtslibBcfFacade::HtslibBcfFacade()
     }
 }
 
-HtslibBcfFacade::HtslibBcfFacade(Path file_path, Mode mode)
+HtslibBcfFacade::HtslibBcfFacade(Path file_path, Mode mode, HtslibThreadPool* thread_pool)
 : file_path_ {std::move(file_path)}
 , file_ {nullptr, HtsFileDeleter {}}
 , header_ {nullptr, HtsHeaderDeleter {}}
 , samples_ {}
+, is_indexing_ {false}
 {
     const auto hts_mode = get_hts_mode(file_path_, mode);
     if (mode == Mode::read) {
@@ -110,6 +124,7 @@ HtslibBcfFacade::HtslibBcfFacade(Path file_path, Mode mode)
             if (!file_) {
                 throw FileOpenError {file_path_};
             }
+            io::attach(file_.get(), thread_pool);
             header_.reset(bcf_hdr_read(file_.get()));
             if (!header_) {
                 throw std::runtime_error {"HtslibBcfFacade: could not make header for file " + file_path_.string()};
@@ -123,6 +138,7 @@ HtslibBcfFacade::HtslibBcfFacade(Path file_path, Mode mode)
         if (!file_) {
             throw FileOpenError {file_path_};
         }
+        io::attach(file_.get(), thread_pool);
         header_.reset(bcf_hdr_init(hts_mode.c_str()));
     } else {
         const auto hts_read_mode = get_hts_mode(file_path_, Mode::read);
@@ -136,6 +152,7 @@ HtslibBcfFacade::HtslibBcfFacade(Path file_path, Mode mode)
         if (!file_) {
             throw FileOpenError {file_path_};
         }
+        io::attach(file_.get(), thread_pool);
         if (header_) {
             samples_ = extract_samples(header_.get());
         } else {
@@ -437,6 +454,121 @@ void HtslibBcfFacade::write(const VcfRecord& record)
     bcf_destroy(hts_record);
 }
 
+bool HtslibBcfFacade::init_index()
+{
+#if defined(HTS_VERSION) && HTS_VERSION >= 101100
+    if (file_ == nullptr || header_ == nullptr || is_indexing_ || !is_bgzf()) return false;
+    // Same index types as index_vcf
+    const auto index_path = file_path_.string() + (is_bcf() ? ".csi" : ".tbi");
+    const int min_shift {is_bcf() ? 14 : 0};
+    is_indexing_ = bcf_idx_init(file_.get(), header_.get(), min_shift, index_path.c_str()) == 0;
+    return is_indexing_;
+#else
+    return false; // htslib is too old to index while writing
+#endif
+}
+
+bool HtslibBcfFacade::save_index() noexcept
+{
+#if defined(HTS_VERSION) && HTS_VERSION >= 101100
+    if (file_ == nullptr || !is_indexing_) return false;
+    is_indexing_ = false;
+    return bcf_idx_save(file_.get()) == 0;
+#else
+    return false;
+#endif
+}
+
+namespace {
+
+std::string format_header(const bcf_hdr_t* header)
+{
+    kstring_t str {0, 0, nullptr};
+    if (bcf_hdr_format(header, 0, &str) < 0) {
+        std::free(str.s);
+        throw std::runtime_error {"HtslibBcfFacade: could not format header"};
+    }
+    std::string result {str.s, str.l};
+    std::free(str.s);
+    return result;
+}
+
+bool is_same_header(const bcf_hdr_t* lhs, const bcf_hdr_t* rhs)
+{
+    return format_header(lhs) == format_header(rhs);
+}
+
+static constexpr std::size_t bgzfBlockHeaderSize {18}, bgzfMaxBlockSize {65536};
+static constexpr std::array<std::uint8_t, 28> bgzfEofBlock {
+    0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00, 0x42, 0x43,
+    0x02, 0x00, 0x1b, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+bool is_eof_block(const std::vector<char>& block, const std::size_t block_size) noexcept
+{
+    return block_size == bgzfEofBlock.size() && std::memcmp(block.data(), bgzfEofBlock.data(), block_size) == 0;
+}
+
+bool is_bgzf_block_header(const std::vector<char>& block_header) noexcept
+{
+    return std::equal(std::cbegin(block_header), std::next(std::cbegin(block_header), 4), std::cbegin(bgzfEofBlock),
+                      [] (char lhs, std::uint8_t rhs) { return static_cast<std::uint8_t>(lhs) == rhs; })
+           && block_header[12] == 'B' && block_header[13] == 'C';
+}
+
+auto bgzf_block_size(const std::vector<char>& block_header) noexcept
+{
+    // BSIZE, the total block size minus one, is the last field of the BGZF block header
+    const auto bsize = static_cast<std::uint8_t>(block_header[16]) | (static_cast<std::uint8_t>(block_header[17]) << 8);
+    return static_cast<std::size_t>(bsize) + 1;
+}
+
+} // namespace
+
+bool HtslibBcfFacade::append(const Path& source)
+{
+    if (file_ == nullptr || header_ == nullptr || is_indexing_ || !is_bgzf()) return false;
+    std::unique_ptr<htsFile, HtsFileDeleter> src {hts_open(source.c_str(), "r"), HtsFileDeleter {}};
+    if (!src) {
+        throw FileOpenError {source};
+    }
+    if (src->format.format != file_->format.format || src->format.compression != bgzf) return false;
+    std::unique_ptr<bcf_hdr_t, HtsHeaderDeleter> src_header {bcf_hdr_read(src.get()), HtsHeaderDeleter {}};
+    if (!src_header || !is_same_header(src_header.get(), header_.get())) return false;
+    BGZF* in {hts_get_bgzfp(src.get())};
+    BGZF* out {hts_get_bgzfp(file_.get())};
+    // Records read along with the end of the header must be recompressed, the rest are copied block by block
+    if (in->block_offset < in->block_length) {
+        const auto num_bytes = static_cast<std::size_t>(in->block_length - in->block_offset);
+        if (bgzf_write(out, static_cast<const char*>(in->uncompressed_block) + in->block_offset, num_bytes) < 0) {
+            throw std::runtime_error {"HtslibBcfFacade: append to " + file_path_.string() + " failed"};
+        }
+    }
+    if (bgzf_flush(out) < 0) {
+        throw std::runtime_error {"HtslibBcfFacade: append to " + file_path_.string() + " failed"};
+    }
+    std::vector<char> block(bgzfMaxBlockSize);
+    while (true) {
+        const auto num_read = bgzf_raw_read(in, block.data(), bgzfBlockHeaderSize);
+        if (num_read == 0) break;
+        if (num_read != static_cast<ssize_t>(bgzfBlockHeaderSize) || !is_bgzf_block_header(block)) {
+            throw std::runtime_error {"HtslibBcfFacade: could not read BGZF block in " + source.string()};
+        }
+        const auto block_size = bgzf_block_size(block);
+        if (block_size < bgzfBlockHeaderSize || block_size > bgzfMaxBlockSize
+            || bgzf_raw_read(in, block.data() + bgzfBlockHeaderSize, block_size - bgzfBlockHeaderSize)
+               != static_cast<ssize_t>(block_size - bgzfBlockHeaderSize)) {
+            throw std::runtime_error {"HtslibBcfFacade: could not read BGZF block in " + source.string()};
+        }
+        // Empty EOF blocks in the middle of a file can end reads early
+        if (is_eof_block(block, block_size)) continue;
+        if (bgzf_raw_write(out, block.data(), block_size) != static_cast<ssize_t>(block_size)) {
+            throw std::runtime_error {"HtslibBcfFacade: append to " + file_path_.string() + " failed"};
+        }
+    }
+    return true;
+}
+
 // HtslibBcfFacade::RecordIterator
 
 HtslibBcfFacade::RecordIterator::RecordIterator(const HtslibBcfFacade& facade)
@@ -609,16 +741,14 @@ void extract_info(const bcf_hdr_t* header, bcf1_t* record, VcfRecord::Builder& b
             throw std::runtime_error {"HtslibBcfFacade: found INFO key not present in header file"};
         }
         const char* key {header->id[BCF_DT_ID][key_id].key};
-        std::vector<std::string> values {};
+        std::vector<VcfValue> values {};
         switch (bcf_hdr_id2type(header, BCF_HL_INFO, key_id)) {
             case BCF_HT_INT: {
                 const auto num_values_written = bcf_get_info_int32(header, record, key, &intinfo, &nintinfo);
                 if (num_values_written > 0) {
                     values.reserve(num_values_written);
                     std::transform(intinfo, intinfo + num_values_written, std::back_inserter(values),
-                                   [](auto v) {
-                                       return v != bcf_int32_missing ? std::to_string(v) : bcf_missing_str;
-                                   });
+                                   [] (auto v) { return v != bcf_int32_missing ? VcfValue {v} : VcfValue {}; });
                 }
                 break;
             }
@@ -627,9 +757,7 @@ void extract_info(const bcf_hdr_t* header, bcf1_t* record, VcfRecord::Builder& b
                 if (num_values_written > 0) {
                     values.reserve(num_values_written);
                     std::transform(floatinfo, floatinfo + num_values_written, std::back_inserter(values),
-                                   [] (auto v) {
-                                       return v != bcf_float_missing ? std::to_string(v) : bcf_missing_str;
-                                   });
+                                   [] (auto v) { return !bcf_float_is_missing(v) ? VcfValue {v} : VcfValue {}; });
                 }
                 break;
             }
@@ -637,13 +765,15 @@ void extract_info(const bcf_hdr_t* header, bcf1_t* record, VcfRecord::Builder& b
                 const auto nchars = bcf_get_info_string(header, record, key, &stringinfo, &nstringinfo);
                 if (nchars > 0) {
                     std::string tmp(stringinfo, nchars);
-                    values = utils::split(tmp, vcfspec::info::valueSeperator);
+                    for (auto& value : utils::split(tmp, vcfspec::info::valueSeperator)) {
+                        values.emplace_back(std::move(value));
+                    }
                 }
                 break;
             }
             case BCF_HT_FLAG: {
                 values.reserve(1);
-                values.emplace_back((bcf_get_info_flag(header, record, key, &flaginfo, &nflaginfo) == 1) ? "1" : "0");
+                values.emplace_back((bcf_get_info_flag(header, record, key, &flaginfo, &nflaginfo) == 1) ? 1 : 0);
                 break;
             }
         }
@@ -673,7 +803,7 @@ void set_info(const bcf_hdr_t* header, bcf1_t* dest, const VcfRecord& source)
             {
                 bc::small_vector<int, defaultBufferCapacity> vals(num_values);
                 std::transform(std::cbegin(values), std::cend(values), std::begin(vals),
-                               [] (const auto& v) { return !is_missing(v) ? std::stoi(v) : bcf_int32_missing; });
+                               [] (const auto& v) { return !v.is_missing() ? v.as_integer() : bcf_int32_missing; });
                 bcf_update_info_int32(header, dest, key.c_str(), vals.data(), num_values);
                 break;
             }
@@ -681,20 +811,19 @@ void set_info(const bcf_hdr_t* header, bcf1_t* dest, const VcfRecord& source)
             {
                 bc::small_vector<float, defaultBufferCapacity> vals(num_values);
                 std::transform(std::cbegin(values), std::cend(values), std::begin(vals),
-                               [] (const auto& v) { return !is_missing(v) ? std::stof(v) : get_bcf_float_missing(); });
+                               [] (const auto& v) { return !v.is_missing() ? v.as_float() : get_bcf_float_missing(); });
                 bcf_update_info_float(header, dest, key.c_str(), vals.data(), num_values);
                 break;
             }
             case BCF_HT_STR:
             {
-                // Can we also use small_vector here?
-                const auto vals = utils::join(values, vcfspec::info::valueSeperator);
+                const auto vals = join(values, vcfspec::info::valueSeperator);
                 bcf_update_info_string(header, dest, key.c_str(), vals.c_str());
                 break;
             }
             case BCF_HT_FLAG:
             {
-                bcf_update_info_flag(header, dest, key.c_str(), "", values.empty() || values.front() == "1");
+                bcf_update_info_flag(header, dest, key.c_str(), "", values.empty() || values.front() == VcfValue {1});
                 break;
             }
         }
@@ -763,7 +892,7 @@ void extract_samples(const bcf_hdr_t* header, bcf1_t* record, VcfRecord::Builder
     int nintformat {}, nfloatformat {}, nstringformat {};
     for (auto itr = first_format, end = std::cend(format); itr != end; ++itr) {
         const auto& key = *itr;
-        std::vector<std::vector<std::string>> values(num_samples, std::vector<std::string> {});
+        std::vector<std::vector<VcfValue>> values(num_samples, std::vector<VcfValue> {});
         switch (bcf_hdr_id2type(header, BCF_HL_FMT, bcf_hdr_id2int(header, BCF_DT_ID, key.c_str()))) {
             case BCF_HT_INT: {
                 const auto num_values_written = bcf_get_format_int32(header, record, key.c_str(), &intformat, &nintformat);
@@ -778,9 +907,7 @@ void extract_samples(const bcf_hdr_t* header, bcf1_t* record, VcfRecord::Builder
                         const auto num_sample_values = num_values_per_sample - num_pad_values;
                         values[sample].reserve(num_sample_values);
                         std::transform(ptr, ptr + num_sample_values, std::back_inserter(values[sample]),
-                                       [] (auto v) {
-                                           return v != bcf_int32_missing ? std::to_string(v) : bcf_missing_str;
-                                       });
+                                       [] (auto v) { return v != bcf_int32_missing ? VcfValue {v} : VcfValue {}; });
                     }
                 }
                 break;
@@ -798,9 +925,7 @@ void extract_samples(const bcf_hdr_t* header, bcf1_t* record, VcfRecord::Builder
                         const auto num_sample_values = num_values_per_sample - num_pad_values;
                         values[sample].reserve(num_sample_values);
                         std::transform(ptr, ptr + num_sample_values, std::back_inserter(values[sample]),
-                                       [] (auto v) {
-                                           return v != bcf_float_missing ? std::to_string(v) : bcf_missing_str;
-                                       });
+                                       [] (auto v) { return !bcf_float_is_missing(v) ? VcfValue {v} : VcfValue {}; });
                     }
                 }
                 break;
@@ -881,7 +1006,7 @@ void set_samples(const bcf_hdr_t* header, bcf1_t* dest, const VcfRecord& source,
         auto genotype_itr = std::begin(genotype);
         for (const auto& sample : samples) {
             const bool is_phased {source.is_sample_phased(sample)};
-            const auto& genotype = source.get_sample_value(sample, vcfspec::format::genotype);
+            const auto& genotype = source.genotype(sample);
             const auto ploidy = static_cast<unsigned>(genotype.size());
             genotype_itr = std::transform(std::cbegin(genotype), std::cend(genotype), genotype_itr,
                                           [is_phased, &alleles] (const auto& allele) {
@@ -912,7 +1037,7 @@ void set_samples(const bcf_hdr_t* header, bcf1_t* dest, const VcfRecord& source,
               for (const auto& sample : samples) {
                   const auto& values = source.get_sample_value(sample, key);
                   value_itr = std::transform(std::cbegin(values), std::cend(values), value_itr,
-                                             [] (const auto& v) { return !is_missing(v) ? std::stoi(v) : bcf_int32_missing; });
+                                             [] (const auto& v) { return !v.is_missing() ? v.as_integer() : bcf_int32_missing; });
                   assert(values.size() <= num_values_per_sample);
                   value_itr = std::fill_n(value_itr, num_values_per_sample - values.size(), pad);
               }
@@ -927,7 +1052,7 @@ void set_samples(const bcf_hdr_t* header, bcf1_t* dest, const VcfRecord& source,
               for (const auto& sample : samples) {
                   const auto& values = source.get_sample_value(sample, key);
                   value_itr = std::transform(std::cbegin(values), std::cend(values), value_itr,
-                                             [] (const auto& v) { return !is_missing(v) ? std::stof(v) : get_bcf_float_missing(); });
+                                             [] (const auto& v) { return !v.is_missing() ? v.as_float() : get_bcf_float_missing(); });
                   assert(values.size() <= num_values_per_sample);
                   value_itr = std::fill_n(value_itr, num_values_per_sample - values.size(), pad);
               }
@@ -936,26 +1061,17 @@ void set_samples(const bcf_hdr_t* header, bcf1_t* dest, const VcfRecord& source,
           }
           case BCF_HT_STR:
           {
-              bc::small_vector<const char*, defaultValueCapacity> typed_values;
-              if (key_cardinality && *key_cardinality <= 1) {
-                  typed_values.resize(num_values);
-                  auto value_itr = std::begin(typed_values);
-                  for (const auto& sample : samples) {
-                      const auto& values = source.get_sample_value(sample, key);
-                      value_itr = std::transform(std::cbegin(values), std::cend(values), value_itr,
-                                                 [] (const auto& value) { return value.c_str(); });
-                  }
-              } else {
-                  str_buffer.clear();
+              str_buffer.clear();
+              if (!key_cardinality || *key_cardinality > 0) {
                   str_buffer.reserve(num_samples);
                   for (const auto& sample : samples) {
-                      str_buffer.push_back(utils::join(source.get_sample_value(sample, key), vcfspec::format::valueSeperator));
+                      str_buffer.push_back(join(source.get_sample_value(sample, key), vcfspec::format::valueSeperator));
                   }
-                  num_values = num_samples;
-                  typed_values.resize(num_values);
-                  std::transform(std::cbegin(str_buffer), std::cend(str_buffer), std::begin(typed_values),
-                                 [] (const auto& value) { return value.c_str(); });
               }
+              num_values = static_cast<int>(str_buffer.size());
+              bc::small_vector<const char*, defaultValueCapacity> typed_values(num_values);
+              std::transform(std::cbegin(str_buffer), std::cend(str_buffer), std::begin(typed_values),
+                             [] (const auto& value) { return value.c_str(); });
               bcf_update_format_string(header, dest, key.c_str(), typed_values.data(), num_values);
               break;
           }
@@ -969,6 +1085,12 @@ bool HtslibBcfFacade::is_bcf() const noexcept
     return file_->format.format == bcf;
 }
 
+bool HtslibBcfFacade::is_bgzf() const noexcept
+{
+    assert(file_);
+    return file_->format.compression == bgzf;
+}
+
 std::size_t HtslibBcfFacade::count_records(HtsBcfSrPtr& sr) const
 {
     std::size_t result {0};
@@ -16,6 +16,7 @@
 #include "htslib/vcf.h"
 #include "htslib/synced_bcf_reader.h"
 
+#include "io/htslib_thread_pool.hpp"
 #include "vcf_reader_impl.hpp"
 #include "vcf_record.hpp"
 
@@ -36,7 +37,7 @@ public:
     enum class Mode { read, write, append };
     
     HtslibBcfFacade(); // write only, goes to stdout
-    HtslibBcfFacade(Path file_path, Mode mode = Mode::read);
+    HtslibBcfFacade(Path file_path, Mode mode = Mode::read, HtslibThreadPool* thread_pool = nullptr);
     
     HtslibBcfFacade(const HtslibBcfFacade&)            = delete;
     HtslibBcfFacade& operator=(const HtslibBcfFacade&) = delete;
@@ -64,6 +65,15 @@ public:
     void write(const VcfHeader& header);
     void write(const VcfRecord& record);
     
+    // Indexes records as they are written. Must be called after the header is written and before
+    // any records; returns false if the file cannot be indexed this way.
+    bool init_index();
+    bool save_index() noexcept;
+    
+    // Appends the records of a bgzipped file with the same format and header as this one by copying
+    // compressed blocks. Returns false, and writes nothing, if the files are not compatible.
+    bool append(const Path& source);
+    
 private:
     struct HtsFileDeleter
     {
@@ -89,8 +99,10 @@ private:
     std::unique_ptr<htsFile, HtsFileDeleter> file_;
     std::unique_ptr<bcf_hdr_t, HtsHeaderDeleter> header_;
     std::vector<std::string> samples_;
+    bool is_indexing_;
     
     bool is_bcf() const noexcept;
+    bool is_bgzf() const noexcept;
     std::size_t count_records(HtsBcfSrPtr& sr) const;
     VcfRecord fetch_record(const bcf_srs_t* sr, UnpackPolicy level) const;
     RecordContainer fetch_records(bcf_srs_t*, UnpackPolicy level, size_t num_records) const;
@@ -6,8 +6,6 @@
 #include <algorithm>
 #include <iterator>
 
-#include <boost/lexical_cast.hpp>
-
 #include "vcf_spec.hpp"
 
 namespace octopus {
@@ -172,9 +170,14 @@ bool VcfRecord::has_alt_allele(const SampleName& sample) const
                             }) != std::cend(genotype);
 }
 
+const std::vector<VcfRecord::NucleotideSequence>& VcfRecord::genotype(const SampleName& sample) const
+{
+    return genotypes_.at(sample).first;
+}
+
 const std::vector<VcfRecord::ValueType>& VcfRecord::get_sample_value(const SampleName& sample, const KeyType& key) const
 {
-    return (key == vcfspec::format::genotype) ? genotypes_.at(sample).first : samples_.at(sample).at(key);
+    return samples_.at(sample).at(key);
 }
 
 // helper non-members needed for printing
@@ -318,12 +321,12 @@ void VcfRecord::print_sample_data(std::ostream& os) const
 
 std::vector<VcfRecord::NucleotideSequence> get_genotype(const VcfRecord& record, const VcfRecord::SampleName& sample)
 {
-    return record.get_sample_value(sample, vcfspec::format::genotype);
+    return record.genotype(sample);
 }
 
 bool is_missing(const std::vector<VcfRecord::ValueType>& values) noexcept
 {
-    return values.size() < 2 && values.front() == vcfspec::missingValue;
+    return values.size() < 2 && values.front().is_missing();
 }
 
 bool is_info_missing(const VcfRecord::KeyType& key, const VcfRecord& record)
@@ -378,7 +381,7 @@ boost::optional<GenomicRegion> get_phase_region(const VcfRecord& record, const V
     if (record.is_sample_phased(sample) && record.has_format(vcfspec::format::phaseSet)) {
         return GenomicRegion {
         record.chrom(),
-        boost::lexical_cast<ContigRegion::Position>(record.get_sample_value(sample, vcfspec::format::phaseSet).front()) - 1,
+        static_cast<ContigRegion::Position>(record.get_sample_value(sample, vcfspec::format::phaseSet).front().as_integer()) - 1,
         static_cast<ContigRegion::Position>(record.pos() + record.ref().size()) - 1
         };
     } else {
@@ -549,12 +552,17 @@ VcfRecord::Builder& VcfRecord::Builder::set_info(const KeyType& key, std::vector
     if (key == "END") {
         if (values.size() != 1)
             throw std::runtime_error {"VcfRecord::Builder INFO key END requires 1 value"};
-        end_ = std::stoll(values.front());
+        end_ = values.front().as_integer();
     }
     info_[key] = std::move(values);
     return *this;
 }
 
+VcfRecord::Builder& VcfRecord::Builder::set_info(const KeyType& key, const std::vector<std::string>& values)
+{
+    return this->set_info(key, std::vector<ValueType> {std::cbegin(values), std::cend(values)});
+}
+
 VcfRecord::Builder& VcfRecord::Builder::set_info(const KeyType& key, std::initializer_list<ValueType> values)
 {
     return this->set_info(key, std::vector<ValueType> {values});
@@ -658,6 +666,11 @@ VcfRecord::Builder& VcfRecord::Builder::set_format(const SampleName& sample, con
     return *this;
 }
 
+VcfRecord::Builder& VcfRecord::Builder::set_format(const SampleName& sample, const KeyType& key, const std::vector<std::string>& values)
+{
+    return this->set_format(sample, key, std::vector<ValueType> {std::cbegin(values), std::cend(values)});
+}
+
 VcfRecord::Builder& VcfRecord::Builder::set_format(const SampleName& sample, const KeyType& key, std::initializer_list<ValueType> values)
 {
     return this->set_format(sample, key, std::vector<ValueType> {values});
@@ -704,7 +717,7 @@ VcfRecord::Builder& VcfRecord::Builder::set_filter(const SampleName& sample, std
 
 VcfRecord::Builder& VcfRecord::Builder::set_filter(const SampleName& sample, std::initializer_list<KeyType> filter)
 {
-    return this->set_format(sample, vcfspec::format::filter, std::move(filter));
+    return this->set_format(sample, vcfspec::format::filter, std::vector<KeyType> {filter});
 }
 
 VcfRecord::Builder& VcfRecord::Builder::add_filter(const SampleName& sample, KeyType filter)
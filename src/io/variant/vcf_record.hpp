@@ -21,11 +21,13 @@
 #include "concepts/mappable.hpp"
 #include "basics/genomic_region.hpp"
 #include "utils/string_utils.hpp"
+#include "vcf_value.hpp"
 
 namespace octopus {
 
 // TODO: consider using boosts small_vector for INFO and genotype fields
 
+// INFO and FORMAT values are typed (see VcfValue); genotypes are stored as alleles and accessed with genotype
 class VcfRecord : public Comparable<VcfRecord>, public Mappable<VcfRecord>
 {
 public:
@@ -35,7 +37,7 @@ public:
     using QualityType        = float;
     using SampleName         = std::string;
     using KeyType            = std::string;
-    using ValueType          = std::string;
+    using ValueType          = VcfValue;
     
     VcfRecord() = default;
     
@@ -107,7 +109,8 @@ public:
     bool is_homozygous_non_ref(const SampleName& sample) const;
     bool has_ref_allele(const SampleName& sample) const;
     bool has_alt_allele(const SampleName& sample) const;
-    const std::vector<ValueType>& get_sample_value(const SampleName& sample, const KeyType& key) const;
+    const std::vector<NucleotideSequence>& genotype(const SampleName& sample) const;
+    const std::vector<ValueType>& get_sample_value(const SampleName& sample, const KeyType& key) const; // not GT
     
     friend std::ostream& operator<<(std::ostream& os, const VcfRecord& record);
     friend Builder;
@@ -201,8 +204,9 @@ public:
     Builder& reserve_info(unsigned n);
     Builder& add_info(const KeyType& key); // flags
     Builder& set_info(const KeyType& key, const ValueType& value);
-    template <typename T> Builder& set_info(const KeyType& key, const T& value); // calls std::to_string
+    template <typename T> Builder& set_info(const KeyType& key, const T& value); // numbers are kept typed
     Builder& set_info(const KeyType& key, std::vector<ValueType> values);
+    Builder& set_info(const KeyType& key, const std::vector<std::string>& values);
     Builder& set_info(const KeyType& key, std::initializer_list<ValueType> values);
     Builder& set_info_flag(KeyType key);
     Builder& set_info_missing(const KeyType& key);
@@ -220,8 +224,9 @@ public:
     Builder& clear_genotype(const SampleName& sample) noexcept;
     Builder& set_format(const SampleName& sample, const KeyType& key, const ValueType& value);
     template <typename T>
-    Builder& set_format(const SampleName& sample, const KeyType& key, const T& value); // calls std::to_string
+    Builder& set_format(const SampleName& sample, const KeyType& key, const T& value); // numbers are kept typed
     Builder& set_format(const SampleName& sample, const KeyType& key, std::vector<ValueType> values);
+    Builder& set_format(const SampleName& sample, const KeyType& key, const std::vector<std::string>& values);
     Builder& set_format(const SampleName& sample, const KeyType& key, std::initializer_list<ValueType> values);
     Builder& set_format_missing(const SampleName& sample, const KeyType& key);
     Builder& clear_format() noexcept;
@@ -331,15 +336,13 @@ VcfRecord::VcfRecord(GenomicRegion region, String&& id,
 template <typename T>
 VcfRecord::Builder& VcfRecord::Builder::set_info(const KeyType& key, const T& value)
 {
-    using std::to_string;
-    return set_info(key, to_string(value));
+    return set_info(key, ValueType {value});
 }
 
 template <typename T>
 VcfRecord::Builder& VcfRecord::Builder::set_format(const SampleName& sample, const KeyType& key, const T& value)
 {
-    using std::to_string;
-    return set_format(sample, key, to_string(value));
+    return set_format(sample, key, ValueType {value});
 }
 
 } // namespace octopus
@@ -157,5 +157,29 @@ VcfType make_vcf_type(const std::string& type, const std::string& value)
         throw;
     }
 }
+
+VcfType make_vcf_type(const std::string& type, const VcfValue& value)
+{
+    // Numbers are converted from their typed representation, so are never formatted and parsed
+    static const std::unordered_map<std::string, std::function<VcfType(const VcfValue&)>> typeMap {
+        {"String",    [] (const auto& value) { return make_vcf_type(value.str()); }},
+        {"Integer",   [] (const auto& value) { return make_vcf_type(static_cast<int>(value.as_integer())); }},
+        {"Float",     [] (const auto& value) { return make_vcf_type(value.as_double()); }},
+        {"Character", [] (const auto& value) { return make_vcf_type(value.str().front()); }},
+        {"Flag",      [] (const auto& value) { return make_vcf_type(value.str() == "1"); }}
+    };
+    
+    if (typeMap.count(type) == 0) throw UnknownVcfType {type};
+    
+    if (value.is_missing() && type != "String") throw BadVcfType {type, value.str()};
+    
+    try {
+        return typeMap.at(type)(value);
+    } catch (std::invalid_argument& e) {
+        throw BadVcfType {type, value.str()};
+    } catch (...) {
+        throw;
+    }
+}
     
 } // namespace octopus
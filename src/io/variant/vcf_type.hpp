@@ -11,6 +11,8 @@
 #include <boost/variant.hpp>
 #include <boost/type_index.hpp>
 
+#include "vcf_value.hpp"
+
 namespace octopus {
 
 namespace detail {
@@ -339,6 +341,7 @@ bool operator<=(const VcfType& lhs, const VcfType& rhs);
 bool operator>=(const VcfType& lhs, const VcfType& rhs);
 
 VcfType make_vcf_type(const std::string& type, const std::string& value);
+VcfType make_vcf_type(const std::string& type, const VcfValue& value);
 
 } // namespace octopus
 
@@ -12,6 +12,9 @@
 #include <functional>
 #include <stdexcept>
 #include <numeric>
+#include <future>
+
+#include <boost/filesystem/operations.hpp>
 
 #include "htslib/vcf.h"
 #include "htslib/tbx.h"
@@ -38,17 +41,33 @@ unsigned get_field_cardinality(const VcfHeader::StructuredKey& key, const VcfRec
     return 0;
 }
 
+namespace {
+
+std::vector<VcfType> get_typed_values(const VcfHeader& header, const VcfHeader::Tag& tag,
+                                      const VcfHeader::StructuredKey& key,
+                                      const std::vector<VcfRecord::ValueType>& values)
+{
+    const auto& type = get_id_field_type(header, tag, key.value);
+    std::vector<VcfType> result {};
+    result.reserve(values.size());
+    std::transform(std::cbegin(values), std::cend(values), std::back_inserter(result),
+                   [&type] (const auto& value) { return make_vcf_type(type, value); });
+    return result;
+}
+
+} // namespace
+
 std::vector<VcfType> get_typed_info_values(const VcfHeader& header, const VcfRecord& record,
                                            const VcfHeader::StructuredKey& key)
 {
-    return get_typed_info_values(header, key, record.info_value(key.value));
+    return get_typed_values(header, vcfspec::header::meta::tag::info, key, record.info_value(key.value));
 }
 
 std::vector<VcfType> get_typed_format_values(const VcfHeader& header, const VcfRecord& record,
                                              const VcfRecord::SampleName sample,
                                              const VcfHeader::StructuredKey& key)
 {
-    return get_typed_format_values(header, key, record.get_sample_value(sample, key.value));
+    return get_typed_values(header, vcfspec::header::meta::tag::format, key, record.get_sample_value(sample, key.value));
 }
 
 bool is_indexable(const boost::filesystem::path& vcf_path)
@@ -57,6 +76,12 @@ bool is_indexable(const boost::filesystem::path& vcf_path)
     return extension == ".bcf" || extension == ".gz";
 }
 
+bool is_indexed(const boost::filesystem::path& vcf_path)
+{
+    using boost::filesystem::exists;
+    return exists(vcf_path.string() + ".csi") || exists(vcf_path.string() + ".tbi");
+}
+
 void index_vcf(const boost::filesystem::path& vcf_path)
 {
     auto* const fp = hts_open(vcf_path.c_str(), "r");
@@ -445,6 +470,98 @@ void merge(std::vector<VcfReader>& sources, VcfWriter& dst)
 
 namespace {
 
+auto make_part_path(const VcfReader::Path& source, const VcfWriter::Path& dst)
+{
+    auto result = source;
+    result += ".part";
+    if (dst.extension() == ".gz") result += dst.stem().extension();
+    result += dst.extension();
+    return result;
+}
+
+VcfWriter write_part(VcfReader& source, const VcfWriter::Path& dst, const VcfHeader& header)
+{
+    VcfWriter result {make_part_path(source.path(), dst), header};
+    const bool is_closed {!source.is_open()};
+    if (is_closed) source.open();
+    auto p = source.iterate();
+    std::copy(std::move(p.first), std::move(p.second), VcfWriterIterator {result});
+    if (is_closed) source.close();
+    result.close();
+    return result;
+}
+
+void remove_part(const VcfWriter::Path& part_path) noexcept
+{
+    boost::system::error_code ec {};
+    boost::filesystem::remove(part_path, ec);
+    boost::filesystem::remove(part_path.string() + ".csi", ec);
+    boost::filesystem::remove(part_path.string() + ".tbi", ec);
+}
+
+// Removes part files that were not appended when the merge finishes, including when it throws
+struct PartFileGuard
+{
+    std::vector<VcfWriter::Path> paths;
+    ~PartFileGuard() { for (const auto& path : paths) remove_part(path); }
+};
+
+void append(VcfWriter&& part, VcfWriter& dst)
+{
+    const auto part_path = *part.path();
+    if (!dst.append(part_path)) {
+        VcfReader part_reader {part_path};
+        auto p = part_reader.iterate();
+        std::copy(std::move(p.first), std::move(p.second), VcfWriterIterator {dst});
+    }
+    // The part is not indexed when its writer is destroyed as the file no longer exists
+    remove_part(part_path);
+}
+
+} // namespace
+
+void merge(std::vector<VcfReader>& sources, VcfWriter& dst, const std::vector<std::string>& contigs, ThreadPool& workers)
+{
+    if (sources.empty()) return;
+    const auto dst_path = dst.path();
+    if (!dst.is_header_written()) {
+        dst << merge(get_headers(sources));
+    }
+    const auto reader_contig_counts = get_contig_count_map(sources, contigs);
+    if (workers.empty() || !dst_path || !is_indexable(*dst_path) || !is_unique_contig_per_reader(reader_contig_counts)) {
+        dst.start_indexing();
+        merge(sources, dst, contigs);
+        return;
+    }
+    const auto header = dst.fetch_header();
+    const auto contig_readers = extract_unique_readers(reader_contig_counts);
+    std::vector<std::future<VcfWriter>> parts {};
+    parts.reserve(contig_readers.size());
+    // Destroyed before parts, so part writers find their files gone and do not index them
+    PartFileGuard part_files {};
+    for (const auto& contig : contigs) {
+        const auto itr = contig_readers.find(contig);
+        if (itr != std::cend(contig_readers)) {
+            VcfReader& source = itr->second.get();
+            part_files.paths.push_back(make_part_path(source.path(), *dst_path));
+            parts.push_back(workers.push([&source, &dst_path, &header] () { return write_part(source, *dst_path, header); }));
+        }
+    }
+    // Parts are appended in contig order while later ones are still being written
+    try {
+        for (auto& part : parts) {
+            append(workers.wait(part), dst);
+        }
+    } catch (...) {
+        for (auto& part : parts) {
+            if (part.valid()) part.wait();
+        }
+        throw;
+    }
+}
+
+namespace {
+
 VcfHeader to_legacy(const VcfHeader& native)
 {
     return VcfHeader::Builder(native).set_file_format("VCFv4.2").build_once();
@@ -477,7 +594,7 @@ VcfRecord convert_to_legacy(const VcfRecord& record, const std::vector<std::stri
         cb.set_alt(std::move(new_alt));
     }
     for (const auto& sample : samples) {
-        const auto& gt = record.get_sample_value(sample, vcfspec::format::genotype);
+        const auto& gt = record.genotype(sample);
         const auto first_non_legacy = std::find_if(std::cbegin(gt), std::cend(gt), is_missing_or_has_deleted);
         if (first_non_legacy != std::cend(gt)) {
             const auto& ref = record.ref();
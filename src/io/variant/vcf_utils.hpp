@@ -14,6 +14,7 @@
 #include "vcf_record.hpp"
 #include "vcf_reader.hpp"
 #include "vcf_writer.hpp"
+#include "utils/thread_pool.hpp"
 
 namespace octopus {
 
@@ -29,6 +30,7 @@ get_typed_format_values(const VcfHeader& header, const VcfRecord& record,
                         const VcfRecord::SampleName sample, const VcfHeader::StructuredKey& key);
 
 bool is_indexable(const boost::filesystem::path& vcf_path);
+bool is_indexed(const boost::filesystem::path& vcf_path);
 
 void index_vcf(const boost::filesystem::path& vcf_path);
 void index_vcf(const VcfReader& reader);
@@ -45,6 +47,9 @@ VcfHeader merge(const std::vector<VcfHeader>& headers);
 
 void merge(std::vector<VcfReader>& sources, VcfWriter& dst, const std::vector<std::string>& contigs);
 void merge(std::vector<VcfReader>& sources, VcfWriter& dst);
+// If each source has a different contig and dst is bgzipped, the sources are re-encoded in parallel and
+// the compressed blocks concatenated into dst in contig order. Otherwise dst is indexed as it is written.
+void merge(std::vector<VcfReader>& sources, VcfWriter& dst, const std::vector<std::string>& contigs, ThreadPool& workers);
 
 void convert_to_legacy(const VcfReader& src, VcfWriter& dst, bool remove_ref_pad_duplicates = true);
 
@@ -0,0 +1,128 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include "vcf_value.hpp"
+
+#include <array>
+#include <cstdio>
+#include <stdexcept>
+#include <utility>
+
+#include "vcf_spec.hpp"
+
+namespace octopus {
+
+VcfValue::VcfValue(std::string value)
+{
+    if (value != vcfspec::missingValue) value_ = std::move(value);
+}
+
+VcfValue::VcfValue(const char* value) : VcfValue {std::string {value}} {}
+
+bool VcfValue::is_missing() const noexcept
+{
+    return value_.which() == 0;
+}
+
+bool VcfValue::is_integer() const noexcept
+{
+    return value_.which() == 1;
+}
+
+bool VcfValue::is_float() const noexcept
+{
+    return value_.which() == 2 || value_.which() == 3;
+}
+
+bool VcfValue::is_string() const noexcept
+{
+    return value_.which() == 4;
+}
+
+namespace {
+
+struct MissingVcfValue : public std::runtime_error
+{
+    MissingVcfValue() : std::runtime_error {"VcfValue: cannot convert a missing value to a number"} {}
+};
+
+template <typename T>
+struct NumericVisitor : public boost::static_visitor<T>
+{
+    template <typename U>
+    T operator()(const U&) const { throw MissingVcfValue {}; }
+    T operator()(VcfValue::Integer value) const { return static_cast<T>(value); }
+    T operator()(VcfValue::Float value) const { return static_cast<T>(value); }
+    T operator()(VcfValue::Double value) const { return static_cast<T>(value); }
+    T operator()(const std::string& value) const { return parse(value, T {}); }
+private:
+    static VcfValue::Integer parse(const std::string& value, VcfValue::Integer) { return std::stoi(value); }
+    static VcfValue::Float parse(const std::string& value, VcfValue::Float) { return std::stof(value); }
+    static double parse(const std::string& value, double) { return std::stod(value); }
+};
+
+std::string format(const VcfValue::Float value)
+{
+    // The same format htslib uses for VCF output
+    std::array<char, 32> buffer {};
+    const auto n = std::snprintf(buffer.data(), buffer.size(), "%g", value);
+    return {buffer.data(), static_cast<std::size_t>(n)};
+}
+
+struct StringVisitor : public boost::static_visitor<std::string>
+{
+    template <typename U>
+    std::string operator()(const U&) const { return vcfspec::missingValue; }
+    std::string operator()(VcfValue::Integer value) const { return std::to_string(value); }
+    std::string operator()(VcfValue::Float value) const { return format(value); }
+    std::string operator()(VcfValue::Double value) const { return std::to_string(value); }
+    std::string operator()(const std::string& value) const { return value; }
+};
+
+} // namespace
+
+VcfValue::Integer VcfValue::as_integer() const
+{
+    return boost::apply_visitor(NumericVisitor<Integer> {}, value_);
+}
+
+VcfValue::Float VcfValue::as_float() const
+{
+    return boost::apply_visitor(NumericVisitor<Float> {}, value_);
+}
+
+double VcfValue::as_double() const
+{
+    return boost::apply_visitor(NumericVisitor<double> {}, value_);
+}
+
+std::string VcfValue::str() const
+{
+    return boost::apply_visitor(StringVisitor {}, value_);
+}
+
+bool operator==(const VcfValue& lhs, const VcfValue& rhs)
+{
+    if (lhs.is_missing() || rhs.is_missing()) {
+        return lhs.is_missing() && rhs.is_missing();
+    } else if (lhs.is_string() || rhs.is_string()) {
+        return lhs.str() == rhs.str();
+    } else if (lhs.is_integer() && rhs.is_integer()) {
+        return lhs.as_integer() == rhs.as_integer();
+    } else {
+        return lhs.as_double() == rhs.as_double();
+    }
+}
+
+bool operator!=(const VcfValue& lhs, const VcfValue& rhs)
+{
+    return !(lhs == rhs);
+}
+
+std::ostream& operator<<(std::ostream& os, const VcfValue& value)
+{
+    os << value.str();
+    return os;
+}
+
+} // namespace octopus
@@ -0,0 +1,91 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef vcf_value_hpp
+#define vcf_value_hpp
+
+#include <string>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <ostream>
+
+#include <boost/variant.hpp>
+
+namespace octopus {
+
+/*
+    VcfValue is a single INFO or FORMAT field value. Numbers are kept in their BCF encoding (32 bit
+    integers and floats) so they are not formatted when records are read from BCF files, or parsed
+    when they are written back or used by filters. Text is only made if the value is printed or
+    asked for as a string. Values from text (e.g. the VCF parser) are kept as strings and parsed on
+    numeric access; "." is a missing value.
+ 
+    Doubles given by callers are kept as doubles, and are printed with std::to_string as they were
+    when values were strings. They are only narrowed to BCF floats when written to a Float field.
+    Integers outside the BCF int32 range are kept as strings.
+ */
+class VcfValue
+{
+public:
+    using Integer = std::int32_t;
+    using Float   = float;
+    using Double  = double;
+
+    VcfValue() = default; // missing
+
+    VcfValue(std::string value);
+    VcfValue(const char* value);
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic<T>::value>>
+    VcfValue(T value);
+
+    VcfValue(const VcfValue&)            = default;
+    VcfValue& operator=(const VcfValue&) = default;
+    VcfValue(VcfValue&&)                 = default;
+    VcfValue& operator=(VcfValue&&)      = default;
+
+    ~VcfValue() = default;
+
+    bool is_missing() const noexcept;
+    bool is_integer() const noexcept;
+    bool is_float() const noexcept; // Float or Double
+    bool is_string() const noexcept;
+
+    // Numeric access converts between integers and floats, and parses strings. Missing values throw.
+    Integer as_integer() const;
+    Float as_float() const;
+    double as_double() const;
+
+    std::string str() const;
+
+private:
+    struct Missing {};
+
+    boost::variant<Missing, Integer, Float, Double, std::string> value_;
+
+    friend bool operator==(const VcfValue& lhs, const VcfValue& rhs);
+};
+
+template <typename T, typename>
+VcfValue::VcfValue(T value)
+{
+    if (std::is_same<T, Float>::value) {
+        value_ = static_cast<Float>(value);
+    } else if (std::is_floating_point<T>::value) {
+        value_ = static_cast<Double>(value);
+    } else if (static_cast<long double>(value) >= std::numeric_limits<Integer>::min()
+               && static_cast<long double>(value) <= std::numeric_limits<Integer>::max()) {
+        value_ = static_cast<Integer>(value);
+    } else {
+        value_ = std::to_string(value); // too big for BCF, so writing it fails as it always did
+    }
+}
+
+bool operator==(const VcfValue& lhs, const VcfValue& rhs);
+bool operator!=(const VcfValue& lhs, const VcfValue& rhs);
+
+std::ostream& operator<<(std::ostream& os, const VcfValue& value);
+
+} // namespace octopus
+
+#endif
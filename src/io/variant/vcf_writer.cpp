@@ -17,25 +17,38 @@ namespace octopus {
 
 namespace {
 
-auto make_vcf_writer(boost::optional<VcfWriter::Path> path = boost::none)
+auto make_vcf_writer(boost::optional<VcfWriter::Path> path = boost::none, HtslibThreadPool* thread_pool = nullptr)
 {
     if (path) {
-        return std::make_unique<HtslibBcfFacade>(std::move(*path), HtslibBcfFacade::Mode::write);
+        return std::make_unique<HtslibBcfFacade>(std::move(*path), HtslibBcfFacade::Mode::write, thread_pool);
     } else {
         return std::make_unique<HtslibBcfFacade>();
     }
 }
 
+void remove_index(const VcfWriter::Path& file_path)
+{
+    using namespace boost::filesystem;
+    const path index_path1 {file_path.string() + ".csi"}, index_path2 {file_path.string() + ".tbi"};
+    if (exists(index_path1)) {
+        remove(index_path1);
+    } else if (exists(index_path2)) {
+        remove(index_path2);
+    }
+}
+
 } // namespace
 
 VcfWriter::VcfWriter()
 : file_path_ {}
+, thread_pool_ {nullptr}
 , writer_ {make_vcf_writer()}
 , is_header_written_ {false}
 {}
 
-VcfWriter::VcfWriter(Path file_path)
+VcfWriter::VcfWriter(Path file_path, HtslibThreadPool* thread_pool)
 : file_path_ {std::move(file_path)}
+, thread_pool_ {thread_pool}
 , writer_ {nullptr}
 , is_header_written_ {false}
 {
@@ -53,13 +66,8 @@ VcfWriter::VcfWriter(Path file_path)
             throw std::runtime_error {ss.str()};
         }
     }
-    Path index_path1 {file_path_->string() + ".csi"}, index_path2 {file_path_->string() + ".tbi"};
-    if (exists(index_path1)) {
-        remove(index_path1);
-    } else if (exists(index_path2)) {
-        remove(index_path2);
-    }
-    writer_ = make_vcf_writer(*file_path_);
+    remove_index(*file_path_);
+    writer_ = make_vcf_writer(*file_path_, thread_pool_);
 }
 
 VcfWriter::VcfWriter(const VcfHeader& header)
@@ -68,8 +76,8 @@ VcfWriter::VcfWriter(const VcfHeader& header)
     write(std::move(header));
 }
 
-VcfWriter::VcfWriter(Path file_path, const VcfHeader& header)
-: VcfWriter {std::move(file_path)}
+VcfWriter::VcfWriter(Path file_path, const VcfHeader& header, HtslibThreadPool* thread_pool)
+: VcfWriter {std::move(file_path), thread_pool}
 {
     write(std::move(header));
 }
@@ -78,6 +86,7 @@ VcfWriter::VcfWriter(VcfWriter&& other)
 {
     std::lock_guard<std::mutex> lock {other.mutex_};
     file_path_         = std::move(other.file_path_);
+    thread_pool_       = other.thread_pool_;
     is_header_written_ = other.is_header_written_;
     writer_            = std::move(other.writer_);
 }
@@ -88,6 +97,7 @@ VcfWriter& VcfWriter::operator=(VcfWriter&& other)
         std::unique_lock<std::mutex> lock_lhs {mutex_, std::defer_lock}, lock_rhs {other.mutex_, std::defer_lock};
         std::lock(lock_lhs, lock_rhs);
         file_path_         = std::move(other.file_path_);
+        thread_pool_       = other.thread_pool_;
         is_header_written_ = other.is_header_written_;
         writer_            = std::move(other.writer_);
     }
@@ -113,6 +123,7 @@ void swap(VcfWriter& lhs, VcfWriter& rhs) noexcept
     std::lock_guard<std::mutex> lock_lhs {lhs.mutex_, std::adopt_lock}, lock_rhs {rhs.mutex_, std::adopt_lock};
     using std::swap;
     swap(lhs.file_path_, rhs.file_path_);
+    swap(lhs.thread_pool_, rhs.thread_pool_);
     swap(lhs.is_header_written_, rhs.is_header_written_);
     swap(lhs.writer_, rhs.writer_);
 }
@@ -129,20 +140,22 @@ void VcfWriter::open()
         throw std::runtime_error {"VcfWriter::open: invalid open request"};
     }
     std::lock_guard<std::mutex> lock {mutex_};
-    writer_ = std::make_unique<HtslibBcfFacade>(*file_path_, HtslibBcfFacade::Mode::append);
+    remove_index(*file_path_); // appended records would not be indexed
+    writer_ = std::make_unique<HtslibBcfFacade>(*file_path_, HtslibBcfFacade::Mode::append, thread_pool_);
 }
 
 void VcfWriter::open(Path file_path)
 {
     std::lock_guard<std::mutex> lock {mutex_};
     file_path_         = std::move(file_path);
-    writer_            = make_vcf_writer(*file_path_);
+    writer_            = make_vcf_writer(*file_path_, thread_pool_);
     is_header_written_ = false;
 }
 
 void VcfWriter::close() noexcept
 {
     std::lock_guard<std::mutex> lock {mutex_};
+    if (writer_) writer_->save_index();
     writer_.reset();
 }
 
@@ -158,6 +171,15 @@ boost::optional<VcfWriter::Path> VcfWriter::path() const
     return file_path_;
 }
 
+VcfHeader VcfWriter::fetch_header() const
+{
+    std::lock_guard<std::mutex> lock {mutex_};
+    if (!is_header_written_) {
+        throw std::runtime_error {"VcfWriter::fetch_header: header has not been written"};
+    }
+    return writer_->fetch_header();
+}
+
 void VcfWriter::write(const VcfHeader& header)
 {
     std::lock_guard<std::mutex> lock {mutex_};
@@ -175,10 +197,26 @@ void VcfWriter::write(const VcfRecord& record)
     }
 }
 
+bool VcfWriter::start_indexing()
+{
+    std::lock_guard<std::mutex> lock {mutex_};
+    return writer_ && is_header_written_ && writer_->init_index();
+}
+
+bool VcfWriter::append(const Path& source)
+{
+    std::lock_guard<std::mutex> lock {mutex_};
+    if (is_header_written_) {
+        return writer_->append(source);
+    } else {
+        throw std::runtime_error {"VcfWriter::append: cannot append records as header has not been written"};
+    }
+}
+
 bool VcfWriter::can_write_index() const noexcept
 {
-    return file_path_ && is_header_written_
-           && is_indexable(*file_path_) && boost::filesystem::exists(*file_path_);
+    return file_path_ && is_header_written_ && is_indexable(*file_path_)
+           && boost::filesystem::exists(*file_path_) && !is_indexed(*file_path_);
 }
 
 // non member methods
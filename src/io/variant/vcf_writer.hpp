@@ -27,9 +27,9 @@ public:
     using Path = boost::filesystem::path;
     
     VcfWriter();
-    VcfWriter(Path file_path);
+    VcfWriter(Path file_path, HtslibThreadPool* thread_pool = nullptr);
     VcfWriter(const VcfHeader& header);
-    VcfWriter(Path file_path, const VcfHeader& header);
+    VcfWriter(Path file_path, const VcfHeader& header, HtslibThreadPool* thread_pool = nullptr);
     
     VcfWriter(const VcfWriter&)            = delete;
     VcfWriter& operator=(const VcfWriter&) = delete;
@@ -49,11 +49,22 @@ public:
     
     boost::optional<Path> path() const;
     
+    VcfHeader fetch_header() const;
+    
     void write(const VcfHeader& header);
     void write(const VcfRecord& record);
     
+    // Builds the index as records are written rather than when the writer is destroyed. Must be called
+    // before any records are written; returns false if the output cannot be indexed this way.
+    bool start_indexing();
+    
+    // Appends the records of a bgzipped file with the same format and header, without decoding them.
+    // Returns false if the file cannot be appended this way.
+    bool append(const Path& source);
+    
 private:
     boost::optional<Path> file_path_;
+    HtslibThreadPool* thread_pool_;
     std::unique_ptr<HtslibBcfFacade> writer_;
     bool is_header_written_;
     mutable std::mutex mutex_;
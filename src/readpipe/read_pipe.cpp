@@ -93,25 +93,34 @@ const std::vector<SampleName>& ReadPipe::samples() const noexcept
 
 namespace {
 
-template <typename Map>
-void sort_each(Map& reads)
+// ReadManager merges the reads from each file into sorted order
+auto fetch_batch(const ReadManager& rm, const std::vector<SampleName>& samples, const GenomicRegion& region)
 {
-    for (auto& p : reads) {
-        std::sort(std::begin(p.second), std::end(p.second));
+    return rm.fetch_reads(samples, region);
+}
+
+// Transformers may change read sequences and base qualities, but never mapped regions, and filters
+// remove reads stably. So only reads with the same mapped region can be out of order.
+void sort_mapped_region_ties(std::vector<AlignedRead>& reads)
+{
+    for (auto first = std::begin(reads); first != std::end(reads);) {
+        const auto last = std::find_if(std::next(first), std::end(reads),
+                                       [first] (const AlignedRead& read) { return !is_same_region(read, *first); });
+        if (std::distance(first, last) > 1) std::sort(first, last);
+        first = last;
     }
 }
 
-auto fetch_batch(const ReadManager& rm, const std::vector<SampleName>& samples, const GenomicRegion& region)
+void sort_mapped_region_ties(ReadManager::SampleReadMap& reads)
 {
-    auto result = rm.fetch_reads(samples, region);
-    sort_each(result);
-    return result;
+    for (auto& p : reads) sort_mapped_region_ties(p.second);
 }
 
 template <typename Container>
 void move_construct(Container&& src, ReadMap::mapped_type& dst)
 {
-    dst.insert(std::make_move_iterator(std::begin(src)), std::make_move_iterator(std::end(src)));
+    assert(std::is_sorted(std::cbegin(src), std::cend(src)));
+    dst = ReadMap::mapped_type {ForwardSortedTag {}, std::make_move_iterator(std::begin(src)), std::make_move_iterator(std::end(src))};
 }
 
 template <>
@@ -128,7 +137,7 @@ void insert_each(Container&& src, ReadMap& dst)
         if (sample_dst.empty()) {
             move_construct(std::move(p.second), sample_dst);
         } else {
-            sample_dst.insert(std::make_move_iterator(std::begin(p.second)),
+            sample_dst.insert(ForwardSortedTag {}, std::make_move_iterator(std::begin(p.second)),
                               std::make_move_iterator(std::end(p.second)));
         }
         p.second.clear();
@@ -177,6 +186,17 @@ void fragment(ReadManager::SampleReadMap& reads, const unsigned fragment_length,
     for (auto& p : reads) fragment(p.second, fragment_length, region);
 }
 
+auto make_read_map(ReadManager::SampleReadMap&& reads)
+{
+    ReadMap result {reads.size()};
+    for (auto& p : reads) {
+        ReadMap::mapped_type sample_reads {};
+        move_construct(std::move(p.second), sample_reads);
+        result.emplace(p.first, std::move(sample_reads));
+    }
+    return result;
+}
+
 struct IsMappingQualityZero
 {
     bool operator()(const AlignedRead& read) const noexcept { return read.mapping_quality() == 0; }
@@ -259,8 +279,9 @@ ReadMap ReadPipe::fetch_reads(const GenomicRegion& region, boost::optional<Repor
                 erase_filtered_reads(batch_reads, filter(batch_reads, filterer_));
             }
         }
+        if (!fragment_size_) sort_mapped_region_ties(batch_reads);
         if (downsampler_) {
-            auto reads = make_mappable_map(std::move(batch_reads));
+            auto reads = make_read_map(std::move(batch_reads));
             auto downsample_reports = downsample(reads, *downsampler_);
             if (debug_log_) stream(*debug_log_) << "Downsampling removed " << count_downsampled_reads(downsample_reports) << " reads from " << region;
             if (report) {
@@ -13,6 +13,7 @@
 #include <algorithm>
 #include <numeric>
 #include <limits>
+#include <cassert>
 
 namespace octopus {
 
@@ -21,21 +22,26 @@ constexpr auto num_kmers(const unsigned char k) noexcept
     return 2 << (2 * static_cast<std::size_t>(k) - 1);
 }
 
+namespace detail {
+
+constexpr std::array<std::uint8_t, 128> baseHashTable
+{
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+} // namespace detail
+
 template <typename T = short>
 constexpr auto perfect_hash(const char base) noexcept
 {
-    constexpr std::array<T, 128> hashTable
-    {
-        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-        0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0,
-        0, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
-    };
-    return hashTable[base];
+    return static_cast<T>(detail::baseHashTable[base]);
 }
 
 using KmerHashType = std::uint_fast32_t;
@@ -52,6 +58,23 @@ constexpr auto perfect_kmer_hash(InputIt first)
                            });
 }
 
+namespace detail {
+
+// The hash of each k-mer is the previous one shifted by one base, with the new last base added
+template <unsigned char K, typename OutputIt>
+void rolling_kmer_hashes(const std::string& sequence, OutputIt result)
+{
+    constexpr unsigned lastBaseShift {2 * (static_cast<unsigned>(K) - 1)};
+    auto hash = perfect_kmer_hash<K>(std::cbegin(sequence));
+    *result++ = hash;
+    for (auto it = std::next(std::cbegin(sequence), K); it != std::cend(sequence); ++it) {
+        hash = (hash >> 2) | (static_cast<KmerHashType>(perfect_hash<KmerHashType>(*it)) << lastBaseShift);
+        *result++ = hash;
+    }
+}
+
+} // namespace detail
+
 using KmerPerfectHashes = std::vector<KmerHashType>;
 
 template <unsigned char K>
@@ -61,40 +84,69 @@ auto compute_kmer_hashes(const std::string& sequence)
         return KmerPerfectHashes {};
     }
     KmerPerfectHashes result(sequence.size() - K + 1);
-    auto result_it = std::begin(result);
-    for (auto it = std::cbegin(sequence); it != std::prev(std::cend(sequence), K - 1); ++it, ++result_it) {
-        *result_it = perfect_kmer_hash<K>(it);
-    }
+    detail::rolling_kmer_hashes<K>(sequence, std::begin(result));
     return result;
 }
 
-using KmerHashTable = std::pair<std::vector<std::vector<std::size_t>>, std::size_t>;
+// Overwrites result, so the caller can choose the container and its allocator
+template <unsigned char K, typename Container>
+void compute_kmer_hashes(const std::string& sequence, Container& result)
+{
+    if (sequence.size() < K) {
+        result.clear();
+        return;
+    }
+    result.resize(sequence.size() - K + 1);
+    detail::rolling_kmer_hashes<K>(sequence, std::begin(result));
+}
+
+// A flat (CSR) index of the k-mers in a target sequence: the target indices of the k-mers with hash h are
+// positions[offsets[h]] to positions[offsets[h + 1]], in ascending order. Tables are reused between targets
+// so that populating one does not allocate once the buffers are large enough.
+struct KmerHashTable
+{
+    using IndexType = std::uint32_t;
+    std::vector<IndexType> offsets = {};
+    std::vector<IndexType> positions = {};
+    std::vector<KmerHashType> hashes = {}; // buffer for populate
+    std::size_t num_indices = 0;
+};
 
 template <unsigned char K>
 KmerHashTable init_kmer_hash_table()
 {
-    return std::make_pair(std::vector<std::vector<std::size_t>> {num_kmers(K), std::vector<std::size_t> {}}, 0);
+    KmerHashTable result {};
+    result.offsets.assign(num_kmers(K) + 1, 0);
+    return result;
 }
 
 inline void clear_kmer_hash_table(KmerHashTable& table)
 {
-    for (auto& bin : table.first) bin.clear();
-    table.second = 0;
+    std::fill(std::begin(table.offsets), std::end(table.offsets), 0);
+    table.positions.clear();
+    table.num_indices = 0;
 }
 
 template <unsigned char K>
 void populate_kmer_hash_table(const std::string& sequence, KmerHashTable& result)
 {
     if (sequence.size() < K) {
+        clear_kmer_hash_table(result);
         return;
     }
-    const auto last_index = sequence.size() - K;
-    auto it = std::cbegin(sequence);
-    for (std::size_t index {0}; index <= last_index; ++index, ++it) {
-        result.first[perfect_kmer_hash<K>(it)].push_back(index);
+    compute_kmer_hashes<K>(sequence, result.hashes);
+    // Counting sort of target indices by k-mer hash
+    std::fill(std::begin(result.offsets), std::end(result.offsets), 0);
+    for (const auto hash : result.hashes) ++result.offsets[hash + 1];
+    std::partial_sum(std::cbegin(result.offsets), std::cend(result.offsets), std::begin(result.offsets));
+    result.positions.resize(result.hashes.size());
+    for (std::size_t index {0}; index < result.hashes.size(); ++index) {
+        // offsets[hash] is used as the insert position and is restored afterwards
+        result.positions[result.offsets[result.hashes[index]]++] = static_cast<KmerHashTable::IndexType>(index);
     }
-    for (auto& bin : result.first) bin.shrink_to_fit();
-    result.second = sequence.size() - K + 1;
+    std::copy_backward(std::cbegin(result.offsets), std::prev(std::cend(result.offsets)), std::end(result.offsets));
+    result.offsets.front() = 0;
+    result.num_indices = result.hashes.size();
 }
 
 template <unsigned char K>
@@ -109,7 +161,7 @@ using MappedIndexCounts = std::vector<unsigned>;
 
 inline MappedIndexCounts init_mapping_counts(const KmerHashTable& target)
 {
-    return MappedIndexCounts(target.second, 0);
+    return MappedIndexCounts(target.num_indices, 0);
 }
 
 inline void reset_mapping_counts(MappedIndexCounts& mapping_counts)
@@ -117,44 +169,50 @@ inline void reset_mapping_counts(MappedIndexCounts& mapping_counts)
     std::fill(std::begin(mapping_counts), std::end(mapping_counts), 0);
 }
 
-template <typename OutputIt>
-OutputIt map_query_to_target(const KmerPerfectHashes& query, const KmerHashTable& target,
+// Writes the target indices that most query k-mers vote for, in ascending order. mapping_counts must be
+// zeroed on entry, and is left zeroed.
+template <typename KmerHashes, typename OutputIt>
+OutputIt map_query_to_target(const KmerHashes& query, const KmerHashTable& target,
                              MappedIndexCounts& mapping_counts, OutputIt result,
                              std::size_t max_mapping_positions = std::numeric_limits<std::size_t>::max())
 {
+    assert(mapping_counts.size() >= target.num_indices);
+    const auto counts = mapping_counts.data();
+    const auto positions = target.positions.data();
+    const auto offsets = target.offsets.data();
     unsigned max_hit_count {0};
-    std::size_t first_max_hit_index {0};
-    unsigned num_max_hits {0};
+    std::size_t first_max_hit_index {0}, num_max_hits {0};
+    std::size_t first_voted {target.num_indices}, last_voted {0};
     for (std::size_t query_index {0}; query_index < query.size(); ++query_index) {
-        for (const auto target_index : target.first[query[query_index]]) {
-            if (target_index >= query_index) {
-                const auto mapping_begin = target_index - query_index;
-                if (++mapping_counts[mapping_begin] > max_hit_count) {
-                    max_hit_count = mapping_counts[mapping_begin];
-                    first_max_hit_index = mapping_begin;
-                    num_max_hits = 1;
-                } else if (mapping_counts[mapping_begin] == max_hit_count) {
-                    ++num_max_hits;
-                    if (mapping_begin < first_max_hit_index) {
-                        first_max_hit_index = mapping_begin;
-                    }
-                }
+        auto position = positions + offsets[query[query_index]];
+        const auto last_position = positions + offsets[query[query_index] + 1];
+        // Positions are sorted and buckets are usually tiny, so skip the ones mapping before the target linearly
+        while (position != last_position && *position < query_index) ++position;
+        if (position == last_position) continue;
+        first_voted = std::min(first_voted, static_cast<std::size_t>(*position - query_index));
+        for (; position != last_position; ++position) {
+            const auto mapping_begin = *position - query_index;
+            const auto count = ++counts[mapping_begin];
+            if (count > max_hit_count) {
+                max_hit_count = count;
+                first_max_hit_index = mapping_begin;
+                num_max_hits = 1;
+            } else if (count == max_hit_count) {
+                ++num_max_hits;
+                first_max_hit_index = std::min(first_max_hit_index, static_cast<std::size_t>(mapping_begin));
             }
         }
+        last_voted = std::max(last_voted, static_cast<std::size_t>(*std::prev(last_position) - query_index) + 1);
     }
-    if (max_hit_count > 0) {
-        *result++ = first_max_hit_index++;
-        --num_max_hits;
-        --max_mapping_positions;
-        while (max_mapping_positions > 0 && num_max_hits > 0) {
-            if (mapping_counts[first_max_hit_index] == max_hit_count) {
-                *result++ = first_max_hit_index;
-                --num_max_hits;
-                --max_mapping_positions;
-            }
-            ++first_max_hit_index;
+    for (auto i = first_max_hit_index; num_max_hits > 0 && max_mapping_positions > 0; ++i) {
+        if (counts[i] == max_hit_count) {
+            *result++ = i;
+            --num_max_hits;
+            --max_mapping_positions;
         }
     }
+    // Only the voted range needs clearing, which is a single contiguous fill
+    if (first_voted < last_voted) std::fill(counts + first_voted, counts + last_voted, 0);
     return result;
 }
 
@@ -0,0 +1,67 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include "memory_arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cassert>
+
+namespace octopus {
+
+MemoryArena::MemoryArena(const std::size_t block_size)
+: blocks_ {}
+, block_size_ {block_size}
+, current_block_ {0}
+, offset_ {0}
+, usage_ {0}
+, stats_ {0, 0, 0, 0}
+{}
+
+namespace {
+
+std::size_t align_offset(const char* block, const std::size_t offset, const std::size_t alignment) noexcept
+{
+    const auto address = reinterpret_cast<std::uintptr_t>(block) + offset;
+    return offset + (alignment - address % alignment) % alignment;
+}
+
+} // namespace
+
+void* MemoryArena::allocate(const std::size_t bytes, const std::size_t alignment)
+{
+    assert(alignment > 0);
+    ++stats_.num_allocations;
+    // Reuse blocks from before the last reset first
+    for (; current_block_ < blocks_.size(); ++current_block_, offset_ = 0) {
+        auto& block = blocks_[current_block_];
+        const auto begin = align_offset(block.data.get(), offset_, alignment);
+        if (begin + bytes <= block.size) {
+            usage_ += begin + bytes - offset_;
+            stats_.peak_usage = std::max(stats_.peak_usage, usage_);
+            offset_ = begin + bytes;
+            return block.data.get() + begin;
+        }
+    }
+    const auto size = std::max(block_size_, bytes + alignment);
+    blocks_.push_back({std::make_unique<char[]>(size), size});
+    ++stats_.num_blocks;
+    stats_.capacity += size;
+    current_block_ = blocks_.size() - 1;
+    offset_ = 0;
+    return allocate(bytes, alignment);
+}
+
+void MemoryArena::reset() noexcept
+{
+    current_block_ = 0;
+    offset_ = 0;
+    usage_ = 0;
+}
+
+MemoryArena::Stats MemoryArena::stats() const noexcept
+{
+    return stats_;
+}
+
+} // namespace octopus
@@ -0,0 +1,107 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef memory_arena_hpp
+#define memory_arena_hpp
+
+#include <cstddef>
+#include <vector>
+#include <memory>
+
+namespace octopus {
+
+/*
+    MemoryArena is a monotonic allocator for short lived working memory. Allocation is a pointer
+    bump and deallocation is a no-op; all memory is released at once by reset, which keeps the
+    underlying blocks for reuse. MemoryArena is not thread-safe.
+ */
+class MemoryArena
+{
+public:
+    struct Stats
+    {
+        std::size_t num_allocations; // served by the arena
+        std::size_t num_blocks;      // allocated from the heap
+        std::size_t capacity;        // bytes held by all blocks
+        std::size_t peak_usage;      // most bytes in use between resets
+    };
+
+    MemoryArena() : MemoryArena {defaultBlockSize_} {}
+
+    MemoryArena(std::size_t block_size);
+
+    MemoryArena(const MemoryArena&)            = delete;
+    MemoryArena& operator=(const MemoryArena&) = delete;
+    MemoryArena(MemoryArena&&)                 = delete;
+    MemoryArena& operator=(MemoryArena&&)      = delete;
+
+    ~MemoryArena() = default;
+
+    void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t));
+
+    // Invalidates all memory allocated since the last reset
+    void reset() noexcept;
+
+    Stats stats() const noexcept;
+
+private:
+    static constexpr std::size_t defaultBlockSize_ {1'048'576};
+
+    struct Block
+    {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+    };
+
+    std::vector<Block> blocks_;
+    std::size_t block_size_, current_block_, offset_, usage_;
+    Stats stats_;
+};
+
+// A standard allocator that allocates from a MemoryArena, or from the heap if it has no arena
+template <typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    ArenaAllocator() noexcept = default;
+    ArenaAllocator(MemoryArena* arena) noexcept : arena_ {arena} {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_ {other.arena()} {}
+
+    T* allocate(std::size_t n)
+    {
+        if (arena_) {
+            return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+        } else {
+            return std::allocator<T> {}.allocate(n);
+        }
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        if (!arena_) std::allocator<T> {}.deallocate(p, n);
+    }
+
+    MemoryArena* arena() const noexcept { return arena_; }
+
+private:
+    MemoryArena* arena_ = nullptr;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) noexcept
+{
+    return lhs.arena() == rhs.arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+
+} // namespace octopus
+
+#endif
@@ -11,28 +11,60 @@
 #include <cstddef>
 #include <utility>
 #include <type_traits>
+#include <exception>
 
 #include "thread_pool.hpp"
 
 namespace octopus {
 
+/*
+    parallel_transform evaluates elements concurrently on the thread pool the calling thread is a
+    worker of (see ThreadPool::current), so nested parallelism stays within the pool's thread budget.
+    The calling thread evaluates the first element itself and helps with pending work while waiting
+    for the rest. If the calling thread is not a pool worker the transform is sequential.
+ */
+
 namespace detail {
 
+// Every future is waited on before returning or rethrowing the first exception, as tasks may
+// reference the caller's state
+template <typename T, typename OutputIt>
+OutputIt collect(std::vector<std::future<T>>& futures, OutputIt result, ThreadPool& pool,
+                 std::exception_ptr error = nullptr)
+{
+    for (auto& f : futures) {
+        try {
+            auto value = pool.wait(f);
+            if (!error) *result++ = std::move(value);
+        } catch (...) {
+            if (!error) error = std::current_exception();
+        }
+    }
+    if (error) std::rethrow_exception(error);
+    return result;
+}
+
 template <typename InputIt,
           typename OutputIt,
           typename UnaryOp>
 OutputIt parallel_transform(InputIt first, InputIt last, OutputIt result, UnaryOp op,
                             std::random_access_iterator_tag)
 {
-    using value_type  = typename std::iterator_traits<InputIt>::value_type;
-    using result_type = std::result_of_t<UnaryOp(value_type)>;
-    std::vector<std::future<result_type>> results(std::distance(first, last));
-    std::transform(first, last, std::begin(results),
-                   [&op](const auto& value) {
-                       return std::async(std::launch::async, op, std::cref(value));
-                   });
-    return std::transform(std::begin(results), std::end(results), result,
-                          [](auto& f) { return f.get(); });
+    auto pool = ThreadPool::current();
+    if (!pool || std::distance(first, last) < 2) return std::transform(first, last, result, std::move(op));
+    using result_type = std::decay_t<decltype(op(*first))>;
+    std::vector<std::future<result_type>> results {};
+    results.reserve(std::distance(first, last) - 1);
+    for (auto itr = std::next(first); itr != last; ++itr) {
+        results.push_back(pool->push([&op, itr] () { return op(*itr); }));
+    }
+    std::exception_ptr error {};
+    try {
+        *result++ = op(*first);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    return collect(results, result, *pool, error);
 }
 
 template <typename InputIt,
@@ -51,16 +83,21 @@ template <typename InputIt1,
 OutputIt parallel_transform(InputIt1 first1, InputIt1 last1, InputIt2 first2, OutputIt result, BinaryOp op,
                             std::random_access_iterator_tag, std::random_access_iterator_tag)
 {
-    using value_type1  = typename std::iterator_traits<InputIt1>::value_type;
-    using value_type2  = typename std::iterator_traits<InputIt2>::value_type;
-    using result_type = std::result_of_t<BinaryOp(value_type1, value_type2)>;
-    std::vector<std::future<result_type>> results(std::distance(first1, last1));
-    std::transform(first1, last1, first2, std::begin(results),
-                   [&op](const auto& a, const auto& b) {
-                       return std::async(std::launch::async, op, std::cref(a), std::cref(b));
-                   });
-    return std::transform(std::begin(results), std::end(results), result,
-                          [](auto& f) { return f.get(); });
+    auto pool = ThreadPool::current();
+    if (!pool || std::distance(first1, last1) < 2) return std::transform(first1, last1, first2, result, std::move(op));
+    using result_type = std::decay_t<decltype(op(*first1, *first2))>;
+    std::vector<std::future<result_type>> results {};
+    results.reserve(std::distance(first1, last1) - 1);
+    for (auto itr1 = std::next(first1), itr2 = std::next(first2); itr1 != last1; ++itr1, ++itr2) {
+        results.push_back(pool->push([&op, itr1, itr2] () { return op(*itr1, *itr2); }));
+    }
+    std::exception_ptr error {};
+    try {
+        *result++ = op(*first1, *first2);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    return collect(results, result, *pool, error);
 }
 
 template <typename InputIt1,
@@ -110,8 +147,7 @@ OutputIt transform(InputIt first, InputIt last, OutputIt result, UnaryOp op, Thr
                    [&op, &pool](const auto& value) {
                        return pool.push(op, std::cref(value));
                    });
-    return std::transform(std::begin(results), std::end(results), result,
-                          [](auto& f) { return f.get(); });
+    return collect(results, result, pool);
 }
 
 template <typename InputIt,
@@ -138,8 +174,7 @@ OutputIt transform(InputIt1 first1, InputIt1 last1, InputIt2 first2, OutputIt re
                    [&op, &pool](const auto& a, const auto& b) {
                        return pool.push(op, std::cref(a), std::cref(b));
                    });
-    return std::transform(std::begin(results), std::end(results), result,
-                          [](auto& f) { return f.get(); });
+    return collect(results, result, pool);
 }
 
 template <typename InputIt1,
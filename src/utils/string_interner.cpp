@@ -0,0 +1,63 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include "string_interner.hpp"
+
+#include <unordered_set>
+#include <shared_mutex>
+#include <mutex>
+#include <utility>
+
+namespace octopus {
+
+namespace {
+
+struct InternedStrings
+{
+    std::shared_timed_mutex mutex;
+    std::unordered_set<std::string> strings;
+};
+
+auto& interned_strings()
+{
+    // Never destroyed so references stay valid during static destruction
+    static auto* result = new InternedStrings {};
+    return *result;
+}
+
+const std::string& empty_string()
+{
+    static const std::string result {};
+    return result;
+}
+
+const std::string* find_interned(InternedStrings& interned, const std::string& str)
+{
+    std::shared_lock<std::shared_timed_mutex> lock {interned.mutex};
+    const auto itr = interned.strings.find(str);
+    return itr != std::cend(interned.strings) ? &(*itr) : nullptr;
+}
+
+} // namespace
+
+const std::string& intern(const std::string& str)
+{
+    if (str.empty()) return empty_string();
+    auto& interned = interned_strings();
+    const auto result = find_interned(interned, str);
+    if (result) return *result;
+    std::lock_guard<std::shared_timed_mutex> lock {interned.mutex};
+    return *interned.strings.insert(str).first;
+}
+
+const std::string& intern(std::string&& str)
+{
+    if (str.empty()) return empty_string();
+    auto& interned = interned_strings();
+    const auto result = find_interned(interned, str);
+    if (result) return *result;
+    std::lock_guard<std::shared_timed_mutex> lock {interned.mutex};
+    return *interned.strings.insert(std::move(str)).first;
+}
+
+} // namespace octopus
@@ -0,0 +1,22 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef string_interner_hpp
+#define string_interner_hpp
+
+#include <string>
+
+namespace octopus {
+
+/*
+ Returns a reference to a single stored copy of str. Interned strings live until the program exits, so
+ the returned reference is always valid, and equal strings always have the same address.
+
+ Only intern strings drawn from a small set, like contig names and read groups.
+ */
+const std::string& intern(const std::string& str);
+const std::string& intern(std::string&& str);
+
+} // namespace octopus
+
+#endif
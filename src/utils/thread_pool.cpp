@@ -5,29 +5,31 @@
 
 namespace octopus {
 
+namespace {
+
+thread_local ThreadPool* current_pool {nullptr};
+thread_local std::size_t current_worker {0};
+
+} // namespace
+
 ThreadPool::ThreadPool() : ThreadPool {0} {}
 
 ThreadPool::ThreadPool(const std::size_t n_threads)
-: stop_ {false}
+: worker_queues_ {}
+, shared_queue_ {}
+, stop_ {false}
 , n_idle_ {n_threads}
+, n_pending_ {0}
+, n_progress_ {0}
+, n_waiting_ {0}
 {
+    worker_queues_.reserve(n_threads);
+    for (std::size_t i {0}; i < n_threads; ++i) {
+        worker_queues_.push_back(std::make_unique<TaskQueue>());
+    }
     workers_.reserve(n_threads);
     for (std::size_t i {0}; i < n_threads; ++i) {
-        workers_.emplace_back([this] {
-            std::function<void()> task;
-            while (true) {
-                std::unique_lock<std::mutex> lk {mutex_};
-                cv_.wait(lk, [this] () { return stop_ || !tasks_.empty(); });
-                if (stop_ && tasks_.empty()) return;
-                task = std::move(tasks_.front());
-                tasks_.pop();
-                --n_idle_;
-                lk.unlock();
-                task();
-                lk.lock();
-                ++n_idle_;
-            }
-        });
+        workers_.emplace_back([this, i] { work(i); });
     }
 }
 
@@ -38,6 +40,7 @@ ThreadPool::~ThreadPool() noexcept
         stop_ = true;
     }
     cv_.notify_all();
+    progress_cv_.notify_all();
     for (auto& worker : workers_) {
         if (worker.joinable()) worker.join();
     }
@@ -60,8 +63,126 @@ std::size_t ThreadPool::n_idle() const noexcept
 
 void ThreadPool::clear() noexcept
 {
-    std::lock_guard<std::mutex> lk {mutex_};
-    while (!tasks_.empty()) tasks_.pop();
+    const auto clear_queue = [this] (TaskQueue& queue) {
+        std::lock_guard<std::mutex> lk {queue.mutex};
+        n_pending_ -= queue.tasks.size();
+        queue.tasks.clear();
+    };
+    clear_queue(shared_queue_);
+    for (auto& queue : worker_queues_) clear_queue(*queue);
+}
+
+bool ThreadPool::run_pending_task()
+{
+    Task task;
+    if (try_pop(task, current_pool != this)) {
+        run(task);
+        return true;
+    }
+    return false;
+}
+
+ThreadPool* ThreadPool::current() noexcept
+{
+    return current_pool;
+}
+
+// private methods
+
+void ThreadPool::enqueue(Task task)
+{
+    auto& queue = current_pool == this ? *worker_queues_[current_worker] : shared_queue_;
+    ++n_pending_; // before the task is visible so the count never underflows
+    {
+        std::lock_guard<std::mutex> lk {queue.mutex};
+        queue.tasks.push_back(std::move(task));
+    }
+    ++n_progress_; // a waiting worker may be able to help with the new task
+    {
+        // Makes sure a worker about to sleep sees the new task
+        std::lock_guard<std::mutex> lk {mutex_};
+    }
+    cv_.notify_one();
+    if (n_waiting_ > 0) progress_cv_.notify_all();
+}
+
+bool ThreadPool::try_pop(Task& task, const bool include_shared)
+{
+    if (n_pending_ == 0) return false;
+    const bool is_worker {current_pool == this};
+    if (is_worker && try_pop_back(*worker_queues_[current_worker], task)) return true;
+    const auto n_queues = worker_queues_.size();
+    const auto first_victim = is_worker ? current_worker + 1 : 0;
+    for (std::size_t i {0}; i < n_queues; ++i) {
+        if (try_pop_front(*worker_queues_[(first_victim + i) % n_queues], task)) return true;
+    }
+    return include_shared && try_pop_front(shared_queue_, task);
+}
+
+bool ThreadPool::try_pop_front(TaskQueue& queue, Task& task)
+{
+    std::lock_guard<std::mutex> lk {queue.mutex};
+    if (queue.tasks.empty()) return false;
+    task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    --n_pending_;
+    return true;
+}
+
+bool ThreadPool::try_pop_back(TaskQueue& queue, Task& task)
+{
+    std::lock_guard<std::mutex> lk {queue.mutex};
+    if (queue.tasks.empty()) return false;
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    --n_pending_;
+    return true;
+}
+
+void ThreadPool::run(Task& task)
+{
+    task();
+    task = nullptr;
+    notify_progress();
+}
+
+void ThreadPool::notify_progress()
+{
+    ++n_progress_;
+    if (n_waiting_ > 0) {
+        {
+            // Makes sure a thread about to sleep in wait_for_progress sees the progress
+            std::lock_guard<std::mutex> lk {mutex_};
+        }
+        progress_cv_.notify_all();
+    }
+}
+
+void ThreadPool::wait_for_progress(const std::size_t last_progress)
+{
+    // Results fulfilled by threads outside the pool do not signal progress, so the sleep is bounded
+    std::unique_lock<std::mutex> lk {mutex_};
+    ++n_waiting_;
+    progress_cv_.wait_for(lk, std::chrono::milliseconds {10}, [&] () { return stop_ || n_progress_ != last_progress; });
+    --n_waiting_;
+}
+
+void ThreadPool::work(const std::size_t index)
+{
+    current_pool = this;
+    current_worker = index;
+    Task task;
+    while (true) {
+        if (try_pop(task, true)) {
+            --n_idle_;
+            run(task);
+            ++n_idle_;
+            continue;
+        }
+        std::unique_lock<std::mutex> lk {mutex_};
+        cv_.wait(lk, [this] () { return stop_ || n_pending_ > 0; });
+        if (stop_ && n_pending_ == 0) return;
+    }
 }
 
 } // namespace octopus
@@ -1,14 +1,12 @@
 // Copyright (c) 2015-2019 Daniel Cooke
 // Use of this source code is governed by the MIT license that can be found in the LICENSE file.
 
-// This thread pool implementation is mostly derived from https://github.com/progschj/ThreadPool
-
 #ifndef thread_pool_hpp
 #define thread_pool_hpp
 
 #include <cstddef>
 #include <vector>
-#include <queue>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <thread>
@@ -16,42 +14,86 @@
 #include <condition_variable>
 #include <future>
 #include <atomic>
+#include <chrono>
 #include <type_traits>
 #include <utility>
 #include <exception>
 
 namespace octopus {
 
+/*
+    ThreadPool is a work-stealing executor. Each worker has its own task queue; tasks pushed by a
+    worker go to the back of that worker's queue, and tasks pushed by any other thread go to a shared
+    queue. Workers run their own most recently pushed tasks first, then steal the oldest tasks of other
+    workers, and only then start tasks from the shared queue, so nested work is finished before new
+    top level work is started.
+
+    Nested parallelism does not need more threads than the pool has: a task that waits on tasks it
+    pushed should use wait, which runs other pending nested work while the result is not ready, and
+    otherwise sleeps until a task finishes or new work is pushed.
+ */
 class ThreadPool
 {
 public:
     ThreadPool();
     explicit ThreadPool(std::size_t n_threads);
-    
+
     ThreadPool(const ThreadPool&)             = delete;
     ThreadPool& operator=(const ThreadPool&)  = delete;
     ThreadPool(ThreadPool&& other) noexcept   = delete;
     ThreadPool& operator=(ThreadPool&& other) = delete;
-    
+
     ~ThreadPool() noexcept;
-    
+
     std::size_t size() const noexcept;
     bool empty() const noexcept;
     std::size_t n_idle() const noexcept;
-    
+
     void clear() noexcept;
-    
+
     template <typename F, typename... Args>
     auto push(F&& f, Args&&... args) -> std::future<std::result_of_t<F(Args...)>>;
-    
+
+    // Runs one pending task on the calling thread if there is one. Workers of this pool only run
+    // nested work, never tasks from the shared queue.
+    bool run_pending_task();
+
+    // Workers of this pool run other nested work while the result is not ready. Other threads just
+    // block, unless the pool has no threads, in which case they run pending tasks themselves.
+    template <typename T>
+    T wait(std::future<T>& result);
+
+    // The pool the calling thread is a worker of, or nullptr
+    static ThreadPool* current() noexcept;
+
 private:
+    using Task = std::function<void()>;
+
+    struct TaskQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<TaskQueue>> worker_queues_;
+    TaskQueue shared_queue_;
+
     std::mutex mutex_;
-    std::condition_variable cv_;
+    std::condition_variable cv_, progress_cv_;
     std::atomic<bool> stop_;
-    std::atomic<std::size_t> n_idle_;
-    
+    std::atomic<std::size_t> n_idle_, n_pending_;
+    std::atomic<std::size_t> n_progress_, n_waiting_; // tasks pushed or finished, and threads sleeping in wait
+
     std::vector<std::thread> workers_;
-    std::queue<std::function<void()>> tasks_;
+
+    void enqueue(Task task);
+    bool try_pop(Task& task, bool include_shared);
+    bool try_pop_front(TaskQueue& queue, Task& task);
+    bool try_pop_back(TaskQueue& queue, Task& task);
+    void run(Task& task);
+    void notify_progress();
+    void wait_for_progress(std::size_t last_progress);
+    void work(std::size_t index);
 };
 
 template <typename F, typename... Args>
@@ -60,15 +102,27 @@ auto ThreadPool::push(F&& f, Args&&... args) -> std::future<std::result_of_t<F(A
     using f_result_type = std::result_of_t<F(Args...)>;
     auto task = std::make_shared<std::packaged_task<f_result_type()>>(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
     auto result = task->get_future();
-    {
-        std::lock_guard<std::mutex> lk {mutex_};
-        if (stop_) throw std::runtime_error {"ThreadPool: calling push on stopped pool"};
-        tasks_.emplace([task] () { (*task)(); });
-    }
-    cv_.notify_one();
+    if (stop_) throw std::runtime_error {"ThreadPool: calling push on stopped pool"};
+    enqueue([task] () { (*task)(); });
     return result;
 }
 
+template <typename T>
+T ThreadPool::wait(std::future<T>& result)
+{
+    if (current() != this && !empty()) return result.get();
+    while (true) {
+        // Read before checking the result so progress made in between is never missed
+        const std::size_t last_progress {n_progress_};
+        if (result.wait_for(std::chrono::seconds {0}) == std::future_status::ready) break;
+        if (!run_pending_task()) {
+            // Whatever result depends on is running on another thread
+            wait_for_progress(last_progress);
+        }
+    }
+    return result.get();
+}
+
 } // namespace octopus
 
 #endif
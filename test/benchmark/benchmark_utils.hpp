@@ -11,7 +11,7 @@ D benchmark(F f, unsigned num_tests)
 {
     D total {0};
     
-    for (; num_tests > 0; --num_tests) {
+    for (auto n = num_tests; n > 0; --n) {
         const auto start = std::chrono::system_clock::now();
         f();
         const auto end = std::chrono::system_clock::now();
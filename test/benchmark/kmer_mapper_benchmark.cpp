@@ -0,0 +1,135 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+// Measures read to haplotype k-mer mapping throughput with the flat k-mer index, against the previous
+// layout of one heap allocated bucket per k-mer.
+// Each test indexes every haplotype in turn and maps all reads to it, as when computing haplotype likelihoods.
+// Usage: kmer_mapper_benchmark [haplotype_length] [read_length] [num_reads] [num_haplotypes] [num_tests]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+
+#include "utils/kmer_mapper.hpp"
+
+#include "benchmark_utils.hpp"
+
+namespace {
+
+constexpr unsigned char K {6};
+
+using BucketTable = std::vector<std::vector<std::size_t>>;
+
+void populate_bucket_table(const std::string& sequence, BucketTable& result)
+{
+    for (auto& bucket : result) bucket.clear();
+    const auto hashes = octopus::compute_kmer_hashes<K>(sequence);
+    for (std::size_t i {0}; i < hashes.size(); ++i) result[hashes[i]].push_back(i);
+    for (auto& bucket : result) bucket.shrink_to_fit();
+}
+
+template <typename OutputIt>
+OutputIt map_with_bucket_table(const octopus::KmerPerfectHashes& query, const BucketTable& target,
+                               std::vector<unsigned>& counts, OutputIt result, std::size_t max_mapping_positions)
+{
+    unsigned max_hit_count {0};
+    std::size_t first_max_hit_index {0};
+    unsigned num_max_hits {0};
+    for (std::size_t query_index {0}; query_index < query.size(); ++query_index) {
+        for (const auto target_index : target[query[query_index]]) {
+            if (target_index >= query_index) {
+                const auto mapping_begin = target_index - query_index;
+                if (++counts[mapping_begin] > max_hit_count) {
+                    max_hit_count = counts[mapping_begin];
+                    first_max_hit_index = mapping_begin;
+                    num_max_hits = 1;
+                } else if (counts[mapping_begin] == max_hit_count) {
+                    ++num_max_hits;
+                    first_max_hit_index = std::min(first_max_hit_index, mapping_begin);
+                }
+            }
+        }
+    }
+    for (; num_max_hits > 0 && max_mapping_positions > 0; ++first_max_hit_index) {
+        if (counts[first_max_hit_index] == max_hit_count) {
+            *result++ = first_max_hit_index;
+            --num_max_hits;
+            --max_mapping_positions;
+        }
+    }
+    std::fill(std::begin(counts), std::end(counts), 0);
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    using namespace octopus;
+    using std::chrono::microseconds;
+    
+    const std::size_t haplotype_length = argc > 1 ? std::stoul(argv[1]) : 1000;
+    const std::size_t read_length = argc > 2 ? std::stoul(argv[2]) : 150;
+    const std::size_t num_reads = argc > 3 ? std::stoul(argv[3]) : 10000;
+    const std::size_t num_haplotypes = argc > 4 ? std::stoul(argv[4]) : 20;
+    const unsigned num_tests = argc > 5 ? std::stoul(argv[5]) : 5;
+    if (read_length > haplotype_length) {
+        std::cerr << "Read length must not exceed haplotype length" << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    std::mt19937 generator {42};
+    const std::string bases {"ACGT"};
+    std::vector<std::string> haplotypes(num_haplotypes, std::string(haplotype_length, 'A'));
+    for (auto& base : haplotypes.front()) base = bases[generator() % 4];
+    for (auto& haplotype : haplotypes) {
+        haplotype = haplotypes.front();
+        for (int i {0}; i < 5; ++i) haplotype[generator() % haplotype_length] = bases[generator() % 4];
+    }
+    std::vector<KmerPerfectHashes> read_hashes(num_reads);
+    for (auto& hashes : read_hashes) {
+        auto read = haplotypes[generator() % num_haplotypes].substr(generator() % (haplotype_length - read_length + 1), read_length);
+        for (auto& base : read) if (generator() % 100 == 0) base = bases[generator() % 4];
+        hashes = compute_kmer_hashes<K>(read);
+    }
+    
+    std::size_t checksum {0};
+    auto flat_table = init_kmer_hash_table<K>();
+    MappedIndexCounts flat_counts {};
+    std::vector<std::size_t> positions(10);
+    const auto flat_time = benchmark<microseconds>([&] () {
+        for (const auto& haplotype : haplotypes) {
+            populate_kmer_hash_table<K>(haplotype, flat_table);
+            flat_counts.resize(flat_table.num_indices);
+            for (const auto& hashes : read_hashes) {
+                const auto last = map_query_to_target(hashes, flat_table, flat_counts, std::begin(positions), positions.size());
+                if (last != std::begin(positions)) checksum += positions.front();
+            }
+        }
+    }, num_tests);
+    
+    BucketTable bucket_table(num_kmers(K));
+    std::vector<unsigned> bucket_counts(haplotype_length, 0);
+    const auto bucket_time = benchmark<microseconds>([&] () {
+        for (const auto& haplotype : haplotypes) {
+            populate_bucket_table(haplotype, bucket_table);
+            for (const auto& hashes : read_hashes) {
+                const auto last = map_with_bucket_table(hashes, bucket_table, bucket_counts, std::begin(positions), positions.size());
+                if (last != std::begin(positions)) checksum += positions.front();
+            }
+        }
+    }, num_tests);
+    
+    const auto per_read = [&] (const microseconds time) { return 1000.0 * time.count() / (num_reads * num_haplotypes); };
+    std::cout << "Mapped " << num_reads << " reads of length " << read_length << " to each of "
+              << num_haplotypes << " haplotypes of length " << haplotype_length << std::endl;
+    std::cout << "Flat index:   " << per_read(flat_time) << "ns per read per haplotype" << std::endl;
+    std::cout << "Bucket index: " << per_read(bucket_time) << "ns per read per haplotype" << std::endl;
+    std::cout << "(checksum " << checksum << ")" << std::endl;
+    
+    return EXIT_SUCCESS;
+}
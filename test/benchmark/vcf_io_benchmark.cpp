@@ -0,0 +1,44 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+// Measures VCF/BCF read and write throughput, e.g. to compare record representations.
+// Usage: vcf_io_benchmark <input.vcf|bcf> <output.vcf|bcf> [num_tests]
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+
+#include "io/variant/vcf_header.hpp"
+#include "io/variant/vcf_reader.hpp"
+#include "io/variant/vcf_writer.hpp"
+
+#include "benchmark_utils.hpp"
+
+int main(int argc, char** argv)
+{
+    using namespace octopus;
+    using std::chrono::milliseconds;
+    
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <input> <output> [num_tests]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const VcfReader::Path input {argv[1]}, output {argv[2]};
+    const unsigned num_tests = argc > 3 ? std::stoul(argv[3]) : 5;
+    
+    const VcfReader reader {input};
+    const auto header = reader.fetch_header();
+    VcfReader::RecordContainer records {};
+    
+    const auto read_time = benchmark<milliseconds>([&] () { records = reader.fetch_records(); }, num_tests);
+    std::cout << "Read " << records.size() << " records in " << read_time.count() << "ms" << std::endl;
+    
+    const auto write_time = benchmark<milliseconds>([&] () {
+        VcfWriter writer {output, header};
+        for (const auto& record : records) writer.write(record);
+    }, num_tests);
+    std::cout << "Wrote " << records.size() << " records in " << write_time.count() << "ms" << std::endl;
+    
+    return EXIT_SUCCESS;
+}
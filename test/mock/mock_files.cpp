@@ -0,0 +1,157 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include "mock_files.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <memory>
+#include <cstdlib>
+
+#include <boost/filesystem/operations.hpp>
+
+#include "htslib/hts.h"
+#include "htslib/sam.h"
+#include "htslib/vcf.h"
+#include "htslib/faidx.h"
+#include "htslib/tbx.h"
+#include "htslib/kstring.h"
+
+namespace octopus { namespace test { namespace mock {
+
+namespace fs = boost::filesystem;
+
+TemporaryDirectory::TemporaryDirectory()
+: path_ {fs::temp_directory_path() / fs::unique_path("octopus-test-%%%%-%%%%-%%%%")}
+{
+    fs::create_directories(path_);
+}
+
+TemporaryDirectory::~TemporaryDirectory()
+{
+    boost::system::error_code ec {};
+    fs::remove_all(path_, ec);
+}
+
+const Path& TemporaryDirectory::path() const noexcept
+{
+    return path_;
+}
+
+Path TemporaryDirectory::operator/(const std::string& filename) const
+{
+    return path_ / filename;
+}
+
+namespace {
+
+struct HtsFileDeleter
+{
+    void operator()(htsFile* file) const { hts_close(file); }
+};
+
+using HtsFilePtr = std::unique_ptr<htsFile, HtsFileDeleter>;
+
+void write_text(const Path& file, const std::string& text)
+{
+    std::ofstream out {file.string()};
+    out << text;
+    if (!out) throw std::runtime_error {"could not write " + file.string()};
+}
+
+auto open(const Path& file, const char* mode)
+{
+    HtsFilePtr result {hts_open(file.c_str(), mode)};
+    if (!result) throw std::runtime_error {"could not open " + file.string()};
+    return result;
+}
+
+} // namespace
+
+void write_indexed_bam(const Path& bam, const std::string& sam)
+{
+    const auto sam_path = bam.string() + ".sam";
+    write_text(sam_path, sam);
+    {
+        auto in = open(sam_path, "r");
+        auto out = open(bam, "wb");
+        std::unique_ptr<bam_hdr_t, decltype(&bam_hdr_destroy)> header {sam_hdr_read(in.get()), &bam_hdr_destroy};
+        if (!header || sam_hdr_write(out.get(), header.get()) < 0) {
+            throw std::runtime_error {"could not convert " + sam_path};
+        }
+        std::unique_ptr<bam1_t, decltype(&bam_destroy1)> record {bam_init1(), &bam_destroy1};
+        int status;
+        while ((status = sam_read1(in.get(), header.get(), record.get())) >= 0) {
+            if (sam_write1(out.get(), header.get(), record.get()) < 0) {
+                throw std::runtime_error {"could not write " + bam.string()};
+            }
+        }
+        if (status < -1) throw std::runtime_error {"could not parse " + sam_path};
+    }
+    fs::remove(sam_path);
+    if (sam_index_build(bam.c_str(), 0) != 0) {
+        throw std::runtime_error {"could not index " + bam.string()};
+    }
+}
+
+void write_indexed_fasta(const Path& fasta, const std::vector<std::pair<std::string, std::string>>& contigs)
+{
+    std::string text {};
+    for (const auto& contig : contigs) {
+        text += '>' + contig.first + '\n' + contig.second + '\n';
+    }
+    write_text(fasta, text);
+    if (fai_build(fasta.c_str()) != 0) {
+        throw std::runtime_error {"could not index " + fasta.string()};
+    }
+}
+
+void write_packed_reference(const Path& packed, const Path& fasta)
+{
+    const std::string command {"python3 \"" OCTOPUS_SCRIPTS_DIR "/pack_reference.py\" \"" + fasta.string()
+                               + "\" -o \"" + packed.string() + "\""};
+    if (std::system(command.c_str()) != 0) {
+        throw std::runtime_error {"could not pack " + fasta.string()};
+    }
+}
+
+void write_indexed_vcf(const Path& vcf, const std::string& text)
+{
+    const auto text_path = vcf.string() + ".txt";
+    write_text(text_path, text);
+    {
+        auto in = open(text_path, "r");
+        auto out = open(vcf, "wz");
+        std::unique_ptr<bcf_hdr_t, decltype(&bcf_hdr_destroy)> header {bcf_hdr_read(in.get()), &bcf_hdr_destroy};
+        if (!header || bcf_hdr_write(out.get(), header.get()) < 0) {
+            throw std::runtime_error {"could not convert " + text_path};
+        }
+        std::unique_ptr<bcf1_t, decltype(&bcf_destroy)> record {bcf_init(), &bcf_destroy};
+        while (bcf_read(in.get(), header.get(), record.get()) == 0) {
+            if (bcf_write(out.get(), header.get(), record.get()) != 0) {
+                throw std::runtime_error {"could not write " + vcf.string()};
+            }
+        }
+    }
+    fs::remove(text_path);
+    if (tbx_index_build(vcf.c_str(), 0, &tbx_conf_vcf) != 0) {
+        throw std::runtime_error {"could not index " + vcf.string()};
+    }
+}
+
+std::string read_text(const Path& file)
+{
+    auto in = open(file, "r");
+    std::string result {};
+    kstring_t line {0, 0, nullptr};
+    while (hts_getline(in.get(), KS_SEP_LINE, &line) >= 0) {
+        result.append(line.s, line.l);
+        result += '\n';
+    }
+    std::free(line.s);
+    return result;
+}
+
+} // namespace mock
+} // namespace test
+} // namespace octopus
@@ -0,0 +1,56 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef mock_files_hpp
+#define mock_files_hpp
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include <boost/filesystem/path.hpp>
+
+namespace octopus { namespace test { namespace mock {
+
+using Path = boost::filesystem::path;
+
+// A uniquely named directory in the system temporary directory, removed with its contents on destruction
+class TemporaryDirectory
+{
+public:
+    TemporaryDirectory();
+    
+    TemporaryDirectory(const TemporaryDirectory&)            = delete;
+    TemporaryDirectory& operator=(const TemporaryDirectory&) = delete;
+    TemporaryDirectory(TemporaryDirectory&&)                 = delete;
+    TemporaryDirectory& operator=(TemporaryDirectory&&)      = delete;
+    
+    ~TemporaryDirectory();
+    
+    const Path& path() const noexcept;
+    Path operator/(const std::string& filename) const;
+    
+private:
+    Path path_;
+};
+
+// Converts coordinate sorted SAM text to BAM and builds the BAM index
+void write_indexed_bam(const Path& bam, const std::string& sam);
+
+// Writes each contig on a single line and builds the fai index
+void write_indexed_fasta(const Path& fasta, const std::vector<std::pair<std::string, std::string>>& contigs);
+
+// Packs an indexed FASTA with scripts/pack_reference.py
+void write_packed_reference(const Path& packed, const Path& fasta);
+
+// Converts VCF text to a bgzipped VCF and builds the tabix index
+void write_indexed_vcf(const Path& vcf, const std::string& text);
+
+// The full content of a text file, decompressing it first if it is compressed
+std::string read_text(const Path& file);
+
+} // namespace mock
+} // namespace test
+} // namespace octopus
+
+#endif
@@ -53,6 +53,25 @@ BOOST_AUTO_TEST_CASE(can_be_moved)
     BOOST_REQUIRE_NO_THROW(read2 = std::move(read1));
 }
 
+BOOST_AUTO_TEST_CASE(reads_share_read_group_and_next_segment_contig_names)
+{
+    const AlignedRead read1 {
+        "read1", GenomicRegion {"1", 0, 4}, "ACGT", AlignedRead::BaseQualityVector {1, 2, 3, 4},
+        parse_cigar("4M"), 10, AlignedRead::Flags {}, std::string {"sample_read_group"}, "",
+        std::string {"chrUn_KI270742v1"}, 10, 30, AlignedRead::Segment::Flags {}
+    };
+    const AlignedRead read2 {
+        "read2", GenomicRegion {"1", 0, 4}, "ACGT", AlignedRead::BaseQualityVector {1, 2, 3, 4},
+        parse_cigar("4M"), 10, AlignedRead::Flags {}, std::string {"sample_read_group"}, "",
+        std::string {"chrUn_KI270742v1"}, 10, 30, AlignedRead::Segment::Flags {}
+    };
+    BOOST_CHECK_EQUAL(read1.read_group(), "sample_read_group");
+    BOOST_CHECK(&read1.read_group() == &read2.read_group());
+    BOOST_CHECK(&read1.next_segment().contig_name() == &read2.next_segment().contig_name());
+    BOOST_CHECK(read1.next_segment() == read2.next_segment());
+    BOOST_CHECK_EQUAL(copy(read1, GenomicRegion {"1", 1, 3}).read_group(), read1.read_group());
+}
+
 BOOST_AUTO_TEST_CASE(can_copy_read_subregions)
 {
     const AlignedRead read {
@@ -1,4 +1,169 @@
 // Copyright (c) 2017 Daniel Cooke
 // Use of this source code is governed by the MIT license that can be found in the LICENSE file.
 
-#include <stdio.h>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <utility>
+#include <memory>
+#include <random>
+#include <sstream>
+
+#include "config/common.hpp"
+#include "config/option_parser.hpp"
+#include "config/option_collation.hpp"
+#include "basics/genomic_region.hpp"
+#include "io/reference/reference_genome.hpp"
+#include "io/read/read_manager.hpp"
+#include "io/variant/vcf_record.hpp"
+#include "readpipe/read_pipe.hpp"
+#include "logging/progress_meter.hpp"
+#include "utils/read_stats.hpp"
+#include "utils/thread_pool.hpp"
+#include "core/callers/caller.hpp"
+#include "core/callers/caller_factory.hpp"
+#include "mock/mock_files.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(core)
+BOOST_AUTO_TEST_SUITE(callers)
+
+namespace {
+
+const GenomicRegion::Size contig_size {2'000};
+const GenomicRegion::Position snv_position {1'000};
+
+std::string make_reference_sequence()
+{
+    static const std::string bases {"ACGT"};
+    std::mt19937 generator {42};
+    std::uniform_int_distribution<std::size_t> base_dist {0, 3};
+    std::string result(contig_size, 'N');
+    for (auto& base : result) base = bases[base_dist(generator)];
+    return result;
+}
+
+char alt_base(const char ref_base)
+{
+    return ref_base == 'A' ? 'C' : 'A';
+}
+
+// Non-overlapping read starts for each sample so no reads are duplicates. Every nth read of a sample
+// carries an SNV at snv_position, where n is given by each sample's alt_period (0 for no SNV).
+std::string make_sam(const std::string& reference,
+                     const std::vector<std::pair<SampleName, unsigned>>& sample_alt_periods)
+{
+    std::string result {"@HD\tVN:1.4\tSO:coordinate\n@SQ\tSN:1\tLN:" + std::to_string(contig_size) + "\n"};
+    for (const auto& p : sample_alt_periods) {
+        result += "@RG\tID:" + p.first + "\tSM:" + p.first + "\n";
+    }
+    const int read_length {100}, stride {2 * static_cast<int>(sample_alt_periods.size())};
+    std::vector<unsigned> read_counts(sample_alt_periods.size(), 0);
+    for (int begin {500}; begin + read_length < 1'500; begin += stride) {
+        for (std::size_t s {0}; s < sample_alt_periods.size(); ++s) {
+            const auto read_begin = begin + 2 * static_cast<int>(s);
+            auto sequence = reference.substr(read_begin, read_length);
+            const auto alt_period = sample_alt_periods[s].second;
+            const auto read_index = read_counts[s]++;
+            const int snv_offset {static_cast<int>(snv_position) - read_begin};
+            if (alt_period > 0 && read_index % alt_period == 0 && snv_offset >= 0 && snv_offset < read_length) {
+                sequence[snv_offset] = alt_base(sequence[snv_offset]);
+            }
+            const auto& sample = sample_alt_periods[s].first;
+            const auto flag = read_index % 2 == 0 ? "0" : "16";
+            result += sample + std::to_string(read_begin) + "\t" + flag + "\t1\t" + std::to_string(read_begin + 1)
+                      + "\t60\t100M\t*\t0\t0\t" + sequence + "\t" + std::string(read_length, 'I') + "\tRG:Z:" + sample + "\n";
+        }
+    }
+    return result;
+}
+
+// Everything needed to build callers from command line options for a small fixture dataset
+struct CallingFixture
+{
+    CallingFixture(const std::vector<std::pair<SampleName, unsigned>>& sample_alt_periods,
+                   std::vector<std::string> extra_arguments = {})
+    : directory {}
+    , option_map {}
+    , reference {}
+    , read_manager {}
+    , read_pipe {}
+    {
+        const auto sequence = make_reference_sequence();
+        const auto fasta_path = directory / "reference.fa", bam_path = directory / "reads.bam";
+        mock::write_indexed_fasta(fasta_path, {{"1", sequence}});
+        mock::write_indexed_bam(bam_path, make_sam(sequence, sample_alt_periods));
+        std::vector<std::string> arguments {"octopus", "--reference", fasta_path.string(), "--reads", bam_path.string()};
+        arguments.insert(std::cend(arguments), std::cbegin(extra_arguments), std::cend(extra_arguments));
+        std::vector<const char*> argv {};
+        for (const auto& argument : arguments) argv.push_back(argument.c_str());
+        argv.push_back(nullptr);
+        option_map = options::parse_options(static_cast<int>(arguments.size()), argv.data());
+        reference = std::make_unique<ReferenceGenome>(options::make_reference(option_map));
+        read_manager = std::make_unique<ReadManager>(options::make_read_manager(option_map));
+        read_pipe = std::make_unique<ReadPipe>(options::make_read_pipe(*read_manager, *reference, read_manager->samples(), option_map));
+    }
+
+    std::unique_ptr<Caller> make_caller() const
+    {
+        const auto regions = options::get_search_regions(option_map, *reference);
+        return options::make_caller_factory(*reference, *read_pipe, regions, option_map).make("1");
+    }
+
+    mock::TemporaryDirectory directory;
+    options::OptionMap option_map;
+    std::unique_ptr<ReferenceGenome> reference;
+    std::unique_ptr<ReadManager> read_manager;
+    std::unique_ptr<ReadPipe> read_pipe;
+};
+
+std::vector<std::string> to_strings(const std::deque<VcfRecord>& records)
+{
+    std::vector<std::string> result {};
+    result.reserve(records.size());
+    for (const auto& record : records) {
+        std::ostringstream ss {};
+        ss << record;
+        result.push_back(ss.str());
+    }
+    return result;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(prefetched_reads_are_the_same_as_directly_fetched_reads)
+{
+    const CallingFixture fixture {{{"sample", 2}}};
+    const auto caller = fixture.make_caller();
+    const GenomicRegion region {"1", 0, contig_size};
+    ThreadPool workers {2};
+
+    auto prefetched = workers.push([&] () { return caller->prefetch_reads(region); });
+    ProgressMeter progress {region};
+    Caller::ReadMap direct_reads {}, prefetched_reads {};
+    const auto direct_calls = caller->call(region, progress, direct_reads);
+    const auto prefetched_calls = caller->call(region, progress, workers.wait(prefetched), prefetched_reads);
+
+    BOOST_CHECK(count_reads(direct_reads) > 0);
+    BOOST_CHECK(prefetched_reads == direct_reads);
+    BOOST_REQUIRE_EQUAL(direct_calls.size(), 1);
+    BOOST_CHECK(to_strings(prefetched_calls) == to_strings(direct_calls));
+}
+
+BOOST_AUTO_TEST_CASE(prefetched_reads_must_be_for_the_call_region)
+{
+    const CallingFixture fixture {{{"sample", 2}}};
+    const auto caller = fixture.make_caller();
+    ProgressMeter progress {GenomicRegion {"1", 0, contig_size}};
+    auto prefetched = caller->prefetch_reads(GenomicRegion {"1", 0, 1'000});
+    BOOST_CHECK_THROW(caller->call(GenomicRegion {"1", 0, contig_size}, progress, std::move(prefetched)), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
@@ -0,0 +1,170 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+#include <random>
+#include <fstream>
+#include <algorithm>
+#include <iterator>
+#include <cstddef>
+
+#include "ranger/ForestProbability.h"
+#include "ranger/globals.h"
+#include "core/csr/filters/flat_random_forest.hpp"
+#include "utils/thread_pool.hpp"
+#include "mock/mock_files.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(core)
+BOOST_AUTO_TEST_SUITE(filters)
+
+namespace {
+
+// x is ordered, level is an unordered factor with levels 1-4, and noise carries no signal. The class
+// depends on an interaction that needs a factor split grouping levels 1 and 3.
+struct TestData
+{
+    std::vector<double> x, level, noise, label;
+    
+    void add(const double x_value, const double level_value, const double noise_value, const double label_value)
+    {
+        x.push_back(x_value);
+        level.push_back(level_value);
+        noise.push_back(noise_value);
+        label.push_back(label_value);
+    }
+};
+
+TestData make_test_data(const std::size_t num_rows, const unsigned seed)
+{
+    TestData result {};
+    std::mt19937 generator {seed};
+    std::uniform_real_distribution<> value_dist {0, 10};
+    std::uniform_int_distribution<> level_dist {1, 4};
+    std::bernoulli_distribution label_noise {0.1};
+    for (std::size_t i {0}; i < num_rows; ++i) {
+        const auto x = value_dist(generator);
+        const auto level = level_dist(generator);
+        const bool odd_level {level % 2 == 1};
+        const bool label {(x > 5) != odd_level};
+        result.add(x, level, value_dist(generator), label != label_noise(generator));
+    }
+    return result;
+}
+
+// Ranger also expects the label column when predicting, but ignores it
+void write_ranger_data(const mock::Path& path, const TestData& data)
+{
+    std::ofstream file {path.string()};
+    file.precision(17);
+    file << "x level noise label\n";
+    for (std::size_t i {0}; i < data.x.size(); ++i) {
+        file << data.x[i] << ' ' << data.level[i] << ' ' << data.noise[i] << ' ' << data.label[i] << '\n';
+    }
+}
+
+void train_ranger_forest(const mock::Path& data, const mock::Path& output_prefix)
+{
+    ranger::ForestProbability forest {};
+    forest.initCpp("label", ranger::MemoryMode::MEM_DOUBLE, data.string(), 0, output_prefix.string(),
+                   25, nullptr, 42, 1, "", ranger::ImportanceMode::IMP_NONE, 1, "",
+                   {}, "", true, {"level"}, false, ranger::DEFAULT_SPLITRULE, "", false, 1.0,
+                   ranger::DEFAULT_ALPHA, ranger::DEFAULT_MINPROP, false,
+                   ranger::PredictionType::RESPONSE, ranger::DEFAULT_NUM_RANDOM_SPLITS, ranger::DEFAULT_MAXDEPTH);
+    forest.run(false, false);
+    forest.saveToFile();
+}
+
+// Ranger's own predictions, as the probability of each class in the forest's class order
+auto predict_with_ranger(const mock::Path& forest_path, const mock::Path& data, const mock::Path& output_prefix,
+                         std::vector<double>& class_values)
+{
+    ranger::ForestProbability forest {};
+    forest.initCpp("", ranger::MemoryMode::MEM_DOUBLE, data.string(), 0, output_prefix.string(),
+                   1000, nullptr, 12, 1, forest_path.string(), ranger::ImportanceMode::IMP_NONE, 1, "",
+                   {}, "", true, {"level"}, false, ranger::DEFAULT_SPLITRULE, "", false, 1.0,
+                   ranger::DEFAULT_ALPHA, ranger::DEFAULT_MINPROP, false,
+                   ranger::PredictionType::RESPONSE, ranger::DEFAULT_NUM_RANDOM_SPLITS, ranger::DEFAULT_MAXDEPTH);
+    forest.run(false, false);
+    class_values = forest.getClassValues();
+    return forest.getPredictions().front();
+}
+
+auto get_split_values(const mock::Path& forest_path)
+{
+    // Load the forest into ranger just to read back its ordered split thresholds
+    std::vector<double> result {};
+    ranger::ForestProbability forest {};
+    const mock::Path dummy_data {forest_path.string() + ".dummy.dat"};
+    write_ranger_data(dummy_data, make_test_data(1, 0));
+    forest.initCpp("", ranger::MemoryMode::MEM_DOUBLE, dummy_data.string(), 0, forest_path.string() + ".dummy",
+                   1000, nullptr, 12, 1, forest_path.string(), ranger::ImportanceMode::IMP_NONE, 1, "",
+                   {}, "", true, {"level"}, false, ranger::DEFAULT_SPLITRULE, "", false, 1.0,
+                   ranger::DEFAULT_ALPHA, ranger::DEFAULT_MINPROP, false,
+                   ranger::PredictionType::RESPONSE, ranger::DEFAULT_NUM_RANDOM_SPLITS, ranger::DEFAULT_MAXDEPTH);
+    const auto split_variables = forest.getSplitVarIDs();
+    const auto split_values = forest.getSplitValues();
+    for (std::size_t tree {0}; tree < split_values.size(); ++tree) {
+        for (std::size_t node {0}; node < split_values[tree].size(); ++node) {
+            if (split_variables[tree][node] == 0 && split_values[tree][node] != 0) {
+                result.push_back(split_values[tree][node]);
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(flat_random_forest_predictions_match_ranger)
+{
+    mock::TemporaryDirectory directory {};
+    const auto training_data = directory / "train.dat";
+    write_ranger_data(training_data, make_test_data(400, 1));
+    const auto forest_prefix = directory / "test";
+    train_ranger_forest(training_data, forest_prefix);
+    const mock::Path forest_path {forest_prefix.string() + ".forest"};
+    
+    auto test_data = make_test_data(300, 2);
+    // Values exactly on an ordered split threshold must go left, as ranger splits on <=
+    const auto thresholds = get_split_values(forest_path);
+    BOOST_REQUIRE(!thresholds.empty());
+    for (const auto threshold : thresholds) {
+        for (int level {1}; level <= 4; ++level) {
+            test_data.add(threshold, level, 5, 0);
+        }
+    }
+    const auto prediction_data = directory / "predict.dat";
+    write_ranger_data(prediction_data, test_data);
+    std::vector<double> class_values {};
+    const auto expected = predict_with_ranger(forest_path, prediction_data, directory / "prediction", class_values);
+    BOOST_REQUIRE_EQUAL(expected.size(), test_data.x.size());
+    BOOST_REQUIRE_EQUAL(class_values.size(), 2);
+    
+    const csr::FlatRandomForest forest {forest_path};
+    BOOST_CHECK_EQUAL(forest.num_trees(), 25);
+    const std::vector<std::string> variable_names {"x", "level", "noise"};
+    BOOST_REQUIRE(forest.variable_names() == variable_names);
+    const csr::FlatRandomForest::DataColumns columns {test_data.x, test_data.level, test_data.noise};
+    ThreadPool workers {2};
+    for (std::size_t class_idx {0}; class_idx < class_values.size(); ++class_idx) {
+        BOOST_REQUIRE(forest.has_class(class_values[class_idx]));
+        const auto actual = forest.predict(columns, class_values[class_idx]);
+        const auto actual_parallel = forest.predict(columns, class_values[class_idx], workers);
+        BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+        BOOST_CHECK(actual_parallel == actual);
+        for (std::size_t row {0}; row < expected.size(); ++row) {
+            BOOST_CHECK_CLOSE(actual[row], expected[row][class_idx], 1e-9);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
@@ -0,0 +1,79 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "core/types/haplotype.hpp"
+#include "core/types/genotype.hpp"
+#include "core/models/haplotype_likelihood_array.hpp"
+#include "core/models/genotype/constant_mixture_genotype_likelihood_model.hpp"
+#include "mock/mock_reference.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(core)
+BOOST_AUTO_TEST_SUITE(model)
+
+BOOST_AUTO_TEST_CASE(batched_genotype_likelihoods_match_single_genotype_evaluation)
+{
+    const auto reference = mock::make_reference();
+    const GenomicRegion region {"5", 100, 200};
+    const auto reference_sequence = reference.fetch_sequence(region);
+    std::vector<Haplotype> haplotypes {};
+    for (int i {0}; i < 6; ++i) {
+        auto sequence = reference_sequence;
+        sequence[10 * i] = sequence[10 * i] == 'A' ? 'C' : 'A';
+        haplotypes.emplace_back(region, std::move(sequence), reference);
+    }
+    std::mt19937 generator {42};
+    std::uniform_real_distribution<HaplotypeLikelihoodArray::LogProbability> likelihood_distribution {-20, 0};
+    HaplotypeLikelihoodArray haplotype_likelihoods {};
+    for (const auto& haplotype : haplotypes) {
+        HaplotypeLikelihoodArray::LikelihoodVector likelihoods(50);
+        std::generate(std::begin(likelihoods), std::end(likelihoods), [&] () { return likelihood_distribution(generator); });
+        haplotype_likelihoods.insert("sample", haplotype, std::move(likelihoods));
+        haplotype_likelihoods.insert("no_reads", haplotype, HaplotypeLikelihoodArray::LikelihoodVector {});
+    }
+    octopus::model::ConstantMixtureGenotypeLikelihoodModel likelihood_model {haplotype_likelihoods};
+    haplotype_likelihoods.prime("no_reads");
+    for (unsigned ploidy {1}; ploidy <= 4; ++ploidy) {
+        std::vector<GenotypeIndex> genotype_indices {};
+        const auto genotypes = generate_all_genotypes(haplotypes, ploidy, genotype_indices);
+        const auto batched = likelihood_model.evaluate(genotypes);
+        BOOST_REQUIRE_EQUAL(batched.size(), genotypes.size());
+        BOOST_CHECK(std::all_of(std::cbegin(batched), std::cend(batched), [] (auto x) { return x == 0; }));
+        likelihood_model.prime(haplotypes);
+        const auto batched_indices = likelihood_model.evaluate(genotype_indices);
+        BOOST_REQUIRE_EQUAL(batched_indices.size(), genotype_indices.size());
+        BOOST_CHECK(std::all_of(std::cbegin(batched_indices), std::cend(batched_indices), [] (auto x) { return x == 0; }));
+        likelihood_model.unprime();
+    }
+    haplotype_likelihoods.prime("sample");
+    for (unsigned ploidy {1}; ploidy <= 4; ++ploidy) {
+        std::vector<GenotypeIndex> genotype_indices {};
+        const auto genotypes = generate_all_genotypes(haplotypes, ploidy, genotype_indices);
+        const auto batched = likelihood_model.evaluate(genotypes);
+        BOOST_REQUIRE_EQUAL(batched.size(), genotypes.size());
+        for (std::size_t i {0}; i < genotypes.size(); ++i) {
+            BOOST_CHECK_CLOSE(batched[i], likelihood_model.evaluate(genotypes[i]), 1e-6);
+        }
+        likelihood_model.prime(haplotypes);
+        const auto batched_indices = likelihood_model.evaluate(genotype_indices);
+        BOOST_REQUIRE_EQUAL(batched_indices.size(), genotype_indices.size());
+        for (std::size_t i {0}; i < genotype_indices.size(); ++i) {
+            BOOST_CHECK_CLOSE(batched_indices[i], likelihood_model.evaluate(genotype_indices[i]), 1e-6);
+        }
+        likelihood_model.unprime();
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
@@ -0,0 +1,214 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+#include <random>
+
+#include "basics/aligned_read.hpp"
+#include "basics/cigar_string.hpp"
+#include "core/types/haplotype.hpp"
+#include "core/models/haplotype_likelihood_array.hpp"
+#include "core/models/read_likelihood_cache.hpp"
+#include "utils/thread_pool.hpp"
+#include "mock/mock_reference.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(core)
+BOOST_AUTO_TEST_SUITE(model)
+
+BOOST_AUTO_TEST_CASE(parallel_haplotype_likelihood_population_matches_serial)
+{
+    const auto reference = mock::make_reference();
+    const GenomicRegion region {"5", 100, 700};
+    const auto reference_sequence = reference.fetch_sequence(region);
+    std::mt19937 generator {42};
+    const std::string bases {"ACGT"};
+    MappableBlock<Haplotype> haplotypes {};
+    for (int i {0}; i < 10; ++i) {
+        auto sequence = reference_sequence;
+        for (int j {0}; j < 3; ++j) sequence[100 + generator() % 400] = bases[generator() % 4];
+        haplotypes.emplace_back(region, std::move(sequence), reference);
+    }
+    const std::vector<SampleName> samples {"sample1", "sample2", "sample3"};
+    ReadMap reads {};
+    for (const auto& sample : samples) {
+        auto& sample_reads = reads[sample];
+        for (int i {0}; i < 100; ++i) {
+            const auto offset = 80 + generator() % 400;
+            auto sequence = reference_sequence.substr(offset, 100);
+            if (generator() % 3 == 0) sequence[generator() % 100] = bases[generator() % 4];
+            const auto begin = static_cast<GenomicRegion::Position>(region.begin() + offset);
+            sample_reads.emplace("read" + std::to_string(i), GenomicRegion {"5", begin, begin + 100},
+                                 std::move(sequence), AlignedRead::BaseQualityVector(100, 30),
+                                 parse_cigar("100M"), 60, AlignedRead::Flags {}, "", "");
+        }
+    }
+    HaplotypeLikelihoodArray serial {10, samples}, parallel {10, samples};
+    ThreadPool workers {3};
+    ReadLikelihoodCache cache {10'000};
+    parallel.set_workers(&workers);
+    parallel.set_cache(&cache);
+    serial.populate(reads, haplotypes);
+    for (int i {0}; i < 2; ++i) {
+        parallel.populate(reads, haplotypes);
+        for (const auto& sample : samples) {
+            for (const auto& haplotype : haplotypes) {
+                const auto& expected = serial(sample, haplotype);
+                const auto& actual = parallel(sample, haplotype);
+                BOOST_CHECK_EQUAL_COLLECTIONS(std::cbegin(actual), std::cend(actual),
+                                              std::cbegin(expected), std::cend(expected));
+            }
+        }
+    }
+    BOOST_CHECK_GT(cache.stats().hits, 0);
+}
+
+BOOST_AUTO_TEST_CASE(sharing_haplotype_prefixes_does_not_change_likelihoods)
+{
+    const auto reference = mock::make_reference();
+    const GenomicRegion region {"5", 100, 700};
+    const auto reference_sequence = reference.fetch_sequence(region);
+    std::mt19937 generator {7};
+    const std::string bases {"ACGT"};
+    // Each haplotype extends an earlier one with an extra variant, as a haplotype tree would
+    MappableBlock<Haplotype> haplotypes {};
+    std::vector<std::string> sequences {reference_sequence};
+    for (int i {0}; i < 12; ++i) {
+        auto sequence = sequences[generator() % sequences.size()];
+        const auto position = 100 + generator() % 400;
+        if (i % 4 == 3) {
+            sequence.insert(position, std::string(1 + generator() % 3, bases[generator() % 4]));
+        } else {
+            sequence[position] = bases[generator() % 4];
+        }
+        sequences.push_back(std::move(sequence));
+    }
+    for (auto& sequence : sequences) haplotypes.emplace_back(region, std::move(sequence), reference);
+    const std::vector<SampleName> samples {"sample1", "sample2"};
+    ReadMap reads {};
+    for (const auto& sample : samples) {
+        auto& sample_reads = reads[sample];
+        for (int i {0}; i < 50; ++i) {
+            const auto offset = 80 + generator() % 400;
+            auto sequence = reference_sequence.substr(offset, 100);
+            if (generator() % 3 == 0) sequence[generator() % 100] = bases[generator() % 4];
+            const auto begin = static_cast<GenomicRegion::Position>(region.begin() + offset);
+            sample_reads.emplace("read" + std::to_string(i), GenomicRegion {"5", begin, begin + 100},
+                                 std::move(sequence), AlignedRead::BaseQualityVector(100, 30),
+                                 parse_cigar("100M"), 60, AlignedRead::Flags {}, "", "");
+        }
+    }
+    HaplotypeLikelihoodModel::Config config {};
+    config.min_batch_size = boost::none;
+    HaplotypeLikelihoodArray expected {HaplotypeLikelihoodModel {config}, 13, samples};
+    config.share_haplotype_prefixes = true;
+    HaplotypeLikelihoodArray serial {HaplotypeLikelihoodModel {config}, 13, samples};
+    HaplotypeLikelihoodArray parallel {HaplotypeLikelihoodModel {config}, 13, samples};
+    ThreadPool workers {3};
+    parallel.set_workers(&workers);
+    expected.populate(reads, haplotypes);
+    serial.populate(reads, haplotypes);
+    parallel.populate(reads, haplotypes);
+    for (const auto& sample : samples) {
+        for (const auto& haplotype : haplotypes) {
+            const auto& expected_likelihoods = expected(sample, haplotype);
+            const auto& serial_likelihoods = serial(sample, haplotype);
+            const auto& parallel_likelihoods = parallel(sample, haplotype);
+            BOOST_CHECK_EQUAL_COLLECTIONS(std::cbegin(serial_likelihoods), std::cend(serial_likelihoods),
+                                          std::cbegin(expected_likelihoods), std::cend(expected_likelihoods));
+            BOOST_CHECK_EQUAL_COLLECTIONS(std::cbegin(parallel_likelihoods), std::cend(parallel_likelihoods),
+                                          std::cbegin(expected_likelihoods), std::cend(expected_likelihoods));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(haplotype_likelihoods_can_be_addressed_by_index)
+{
+    const auto reference = mock::make_reference();
+    const GenomicRegion region {"5", 100, 200};
+    auto alt_sequence = reference.fetch_sequence(region);
+    alt_sequence[50] = alt_sequence[50] == 'A' ? 'C' : 'A';
+    const Haplotype ref {region, reference}, alt {region, alt_sequence, reference};
+    HaplotypeLikelihoodArray haplotype_likelihoods {};
+    haplotype_likelihoods.insert("sample1", ref, HaplotypeLikelihoodArray::LikelihoodVector {-1, -2, -3});
+    haplotype_likelihoods.insert("sample1", alt, HaplotypeLikelihoodArray::LikelihoodVector {-4, -5, -6});
+    haplotype_likelihoods.insert("sample2", alt, HaplotypeLikelihoodArray::LikelihoodVector {-7, -8});
+    haplotype_likelihoods.insert("sample2", ref, HaplotypeLikelihoodArray::LikelihoodVector {-9, -10});
+    BOOST_CHECK_EQUAL(haplotype_likelihoods.num_likelihoods("sample1"), 3);
+    BOOST_CHECK_EQUAL(haplotype_likelihoods.num_likelihoods("sample2"), 2);
+    const auto sample2 = haplotype_likelihoods.sample_index("sample2");
+    const auto ref_index = haplotype_likelihoods.haplotype_index(ref);
+    const auto alt_index = haplotype_likelihoods.haplotype_index(alt);
+    BOOST_CHECK_NE(ref_index, alt_index);
+    const auto ref_likelihoods = haplotype_likelihoods(sample2, ref_index);
+    BOOST_REQUIRE_EQUAL(ref_likelihoods.size(), 2);
+    BOOST_CHECK_EQUAL(ref_likelihoods[0], -9);
+    BOOST_CHECK_EQUAL(ref_likelihoods[1], -10);
+    const auto alt_likelihoods = haplotype_likelihoods("sample1", alt);
+    BOOST_REQUIRE_EQUAL(alt_likelihoods.size(), 3);
+    BOOST_CHECK_EQUAL(alt_likelihoods.front(), -4);
+    BOOST_CHECK_EQUAL(alt_likelihoods.back(), -6);
+    haplotype_likelihoods.prime("sample2");
+    BOOST_CHECK_EQUAL(haplotype_likelihoods[alt].front(), -7);
+    BOOST_CHECK_EQUAL(haplotype_likelihoods[alt_index].back(), -8);
+    haplotype_likelihoods.unprime();
+    const std::vector<Haplotype> erased {alt};
+    haplotype_likelihoods.erase(erased);
+    BOOST_CHECK(!haplotype_likelihoods.contains(alt));
+    BOOST_CHECK(haplotype_likelihoods.contains(ref));
+    BOOST_CHECK_EQUAL(haplotype_likelihoods("sample1", ref).front(), -1);
+}
+
+BOOST_AUTO_TEST_CASE(inserting_different_haplotypes_for_each_sample_keeps_every_cell_addressable)
+{
+    const auto reference = mock::make_reference();
+    const GenomicRegion region {"5", 100, 200};
+    const auto ref_sequence = reference.fetch_sequence(region);
+    std::vector<Haplotype> haplotypes {};
+    for (int i {0}; i < 4; ++i) {
+        auto sequence = ref_sequence;
+        sequence[10 * i] = sequence[10 * i] == 'A' ? 'C' : 'A';
+        haplotypes.emplace_back(region, std::move(sequence), reference);
+    }
+    using LikelihoodVector = HaplotypeLikelihoodArray::LikelihoodVector;
+    HaplotypeLikelihoodArray haplotype_likelihoods {};
+    haplotype_likelihoods.insert("sample1", haplotypes[0], LikelihoodVector {-1, -2});
+    haplotype_likelihoods.insert("sample2", haplotypes[1], LikelihoodVector {-3, -4, -5});
+    haplotype_likelihoods.insert("sample1", haplotypes[2], LikelihoodVector {-6, -7});
+    haplotype_likelihoods.insert("sample3", haplotypes[3], LikelihoodVector {-8});
+    const std::vector<SampleName> samples {"sample1", "sample2", "sample3"};
+    const std::vector<std::size_t> num_likelihoods {2, 3, 1};
+    for (std::size_t s {0}; s < samples.size(); ++s) {
+        const auto sample_index = haplotype_likelihoods.sample_index(samples[s]);
+        for (const auto& haplotype : haplotypes) {
+            const auto likelihoods = haplotype_likelihoods(sample_index, haplotype_likelihoods.haplotype_index(haplotype));
+            BOOST_REQUIRE_EQUAL(likelihoods.size(), num_likelihoods[s]);
+            for (const auto likelihood : likelihoods) BOOST_CHECK_LE(likelihood, 0);
+        }
+        const auto sample_likelihoods = haplotype_likelihoods.extract_sample(samples[s]);
+        BOOST_CHECK_EQUAL(sample_likelihoods.size(), haplotypes.size());
+        for (const auto& p : sample_likelihoods) BOOST_CHECK_EQUAL(p.second.size(), num_likelihoods[s]);
+    }
+    BOOST_CHECK_EQUAL(haplotype_likelihoods("sample1", haplotypes[0]).back(), -2);
+    BOOST_CHECK_EQUAL(haplotype_likelihoods("sample2", haplotypes[1]).back(), -5);
+    BOOST_CHECK_EQUAL(haplotype_likelihoods("sample1", haplotypes[2]).front(), -6);
+    BOOST_CHECK_EQUAL(haplotype_likelihoods("sample3", haplotypes[3]).front(), -8);
+    const std::vector<Haplotype> erased {haplotypes[0], haplotypes[2]};
+    haplotype_likelihoods.erase(erased);
+    BOOST_CHECK_EQUAL(haplotype_likelihoods.haplotype_index(haplotypes[1]), 0);
+    BOOST_CHECK_EQUAL(haplotype_likelihoods.haplotype_index(haplotypes[3]), 1);
+    BOOST_CHECK_EQUAL(haplotype_likelihoods("sample2", haplotypes[1]).front(), -3);
+    BOOST_CHECK_EQUAL(haplotype_likelihoods("sample3", haplotypes[3]).front(), -8);
+    haplotype_likelihoods.insert("sample1", haplotypes[1], LikelihoodVector {-9, -10});
+    BOOST_CHECK_EQUAL(haplotype_likelihoods("sample1", haplotypes[1]).back(), -10);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
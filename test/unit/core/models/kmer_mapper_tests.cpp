@@ -1,4 +1,85 @@
 // Copyright (c) 2017 Daniel Cooke
 // Use of this source code is governed by the MIT license that can be found in the LICENSE file.
 
-#include <stdio.h>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <iterator>
+
+#include "utils/kmer_mapper.hpp"
+
+namespace octopus { namespace test {
+
+namespace {
+
+// Counts every query k-mer that matches the target at each mapping position
+std::vector<std::size_t>
+naive_map_query_to_target(const KmerPerfectHashes& query, const KmerPerfectHashes& target, const std::size_t max_positions)
+{
+    std::vector<unsigned> counts(target.size(), 0);
+    for (std::size_t begin {0}; begin < target.size(); ++begin) {
+        for (std::size_t i {0}; i < query.size() && begin + i < target.size(); ++i) {
+            if (query[i] == target[begin + i]) ++counts[begin];
+        }
+    }
+    std::vector<std::size_t> result {};
+    const auto max_count = counts.empty() ? 0u : *std::max_element(std::cbegin(counts), std::cend(counts));
+    if (max_count == 0) return result;
+    for (std::size_t begin {0}; begin < counts.size() && result.size() < max_positions; ++begin) {
+        if (counts[begin] == max_count) result.push_back(begin);
+    }
+    return result;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(core)
+BOOST_AUTO_TEST_SUITE(model)
+
+BOOST_AUTO_TEST_CASE(rolling_kmer_hashes_match_direct_hashes)
+{
+    constexpr unsigned char K {6};
+    const std::string sequence {"ACGTTGCAAACCCGGGTTTTAGCTAGNACGT"};
+    const auto hashes = compute_kmer_hashes<K>(sequence);
+    BOOST_REQUIRE_EQUAL(hashes.size(), sequence.size() - K + 1);
+    for (std::size_t i {0}; i < hashes.size(); ++i) {
+        BOOST_CHECK_EQUAL(hashes[i], perfect_kmer_hash<K>(std::next(std::cbegin(sequence), i)));
+    }
+    BOOST_CHECK(compute_kmer_hashes<K>("ACGTA").empty());
+}
+
+BOOST_AUTO_TEST_CASE(kmer_mapper_finds_the_most_voted_mapping_positions)
+{
+    constexpr unsigned char K {6};
+    std::mt19937 generator {42};
+    const std::string bases {"ACGT"};
+    auto table = init_kmer_hash_table<K>();
+    MappedIndexCounts counts {};
+    for (int trial {0}; trial < 200; ++trial) {
+        // Low complexity targets give repeated k-mers and ties
+        const auto alphabet_size = 1 + trial % 4;
+        std::string target(20 + generator() % 300, 'A');
+        for (auto& base : target) base = bases[generator() % alphabet_size];
+        const auto query_begin = generator() % target.size();
+        auto query = target.substr(query_begin, 1 + generator() % 150);
+        for (auto& base : query) if (generator() % 20 == 0) base = bases[generator() % 4];
+        populate_kmer_hash_table<K>(target, table);
+        counts.resize(table.num_indices);
+        const auto query_hashes = compute_kmer_hashes<K>(query);
+        const auto max_positions = trial % 2 == 0 ? std::size_t {10} : target.size();
+        std::vector<std::size_t> actual(max_positions);
+        actual.erase(map_query_to_target(query_hashes, table, counts, std::begin(actual), max_positions), std::end(actual));
+        const auto expected = naive_map_query_to_target(query_hashes, compute_kmer_hashes<K>(target), max_positions);
+        BOOST_CHECK_EQUAL_COLLECTIONS(std::cbegin(actual), std::cend(actual), std::cbegin(expected), std::cend(expected));
+        BOOST_CHECK(std::all_of(std::cbegin(counts), std::cend(counts), [] (auto count) { return count == 0; }));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
@@ -9,8 +9,11 @@
 #include <algorithm>
 #include <utility>
 #include <iostream>
+#include <random>
+#include <chrono>
 
 #include "core/models/pairhmm/simd_pair_hmm_factory.hpp"
+#include "core/models/pairhmm/simd_pair_hmm_wrapper.hpp"
 
 namespace octopus { namespace test {
 
@@ -712,9 +715,177 @@ BOOST_AUTO_TEST_CASE(avx2_check_alignments)
 }
 #endif /* __AVX2__ */
 
+BOOST_AUTO_TEST_CASE(dispatched_kernels_agree)
+{
+    for (const auto instruction_set : {PairHMMInstructionSet::sse2, PairHMMInstructionSet::avx2, PairHMMInstructionSet::avx512}) {
+        if (!is_compiled(instruction_set) || !is_supported(instruction_set)) continue;
+        BOOST_TEST_MESSAGE("Testing " << instruction_set << " kernels");
+        for (const auto precision : {ScorePrecision::int16, ScorePrecision::int32}) {
+            PairHMMWrapper hmm {16, precision, instruction_set};
+            CHECK_TEST(band16_speed_test, hmm)
+            CHECK_ALIGNER(band16_speed_test, hmm, band16_speed_expected_alignment)
+        }
+    }
+}
+
+// Interleaved inputs for PairHMMWrapper::batch_align
+struct BatchTestCase
+{
+    int batch_size, truth_len, target_len;
+    std::string truths, targets, snv_masks;
+    std::vector<std::int8_t> qualities, snv_priors, gap_open, gap_extend;
+};
+
+template <typename Generator>
+BatchTestCase make_random_batch_test(const int batch_size, const int band_size, const int target_len, Generator& generator)
+{
+    const static std::string bases {"ACGTN"};
+    std::discrete_distribution<int> base_dist {25, 25, 25, 25, 1};
+    std::bernoulli_distribution mutation_dist {0.05};
+    std::uniform_int_distribution<int> quality_dist {2, 40}, open_dist {10, 45}, extend_dist {1, 10};
+    BatchTestCase result {batch_size, target_len + 2 * band_size - 1, target_len};
+    result.truths.resize(result.truth_len * batch_size);
+    result.snv_masks.resize(result.truths.size());
+    result.snv_priors.resize(result.truths.size());
+    result.gap_open.resize(result.truths.size());
+    result.gap_extend.resize(result.truths.size());
+    result.targets.resize(target_len * batch_size);
+    result.qualities.resize(result.targets.size());
+    for (int lane {0}; lane < batch_size; ++lane) {
+        std::string truth(result.truth_len, 'N');
+        for (auto& base : truth) base = bases[base_dist(generator)];
+        // The target is a mutated copy of the truth, including some indels
+        std::string target {};
+        for (int j {band_size}; j < result.truth_len && static_cast<int>(target.size()) < target_len; ++j) {
+            if (mutation_dist(generator)) {
+                switch (extend_dist(generator) % 3) {
+                    case 0: target += bases[base_dist(generator)]; break;
+                    case 1: target += truth[j]; target += bases[base_dist(generator)]; break;
+                    default: break;
+                }
+            } else {
+                target += truth[j];
+            }
+        }
+        target.resize(target_len, 'A');
+        for (int j {0}; j < result.truth_len; ++j) {
+            const auto idx = j * batch_size + lane;
+            result.truths[idx]     = truth[j];
+            result.snv_masks[idx]  = bases[base_dist(generator)];
+            result.snv_priors[idx] = quality_dist(generator);
+            result.gap_open[idx]   = open_dist(generator);
+            result.gap_extend[idx] = extend_dist(generator);
+        }
+        for (int j {0}; j < target_len; ++j) {
+            result.targets[j * batch_size + lane]   = target[j];
+            result.qualities[j * batch_size + lane] = quality_dist(generator);
+        }
+    }
+    return result;
+}
+
+template <typename T>
+std::vector<T> get_lane(const T* values, const int length, const int batch_size, const int lane)
+{
+    std::vector<T> result(length);
+    for (int j {0}; j < length; ++j) result[j] = values[j * batch_size + lane];
+    return result;
+}
+
+std::vector<int> batch_align_helper(const BatchTestCase& test, const PairHMMWrapper& hmm)
+{
+    std::vector<int> result(test.batch_size);
+    hmm.batch_align(test.truths.data(), test.targets.data(), test.qualities.data(), test.truth_len, test.target_len,
+                    test.snv_masks.data(), test.snv_priors.data(), test.gap_open.data(), test.gap_extend.data(), 2,
+                    result.data());
+    return result;
+}
+
+int lane_align_helper(const BatchTestCase& test, const PairHMMWrapper& hmm, const int lane)
+{
+    const auto truth      = get_lane(test.truths.data(), test.truth_len, test.batch_size, lane);
+    const auto snv_mask   = get_lane(test.snv_masks.data(), test.truth_len, test.batch_size, lane);
+    const auto snv_prior  = get_lane(test.snv_priors.data(), test.truth_len, test.batch_size, lane);
+    const auto gap_open   = get_lane(test.gap_open.data(), test.truth_len, test.batch_size, lane);
+    const auto gap_extend = get_lane(test.gap_extend.data(), test.truth_len, test.batch_size, lane);
+    const auto target     = get_lane(test.targets.data(), test.target_len, test.batch_size, lane);
+    const auto qualities  = get_lane(test.qualities.data(), test.target_len, test.batch_size, lane);
+    return hmm.align(truth.data(), target.data(), qualities.data(), test.truth_len, test.target_len,
+                     snv_mask.data(), snv_prior.data(), gap_open.data(), gap_extend.data(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(batch_kernels_agree_with_single_read_kernels)
+{
+    std::mt19937 generator {42};
+    for (const auto instruction_set : {PairHMMInstructionSet::sse2, PairHMMInstructionSet::avx2, PairHMMInstructionSet::avx512}) {
+        if (!is_compiled(instruction_set) || !is_supported(instruction_set)) continue;
+        for (const auto precision : {ScorePrecision::int16, ScorePrecision::int32}) {
+            for (const int band_size : {8, 16, 32, 64}) {
+                PairHMMWrapper hmm {band_size, precision, instruction_set};
+                BOOST_REQUIRE_EQUAL(hmm.band_size(), band_size);
+                for (const int target_len : {1, 10, 100, 151}) {
+                    const auto test = make_random_batch_test(hmm.batch_size(), band_size, target_len, generator);
+                    const auto scores = batch_align_helper(test, hmm);
+                    for (int lane {0}; lane < hmm.batch_size(); ++lane) {
+                        BOOST_CHECK_EQUAL(scores[lane], lane_align_helper(test, hmm, lane));
+                    }
+                }
+            }
+        }
+    }
+}
 
 // Speed tests
 
+BOOST_AUTO_TEST_CASE(batch_kernel_speed)
+{
+    using Clock = std::chrono::steady_clock;
+    using std::chrono::duration_cast; using std::chrono::microseconds;
+    const int num_batches {2000};
+    std::mt19937 generator {42};
+    for (const auto instruction_set : {PairHMMInstructionSet::sse2, PairHMMInstructionSet::avx2, PairHMMInstructionSet::avx512}) {
+        if (!is_compiled(instruction_set) || !is_supported(instruction_set)) continue;
+        for (const int band_size : {8, 16}) {
+            PairHMMWrapper hmm {band_size, ScorePrecision::int16, instruction_set};
+            const auto test = make_random_batch_test(hmm.batch_size(), band_size, 150, generator);
+            std::vector<std::vector<char>> truths, snv_masks, targets;
+            std::vector<std::vector<std::int8_t>> snv_priors, gap_opens, gap_extends, qualities;
+            for (int lane {0}; lane < hmm.batch_size(); ++lane) {
+                truths.push_back(get_lane(test.truths.data(), test.truth_len, test.batch_size, lane));
+                snv_masks.push_back(get_lane(test.snv_masks.data(), test.truth_len, test.batch_size, lane));
+                snv_priors.push_back(get_lane(test.snv_priors.data(), test.truth_len, test.batch_size, lane));
+                gap_opens.push_back(get_lane(test.gap_open.data(), test.truth_len, test.batch_size, lane));
+                gap_extends.push_back(get_lane(test.gap_extend.data(), test.truth_len, test.batch_size, lane));
+                targets.push_back(get_lane(test.targets.data(), test.target_len, test.batch_size, lane));
+                qualities.push_back(get_lane(test.qualities.data(), test.target_len, test.batch_size, lane));
+            }
+            long single_checksum {0}, batch_checksum {0};
+            const auto single_start = Clock::now();
+            for (int i {0}; i < num_batches; ++i) {
+                for (int lane {0}; lane < hmm.batch_size(); ++lane) {
+                    single_checksum += hmm.align(truths[lane].data(), targets[lane].data(), qualities[lane].data(),
+                                                 test.truth_len, test.target_len, snv_masks[lane].data(), snv_priors[lane].data(),
+                                                 gap_opens[lane].data(), gap_extends[lane].data(), 2);
+                }
+            }
+            const auto single_end = Clock::now();
+            std::vector<int> scores(hmm.batch_size());
+            for (int i {0}; i < num_batches; ++i) {
+                hmm.batch_align(test.truths.data(), test.targets.data(), test.qualities.data(), test.truth_len, test.target_len,
+                                test.snv_masks.data(), test.snv_priors.data(), test.gap_open.data(), test.gap_extend.data(), 2,
+                                scores.data());
+                for (const auto score : scores) batch_checksum += score;
+            }
+            const auto batch_end = Clock::now();
+            BOOST_CHECK_EQUAL(single_checksum, batch_checksum);
+            BOOST_TEST_MESSAGE(instruction_set << " band " << band_size << ", " << num_batches * hmm.batch_size() << " reads: "
+                               << "single read kernel " << duration_cast<microseconds>(single_end - single_start).count() << "us, "
+                               << "batch kernel (" << hmm.batch_size() << " lanes) "
+                               << duration_cast<microseconds>(batch_end - single_end).count() << "us");
+        }
+    }
+}
+
 
 const int iterations = 1000000;
 
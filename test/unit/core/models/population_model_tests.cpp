@@ -0,0 +1,143 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <iterator>
+#include <cmath>
+
+#include "core/types/haplotype.hpp"
+#include "core/types/genotype.hpp"
+#include "core/models/haplotype_likelihood_array.hpp"
+#include "core/models/genotype/population_model.hpp"
+#include "core/models/genotype/uniform_population_prior_model.hpp"
+#include "mock/mock_reference.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(core)
+BOOST_AUTO_TEST_SUITE(model)
+
+namespace {
+
+// Diploid biallelic cohort where sample s carries s % 3 copies of the alt haplotype, each
+// sample having 10 reads that strongly support its true genotype
+struct BiallelicCohort
+{
+    explicit BiallelicCohort(const unsigned num_samples)
+    {
+        const auto reference = mock::make_reference();
+        const GenomicRegion region {"5", 100, 200};
+        auto alt_sequence = reference.fetch_sequence(region);
+        alt_sequence[50] = alt_sequence[50] == 'A' ? 'C' : 'A';
+        const Haplotype ref {region, reference}, alt {region, alt_sequence, reference};
+        haplotypes = MappableBlock<Haplotype> {ref, alt};
+        genotypes = generate_all_genotypes(haplotypes, 2);
+        for (unsigned s {0}; s < num_samples; ++s) {
+            samples.push_back("sample" + std::to_string(s));
+            true_alt_counts.push_back(s % 3);
+            HaplotypeLikelihoodArray::LikelihoodVector ref_likelihoods(10, -1.0), alt_likelihoods(10, -10.0);
+            const auto num_alt_reads = 5 * true_alt_counts.back();
+            std::fill_n(std::begin(ref_likelihoods), num_alt_reads, -10.0);
+            std::fill_n(std::begin(alt_likelihoods), num_alt_reads, -1.0);
+            haplotype_likelihoods.insert(samples.back(), ref, std::move(ref_likelihoods));
+            haplotype_likelihoods.insert(samples.back(), alt, std::move(alt_likelihoods));
+        }
+    }
+    
+    const Haplotype& alt() const noexcept { return haplotypes[1]; }
+    
+    MappableBlock<Haplotype> haplotypes;
+    MappableBlock<Genotype<Haplotype>> genotypes;
+    std::vector<SampleName> samples;
+    std::vector<unsigned> true_alt_counts;
+    HaplotypeLikelihoodArray haplotype_likelihoods;
+};
+
+void check_sample_marginals(const BiallelicCohort& cohort,
+                            const octopus::model::PopulationModel::InferredLatents& actual,
+                            const octopus::model::PopulationModel::InferredLatents& expected,
+                            const double tolerance)
+{
+    const auto& expected_marginals = expected.posteriors.marginal_genotype_probabilities;
+    const auto& actual_marginals = actual.posteriors.marginal_genotype_probabilities;
+    BOOST_REQUIRE_EQUAL(actual_marginals.size(), cohort.samples.size());
+    BOOST_REQUIRE_EQUAL(expected_marginals.size(), cohort.samples.size());
+    for (std::size_t s {0}; s < cohort.samples.size(); ++s) {
+        BOOST_REQUIRE_EQUAL(actual_marginals[s].size(), cohort.genotypes.size());
+        BOOST_CHECK_CLOSE(std::accumulate(std::cbegin(actual_marginals[s]), std::cend(actual_marginals[s]), 0.0), 1.0, 1e-6);
+        for (std::size_t g {0}; g < cohort.genotypes.size(); ++g) {
+            BOOST_CHECK_SMALL(actual_marginals[s][g] - expected_marginals[s][g], tolerance);
+        }
+        const auto map_itr = std::max_element(std::cbegin(actual_marginals[s]), std::cend(actual_marginals[s]));
+        const auto& map_genotype = cohort.genotypes[std::distance(std::cbegin(actual_marginals[s]), map_itr)];
+        BOOST_CHECK_EQUAL(map_genotype.count(cohort.alt()), cohort.true_alt_counts[s]);
+    }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(population_model_sample_blocks_do_not_change_posteriors)
+{
+    const BiallelicCohort cohort {12};
+    const UniformPopulationPriorModel prior_model {};
+    octopus::model::PopulationModel::Options single_sample_blocks {}, multi_sample_blocks {};
+    single_sample_blocks.sample_block_size = 1;
+    multi_sample_blocks.sample_block_size = 5;
+    const octopus::model::PopulationModel single_sample_block_model {prior_model, single_sample_blocks};
+    const octopus::model::PopulationModel multi_sample_block_model {prior_model, multi_sample_blocks};
+    const auto expected = single_sample_block_model.evaluate(cohort.samples, cohort.genotypes, cohort.haplotype_likelihoods);
+    const auto actual = multi_sample_block_model.evaluate(cohort.samples, cohort.genotypes, cohort.haplotype_likelihoods);
+    BOOST_CHECK_CLOSE(actual.log_evidence, expected.log_evidence, 1e-6);
+    check_sample_marginals(cohort, actual, expected, 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(population_model_sample_blocks_agree_with_joint_evaluation)
+{
+    const BiallelicCohort cohort {7};
+    const UniformPopulationPriorModel prior_model {};
+    octopus::model::PopulationModel::Options joint {}, blocked {};
+    blocked.sample_block_size = 3;
+    const octopus::model::PopulationModel joint_model {prior_model, joint};
+    const octopus::model::PopulationModel blocked_model {prior_model, blocked};
+    const auto expected = joint_model.evaluate(cohort.samples, cohort.genotypes, cohort.haplotype_likelihoods);
+    const auto actual = blocked_model.evaluate(cohort.samples, cohort.genotypes, cohort.haplotype_likelihoods);
+    // Blocked evaluation uses estimated Hardy-Weinberg genotype priors rather than the joint prior model,
+    // so posteriors differ only by the weight of the prior, which is small with this much evidence
+    check_sample_marginals(cohort, actual, expected, 1e-2);
+}
+
+BOOST_AUTO_TEST_CASE(population_model_sample_blocks_handle_mixed_ploidies)
+{
+    const BiallelicCohort cohort {6};
+    auto genotypes = generate_all_genotypes(cohort.haplotypes, 1);
+    genotypes.insert(std::cend(genotypes), std::cbegin(cohort.genotypes), std::cend(cohort.genotypes));
+    std::vector<unsigned> sample_ploidies {};
+    for (std::size_t s {0}; s < cohort.samples.size(); ++s) sample_ploidies.push_back(s % 2 == 0 ? 2 : 1);
+    const UniformPopulationPriorModel prior_model {};
+    octopus::model::PopulationModel::Options blocked {};
+    blocked.sample_block_size = 2;
+    const octopus::model::PopulationModel model {prior_model, blocked};
+    const auto latents = model.evaluate(cohort.samples, sample_ploidies, genotypes, cohort.haplotype_likelihoods);
+    const auto& marginals = latents.posteriors.marginal_genotype_probabilities;
+    BOOST_CHECK(std::isfinite(latents.log_evidence));
+    BOOST_REQUIRE_EQUAL(marginals.size(), cohort.samples.size());
+    for (std::size_t s {0}; s < cohort.samples.size(); ++s) {
+        BOOST_REQUIRE_EQUAL(marginals[s].size(), genotypes.size());
+        BOOST_CHECK(std::all_of(std::cbegin(marginals[s]), std::cend(marginals[s]), [] (double p) { return std::isfinite(p); }));
+        BOOST_CHECK_CLOSE(std::accumulate(std::cbegin(marginals[s]), std::cend(marginals[s]), 0.0), 1.0, 1e-6);
+        for (std::size_t g {0}; g < genotypes.size(); ++g) {
+            if (genotypes[g].ploidy() != sample_ploidies[s]) BOOST_CHECK_EQUAL(marginals[s][g], 0.0);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
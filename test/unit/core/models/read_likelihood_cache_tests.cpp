@@ -0,0 +1,86 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <cstddef>
+
+#include "basics/aligned_read.hpp"
+#include "basics/cigar_string.hpp"
+#include "core/types/haplotype.hpp"
+#include "core/models/haplotype_likelihood_model.hpp"
+#include "core/models/read_likelihood_cache.hpp"
+#include "mock/mock_reference.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(core)
+BOOST_AUTO_TEST_SUITE(model)
+
+BOOST_AUTO_TEST_CASE(read_likelihood_cache_is_bounded_and_keeps_recent_entries)
+{
+    ReadLikelihoodCache cache {10};
+    for (ReadLikelihoodCache::Key key {0}; key < 100; ++key) {
+        cache.insert(key, -static_cast<double>(key));
+        BOOST_CHECK_LE(cache.size(), cache.capacity());
+    }
+    const auto hit = cache.find(99);
+    BOOST_REQUIRE(hit);
+    BOOST_CHECK_EQUAL(*hit, -99.0);
+    BOOST_CHECK(!cache.find(0));
+    BOOST_CHECK_EQUAL(cache.stats().hits, 1);
+    BOOST_CHECK_EQUAL(cache.stats().misses, 1);
+    BOOST_CHECK_EQUAL(cache.hit_rate(), 0.5);
+}
+
+BOOST_AUTO_TEST_CASE(read_likelihood_cache_with_zero_capacity_stores_nothing)
+{
+    ReadLikelihoodCache cache {0};
+    cache.insert(1, -1.0);
+    BOOST_CHECK(cache.empty());
+    BOOST_CHECK(!cache.find(1));
+}
+
+BOOST_AUTO_TEST_CASE(prefix_hash_window_hashes_only_depend_on_window_symbols)
+{
+    const std::string lhs {"ACGTACGTTTGACCA"}, rhs {"GGGTACGTTTGATTT"};
+    PrefixHash lhs_hash {}, rhs_hash {};
+    lhs_hash.assign(lhs.size(), [&] (std::size_t i) { return static_cast<PrefixHash::Symbol>(lhs[i]); });
+    rhs_hash.assign(rhs.size(), [&] (std::size_t i) { return static_cast<PrefixHash::Symbol>(rhs[i]); });
+    BOOST_CHECK_EQUAL(lhs_hash(3, 12), rhs_hash(3, 12));
+    BOOST_CHECK_NE(lhs_hash(1, 12), rhs_hash(1, 12));
+    BOOST_CHECK_NE(lhs_hash(3, 13), rhs_hash(3, 13));
+    BOOST_CHECK_NE(lhs_hash(3, 12), lhs_hash(3, 11));
+    const auto direct_hash = PrefixHash::hash(9, [&] (std::size_t i) { return static_cast<PrefixHash::Symbol>(lhs[3 + i]); });
+    BOOST_CHECK_EQUAL(lhs_hash(3, 12), direct_hash);
+}
+
+BOOST_AUTO_TEST_CASE(cached_likelihoods_match_uncached_for_reads_shifted_past_the_haplotype_pad)
+{
+    const auto reference = mock::make_reference();
+    HaplotypeLikelihoodModel cached_model {}, uncached_model {};
+    ReadLikelihoodCache cache {100};
+    cached_model.set_cache(&cache);
+    // The read ends at the haplotype end, so is shifted left by the pad to a position less than the pad
+    const auto pad = cached_model.pad_requirement();
+    const GenomicRegion::Size read_length {100};
+    const GenomicRegion haplotype_region {"5", 100, 100 + pad + pad / 2 + read_length};
+    const Haplotype haplotype {haplotype_region, reference};
+    const GenomicRegion read_region {"5", haplotype_region.end() - read_length, haplotype_region.end()};
+    const AlignedRead read {"read", read_region, reference.fetch_sequence(read_region),
+                           AlignedRead::BaseQualityVector(read_length, 30), parse_cigar("100M"),
+                           60, AlignedRead::Flags {}, "", ""};
+    cached_model.reset(haplotype);
+    uncached_model.reset(haplotype);
+    const auto expected = uncached_model.evaluate(read);
+    BOOST_CHECK_EQUAL(cached_model.evaluate(read), expected);
+    BOOST_CHECK_EQUAL(cached_model.evaluate(read), expected);
+    BOOST_CHECK(cache.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
@@ -0,0 +1,101 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include "core/task_cost.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(core)
+BOOST_AUTO_TEST_SUITE(task_cost)
+
+BOOST_AUTO_TEST_CASE(calculate_tandem_repeat_fraction_finds_short_period_repeats)
+{
+    BOOST_CHECK_EQUAL(calculate_tandem_repeat_fraction(""), 0);
+    BOOST_CHECK_EQUAL(calculate_tandem_repeat_fraction("AAAAAAAAAAA"), 0); // too short
+    BOOST_CHECK_EQUAL(calculate_tandem_repeat_fraction("ACGTTGCAAGTCCTAGGATC"), 0);
+    BOOST_CHECK_EQUAL(calculate_tandem_repeat_fraction("AAAAAAAAAAAA"), 1);
+    BOOST_CHECK_EQUAL(calculate_tandem_repeat_fraction("ACACACACACAC"), 1);
+    BOOST_CHECK_EQUAL(calculate_tandem_repeat_fraction("ACGTAGACGTAG"), 1); // period 6
+    BOOST_CHECK_EQUAL(calculate_tandem_repeat_fraction("ACGTAGCACGTAGC"), 0); // period 7
+    // 12bp of repeat in a 24bp sequence
+    BOOST_CHECK_EQUAL(calculate_tandem_repeat_fraction("ACGTTGCAAGTCCACACACACACA"), 0.5);
+    BOOST_CHECK_EQUAL(calculate_tandem_repeat_fraction("CACACACACACAACGTTGCAAGTC"), 0.5);
+    // 11bp runs are below the minimum length
+    BOOST_CHECK_EQUAL(calculate_tandem_repeat_fraction("ACGTTGCAAGTCCTTTTTTTTTTTG"), 0);
+}
+
+BOOST_AUTO_TEST_CASE(calculate_tandem_repeat_fraction_ignores_n_runs)
+{
+    BOOST_CHECK_EQUAL(calculate_tandem_repeat_fraction(std::string(100, 'N')), 0);
+    BOOST_CHECK_EQUAL(calculate_tandem_repeat_fraction(std::string(12, 'N') + std::string(12, 'T')), 0.5);
+}
+
+BOOST_AUTO_TEST_CASE(make_task_cost_weights_reads_by_repeats_and_depth_variation)
+{
+    const auto empty = make_task_cost({0, 0, 0}, 0.5);
+    BOOST_CHECK_EQUAL(empty.num_reads, 0);
+    BOOST_CHECK_EQUAL(empty.predicted, 0);
+    
+    const auto even = make_task_cost({10, 10, 10, 10}, 0);
+    BOOST_CHECK_EQUAL(even.num_reads, 40);
+    BOOST_CHECK_EQUAL(even.depth_variation, 0);
+    BOOST_CHECK_EQUAL(even.predicted, 40);
+    
+    const auto single_bin = make_task_cost({40}, 0);
+    BOOST_CHECK_EQUAL(single_bin.depth_variation, 0);
+    BOOST_CHECK_EQUAL(single_bin.predicted, even.predicted);
+    
+    const auto uneven = make_task_cost({0, 20, 0, 20}, 0);
+    BOOST_CHECK_EQUAL(uneven.num_reads, 40);
+    BOOST_CHECK_GT(uneven.depth_variation, 0);
+    BOOST_CHECK_GT(uneven.predicted, even.predicted);
+    
+    const auto repetitive = make_task_cost({10, 10, 10, 10}, 0.5);
+    BOOST_CHECK_EQUAL(repetitive.repeat_fraction, 0.5);
+    BOOST_CHECK_GT(repetitive.predicted, even.predicted);
+}
+
+BOOST_AUTO_TEST_CASE(head_task_cost_scales_reads_and_keeps_the_other_signals)
+{
+    const auto cost = make_task_cost({30, 10}, 0.25);
+    const auto half = head_task_cost(cost, 0.5);
+    BOOST_CHECK_EQUAL(half.num_reads, 20);
+    BOOST_CHECK_EQUAL(half.depth_variation, cost.depth_variation);
+    BOOST_CHECK_EQUAL(half.repeat_fraction, cost.repeat_fraction);
+    BOOST_CHECK_CLOSE(half.predicted, cost.predicted / 2, 1e-6);
+    BOOST_CHECK_EQUAL(head_task_cost(cost, 1).predicted, cost.predicted);
+    BOOST_CHECK_EQUAL(head_task_cost(cost, 0).predicted, 0);
+}
+
+BOOST_AUTO_TEST_CASE(calculate_split_size_only_splits_windows_over_the_cost_limit)
+{
+    const auto cost = make_task_cost({100}, 0); // predicted cost 100
+    BOOST_CHECK_EQUAL(calculate_split_size(1000, cost, 100, 1), 1000);
+    BOOST_CHECK_EQUAL(calculate_split_size(1000, cost, 200, 1), 1000);
+    BOOST_CHECK_EQUAL(calculate_split_size(1000, cost, 50, 1), 500);
+    BOOST_CHECK_EQUAL(calculate_split_size(1000, cost, 25, 1), 250);
+    BOOST_CHECK_EQUAL(calculate_split_size(1000, TaskCost {}, 0, 1), 1000);
+}
+
+BOOST_AUTO_TEST_CASE(calculate_split_size_respects_the_minimum_window_size)
+{
+    const auto cost = make_task_cost({100}, 0);
+    BOOST_CHECK_EQUAL(calculate_split_size(1000, cost, 1, 300), 300);
+    BOOST_CHECK_EQUAL(calculate_split_size(200, cost, 1, 300), 200);
+    BOOST_CHECK_EQUAL(calculate_split_size(300, cost, 1, 300), 300);
+    const auto split_size = calculate_split_size(1000, cost, 50, 1);
+    const auto head_cost = head_task_cost(cost, split_size / 1000.0);
+    BOOST_CHECK_LE(head_cost.predicted, 50);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
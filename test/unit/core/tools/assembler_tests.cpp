@@ -72,6 +72,36 @@ BOOST_AUTO_TEST_CASE(assembler_throws_if_reference_sequence_is_inserted_twice)
     BOOST_CHECK_THROW(assembler.insert_reference(reference), std::exception);
 }
 
+BOOST_AUTO_TEST_CASE(assembler_finds_snv_bubbles_with_short_and_long_kmers)
+{
+    // Kmers longer than a word are not packed, so check both paths give the same bubble
+    const Assembler::NucleotideSequence reference {"GATTACAGCTTGACCATGGCATACGGTCCAGTTAGCAATCGCTAGGACTTCAGTCCGATACCGTAAGTTGCGACCTAGA"};
+    auto alt = reference;
+    alt[40] = 'A';
+    const Assembler::BaseQualityVector base_qualities(reference.size(), 30);
+    auto read_with_n = alt;
+    read_with_n[5] = 'N';
+    for (const unsigned kmer_size : {11u, 32u, 33u}) {
+        Assembler assembler {{kmer_size}, reference};
+        BOOST_REQUIRE(assembler.is_unique_reference());
+        for (int i {0}; i < 3; ++i) {
+            assembler.insert_read(alt, base_qualities, Assembler::Direction::forward);
+            assembler.insert_read(alt, base_qualities, Assembler::Direction::reverse);
+        }
+        assembler.insert_read(read_with_n, base_qualities, Assembler::Direction::forward);
+        BOOST_CHECK_EQUAL(assembler.num_kmers(), reference.size() - kmer_size + 1 + kmer_size);
+        assembler.prune(2);
+        assembler.cleanup();
+        BOOST_REQUIRE(!assembler.is_all_reference());
+        const auto variants = assembler.extract_variants(10, 0);
+        BOOST_REQUIRE_EQUAL(variants.size(), 1);
+        const auto& variant = variants.front();
+        BOOST_CHECK_EQUAL(variant.ref.size(), variant.alt.size());
+        BOOST_CHECK_EQUAL(variant.ref[40 - variant.begin_pos], 'G');
+        BOOST_CHECK_EQUAL(variant.alt[40 - variant.begin_pos], 'A');
+    }
+}
+
 
 
 BOOST_AUTO_TEST_SUITE_END()
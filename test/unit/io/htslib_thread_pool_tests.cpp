@@ -0,0 +1,100 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+#include <sstream>
+
+#include "basics/genomic_region.hpp"
+#include "io/htslib_thread_pool.hpp"
+#include "io/read/read_manager.hpp"
+#include "io/variant/vcf_reader.hpp"
+#include "io/variant/vcf_writer.hpp"
+#include "io/variant/vcf_header.hpp"
+#include "io/variant/vcf_record.hpp"
+#include "mock/mock_files.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(io)
+BOOST_AUTO_TEST_SUITE(htslib_thread_pool)
+
+namespace {
+
+std::string make_test_sam()
+{
+    std::string result {"@HD\tVN:1.4\tSO:coordinate\n@SQ\tSN:1\tLN:100000\n@RG\tID:rg\tSM:sample\n"};
+    const std::string bases {"ACGT"};
+    for (int begin {0}; begin < 90'000; begin += 7) {
+        std::string sequence(100, 'A');
+        for (int i {0}; i < 100; ++i) sequence[i] = bases[(begin + i * i) % 4];
+        result += "read" + std::to_string(begin) + "\t0\t1\t" + std::to_string(begin + 1) + "\t60\t100M\t*\t0\t0\t"
+                  + sequence + "\t*\tRG:Z:rg\n";
+    }
+    return result;
+}
+
+std::string make_test_vcf()
+{
+    std::string result {"##fileformat=VCFv4.2\n##contig=<ID=1,length=100000>\n"
+                        "##FORMAT=<ID=GT,Number=1,Type=String,Description=\"Genotype\">\n"
+                        "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tsample\n"};
+    for (int position {1}; position < 90'000; position += 11) {
+        result += "1\t" + std::to_string(position) + "\t.\tA\tC\t" + std::to_string(position % 100) + "\tPASS\t.\tGT\t0/1\n";
+    }
+    return result;
+}
+
+std::vector<std::string> to_strings(const std::vector<VcfRecord>& records)
+{
+    std::vector<std::string> result {};
+    result.reserve(records.size());
+    for (const auto& record : records) {
+        std::ostringstream ss {};
+        ss << record;
+        result.push_back(ss.str());
+    }
+    return result;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(read_and_write_files_can_share_an_htslib_thread_pool)
+{
+    mock::TemporaryDirectory directory {};
+    const auto bam = directory / "reads.bam";
+    mock::write_indexed_bam(bam, make_test_sam());
+    const auto vcf = directory / "calls.vcf.gz";
+    mock::write_indexed_vcf(vcf, make_test_vcf());
+    const auto copy = directory / "copy.vcf.gz";
+    std::vector<VcfRecord> expected_records {};
+    {
+        HtslibThreadPool pool {2};
+        BOOST_CHECK_EQUAL(pool.size(), 2);
+        const ::octopus::io::ReadManager pooled_reads {{bam}, 1, &pool}, reads {bam};
+        const auto& sample = reads.samples().front();
+        for (const GenomicRegion region : {GenomicRegion {"1", 0, 100'000}, GenomicRegion {"1", 45'000, 46'000}}) {
+            const auto expected = reads.fetch_reads(sample, region);
+            const auto actual = pooled_reads.fetch_reads(sample, region);
+            BOOST_CHECK(!expected.empty());
+            BOOST_CHECK(actual == expected);
+        }
+        const VcfReader src {vcf};
+        expected_records = src.fetch_records();
+        VcfWriter dst {copy, src.fetch_header(), &pool};
+        write(expected_records, dst);
+        dst.close();
+    }
+    const auto actual_records = VcfReader {copy}.fetch_records();
+    const auto expected = to_strings(expected_records), actual = to_strings(actual_records);
+    BOOST_CHECK_EQUAL(expected.size(), 8'182);
+    BOOST_CHECK_EQUAL_COLLECTIONS(std::cbegin(actual), std::cend(actual), std::cbegin(expected), std::cend(expected));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
@@ -0,0 +1,185 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <random>
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <stdexcept>
+
+#include "basics/genomic_region.hpp"
+#include "io/reference/fasta.hpp"
+#include "io/reference/packed_reference.hpp"
+#include "mock/mock_files.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(io)
+BOOST_AUTO_TEST_SUITE(packed_reference)
+
+namespace {
+
+using Contigs = std::vector<std::pair<std::string, std::string>>;
+
+// Random ACGT with runs of N, IUPAC codes, and lowercase, including at the contig ends
+std::string make_test_sequence(const std::size_t length, std::mt19937& generator)
+{
+    std::string result(length, 'A');
+    const std::string bases {"ACGT"}, iupac {"RYKMSWBDHVN"};
+    std::uniform_int_distribution<std::size_t> base_dist {0, 3}, iupac_dist {0, iupac.size() - 1};
+    std::generate(std::begin(result), std::end(result), [&] () { return bases[base_dist(generator)]; });
+    if (length == 0) return result;
+    std::uniform_int_distribution<std::size_t> position_dist {0, length - 1}, run_length_dist {1, 40};
+    const auto add_run = [&] (const std::size_t begin, const std::size_t run_length, const auto& transform) {
+        const auto end = std::min(begin + run_length, length);
+        std::for_each(std::next(std::begin(result), begin), std::next(std::begin(result), end), transform);
+    };
+    const auto to_n = [] (char& base) { base = 'N'; };
+    const auto to_lower = [] (char& base) { base = std::tolower(base); };
+    for (std::size_t i {0}; i < 1 + length / 200; ++i) {
+        add_run(position_dist(generator), run_length_dist(generator), to_n);
+        add_run(position_dist(generator), run_length_dist(generator), to_lower);
+        result[position_dist(generator)] = iupac[iupac_dist(generator)];
+    }
+    add_run(0, run_length_dist(generator), to_n);
+    add_run(length - std::min(length, run_length_dist(generator)), length, to_lower);
+    return result;
+}
+
+Contigs make_test_contigs()
+{
+    std::mt19937 generator {42};
+    Contigs result {};
+    for (const std::size_t length : {1, 3, 4, 5, 1'001, 20'003}) {
+        result.emplace_back("chr" + std::to_string(result.size() + 1), make_test_sequence(length, generator));
+    }
+    result.emplace_back("all_n", std::string(1'000, 'N'));
+    result.emplace_back("all_lowercase", "acgtnacgtnnnnacgtrykm");
+    return result;
+}
+
+struct PackedFasta
+{
+    mock::TemporaryDirectory directory;
+    mock::Path fasta, packed;
+    Contigs contigs;
+    
+    PackedFasta()
+    : directory {}
+    , fasta {directory / "reference.fa"}
+    , packed {directory / "reference.pfa"}
+    , contigs {make_test_contigs()}
+    {
+        mock::write_indexed_fasta(fasta, contigs);
+        mock::write_packed_reference(packed, fasta);
+    }
+};
+
+std::vector<GenomicRegion> make_random_regions(const Contigs& contigs, const std::size_t num_regions,
+                                               const GenomicRegion::Size max_overhang)
+{
+    std::mt19937 generator {7};
+    std::uniform_int_distribution<std::size_t> contig_dist {0, contigs.size() - 1};
+    std::vector<GenomicRegion> result {};
+    result.reserve(num_regions);
+    for (std::size_t i {0}; i < num_regions; ++i) {
+        const auto& contig = contigs[contig_dist(generator)];
+        const GenomicRegion::Size contig_size = contig.second.size();
+        std::uniform_int_distribution<GenomicRegion::Size> begin_dist {0, contig_size + max_overhang};
+        const auto begin = begin_dist(generator);
+        std::uniform_int_distribution<GenomicRegion::Size> size_dist {0, std::min<GenomicRegion::Size>(contig_size + max_overhang - begin, 500)};
+        result.emplace_back(contig.first, begin, begin + size_dist(generator));
+    }
+    return result;
+}
+
+std::vector<GenomicRegion> make_run_regions(const Contigs& contigs)
+{
+    // Regions starting, ending, and contained inside N and lowercase runs
+    std::vector<GenomicRegion> result {};
+    for (const auto& contig : contigs) {
+        const auto& sequence = contig.second;
+        for (std::size_t i {1}; i < sequence.size(); ++i) {
+            const bool n_boundary {(sequence[i] == 'N') != (sequence[i - 1] == 'N')};
+            const bool case_boundary {std::islower(sequence[i]) != std::islower(sequence[i - 1])};
+            if (n_boundary || case_boundary) {
+                const GenomicRegion::Size position = i;
+                for (GenomicRegion::Size offset : {0, 1, 3, 5}) {
+                    if (position >= offset) {
+                        result.emplace_back(contig.first, position - offset, std::min<GenomicRegion::Size>(position + 2 * offset, sequence.size()));
+                    }
+                }
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(packed_reference_fetches_the_packed_sequence)
+{
+    const PackedFasta reference {};
+    const ::octopus::io::PackedReference packed {reference.packed};
+    BOOST_REQUIRE(packed.is_open());
+    const auto contig_names = packed.fetch_contig_names();
+    BOOST_REQUIRE_EQUAL(contig_names.size(), reference.contigs.size());
+    for (std::size_t i {0}; i < contig_names.size(); ++i) {
+        const auto& contig = reference.contigs[i];
+        BOOST_CHECK_EQUAL(contig_names[i], contig.first);
+        BOOST_CHECK_EQUAL(packed.fetch_contig_size(contig.first), contig.second.size());
+        BOOST_CHECK_EQUAL(packed.fetch_sequence(GenomicRegion {contig.first, 0, static_cast<GenomicRegion::Size>(contig.second.size())}), contig.second);
+    }
+    auto regions = make_random_regions(reference.contigs, 20'000, 0);
+    const auto run_regions = make_run_regions(reference.contigs);
+    BOOST_REQUIRE(!run_regions.empty());
+    regions.insert(std::cend(regions), std::cbegin(run_regions), std::cend(run_regions));
+    for (const auto& region : regions) {
+        const auto itr = std::find_if(std::cbegin(reference.contigs), std::cend(reference.contigs),
+                                      [&] (const auto& contig) { return contig.first == region.contig_name(); });
+        const auto expected = itr->second.substr(region.begin(), size(region));
+        BOOST_CHECK_EQUAL(packed.fetch_sequence(region), expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(packed_reference_matches_fasta)
+{
+    using Options = ::octopus::io::Fasta::Options;
+    const PackedFasta reference {};
+    auto regions = make_random_regions(reference.contigs, 5'000, 50);
+    const auto run_regions = make_run_regions(reference.contigs);
+    regions.insert(std::cend(regions), std::cbegin(run_regions), std::cend(run_regions));
+    for (const auto capitalisation : {Options::CapitalisationPolicy::maintain, Options::CapitalisationPolicy::capitalise}) {
+        for (const auto iupac : {Options::IUPACAmbiguitySymbolPolicy::maintain, Options::IUPACAmbiguitySymbolPolicy::disambiguate}) {
+            for (const auto fill : {Options::BaseFillPolicy::ignore, Options::BaseFillPolicy::fill_with_ns, Options::BaseFillPolicy::throw_exception}) {
+                Options options {};
+                options.base_transform_policy = capitalisation;
+                options.iupac_ambiguity_symbol_policy = iupac;
+                options.base_fill_policy = fill;
+                const ::octopus::io::Fasta fasta {reference.fasta, options};
+                const ::octopus::io::PackedReference packed {reference.packed, options};
+                BOOST_CHECK(packed.fetch_contig_names() == fasta.fetch_contig_names());
+                for (const auto& region : regions) {
+                    if (fill == Options::BaseFillPolicy::throw_exception
+                        && region.end() > fasta.fetch_contig_size(region.contig_name())) {
+                        BOOST_CHECK_THROW(fasta.fetch_sequence(region), std::exception);
+                        BOOST_CHECK_THROW(packed.fetch_sequence(region), std::exception);
+                    } else {
+                        BOOST_CHECK_EQUAL(packed.fetch_sequence(region), fasta.fetch_sequence(region));
+                    }
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
@@ -0,0 +1,158 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "basics/contig_region.hpp"
+#include "basics/genomic_region.hpp"
+#include "io/read/read_coverage_index.hpp"
+#include "io/read/read_manager.hpp"
+#include "mock/mock_files.hpp"
+
+namespace octopus { namespace test {
+
+namespace fs = boost::filesystem;
+
+BOOST_AUTO_TEST_SUITE(io)
+BOOST_AUTO_TEST_SUITE(read_coverage_index)
+
+namespace {
+
+// 10 reads of length 100 starting every 10bp in each of the first 5 bins
+auto make_test_index()
+{
+    ::octopus::io::ReadCoverageIndex result {100};
+    result.add_contig("sample", "1", 1'000);
+    for (GenomicRegion::Position begin {0}; begin < 500; begin += 10) {
+        result.add("sample", "1", ContigRegion {begin, begin + 100});
+    }
+    return result;
+}
+
+// The same reads as make_test_index as coordinate sorted SAM text, plus num_extra_reads reads at the end of the contig
+std::string make_test_sam(const int num_extra_reads = 0)
+{
+    std::string result {"@HD\tVN:1.4\tSO:coordinate\n@SQ\tSN:1\tLN:1000\n@RG\tID:rg\tSM:sample\n"};
+    const std::string sequence(100, 'A');
+    const auto add_read = [&] (const int begin) {
+        result += "read" + std::to_string(begin) + "\t0\t1\t" + std::to_string(begin + 1) + "\t60\t100M\t*\t0\t0\t"
+                  + sequence + "\t*\tRG:Z:rg\n";
+    };
+    for (int begin {0}; begin < 500; begin += 10) add_read(begin);
+    for (int i {0}; i < num_extra_reads; ++i) add_read(800);
+    return result;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(read_coverage_index_answers_read_queries)
+{
+    const auto index = make_test_index();
+    const std::vector<std::string> samples {"sample"};
+
+    BOOST_CHECK(index.is_indexed(samples, GenomicRegion {"1", 0, 100}));
+    BOOST_CHECK(!index.is_indexed(samples, GenomicRegion {"2", 0, 100}));
+    BOOST_CHECK(!index.is_indexed({"other"}, GenomicRegion {"1", 0, 100}));
+
+    BOOST_CHECK(index.has_reads(samples, GenomicRegion {"1", 0, 100}));
+    BOOST_CHECK(index.has_reads(samples, GenomicRegion {"1", 550, 580})); // overlapped by reads starting before 500
+    BOOST_CHECK(!index.has_reads(samples, GenomicRegion {"1", 700, 800}));
+
+    BOOST_CHECK_EQUAL(index.count_reads(samples, GenomicRegion {"1", 0, 500}), 50);
+    BOOST_CHECK_EQUAL(index.count_reads(samples, GenomicRegion {"1", 800, 1'000}), 0);
+
+    BOOST_CHECK_EQUAL(index.find_covered_subregion(samples, GenomicRegion {"1", 0, 1'000}, 100), (GenomicRegion {"1", 0, 1'000}));
+    BOOST_CHECK_EQUAL(index.find_covered_subregion(samples, GenomicRegion {"1", 0, 1'000}, 25), (GenomicRegion {"1", 0, 250}));
+}
+
+BOOST_AUTO_TEST_CASE(read_coverage_index_can_be_saved_and_loaded)
+{
+    const auto index = make_test_index();
+    const auto path = fs::temp_directory_path() / fs::unique_path("octopus-coverage-%%%%-%%%%.idx");
+    index.write(path);
+    const auto loaded = ::octopus::io::read_coverage_index(path);
+    fs::remove(path);
+    const std::vector<std::string> samples {"sample"};
+    BOOST_CHECK_EQUAL(loaded.bin_size(), index.bin_size());
+    for (GenomicRegion::Position begin {0}; begin < 1'000; begin += 50) {
+        const GenomicRegion region {"1", begin, begin + 50};
+        BOOST_CHECK_EQUAL(loaded.has_reads(samples, region), index.has_reads(samples, region));
+        BOOST_CHECK_EQUAL(loaded.count_reads(samples, region), index.count_reads(samples, region));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(read_coverage_index_queries_agree_with_read_manager)
+{
+    mock::TemporaryDirectory directory {};
+    const auto bam = directory / "reads.bam";
+    mock::write_indexed_bam(bam, make_test_sam());
+    const ::octopus::io::ReadManager reads {bam};
+    const auto samples = reads.samples();
+    BOOST_REQUIRE_EQUAL(samples.size(), 1);
+    const auto index = ::octopus::io::make_read_coverage_index(reads, {GenomicRegion {"1", 0, 1'000}}, 100);
+    BOOST_REQUIRE(index.is_indexed(samples, GenomicRegion {"1", 0, 1'000}));
+    // Index answers are estimates that may include reads ending just before a region, but never miss reads
+    for (GenomicRegion::Position begin {0}; begin < 1'000; begin += 25) {
+        const GenomicRegion region {"1", begin, std::min(begin + 75, GenomicRegion::Position {1'000})};
+        if (reads.has_reads(samples, region)) BOOST_CHECK(index.has_reads(samples, region));
+        BOOST_CHECK_GE(index.count_reads(samples, region), reads.count_reads(samples, region));
+    }
+    BOOST_CHECK_EQUAL(index.count_reads(samples, GenomicRegion {"1", 0, 500}), reads.count_reads(samples, GenomicRegion {"1", 0, 500}));
+    BOOST_CHECK_EQUAL(index.count_reads(samples, GenomicRegion {"1", 600, 1'000}), 0);
+    BOOST_CHECK_EQUAL(reads.count_reads(samples, GenomicRegion {"1", 600, 1'000}), 0);
+    BOOST_CHECK(!index.has_reads(samples, GenomicRegion {"1", 700, 1'000}));
+    const GenomicRegion contig {"1", 0, 1'000};
+    for (const std::size_t max_reads : {10, 25, 40, 100}) {
+        BOOST_CHECK_EQUAL(index.find_covered_subregion(samples, contig, max_reads),
+                          reads.find_covered_subregion(samples, contig, max_reads));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(read_coverage_index_covered_subregions_agree_with_read_counts)
+{
+    const auto index = make_test_index();
+    const std::vector<std::string> samples {"sample"};
+    for (GenomicRegion::Position begin {0}; begin < 1'000; begin += 50) {
+        const GenomicRegion region {"1", begin, 1'000};
+        for (const std::size_t max_reads : {0, 5, 10, 20}) {
+            const auto covered_region = index.find_covered_subregion(samples, region, max_reads);
+            BOOST_CHECK_EQUAL(covered_region.begin(), region.begin());
+            BOOST_CHECK_LE(covered_region.end(), region.end());
+            if (covered_region != region) {
+                // Reads starting before the region are counted by both queries
+                BOOST_CHECK_GT(index.count_reads(samples, region), max_reads);
+                if (!is_empty(covered_region)) BOOST_CHECK_LE(index.count_reads(samples, covered_region), max_reads);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(read_coverage_index_is_stale_when_read_files_change)
+{
+    mock::TemporaryDirectory directory {};
+    const auto bam = directory / "reads.bam";
+    mock::write_indexed_bam(bam, make_test_sam());
+    const auto path = directory / "reads.idx";
+    {
+        const ::octopus::io::ReadManager reads {bam};
+        const auto index = ::octopus::io::make_read_coverage_index(reads, {GenomicRegion {"1", 0, 1'000}}, 100);
+        BOOST_CHECK(index.is_current({bam}));
+        BOOST_CHECK(!index.is_current({}));
+        index.write(path);
+    }
+    BOOST_CHECK(::octopus::io::read_coverage_index(path).is_current({bam}));
+    mock::write_indexed_bam(bam, make_test_sam(20));
+    BOOST_CHECK(!::octopus::io::read_coverage_index(path).is_current({bam}));
+    BOOST_CHECK(!make_test_index().is_current({bam}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
@@ -150,6 +150,31 @@ BOOST_AUTO_TEST_CASE(read_manager_multiple_files_above_max_file_limit_test)
     BOOST_CHECK(small_reads3.size() == 7);
 }
 
+BOOST_AUTO_TEST_CASE(fetching_with_workers_gives_the_same_reads_as_serial_fetching)
+{
+    BOOST_REQUIRE(test_file_exists(NA12878_low_coverage));
+    BOOST_REQUIRE(test_file_exists(HG00101));
+    BOOST_REQUIRE(test_file_exists(HG00102));
+    
+    std::vector<fs::path> read_paths {NA12878_low_coverage, HG00101, HG00102};
+    
+    ReadManager serial_read_manager(read_paths, 3), concurrent_read_manager(read_paths, 3);
+    ThreadPool workers {3};
+    concurrent_read_manager.set_fetch_workers(&workers);
+    
+    const auto samples = serial_read_manager.samples();
+    
+    const GenomicRegion a_big_region {"1", 2000000, 3000000};
+    const GenomicRegion a_small_region {"10", 1000000, 1000100};
+    
+    for (const auto& region : {a_big_region, a_small_region}) {
+        BOOST_CHECK(concurrent_read_manager.fetch_reads(samples, region) == serial_read_manager.fetch_reads(samples, region));
+        for (const auto& sample : samples) {
+            BOOST_CHECK(concurrent_read_manager.fetch_reads(sample, region) == serial_read_manager.fetch_reads(sample, region));
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 BOOST_AUTO_TEST_SUITE_END()
 
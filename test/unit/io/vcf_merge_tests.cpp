@@ -0,0 +1,118 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <cstddef>
+
+#include <boost/filesystem/operations.hpp>
+
+#include "basics/genomic_region.hpp"
+#include "io/variant/vcf_reader.hpp"
+#include "io/variant/vcf_writer.hpp"
+#include "io/variant/vcf_record.hpp"
+#include "io/variant/vcf_utils.hpp"
+#include "utils/thread_pool.hpp"
+#include "mock/mock_files.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(io)
+BOOST_AUTO_TEST_SUITE(vcf_merge)
+
+namespace {
+
+const std::vector<std::string> contigs {"1", "2", "3"};
+
+// Every part has the same header, but only records on its own contig
+std::string make_test_vcf(const std::string& contig, const std::size_t num_records)
+{
+    std::string result {"##fileformat=VCFv4.2\n"};
+    for (const auto& c : contigs) result += "##contig=<ID=" + c + ",length=1000000>\n";
+    result += "##INFO=<ID=DP,Number=1,Type=Integer,Description=\"Depth\">\n"
+              "##FORMAT=<ID=GT,Number=1,Type=String,Description=\"Genotype\">\n"
+              "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tsample\n";
+    for (std::size_t i {0}; i < num_records; ++i) {
+        const auto position = 1 + 13 * i;
+        result += contig + "\t" + std::to_string(position) + "\t.\tA\tC\t" + std::to_string(position % 100)
+                  + "\tPASS\tDP=" + std::to_string(i % 50) + "\tGT\t0/1\n";
+    }
+    return result;
+}
+
+std::vector<std::string> to_strings(const std::vector<VcfRecord>& records)
+{
+    std::vector<std::string> result {};
+    result.reserve(records.size());
+    for (const auto& record : records) {
+        std::ostringstream ss {};
+        ss << record;
+        result.push_back(ss.str());
+    }
+    return result;
+}
+
+bool has_part_files(const mock::Path& directory)
+{
+    using boost::filesystem::directory_iterator;
+    for (directory_iterator itr {directory}; itr != directory_iterator {}; ++itr) {
+        if (itr->path().filename().string().find(".part") != std::string::npos) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(parallel_merge_of_contig_parts_round_trips_and_is_indexed)
+{
+    mock::TemporaryDirectory directory {};
+    std::vector<VcfReader::Path> part_paths {};
+    // Big enough that the parts span several BGZF blocks
+    const std::vector<std::size_t> num_records {20'000, 5, 3'000};
+    for (std::size_t i {0}; i < contigs.size(); ++i) {
+        part_paths.push_back(directory / ("calls." + contigs[i] + ".vcf.gz"));
+        mock::write_indexed_vcf(part_paths.back(), make_test_vcf(contigs[i], num_records[i]));
+    }
+    std::vector<VcfRecord> expected_records {};
+    std::vector<VcfReader> sources {};
+    for (const auto& path : part_paths) {
+        sources.emplace_back(path);
+        const auto records = sources.back().fetch_records();
+        expected_records.insert(std::cend(expected_records), std::cbegin(records), std::cend(records));
+    }
+    const auto merged = directory / "merged.vcf.gz";
+    {
+        ThreadPool workers {2};
+        VcfWriter dst {merged, sources.front().fetch_header()};
+        merge(sources, dst, contigs, workers);
+    }
+    BOOST_CHECK(!has_part_files(directory.path()));
+    BOOST_REQUIRE(is_indexed(merged));
+    const VcfReader result {merged};
+    const auto expected = to_strings(expected_records), actual = to_strings(result.fetch_records());
+    BOOST_CHECK_EQUAL(actual.size(), 23'005);
+    BOOST_CHECK_EQUAL_COLLECTIONS(std::cbegin(actual), std::cend(actual), std::cbegin(expected), std::cend(expected));
+    // Region queries go through the index
+    for (std::size_t i {0}; i < contigs.size(); ++i) {
+        BOOST_CHECK_EQUAL(result.count_records(contigs[i]), num_records[i]);
+        const auto expected_part = to_strings(VcfReader {part_paths[i]}.fetch_records(contigs[i]));
+        const auto actual_part = to_strings(result.fetch_records(contigs[i]));
+        BOOST_CHECK_EQUAL_COLLECTIONS(std::cbegin(actual_part), std::cend(actual_part),
+                                      std::cbegin(expected_part), std::cend(expected_part));
+    }
+    const GenomicRegion region {"1", 100'000, 110'000};
+    const auto expected_region = to_strings(VcfReader {part_paths.front()}.fetch_records(region));
+    const auto actual_region = to_strings(result.fetch_records(region));
+    BOOST_CHECK(!actual_region.empty());
+    BOOST_CHECK_EQUAL_COLLECTIONS(std::cbegin(actual_region), std::cend(actual_region),
+                                  std::cbegin(expected_region), std::cend(expected_region));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
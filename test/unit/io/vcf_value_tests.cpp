@@ -0,0 +1,95 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+#include "io/variant/vcf_value.hpp"
+#include "io/variant/vcf_type.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(io)
+BOOST_AUTO_TEST_SUITE(vcf_value)
+
+BOOST_AUTO_TEST_CASE(vcf_values_compare_numbers_by_value_and_text_by_string)
+{
+    BOOST_CHECK(VcfValue {1} == VcfValue {1});
+    BOOST_CHECK(VcfValue {1} != VcfValue {2});
+    BOOST_CHECK(VcfValue {1} == VcfValue {1.0f});
+    BOOST_CHECK(VcfValue {0.5f} == VcfValue {0.5});
+    BOOST_CHECK(VcfValue {"1"} == VcfValue {1});
+    BOOST_CHECK(VcfValue {"1.0"} != VcfValue {1});
+    BOOST_CHECK(VcfValue {"PASS"} == VcfValue {std::string {"PASS"}});
+    BOOST_CHECK(VcfValue {} == VcfValue {"."});
+    BOOST_CHECK(VcfValue {} != VcfValue {0});
+    BOOST_CHECK(VcfValue {0} != VcfValue {});
+}
+
+BOOST_AUTO_TEST_CASE(vcf_values_outside_the_bcf_integer_range_are_kept_as_strings)
+{
+    const auto max = std::numeric_limits<VcfValue::Integer>::max();
+    const auto min = std::numeric_limits<VcfValue::Integer>::min();
+    BOOST_CHECK(VcfValue {max}.is_integer());
+    BOOST_CHECK(VcfValue {min}.is_integer());
+    BOOST_CHECK(VcfValue {static_cast<std::uint32_t>(max)}.is_integer());
+    const std::int64_t too_big {static_cast<std::int64_t>(max) + 1}, too_small {static_cast<std::int64_t>(min) - 1};
+    const VcfValue big_value {too_big}, small_value {too_small};
+    BOOST_CHECK(big_value.is_string());
+    BOOST_CHECK_EQUAL(big_value.str(), std::to_string(too_big));
+    BOOST_CHECK(small_value.is_string());
+    BOOST_CHECK_EQUAL(small_value.str(), std::to_string(too_small));
+    BOOST_CHECK(VcfValue {std::numeric_limits<std::uint64_t>::max()}.is_string());
+}
+
+BOOST_AUTO_TEST_CASE(missing_vcf_values_print_as_dot_and_have_no_numeric_value)
+{
+    const VcfValue missing {}, dot {"."};
+    BOOST_CHECK(missing.is_missing());
+    BOOST_CHECK(dot.is_missing());
+    BOOST_CHECK(!missing.is_integer() && !missing.is_float() && !missing.is_string());
+    BOOST_CHECK_EQUAL(missing.str(), ".");
+    BOOST_CHECK_THROW(missing.as_integer(), std::runtime_error);
+    BOOST_CHECK_THROW(missing.as_float(), std::runtime_error);
+    BOOST_CHECK_THROW(missing.as_double(), std::runtime_error);
+    BOOST_CHECK(!VcfValue {""}.is_missing());
+}
+
+BOOST_AUTO_TEST_CASE(vcf_value_numbers_convert_and_print_like_their_source)
+{
+    BOOST_CHECK_EQUAL(VcfValue {"42"}.as_integer(), 42);
+    BOOST_CHECK_EQUAL(VcfValue {"0.25"}.as_double(), 0.25);
+    BOOST_CHECK_EQUAL(VcfValue {7}.as_double(), 7.0);
+    BOOST_CHECK_EQUAL(VcfValue {7}.str(), "7");
+    // BCF floats print the same way as htslib
+    BOOST_CHECK(VcfValue {0.1f}.is_float());
+    BOOST_CHECK_EQUAL(VcfValue {0.1f}.str(), "0.1");
+    BOOST_CHECK_EQUAL(VcfValue {1234567.0f}.str(), "1.23457e+06");
+    // Doubles are not narrowed, and print as they did when values were strings
+    BOOST_CHECK(VcfValue {0.1}.is_float());
+    BOOST_CHECK_EQUAL(VcfValue {0.1}.as_double(), 0.1);
+    BOOST_CHECK_EQUAL(VcfValue {0.1}.str(), std::to_string(0.1));
+    BOOST_CHECK_EQUAL(VcfValue {1234567.0}.str(), std::to_string(1234567.0));
+    BOOST_CHECK_EQUAL(VcfValue {0.1}.as_float(), 0.1f);
+}
+
+BOOST_AUTO_TEST_CASE(vcf_types_are_made_from_typed_values_without_formatting)
+{
+    BOOST_CHECK(make_vcf_type("Integer", VcfValue {3}) == VcfType {3});
+    BOOST_CHECK(make_vcf_type("Integer", VcfValue {"3"}) == VcfType {3});
+    BOOST_CHECK(make_vcf_type("Float", VcfValue {0.1}) == VcfType {0.1});
+    BOOST_CHECK(make_vcf_type("Float", VcfValue {0.5f}) == VcfType {0.5});
+    BOOST_CHECK(make_vcf_type("String", VcfValue {0.1}) == VcfType {std::to_string(0.1)});
+    BOOST_CHECK(make_vcf_type("String", VcfValue {}) == VcfType {"."});
+    BOOST_CHECK(make_vcf_type("Flag", VcfValue {1}) == VcfType {true});
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
@@ -0,0 +1,43 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <cstdint>
+
+#include "utils/memory_arena.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(utils)
+
+BOOST_AUTO_TEST_CASE(memory_arena_reuses_blocks_after_reset)
+{
+    MemoryArena arena {1024};
+    std::size_t num_blocks {0};
+    for (int i {0}; i < 3; ++i) {
+        std::vector<std::uint32_t, ArenaAllocator<std::uint32_t>> values {&arena};
+        for (std::uint32_t j {0}; j < 100; ++j) values.push_back(j);
+        BOOST_CHECK_EQUAL(values.back(), 99);
+        BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(values.data()) % alignof(std::uint32_t), 0);
+        if (i == 0) num_blocks = arena.stats().num_blocks;
+        arena.reset();
+    }
+    const auto stats = arena.stats();
+    BOOST_CHECK(stats.num_allocations > 3);
+    BOOST_CHECK_EQUAL(stats.num_blocks, num_blocks);
+    BOOST_CHECK(stats.peak_usage <= stats.capacity);
+}
+
+BOOST_AUTO_TEST_CASE(arena_allocator_uses_the_heap_without_an_arena)
+{
+    std::vector<int, ArenaAllocator<int>> values(1000, 1);
+    BOOST_CHECK_EQUAL(values.size(), 1000);
+    BOOST_CHECK(values.get_allocator().arena() == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
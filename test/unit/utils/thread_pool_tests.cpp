@@ -0,0 +1,93 @@
+// Copyright (c) 2015-2019 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <numeric>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <chrono>
+
+#include "utils/thread_pool.hpp"
+#include "utils/parallel_transform.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(utils)
+
+BOOST_AUTO_TEST_CASE(parallel_transform_is_sequential_outside_a_thread_pool)
+{
+    BOOST_CHECK(ThreadPool::current() == nullptr);
+    const std::vector<int> values {1, 2, 3, 4};
+    std::vector<int> result(values.size());
+    parallel_transform(std::cbegin(values), std::cend(values), std::begin(result), [] (int x) {
+        return ThreadPool::current() == nullptr ? 2 * x : -1;
+    });
+    BOOST_CHECK_EQUAL(result[3], 8);
+}
+
+BOOST_AUTO_TEST_CASE(nested_parallel_transform_completes_with_fewer_threads_than_tasks)
+{
+    ThreadPool pool {2};
+    std::vector<int> outer(8);
+    std::iota(std::begin(outer), std::end(outer), 0);
+    std::vector<std::future<int>> sums {};
+    for (const auto x : outer) {
+        sums.push_back(pool.push([x] () {
+            if (ThreadPool::current() == nullptr) return -1;
+            std::vector<int> inner(16, x), result(inner.size());
+            parallel_transform(std::cbegin(inner), std::cend(inner), std::begin(result), [] (int y) { return y + 1; });
+            return std::accumulate(std::cbegin(result), std::cend(result), 0);
+        }));
+    }
+    // Block rather than help so every outer task runs on a pool thread
+    for (std::size_t i {0}; i < sums.size(); ++i) {
+        BOOST_CHECK_EQUAL(sums[i].get(), 16 * (outer[i] + 1));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parallel_transform_rethrows_task_exceptions)
+{
+    ThreadPool pool {2};
+    auto result = pool.push([] () {
+        std::vector<int> values {0, 1, 2, 3}, transformed(values.size());
+        parallel_transform(std::cbegin(values), std::cend(values), std::begin(transformed), [] (int x) {
+            if (x == 2) throw std::runtime_error {"bad value"};
+            return x;
+        });
+        return transformed.back();
+    });
+    BOOST_CHECK_THROW(result.get(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(thread_pool_wait_does_not_run_pool_tasks_outside_the_pool)
+{
+    ThreadPool pool {1};
+    std::promise<void> gate {};
+    auto gate_future = gate.get_future().share();
+    auto blocker = pool.push([gate_future] () { gate_future.wait(); });
+    auto task = pool.push([] () { return std::this_thread::get_id(); });
+    // The only worker is busy, so a waiter that helped would run task itself
+    std::thread opener {[&gate] () {
+        std::this_thread::sleep_for(std::chrono::milliseconds {50});
+        gate.set_value();
+    }};
+    const auto task_thread = pool.wait(task);
+    opener.join();
+    blocker.get();
+    BOOST_CHECK(task_thread != std::this_thread::get_id());
+}
+
+BOOST_AUTO_TEST_CASE(thread_pool_wait_runs_pending_tasks_when_the_pool_has_no_threads)
+{
+    ThreadPool pool {};
+    auto task = pool.push([] () { return std::this_thread::get_id(); });
+    BOOST_CHECK(pool.wait(task) == std::this_thread::get_id());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus